@@ -61,6 +61,20 @@ router.post('/save', (req, res) => {
   if (req.body.mqttpass && req.body.mqttpass !== '********' && req.body.mqttpass.length > 0) {
     mockData.mqttPassword = req.body.mqttpass;
   }
+  if (req.body.broker !== undefined) {
+    mockData.mqttFramed = req.body.mqtt_framed !== undefined;
+    mockData.mqttCompressed = req.body.mqtt_compressed !== undefined;
+    mockData.mqttVersion5 = req.body.mqtt_v5 !== undefined;
+    mockData.mqttTls = req.body.mqtt_tls !== undefined;
+    mockData.mqttJson = req.body.mqtt_json !== undefined;
+    mockData.mqttMultiplex = req.body.mqtt_mux !== undefined;
+  }
+  if (req.body.mqtt_snapshot !== undefined) {
+    mockData.mqttSnapshotInterval = Math.max(0, parseInt(req.body.mqtt_snapshot) || 0);
+  }
+  if (req.body.mqtt_inflight !== undefined) {
+    mockData.mqttInflight = Math.min(8, Math.max(0, parseInt(req.body.mqtt_inflight) || 0));
+  }
 
   // Update Web User settings
   if (req.body.web_user) {
@@ -31,6 +31,14 @@ function processTemplate(content, mockData) {
   processed = processed.replace(/%MQTT_USER%/g, escapeHTML(mockData.mqttUser));
   processed = processed.replace(/%MQTT_PASSWORD_DISPLAY%/g, mockData.mqttPassword ? '********' : '');
   processed = processed.replace(/%MQTT_PASSWORD_HAS_VALUE%/g, mockData.mqttPassword ? '1' : '0');
+  processed = processed.replace(/%MQTT_FRAMED_CHECKED%/g, mockData.mqttFramed ? 'checked' : '');
+  processed = processed.replace(/%MQTT_COMPRESSED_CHECKED%/g, mockData.mqttCompressed ? 'checked' : '');
+  processed = processed.replace(/%MQTT_V5_CHECKED%/g, mockData.mqttVersion5 ? 'checked' : '');
+  processed = processed.replace(/%MQTT_TLS_CHECKED%/g, mockData.mqttTls ? 'checked' : '');
+  processed = processed.replace(/%MQTT_JSON_CHECKED%/g, mockData.mqttJson ? 'checked' : '');
+  processed = processed.replace(/%MQTT_MUX_CHECKED%/g, mockData.mqttMultiplex ? 'checked' : '');
+  processed = processed.replace(/%MQTT_SNAPSHOT_INTERVAL%/g, String(mockData.mqttSnapshotInterval ?? 10));
+  processed = processed.replace(/%MQTT_INFLIGHT%/g, String(mockData.mqttInflight ?? 0));
 
   // MQTT Topics
   processed = processed.replace(/%TOPIC_TTY0_RX%/g, escapeHTML(mockData.topicTty0Rx));
@@ -1,6 +1,7 @@
 #include "application.h"
 #include "infrastructure/logging/logger.h"
 #include "infrastructure/mqttt/mqtt_client.h"
+#include "infrastructure/storage/file_system_policy.h"
 #include <Arduino.h>
 #include <ArduinoOTA.h>
 #include <HardwareSerial.h>
@@ -13,14 +14,13 @@ namespace jrb::wifi_serial {
 Application *Application::s_instance = nullptr;
 
 Application::Application()
-    : preferencesStorage(), wifiManager(preferencesStorage),
-      pubSubClient(wifiClient),
+    : preferencesStorage(), wifiManager(preferencesStorage), pubSubClient(),
       mqttClient(pubSubClient, preferencesStorage),
       systemInfo(preferencesStorage, otaEnabled),
       sshServer(preferencesStorage, systemInfo, specialCharacterHandler),
       webServer(preferencesStorage),
-      tty0Broadcaster(webServer.getTty0Stream(), mqttClient.getTty0Stream()),
-      tty1Broadcaster(webServer.getTty1Stream(), mqttClient.getTty1Stream(),
+      tty0Broadcaster(webServer.getTty0Stream(), mqttClient.getTty0Sink()),
+      tty1Broadcaster(webServer.getTty1Stream(), mqttClient.getTty1Sink(),
                       sshServer.getStream()),
       otaManager(preferencesStorage, otaEnabled),
       specialCharacterHandler(systemInfo, preferencesStorage), serial1(1) {
@@ -102,12 +102,29 @@ void Application::setup() {
         s_instance->sshServer.sendToSSHClients(data);
       });
 
-  // SSH server setup (after network is ready)
+  // Offline spill and the TLS CA share the LittleFS partition mounted by the
+  // web server
+  mqttClient.setupSpill();
+  setupMqttTls();
+
+  // SSH server setup (after network is ready); host keys are prepared in its
+  // task, so this doesn't wait for key generation
   sshServer.setup();
 
+  // Configuration only changes through the web UI, which restarts
+  preferencesStorage.describeTo(telemetry);
+  telemetry.setString("macAddress", WiFi.macAddress().c_str());
+
+  // MQTT owns its task from here on; loop() only touches its rings
   lastInfoPublish = millis();
+  xTaskCreate(mqttTask, "MQTT", MQTT_TASK_STACK_SIZE, this, MQTT_TASK_PRIORITY,
+              &mqttTaskHandle);
+  if (!mqttTaskHandle) {
+    LOG_ERROR("Failed to create MQTT task");
+  }
+
   systemInfo.logSystemInformation();
-  LOG_INFO("Setup complete!");
+  LOG_INFO("Setup complete in %lu ms, serial bridge active", millis());
 }
 
 void Application::loop() {
@@ -119,16 +136,43 @@ void Application::loop() {
   }
 
   wifiManager.loop();
-  mqttClient.loop();
   ArduinoOTA.handle();
 
-  reconnectMqttIfNeeded();
-  publishInfoIfNeeded();
+  mqttClient.dispatchInbound();
 
   handleSerialPort0();
   handleSerialPort1();
 }
 
+void Application::mqttTask(void *parameter) {
+  static_cast<Application *>(parameter)->runMqttTask();
+}
+
+void Application::runMqttTask() {
+  LOG_INFO("MQTT task started");
+  for (;;) {
+    reconnectMqttIfNeeded();
+    mqttClient.loop();
+    publishInfoIfNeeded();
+    vTaskDelay(pdMS_TO_TICKS(MQTT_TASK_PERIOD_MS));
+  }
+}
+
+void Application::setupMqttTls() {
+  if (!preferencesStorage.mqttTls)
+    return;
+  FileSystemPolicy fileSystem;
+  const size_t size = fileSystem.size(MQTT_TLS_CA_PATH);
+  if (size > 0) {
+    mqttCaCert.resize(size);
+    fileSystem.read(MQTT_TLS_CA_PATH, 0,
+                    reinterpret_cast<uint8_t *>(&mqttCaCert[0]), size);
+    LOG_INFO("MQTT TLS: broker verified against %s", MQTT_TLS_CA_PATH);
+  }
+  pubSubClient.getTransport().setTls(
+      true, mqttCaCert.empty() ? nullptr : mqttCaCert.c_str());
+}
+
 void Application::reconnectMqttIfNeeded() {
   if (!wifiManager.isAPMode() && preferencesStorage.mqttBroker.length() > 0 &&
       !mqttClient.isConnected()) {
@@ -148,21 +192,55 @@ void Application::reconnectMqttIfNeeded() {
 }
 
 void Application::publishInfoIfNeeded() {
-  if (!wifiManager.isAPMode() && mqttClient.isConnected()) {
-    static constexpr unsigned long INFO_PUBLISH_INTERVAL_MS = 30000;
-
-    if (millis() - lastInfoPublish >= INFO_PUBLISH_INTERVAL_MS) {
-      types::string macAddress = WiFi.macAddress().c_str();
-      types::string ipAddress = WiFi.status() == WL_CONNECTED
-                                    ? WiFi.localIP().toString().c_str()
-                                    : "Not connected";
-      types::string ssid = WiFi.status() == WL_CONNECTED ? WiFi.SSID().c_str()
-                                                         : "Not configured";
-      mqttClient.publishInfo(
-          preferencesStorage.serialize(ipAddress, macAddress, ssid));
-      lastInfoPublish = millis();
+  if (wifiManager.isAPMode() || !mqttClient.isConnected()) {
+    infoPublished = false; // full document again once (re)connected
+    infoAttempted = false;
+    return;
+  }
+
+  // The first attempt after connecting goes out at once; a refused full
+  // document is retried at the delta interval, not every loop
+  const unsigned long now = millis();
+  if (infoAttempted && now - lastInfoDelta < MQTT_INFO_DELTA_INTERVAL_MS)
+    return;
+  infoAttempted = true;
+  lastInfoDelta = now;
+  updateTelemetry();
+
+  if (!infoPublished || now - lastInfoPublish >= MQTT_INFO_FULL_INTERVAL_MS) {
+    if (mqttClient.publishInfo(telemetry.full())) {
+      telemetry.markPublished();
+      infoPublished = true;
+      lastInfoPublish = now;
     }
+  } else if (telemetry.changed() &&
+             mqttClient.publishInfoDelta(telemetry.delta())) {
+    telemetry.markPublished();
+  }
+}
+
+void Application::updateTelemetry() {
+  const bool wifiConnected = WiFi.status() == WL_CONNECTED;
+  // String conversions allocate: only redo them when the address changes
+  const uint32_t ip =
+      wifiConnected ? static_cast<uint32_t>(WiFi.localIP()) : 0;
+  if (!telemetryNetworkSet || ip != telemetryIp) {
+    telemetryNetworkSet = true;
+    telemetryIp = ip;
+    telemetry.setString("ipAddress", wifiConnected
+                                         ? WiFi.localIP().toString().c_str()
+                                         : "Not connected");
+    telemetry.setString("ssid", wifiConnected ? WiFi.SSID().c_str()
+                                              : "Not configured");
   }
+  telemetry.setNumber("rssi", wifiConnected ? WiFi.RSSI() : 0);
+  telemetry.setNumber("freeHeap", static_cast<long>(ESP.getFreeHeap()));
+  telemetry.setNumber("minFreeHeap", static_cast<long>(ESP.getMinFreeHeap()));
+  telemetry.setNumber("uptimeSec", static_cast<long>(millis() / 1000));
+  // Publishes the budget held back (tty, coalesced later) or gave up (info)
+  const auto &budget = mqttClient.getPublishBudget();
+  telemetry.setNumber("mqttDeferred", static_cast<long>(budget.deferred()));
+  telemetry.setNumber("mqttDropped", static_cast<long>(budget.dropped()));
 }
 
 void Application::handleSerialPort0() {
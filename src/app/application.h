@@ -5,6 +5,7 @@
 #include "domain/config/preferences_storage.h"
 #include "domain/config/special_character_handler.h"
 #include "domain/messaging/mqtt_buffer.h"
+#include "domain/messaging/telemetry_document.hpp"
 #include "domain/network/ssh_buffer.h"
 #include "domain/network/ssh_server.h"
 #include "domain/serial/serial_log.hpp"
@@ -14,8 +15,8 @@
 #include "infrastructure/wifi/wifi_manager.h"
 #include "ota_manager.h"
 #include "system_info.h"
-#include <PubSubClient.h>
-#include <WiFiClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <functional>
 #include <vector>
 
@@ -37,6 +38,11 @@ namespace jrb::wifi_serial {
  * - Provide callbacks for MQTT tty ports and reset configuration.
  * - Bridge web/serial/mqtt messages into the appropriate handlers.
  *
+ * MQTT runs in its own FreeRTOS task so a slow or unreachable broker never
+ * delays the UART handlers. The two sides only meet in lock-free SPSC rings
+ * owned by MqttClient: tty output flows main loop -> MQTT task through the
+ * broadcaster sinks, rx payloads flow back through dispatchInbound().
+ *
  * The class is non-copyable (holds a reference to a container) and is
  * intended to be instantiated once as the program's main application object.
  */
@@ -66,32 +72,55 @@ private:
   // Primitives (initialize first)
   bool otaEnabled{false};
   unsigned long lastInfoPublish{0};
+  unsigned long lastInfoDelta{0};
+  bool infoPublished{false};
+  bool infoAttempted{false}; // since (re)connecting
+  bool telemetryNetworkSet{false};
+  uint32_t telemetryIp{0};
+  types::string mqttCaCert; // PEM; the TLS transport keeps a pointer
   unsigned long lastMqttReconnectAttempt{0};
 
   // Stack objects (order matters - dependencies flow down)
   PreferencesStorage preferencesStorage;
   WiFiManager wifiManager;
-  WiFiClient wifiClient;
+  PubSubClientPolicy pubSubClient; // must be constructed before mqttClient
   MqttClient mqttClient;
-  PubSubClient pubSubClient;
   SystemInfo systemInfo;
   SSHServer sshServer;
   SpecialCharacterHandler specialCharacterHandler;
   HardwareSerial serial1;
 
   WebConfigServer webServer;
-  Broadcaster<SerialLog, MqttLog> tty0Broadcaster;
-  Broadcaster<SerialLog, MqttLog, SshLog> tty1Broadcaster;
+  // Info topic document, only touched by the MQTT task after setup()
+  TelemetryDocument<MQTT_INFO_MAX_FIELDS> telemetry;
+  // describeTo() fields, macAddress and the updateTelemetry() fields
+  static constexpr size_t INFO_FIELDS = 32;
+  static_assert(MQTT_INFO_MAX_FIELDS >= INFO_FIELDS + 8,
+                "leave room for new telemetry fields");
+  Broadcaster<SerialLog, MqttTxSink> tty0Broadcaster;
+  Broadcaster<SerialLog, MqttTxSink, SshLog> tty1Broadcaster;
 
   // Heap objects (lazy init in constructor)
   ButtonHandler buttonHandler;
   OTAManager otaManager;
 
+  TaskHandle_t mqttTaskHandle{nullptr};
+  // TLS handshakes need the extra headroom over plain MQTT
+  static constexpr uint32_t MQTT_TASK_STACK_SIZE = 8192;
+  static constexpr UBaseType_t MQTT_TASK_PRIORITY = 1; // same as loopTask
+  static constexpr TickType_t MQTT_TASK_PERIOD_MS = 5;
+
   // Helper methods for loop processing
   void handleSerialPort0();
   void handleSerialPort1();
+
+  // MQTT task (everything that touches the broker connection)
+  static void mqttTask(void *parameter);
+  void runMqttTask();
+  void setupMqttTls();
   void reconnectMqttIfNeeded();
   void publishInfoIfNeeded();
+  void updateTelemetry();
 
   static Application *s_instance;
 };
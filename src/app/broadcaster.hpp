@@ -16,6 +16,12 @@ namespace jrb::wifi_serial {
  * - Subscribers stored as references (zero copy)
  * - Fold expressions expand at compile-time (zero loop overhead)
  *
+ * Activity gating:
+ * - Every subscriber exposes a cheap `active()` check and is only handed
+ *   data while it has a consumer
+ * - Inactive subscribers with `INACTIVE_BACKLOG > 0` get the data through
+ *   `retain()` (keep most recent bytes for replay); the rest discard it
+ *
  * Trade-off: Different types for different subscriber lists
  * (Broadcaster<SerialLog, BufferedStream> != Broadcaster<SerialLog,
  * BufferedStream, SSHSubscriber>)
@@ -47,9 +53,9 @@ public:
   void append(uint8_t byte) {
     std::apply(
         [byte](auto &...subs) {
-          (subs.get().append(byte),
-           ...); // Fold expression: expands to sub1.append(byte),
-                 // sub2.append(byte), ...
+          (deliver(subs.get(), byte),
+           ...); // Fold expression: expands to deliver(sub1, byte),
+                 // deliver(sub2, byte), ...
         },
         subscribers);
   }
@@ -62,12 +68,27 @@ public:
   void append(const types::span<const uint8_t> &buffer) {
     std::apply(
         [&buffer](auto &...subs) {
-          (subs.get().append(buffer),
-           ...); // Fold expression: expands to sub1.append(buffer),
-                 // sub2.append(buffer), ...
+          (deliver(subs.get(), buffer),
+           ...); // Fold expression: expands to deliver(sub1, buffer),
+                 // deliver(sub2, buffer), ...
         },
         subscribers);
   }
+
+private:
+  /**
+   * @brief Hand data to one subscriber according to its activity state
+   *
+   * The inactive branch compiles away entirely for discarding subscribers.
+   */
+  template <typename Subscriber, typename Data>
+  static void deliver(Subscriber &sub, const Data &data) {
+    if (sub.active()) {
+      sub.append(data);
+    } else if constexpr (Subscriber::INACTIVE_BACKLOG > 0) {
+      sub.retain(data);
+    }
+  }
 };
 
 } // namespace jrb::wifi_serial
@@ -13,6 +13,8 @@ namespace jrb::wifi_serial {
 #define CMD_TTY0_TO_TTY1_BRIDGE 'b'
 #define CMD_RESET 0x0E
 #define CMD_DISCONNECT_SSH 'x'
+#define CMD_ROTATE_SSH_KEY 'k'
+#define CMD_TAIL_SSH 't'
 #define LED_PIN 8
 #define BOOT_BUTTON_PIN 9
 
@@ -27,12 +29,44 @@ namespace jrb::wifi_serial {
 #define AP_MODE_TIMEOUT_MINUTES 5
 
 #define MQTT_BUFFER_SIZE 1024
+#define MQTT_TX_QUEUE_SIZE 2048 // bytes the socket could not take yet
 #define MQTT_PUBLISH_BUFFER_SIZE 256
 #define MQTT_PUBLISH_INTERVAL_MS 5000
 #define MQTT_PUBLISH_MIN_CHARS 64
+#define MQTT_INACTIVE_BACKLOG 512 // tty bytes kept for replay while offline
+#define MQTT_TX_RING_SIZE 2048 // UART -> MQTT task, ~175 ms at 115200 baud
+#define MQTT_RX_RING_SIZE 1024 // MQTT task -> main loop (rx payloads)
+#define MQTT_MAX_ROUTES 16 // inbound topic filters (tty rx + addRoute())
+#define MQTT_UPLOAD_CHUNK_SIZE 480 // chunked upload: max data bytes per chunk
+#define MQTT_TLS_WRITE_SIZE 1024 // TLS: plaintext bytes per record write
+#define MQTT_TLS_CA_PATH "/mqtt_ca.pem" // TLS: broker CA chain on LittleFS
+#define MQTT_TOPIC_ALIASES 8 // MQTT 5: outbound topics sent as a 2-byte alias
+#define MQTT_TTY_MESSAGE_EXPIRY_SEC 600 // MQTT 5: tty publishes expire on the broker
+#define MQTT_MAX_INFLIGHT 8 // QoS 1 tty publishes: upper bound of the in-flight window
+#define MQTT_FRAME_MIN_BYTES 256 // framed mode: publish once this much is queued
+#define MQTT_FRAME_MAX_DELAY_MS 50 // framed mode: ...or when the oldest byte is this old
+#define MQTT_COMPRESS_HISTORY_BYTES 16384 // compressed frames: history restart interval
+#define MQTT_JSON_BATCH_SIZE 1024 // JSON output: max payload per publish
+#define MQTT_LINE_STAMPS 64 // JSON output: line arrival times kept per port
+#define MQTT_TX_STAMP_RING_SIZE 1024 // JSON output: UART -> MQTT task line stamps
+#define MQTT_MUX_BATCH_SIZE 2048 // multiplexed output: max payload per publish
+#define MQTT_SPILL_SEGMENT_SIZE 8192 // offline spill: bytes per LittleFS segment file
+#define MQTT_SPILL_MAX_SEGMENTS 8 // offline spill: oldest segment dropped beyond this
+#define MQTT_SPILL_RECORD_SIZE 512 // offline spill: max payload per record (= replay publish)
+#define MQTT_SPILL_COMMIT_MS 1000 // offline spill: write a partial record after this long
+#define MQTT_SPILL_RECORD_STAMPS 32 // offline spill, JSON: line arrival times per record
+#define MQTT_SPILL_REPLAY_BYTES_PER_SEC 4096 // offline spill: replay rate after reconnect
+#define MQTT_SNAPSHOT_SIZE 2048 // retained scrollback: last bytes kept per port
+#define MQTT_INFO_DELTA_INTERVAL_MS 5000 // info/delta: changed telemetry fields
+#define MQTT_INFO_FULL_INTERVAL_MS 300000 // info: full document (also on connect)
+#define MQTT_INFO_MAX_FIELDS 48 // info: telemetry fields kept (Application uses 32)
+#define MQTT_PUBLISH_RATE 20 // publish budget: messages per second per connection
+#define MQTT_PUBLISH_BURST 40 // publish budget: bucket size (tty leaves half, info a tenth)
 #define DEFAULT_DEVICE_NAME "esp32c3"
 #define DEFAULT_BAUD_RATE_TTY1 115200
 #define DEFAULT_MQTT_PORT 1883
+#define DEFAULT_MQTT_SNAPSHOT_INTERVAL_SEC 10
+#define DEFAULT_MQTT_INFLIGHT 0 // tty publishes default to QoS 0
 #define DEFAULT_MQTT_BROKER ""
 
 #define DEFAULT_TOPIC_TTY0 "wifi_serial/%s/ttyS0"
@@ -40,4 +74,18 @@ namespace jrb::wifi_serial {
 
 #define HTTP_PORT 80
 
+#define SSH_HOST_KEY_PATH "/ssh_host_key" // LittleFS: persisted RSA host key
+#define SSH_HOST_KEY_ED25519_PATH "/ssh_host_ed25519_key"
+#define SSH_HOST_KEY_ECDSA_PATH "/ssh_host_ecdsa_key"
+#define SSH_HOST_KEY_ORDER "ed25519,ecdsa,rsa" // host keys offered, in order
+#define SSH_MAX_SESSIONS 2 // concurrent SSH sessions, one task each
+#define SSH_SESSION_BACKLOG 8192 // recent ttyS1 output kept for SSH (power of 2)
+#define SSH_SCROLLBACK_REPLAY 2048 // bytes replayed when a session opens, 0 = off
+#define SSH_WRITE_BATCH_SIZE 4096 // bytes per SSH channel write, per session
+#define SSH_HOST_KEY_MAX_SIZE 4096 // bytes of exported private key text
+#define SSH_AUTHORIZED_KEYS_PATH "/authorized_keys" // LittleFS: keys allowed to log in
+#define SSH_AUTHORIZED_KEYS_MAX 16 // keys kept from it
+#define SSH_AUTHORIZED_KEYS_MAX_SIZE 16384 // bytes; a larger file is ignored
+#define SSH_PASSWORD_AUTH true // false: only authorized keys can log in
+
 } // namespace jrb::wifi_serial
@@ -90,7 +90,9 @@ public:
       const types::string &macAddress, const types::string &ssid,
       const types::string &password, const types::string &webUser,
       const types::string &webPassword, bool debugEnabled,
-      bool tty02tty1Bridge) const {
+      bool tty02tty1Bridge, bool mqttFramed, bool mqttCompressed,
+      bool mqttVersion5, bool mqttTls, int32_t mqttSnapshotInterval,
+      int32_t mqttInflight, bool mqttJson, bool mqttMultiplex) const {
     String output;
     StaticJsonDocument<1024> obj;
     obj["deviceName"] = deviceName.c_str();
@@ -112,6 +114,14 @@ public:
     obj["webPassword"] = webPassword.length() > 0 ? "********" : "NO_PASSWORD";
     obj["debugEnabled"] = debugEnabled;
     obj["tty02tty1Bridge"] = tty02tty1Bridge;
+    obj["mqttFramed"] = mqttFramed;
+    obj["mqttCompressed"] = mqttCompressed;
+    obj["mqttVersion5"] = mqttVersion5;
+    obj["mqttTls"] = mqttTls;
+    obj["mqttSnapshotInterval"] = mqttSnapshotInterval;
+    obj["mqttInflight"] = mqttInflight;
+    obj["mqttJson"] = mqttJson;
+    obj["mqttMultiplex"] = mqttMultiplex;
     serializeJsonPretty(obj, output);
     return types::string(output.c_str());
   }
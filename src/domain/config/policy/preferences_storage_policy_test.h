@@ -142,7 +142,9 @@ public:
       const types::string &macAddress, const types::string &ssid,
       const types::string &password, const types::string &webUser,
       const types::string &webPassword, bool debugEnabled,
-      bool tty02tty1Bridge) const {
+      bool tty02tty1Bridge, bool mqttFramed, bool mqttCompressed,
+      bool mqttVersion5, bool mqttTls, int32_t mqttSnapshotInterval,
+      int32_t mqttInflight, bool mqttJson, bool mqttMultiplex) const {
     std::ostringstream oss;
     oss << "{\n"
         << "  \"deviceName\": \"" << deviceName << "\",\n"
@@ -167,6 +169,16 @@ public:
         << (webPassword.empty() ? "NO_PASSWORD" : "********") << "\",\n"
         << "  \"debugEnabled\": " << (debugEnabled ? "true" : "false") << ",\n"
         << "  \"tty02tty1Bridge\": " << (tty02tty1Bridge ? "true" : "false")
+        << ",\n"
+        << "  \"mqttFramed\": " << (mqttFramed ? "true" : "false") << ",\n"
+        << "  \"mqttCompressed\": " << (mqttCompressed ? "true" : "false")
+        << ",\n"
+        << "  \"mqttVersion5\": " << (mqttVersion5 ? "true" : "false") << ",\n"
+        << "  \"mqttTls\": " << (mqttTls ? "true" : "false") << ",\n"
+        << "  \"mqttSnapshotInterval\": " << mqttSnapshotInterval << ",\n"
+        << "  \"mqttInflight\": " << mqttInflight << ",\n"
+        << "  \"mqttJson\": " << (mqttJson ? "true" : "false") << ",\n"
+        << "  \"mqttMultiplex\": " << (mqttMultiplex ? "true" : "false")
         << "\n"
         << "}";
     return oss.str();
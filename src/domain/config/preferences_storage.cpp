@@ -15,7 +15,11 @@ PreferencesStorage<StoragePolicy>::PreferencesStorage()
       mqttBroker{}, mqttPort{DEFAULT_MQTT_PORT}, mqttUser{}, mqttPassword{},
       topicTty0Rx{}, topicTty0Tx{}, topicTty1Rx{}, topicTty1Tx{}, ssid{},
       password{}, webUser{"admin"}, webPassword{}, debugEnabled{false},
-      tty02tty1Bridge{false} {
+      tty02tty1Bridge{false}, mqttFramed{false}, mqttCompressed{false},
+      mqttVersion5{false}, mqttTls{false},
+      mqttSnapshotInterval{DEFAULT_MQTT_SNAPSHOT_INTERVAL_SEC},
+      mqttInflight{DEFAULT_MQTT_INFLIGHT}, mqttJson{false},
+      mqttMultiplex{false} {
   load();
 }
 
@@ -44,6 +48,15 @@ void PreferencesStorage<StoragePolicy>::load() {
   password = storage.getString("password", "");
   webUser = storage.getString("webUser", "admin");
   webPassword = storage.getString("webPassword", "");
+  mqttFramed = storage.getInt("mqttFramed", 0) != 0;
+  mqttCompressed = storage.getInt("mqttCompressed", 0) != 0;
+  mqttVersion5 = storage.getInt("mqttV5", 0) != 0;
+  mqttTls = storage.getInt("mqttTls", 0) != 0;
+  mqttSnapshotInterval = storage.getInt("mqttSnapshotSec",
+                                        DEFAULT_MQTT_SNAPSHOT_INTERVAL_SEC);
+  mqttInflight = storage.getInt("mqttInflight", DEFAULT_MQTT_INFLIGHT);
+  mqttJson = storage.getInt("mqttJson", 0) != 0;
+  mqttMultiplex = storage.getInt("mqttMux", 0) != 0;
 
   storage.end();
   generateDefaultTopics();
@@ -110,7 +123,9 @@ PreferencesStorage<StoragePolicy>::serialize(const types::string &ipAddress,
   return storage.serializeJson(
       deviceName, mqttBroker, mqttPort, mqttUser, mqttPassword, topicTty0Rx,
       topicTty0Tx, topicTty1Rx, topicTty1Tx, ipAddress, macAddress, ssid,
-      password, webUser, webPassword, debugEnabled, tty02tty1Bridge);
+      password, webUser, webPassword, debugEnabled, tty02tty1Bridge,
+      mqttFramed, mqttCompressed, mqttVersion5, mqttTls, mqttSnapshotInterval,
+      mqttInflight, mqttJson, mqttMultiplex);
 }
 
 template <typename StoragePolicy>
@@ -131,6 +146,14 @@ void PreferencesStorage<StoragePolicy>::save() {
   storage.putString("password", password);
   storage.putString("webUser", webUser);
   storage.putString("webPassword", webPassword);
+  storage.putInt("mqttFramed", mqttFramed ? 1 : 0);
+  storage.putInt("mqttCompressed", mqttCompressed ? 1 : 0);
+  storage.putInt("mqttV5", mqttVersion5 ? 1 : 0);
+  storage.putInt("mqttTls", mqttTls ? 1 : 0);
+  storage.putInt("mqttSnapshotSec", mqttSnapshotInterval);
+  storage.putInt("mqttInflight", mqttInflight);
+  storage.putInt("mqttJson", mqttJson ? 1 : 0);
+  storage.putInt("mqttMux", mqttMultiplex ? 1 : 0);
 
   storage.end();
 }
@@ -157,6 +180,14 @@ void PreferencesStorage<StoragePolicy>::clear() {
   webPassword = "";
   debugEnabled = false;
   tty02tty1Bridge = false;
+  mqttFramed = false;
+  mqttCompressed = false;
+  mqttVersion5 = false;
+  mqttTls = false;
+  mqttSnapshotInterval = DEFAULT_MQTT_SNAPSHOT_INTERVAL_SEC;
+  mqttInflight = DEFAULT_MQTT_INFLIGHT;
+  mqttJson = false;
+  mqttMultiplex = false;
 }
 
 } // namespace jrb::wifi_serial::internal
@@ -62,6 +62,14 @@ public:
   types::string webPassword;
   bool debugEnabled;
   bool tty02tty1Bridge;
+  bool mqttFramed; // tty publishes carry a tty_frame header
+  bool mqttCompressed; // framed payloads are compressed (needs mqttFramed)
+  bool mqttVersion5; // connect with MQTT 5, falls back to 3.1.1
+  bool mqttTls; // MQTT over TLS (CA from MQTT_TLS_CA_PATH if present)
+  int32_t mqttSnapshotInterval; // retained scrollback refresh, seconds (0 = off)
+  int32_t mqttInflight; // tty publishes: QoS 1 in-flight window (0 = QoS 0)
+  bool mqttJson; // tty publishes are tty_json line records (overrides framing)
+  bool mqttMultiplex; // all ports on one tty_mux topic pair (implies framing)
 
   /**
    * @brief Serializes the configuration to a JSON string.
@@ -74,6 +82,41 @@ public:
                           const types::string &macAddress,
                           const types::string &ssid) const;
 
+  /**
+   * @brief Set the serialize() fields except the network ones on a document
+   * with setString/setNumber/setBool (e.g. TelemetryDocument).
+   *
+   * Same keys and password masking as serialize().
+   */
+  template <typename Document> void describeTo(Document &document) const {
+    document.setString("deviceName", deviceName.c_str());
+    document.setString("mqttBroker", mqttBroker.c_str());
+    document.setNumber("mqttPort", mqttPort);
+    document.setString("mqttUser", mqttUser.c_str());
+    document.setString("mqttPassword",
+                       mqttPassword.empty() ? "NO_PASSWORD" : "********");
+    document.setString("topicTty0Rx", topicTty0Rx.c_str());
+    document.setString("topicTty0Tx", topicTty0Tx.c_str());
+    document.setString("topicTty1Rx", topicTty1Rx.c_str());
+    document.setString("topicTty1Tx", topicTty1Tx.c_str());
+    document.setString("mqtt", mqttBroker.empty() ? "disconnected" : "connected");
+    document.setString("password",
+                       password.empty() ? "NO_PASSWORD" : "********");
+    document.setString("webUser", webUser.c_str());
+    document.setString("webPassword",
+                       webPassword.empty() ? "NO_PASSWORD" : "********");
+    document.setBool("debugEnabled", debugEnabled);
+    document.setBool("tty02tty1Bridge", tty02tty1Bridge);
+    document.setBool("mqttFramed", mqttFramed);
+    document.setBool("mqttCompressed", mqttCompressed);
+    document.setBool("mqttVersion5", mqttVersion5);
+    document.setBool("mqttTls", mqttTls);
+    document.setNumber("mqttSnapshotInterval", mqttSnapshotInterval);
+    document.setNumber("mqttInflight", mqttInflight);
+    document.setBool("mqttJson", mqttJson);
+    document.setBool("mqttMultiplex", mqttMultiplex);
+  }
+
   /**
    * @brief Saves current configuration to persistent storage.
    */
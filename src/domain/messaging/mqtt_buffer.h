@@ -2,8 +2,126 @@
 
 #include "config.h"
 #include "infrastructure/memory/buffered_stream.hpp"
+#include "infrastructure/memory/loss_tracking_ring.hpp"
+#include "infrastructure/memory/spsc_ring.hpp"
+#include "infrastructure/types.hpp"
 #include "mqtt_flush_policy.h"
 
+#ifndef ESP_PLATFORM
+#include "infrastructure/platform/arduino_compat.h"
+#else
+#include <Arduino.h>
+#endif
+
 namespace jrb::wifi_serial {
-using MqttLog = BufferedStream<MqttFlushPolicy, MQTT_BUFFER_SIZE>;
+using MqttLog =
+    BufferedStream<MqttFlushPolicy, MQTT_BUFFER_SIZE, MQTT_MAX_INFLIGHT>;
+
+/**
+ * @brief Broadcaster sink that hands tty output to the MQTT task
+ *
+ * Always active: the UART path only copies into the ring. Line buffering,
+ * offline retention and publishing happen in the MQTT task, which drains
+ * the ring into the matching MqttLog. Bytes dropped on a full ring are
+ * reported to the drain, which advances the stream offset past them.
+ *
+ * Every line start that makes it into the ring is stamped with its arrival
+ * time in a side ring, for JSON output. A stamp is queued right after its
+ * bytes; a drain that races it, or finds the side ring was full, falls back
+ * to its own clock.
+ */
+class MqttTxSink final : public LossTrackingRing<MQTT_TX_RING_SIZE> {
+public:
+  static constexpr size_t INACTIVE_BACKLOG = 0;
+
+  bool active() const { return true; }
+
+  // ---- Producer side ----
+
+  void append(uint8_t byte) { append(types::span<const uint8_t>(&byte, 1)); }
+
+  void append(const types::span<const uint8_t> &data) {
+    if (data.empty())
+      return;
+    const uint32_t start = static_cast<uint32_t>(writePosition());
+    LossTrackingRing::append(data);
+    const size_t written = static_cast<uint32_t>(writePosition()) - start;
+    const uint32_t now = static_cast<uint32_t>(millis());
+    for (size_t i = 0; i < written; ++i) {
+      if (atLineStart)
+        pushStamp(start + static_cast<uint32_t>(i), now);
+      atLineStart = data[i] == '\n';
+    }
+    if (written < data.size())
+      atLineStart = data[data.size() - 1] == '\n';
+  }
+
+  // ---- Consumer side ----
+
+  /**
+   * @brief Arrival time of the line starting at a ring position
+   *
+   * Positions must be asked for in ring order; stamps of earlier positions
+   * are discarded on the way.
+   * @return false if that line start wasn't stamped (yet)
+   */
+  bool lineArrival(uint32_t position, uint32_t &millisOut) {
+    while (stampPending || popStamp()) {
+      const int32_t ahead = static_cast<int32_t>(stampPosition - position);
+      if (ahead > 0)
+        return false;
+      stampPending = false;
+      if (ahead == 0) {
+        millisOut = stampMillis;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  static constexpr size_t STAMP_SIZE = 8; // position, millis (BE u32)
+
+  SpscRing<MQTT_TX_STAMP_RING_SIZE> stamps;
+
+  // Producer-only
+  bool atLineStart{true};
+
+  // Consumer-only
+  bool stampPending{false};
+  uint32_t stampPosition{0};
+  uint32_t stampMillis{0};
+
+  void pushStamp(uint32_t position, uint32_t now) {
+    uint8_t record[STAMP_SIZE];
+    writeU32(record, position);
+    writeU32(record + 4, now);
+    stamps.pushMessage(types::span<const uint8_t>(record, sizeof(record)));
+  }
+
+  bool popStamp() {
+    uint8_t record[STAMP_SIZE];
+    size_t length = 0;
+    if (!stamps.popMessage(record, sizeof(record), length) ||
+        length != STAMP_SIZE)
+      return false;
+    stampPosition = readU32(record);
+    stampMillis = readU32(record + 4);
+    stampPending = true;
+    return true;
+  }
+
+  static void writeU32(uint8_t *out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+  }
+
+  static uint32_t readU32(const uint8_t *in) {
+    return (static_cast<uint32_t>(in[0]) << 24) |
+           (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | in[3];
+  }
+};
 } // namespace jrb::wifi_serial
\ No newline at end of file
@@ -1,16 +1,32 @@
 #include "mqtt_flush_policy.h"
 #include "infrastructure/logging/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef ESP_PLATFORM
+#include "infrastructure/platform/arduino_compat.h"
+#else
+#include <Arduino.h>
+#endif
 
 namespace jrb::wifi_serial {
 namespace internal {
 template <typename PubSubClientPolicy>
 MqttFlushPolicy<PubSubClientPolicy>::MqttFlushPolicy(
-    PubSubClientPolicy &mqttClient, const types::string &topic)
-    : mqttClient{mqttClient}, topic{topic} {}
+    PubSubClientPolicy &mqttClient, const types::string &topic,
+    const bool &connected, const bool &framed, const bool &compressed,
+    const bool &json, uint8_t port, MqttMuxBatch<PubSubClientPolicy> *mux)
+    : mqttClient{mqttClient}, topic{topic}, connected{connected},
+      framed{framed}, compressed{compressed}, json{json}, port{port},
+      mux{mux} {
+  snprintf(portText, sizeof(portText), "%u", static_cast<unsigned>(port));
+}
 
 template <typename PubSubClientPolicy>
 void MqttFlushPolicy<PubSubClientPolicy>::flush(
-    const types::span<const uint8_t> &buffer, const char *name) {
+    const types::span<const uint8_t> &buffer, uint32_t offset,
+    const char *name) {
   if (buffer.empty())
     return;
 
@@ -22,18 +38,222 @@ void MqttFlushPolicy<PubSubClientPolicy>::flush(
     return;
   }
 
+  if (multiplexed()) {
+    // Published by the owner, or by the batch itself once it is full
+    const size_t frameLength = encodeMuxFrame(buffer, offset);
+    mux->add(port, frameBuffer.data(), frameLength);
+    streamStartPending = false;
+    return;
+  }
+
   LOG_VERBOSE("MQTT publishing %d bytes to topic: %s", buffer.size(),
               topic.c_str());
-  bool result = mqttClient.publish(topic.c_str(), buffer.data(), buffer.size());
+  if (json) {
+    const bool result = publishJson(
+        buffer, offset, [this, offset](const uint8_t *payload, size_t length) {
+          return mqttClient.publish(topic.c_str(), payload, length, false,
+                                    publishProperties(offset));
+        });
+    if (!result) {
+      LOG_ERROR("MQTT JSON publish failed for topic: %s (offset %u)",
+                topic.c_str(), offset);
+    }
+    return;
+  }
+  if (!framed) {
+    bool result = mqttClient.publish(topic.c_str(), buffer.data(),
+                                     buffer.size(), false,
+                                     publishProperties(offset));
+    if (!result) {
+      LOG_ERROR("MQTT publish failed for topic: %s", topic.c_str());
+    }
+    return;
+  }
+
+  // A lost publish needs no bookkeeping: the next frame's offset shows it
+  const size_t frameLength = encodeFrame(buffer, offset);
+  bool result = mqttClient.publish(topic.c_str(), frameBuffer.data(),
+                                   frameLength, false,
+                                   publishProperties(offset));
   if (!result) {
-    LOG_ERROR("MQTT publish failed for topic: %s", topic.c_str());
+    LOG_ERROR("MQTT framed publish failed for topic: %s (offset %u)",
+              topic.c_str(), offset);
+    // The receiver's history now lacks this chunk
+    compressor.reset();
+    return;
+  }
+  streamStartPending = false;
+}
+
+template <typename PubSubClientPolicy>
+uint16_t MqttFlushPolicy<PubSubClientPolicy>::publishAcked(
+    const types::span<const uint8_t> &buffer, uint32_t offset) {
+  if (buffer.empty() || topic.length() == 0 || !mqttClient.connected())
+    return 0;
+
+  if (multiplexed()) {
+    const size_t frameLength = encodeMuxFrame(buffer, offset);
+    const uint16_t packetId =
+        mux->publishAcked(port, frameBuffer.data(), frameLength);
+    if (packetId != 0)
+      streamStartPending = false;
+    return packetId;
+  }
+
+  if (json) {
+    uint16_t packetId = 0;
+    const bool result = publishJson(
+        buffer, offset,
+        [this, offset, &packetId](const uint8_t *payload, size_t length) {
+          packetId = mqttClient.publishAcked(topic.c_str(), payload, length,
+                                             publishProperties(offset));
+          return packetId != 0;
+        });
+    // A batch that didn't go out fails the chunk; the stream resends it
+    // whole, so earlier batches may arrive twice
+    return result ? packetId : 0;
+  }
+  if (!framed)
+    return mqttClient.publishAcked(topic.c_str(), buffer.data(),
+                                   buffer.size(), publishProperties(offset));
+
+  const size_t frameLength = encodeFrame(buffer, offset);
+  const uint16_t packetId =
+      mqttClient.publishAcked(topic.c_str(), frameBuffer.data(), frameLength,
+                              publishProperties(offset));
+  if (packetId == 0) {
+    compressor.reset();
+    return 0;
+  }
+  streamStartPending = false;
+  return packetId;
+}
+
+template <typename PubSubClientPolicy>
+MqttPublishProperties
+MqttFlushPolicy<PubSubClientPolicy>::publishProperties(uint32_t offset) {
+  MqttPublishProperties properties;
+  properties.messageExpirySec = MQTT_TTY_MESSAGE_EXPIRY_SEC;
+  // JSON records and frame headers carry the port and offset themselves
+  if (!framed && !json) {
+    snprintf(offsetText, sizeof(offsetText), "%lu",
+             static_cast<unsigned long>(offset));
+    properties.addUserProperty("port", portText);
+    properties.addUserProperty("seq", offsetText);
+  }
+  return properties;
+}
+
+template <typename PubSubClientPolicy>
+void MqttFlushPolicy<PubSubClientPolicy>::restartHistory() {
+  compressor.reset();
+}
+
+template <typename PubSubClientPolicy>
+template <typename Publish>
+bool MqttFlushPolicy<PubSubClientPolicy>::publishJson(
+    const types::span<const uint8_t> &buffer, uint32_t offset,
+    Publish &&publish) {
+  const uint32_t now = static_cast<uint32_t>(millis());
+  size_t at = 0;
+  while (at < buffer.size()) {
+    tty_json::BatchWriter batch(jsonBuffer.data(), jsonBuffer.size());
+    at = encodeJsonBatch(batch, buffer, at, offset, now);
+    if (!publish(jsonBuffer.data(), batch.finish()))
+      return false;
+  }
+  return true;
+}
+
+template <typename PubSubClientPolicy>
+size_t MqttFlushPolicy<PubSubClientPolicy>::encodeJsonBatch(
+    tty_json::BatchWriter &batch, const types::span<const uint8_t> &buffer,
+    size_t at, uint32_t offset, uint32_t now) {
+  while (at < buffer.size()) {
+    const uint32_t seq = offset + static_cast<uint32_t>(at);
+    if (!batch.beginRecord(lineClock.arrival(seq, now), port, seq))
+      break;
+    const uint8_t *line = buffer.data() + at;
+    const size_t left = buffer.size() - at;
+    const auto *newline =
+        static_cast<const uint8_t *>(memchr(line, '\n', left));
+    const size_t lineLength = newline ? newline - line + 1 : left;
+    size_t textLength = newline ? lineLength - 1 : lineLength;
+    if (newline && textLength > 0 && line[textLength - 1] == '\r')
+      textLength--;
+
+    const size_t used = batch.appendText(line, textLength);
+    if (used < textLength) {
+      // Batch full: the line continues in the next one
+      if (used == 0 && batch.recordCount() > 1) {
+        batch.cancelRecord();
+        return at;
+      }
+      batch.endRecord(true);
+      return at + used;
+    }
+    batch.endRecord(newline == nullptr);
+    at += lineLength;
   }
+  return at;
+}
+
+template <typename PubSubClientPolicy>
+size_t MqttFlushPolicy<PubSubClientPolicy>::encodeMuxFrame(
+    const types::span<const uint8_t> &buffer, uint32_t offset) {
+  // A failed mux publish may have carried earlier frames of this port
+  if (mux->takeLoss(port))
+    compressor.reset();
+  return encodeFrame(buffer, offset);
+}
+
+template <typename PubSubClientPolicy>
+size_t MqttFlushPolicy<PubSubClientPolicy>::encodeFrame(
+    const types::span<const uint8_t> &buffer, uint32_t offset) {
+  tty_frame::Header header;
+  header.port = port;
+  header.flags = streamStartPending ? tty_frame::FLAG_STREAM_START : 0;
+  header.offset = offset;
+  const size_t length = std::min<size_t>(buffer.size(), MQTT_BUFFER_SIZE);
+  const size_t payloadLength =
+      encodePayload(buffer.data(), length, offset, header.flags);
+  tty_frame::encodeHeader(header, frameBuffer.data());
+  return tty_frame::HEADER_SIZE + payloadLength;
+}
+
+template <typename PubSubClientPolicy>
+size_t MqttFlushPolicy<PubSubClientPolicy>::encodePayload(const uint8_t *data,
+                                                          size_t length,
+                                                          uint32_t offset,
+                                                          uint8_t &flags) {
+  uint8_t *payload = frameBuffer.data() + tty_frame::HEADER_SIZE;
+  if (!compressed) {
+    // Start from scratch whenever compression gets switched back on
+    compressor.reset();
+    memcpy(payload, data, length);
+    return length;
+  }
+
+  // History only carries over contiguous chunks; restart it periodically so
+  // subscribers that joined late or lost a message can decode again
+  if (offset != historyEndOffset ||
+      compressor.historySize() >= MQTT_COMPRESS_HISTORY_BYTES) {
+    compressor.reset();
+  }
+  if (compressor.historySize() == 0)
+    flags |= tty_frame::FLAG_HISTORY_RESET;
+  historyEndOffset = offset + static_cast<uint32_t>(length);
+
+  const size_t packed = compressor.compress(data, length, payload);
+  if (packed < length) {
+    flags |= tty_frame::FLAG_COMPRESSED;
+    return packed;
+  }
+  // Incompressible: send as-is, the decoder still adds it to its history
+  memcpy(payload, data, length);
+  return length;
 }
 } // namespace internal
 // Explicit instantiation for production and test builds
-#ifdef ESP_PLATFORM
-template class internal::MqttFlushPolicy<PubSubClient>;
-#else
-template class internal::MqttFlushPolicy<PubSubClientTest>;
-#endif
+template class internal::MqttFlushPolicy<PubSubClientPolicy>;
 } // namespace jrb::wifi_serial
\ No newline at end of file
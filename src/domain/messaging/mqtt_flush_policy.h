@@ -1,8 +1,15 @@
 #pragma once
 
+#include "config.h"
 #include "infrastructure/logging/logger.h"
 #include "infrastructure/mqttt/pub_sub_client_policy.h"
 #include "infrastructure/types.hpp"
+#include "mqtt_mux_batch.h"
+#include "tty_compression.h"
+#include "tty_frame.h"
+#include "tty_json.h"
+#include "tty_line_clock.hpp"
+#include <array>
 
 namespace jrb::wifi_serial {
 namespace internal {
@@ -13,16 +20,110 @@ namespace internal {
  * PubSubClientTest)
  *
  * Zero-cost abstraction using compile-time polymorphism.
+ *
+ * Activity follows the owning MqttClient's cached connection flag, so the
+ * per-byte check never touches the socket. While disconnected the stream
+ * keeps the last MQTT_INACTIVE_BACKLOG bytes and replays them on reconnect.
+ *
+ * In framed mode every publish is prefixed with a tty_frame header carrying
+ * the port and the stream offset of the chunk, so consumers can detect lost
+ * ranges. The very first framed publish after boot is flagged as the start
+ * of the stream. Framed payloads can additionally be compressed against the
+ * port's recent history; the history restarts after any publish the
+ * receiver may have missed.
+ *
+ * JSON output (tty_json.h) replaces framing: each publish is a batch of
+ * line records stamped with the arrival times the MqttClient recorded via
+ * stampLine(). A chunk whose records exceed MQTT_JSON_BATCH_SIZE goes out
+ * as several publishes; for QoS 1 the last packet id stands for all of
+ * them, since brokers acknowledge in order.
+ *
+ * Given an active MqttMuxBatch, frames go to it instead of the port's own
+ * topic, whatever the framed and JSON settings; the owner publishes the
+ * batch once every port has flushed.
+ *
+ * Tty publishes carry MQTT 5 properties, which 3.1.1 connections drop: a
+ * message expiry of MQTT_TTY_MESSAGE_EXPIRY_SEC so brokers don't hand stale
+ * console output to late subscribers, and in unframed mode "port" and "seq"
+ * (stream offset) user properties, the metadata framed headers already
+ * carry.
  */
 template <typename PubSubClientPolicy> class MqttFlushPolicy {
 private:
   PubSubClientPolicy &mqttClient;
   const types::string &topic;
+  const bool &connected;
+  const bool &framed;
+  const bool &compressed;
+  const bool &json;
+  uint8_t port;
+  bool streamStartPending{true};
+  tty_compression::Compressor compressor;
+  uint32_t historyEndOffset{0}; // stream offset following the history
+  char portText[4];
+  char offsetText[11];
+  TtyLineClock<MQTT_LINE_STAMPS> lineClock;
+  MqttMuxBatch<PubSubClientPolicy> *mux;
+
+  // Header + chunk; shared by all streams since they flush from one task
+  static inline std::array<uint8_t,
+                           tty_frame::HEADER_SIZE +
+                               tty_compression::maxCompressedSize(
+                                   MQTT_BUFFER_SIZE)>
+      frameBuffer;
+  static inline std::array<uint8_t, MQTT_JSON_BATCH_SIZE> jsonBuffer;
+  static_assert(MQTT_JSON_BATCH_SIZE >= tty_json::BatchWriter::MAX_HEADER_SIZE +
+                                            tty_json::BatchWriter::CLOSE_SIZE +
+                                            16,
+                "a JSON batch must fit at least one record");
+
+  size_t encodeFrame(const types::span<const uint8_t> &buffer,
+                     uint32_t offset);
+  size_t encodePayload(const uint8_t *data, size_t length, uint32_t offset,
+                       uint8_t &flags);
+  MqttPublishProperties publishProperties(uint32_t offset);
+  bool multiplexed() const { return mux != nullptr && mux->active(); }
+  size_t encodeMuxFrame(const types::span<const uint8_t> &buffer,
+                        uint32_t offset);
+  template <typename Publish>
+  bool publishJson(const types::span<const uint8_t> &buffer, uint32_t offset,
+                   Publish &&publish);
+  size_t encodeJsonBatch(tty_json::BatchWriter &batch,
+                         const types::span<const uint8_t> &buffer, size_t at,
+                         uint32_t offset, uint32_t now);
 
 public:
-  MqttFlushPolicy(PubSubClientPolicy &mqttClient, const types::string &topic);
+  static constexpr size_t INACTIVE_BACKLOG = MQTT_INACTIVE_BACKLOG;
+
+  MqttFlushPolicy(PubSubClientPolicy &mqttClient, const types::string &topic,
+                  const bool &connected, const bool &framed,
+                  const bool &compressed, const bool &json, uint8_t port,
+                  MqttMuxBatch<PubSubClientPolicy> *mux = nullptr);
+
+  bool active() const { return connected; }
+
+  void flush(const types::span<const uint8_t> &buffer, uint32_t offset,
+             const char *name);
+
+  /**
+   * @brief Publish one chunk with QoS 1, framed like flush()
+   * @return Packet id to match against the PUBACK, 0 if not sent
+   */
+  uint16_t publishAcked(const types::span<const uint8_t> &buffer,
+                        uint32_t offset);
+
+  /**
+   * @brief Restart the compression history; publishes in flight when the
+   * connection dropped may never reach the receiver
+   */
+  void restartHistory();
 
-  void flush(const types::span<const uint8_t> &buffer, const char *name);
+  /**
+   * @brief Record when the line starting at a stream offset arrived
+   */
+  void stampLine(uint32_t offset, uint32_t millis) {
+    lineClock.stamp(offset, millis);
+  }
 };
 } // namespace internal
 
@@ -0,0 +1,79 @@
+#include "mqtt_mux_batch.h"
+#include "infrastructure/logging/logger.h"
+
+namespace jrb::wifi_serial {
+namespace internal {
+template <typename PubSubClientPolicy>
+MqttMuxBatch<PubSubClientPolicy>::MqttMuxBatch(PubSubClientPolicy &mqttClient,
+                                               const types::string &topic,
+                                               const bool &enabled)
+    : mqttClient{mqttClient}, topic{topic}, enabled{enabled},
+      writer{buffer.data(), buffer.size()} {}
+
+template <typename PubSubClientPolicy>
+void MqttMuxBatch<PubSubClientPolicy>::add(uint8_t port, const uint8_t *frame,
+                                           size_t length) {
+  if (!writer.fits(length))
+    publish();
+  append(port, frame, length);
+}
+
+template <typename PubSubClientPolicy>
+bool MqttMuxBatch<PubSubClientPolicy>::publish() {
+  if (writer.empty())
+    return true;
+  LOG_VERBOSE("MQTT publishing %u frames (%u bytes) to topic: %s",
+              (unsigned)writer.sections(), (unsigned)writer.size(),
+              topic.c_str());
+  const bool result = mqttClient.publish(topic.c_str(), writer.data(),
+                                         writer.size(), false,
+                                         publishProperties());
+  if (!result) {
+    LOG_ERROR("MQTT mux publish failed for topic: %s (%u frames)",
+              topic.c_str(), (unsigned)writer.sections());
+    // A lost publish needs no other bookkeeping: the next frame's offset
+    // shows it
+    lostPorts |= batchPorts;
+  }
+  writer.clear();
+  batchPorts = 0;
+  return result;
+}
+
+template <typename PubSubClientPolicy>
+uint16_t MqttMuxBatch<PubSubClientPolicy>::publishAcked(uint8_t port,
+                                                        const uint8_t *frame,
+                                                        size_t length) {
+  // Keep the broker's view in stream order
+  publish();
+  append(port, frame, length);
+  const uint16_t packetId = mqttClient.publishAcked(
+      topic.c_str(), writer.data(), writer.size(), publishProperties());
+  if (packetId == 0)
+    lostPorts |= batchPorts;
+  writer.clear();
+  batchPorts = 0;
+  return packetId;
+}
+
+template <typename PubSubClientPolicy>
+void MqttMuxBatch<PubSubClientPolicy>::append(uint8_t port,
+                                              const uint8_t *frame,
+                                              size_t length) {
+  // Frames never exceed FRAME_CAPACITY, so an empty batch takes any of them
+  writer.append(port, frame, length);
+  batchPorts |= portBit(port);
+}
+
+template <typename PubSubClientPolicy>
+MqttPublishProperties
+MqttMuxBatch<PubSubClientPolicy>::publishProperties() const {
+  // Ports and offsets are in the frame headers
+  MqttPublishProperties properties;
+  properties.messageExpirySec = MQTT_TTY_MESSAGE_EXPIRY_SEC;
+  return properties;
+}
+} // namespace internal
+// Explicit instantiation for production and test builds
+template class internal::MqttMuxBatch<PubSubClientPolicy>;
+} // namespace jrb::wifi_serial
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "config.h"
+#include "infrastructure/mqttt/pub_sub_client_policy.h"
+#include "infrastructure/types.hpp"
+#include "tty_compression.h"
+#include "tty_frame.h"
+#include "tty_mux.h"
+#include <array>
+
+namespace jrb::wifi_serial {
+namespace internal {
+/**
+ * @class MqttMuxBatch
+ * @brief Collects the frames of every port into one publish on the mux tx
+ * topic (tty_mux.h).
+ * @tparam PubSubClientPolicy The PubSubClient policy type (PubSubClient or
+ * PubSubClientTest)
+ *
+ * The ports' flush policies add() their frames while the MqttClient flushes
+ * its streams; publish() then sends whatever was collected as a single
+ * PUBLISH. A frame that doesn't fit first publishes what is already there.
+ *
+ * QoS 1 chunks can't share a publish: the stream needs the packet id of
+ * its chunk before the other port has flushed. publishAcked() sends them
+ * as single-section payloads on the same topic.
+ */
+template <typename PubSubClientPolicy> class MqttMuxBatch {
+public:
+  MqttMuxBatch(PubSubClientPolicy &mqttClient, const types::string &topic,
+               const bool &enabled);
+
+  /**
+   * @brief Whether the ports' frames go to this batch
+   */
+  bool active() const { return enabled && topic.length() > 0; }
+
+  /**
+   * @brief Collect a frame; publishes the batch first if it doesn't fit
+   */
+  void add(uint8_t port, const uint8_t *frame, size_t length);
+
+  /**
+   * @brief Publish the collected frames, if any
+   * @return false if the publish failed; the frames are gone either way
+   */
+  bool publish();
+
+  /**
+   * @brief Publish one frame with QoS 1, after anything already collected
+   * @return Packet id to match against the PUBACK, 0 if not sent
+   */
+  uint16_t publishAcked(uint8_t port, const uint8_t *frame, size_t length);
+
+  /**
+   * @brief Whether frames of the port were lost since the last call, so the
+   * receiver's compression history lacks them
+   */
+  bool takeLoss(uint8_t port) {
+    const bool lost = lostPorts & portBit(port);
+    lostPorts &= static_cast<uint16_t>(~portBit(port));
+    return lost;
+  }
+
+  bool empty() const { return writer.empty(); }
+  size_t sections() const { return writer.sections(); }
+
+private:
+  static constexpr size_t FRAME_CAPACITY =
+      tty_frame::HEADER_SIZE +
+      tty_compression::maxCompressedSize(MQTT_BUFFER_SIZE);
+  static_assert(MQTT_MUX_BATCH_SIZE >=
+                    tty_mux::SECTION_HEADER_SIZE + FRAME_CAPACITY,
+                "a mux publish must fit the largest frame");
+
+  PubSubClientPolicy &mqttClient;
+  const types::string &topic;
+  const bool &enabled;
+  std::array<uint8_t, MQTT_MUX_BATCH_SIZE> buffer;
+  tty_mux::Writer writer;
+  uint16_t batchPorts{0}; // one bit per port with a frame in the batch
+  uint16_t lostPorts{0};
+
+  void append(uint8_t port, const uint8_t *frame, size_t length);
+  static uint16_t portBit(uint8_t port) {
+    return static_cast<uint16_t>(1u << (port & tty_frame::MAX_PORT));
+  }
+  MqttPublishProperties publishProperties() const;
+};
+} // namespace internal
+
+using MqttMuxBatch = internal::MqttMuxBatch<PubSubClientPolicy>;
+
+} // namespace jrb::wifi_serial
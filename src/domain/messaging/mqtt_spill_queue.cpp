@@ -0,0 +1,310 @@
+#include "mqtt_spill_queue.h"
+#include "infrastructure/logging/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifndef ESP_PLATFORM
+#include "infrastructure/platform/arduino_compat.h"
+#else
+#include <Arduino.h>
+#endif
+
+namespace jrb::wifi_serial {
+namespace internal {
+namespace {
+constexpr const char *SPILL_DIRECTORY = "/spill";
+} // namespace
+
+template <typename FileSystem> bool MqttSpillQueue<FileSystem>::begin() {
+  mounted = fs.begin() && fs.mkdir(SPILL_DIRECTORY);
+  if (!mounted) {
+    LOG_WARN("MQTT spill disabled: file system not available");
+    return false;
+  }
+
+  // Stream offsets restart at every boot, so an earlier boot's records
+  // can't be replayed in order with this one's
+  std::vector<types::string> names;
+  fs.list(SPILL_DIRECTORY,
+          [&names](const char *name) { names.emplace_back(name); });
+  for (const auto &name : names)
+    fs.remove((types::string(SPILL_DIRECTORY) + "/" + name).c_str());
+  if (!names.empty())
+    LOG_INFO("MQTT spill: discarded %u segments from the previous boot",
+             (unsigned)names.size());
+
+  clear();
+  droppedBytes = 0;
+  return true;
+}
+
+template <typename FileSystem>
+void MqttSpillQueue<FileSystem>::append(
+    uint8_t port, uint32_t offset, const types::span<const uint8_t> &data) {
+  if (!mounted)
+    return;
+
+  size_t i = 0;
+  while (i < data.size()) {
+    // A record holds one contiguous range of one port
+    if (pendingLength > 0 &&
+        (port != pendingPort ||
+         offset != pendingOffset + static_cast<uint32_t>(pendingLength))) {
+      commit();
+    }
+    if (pendingLength == 0) {
+      // Stamps taken for this record's first byte stay with it
+      if (port != pendingPort || offset != pendingOffset)
+        pendingStampCount = 0;
+      pendingPort = port;
+      pendingOffset = offset;
+      pendingSince = millis();
+    }
+
+    const size_t n =
+        std::min(data.size() - i, MQTT_SPILL_RECORD_SIZE - pendingLength);
+    memcpy(pending.data() + RECORD_HEADER_SIZE + pendingLength,
+           data.data() + i, n);
+    pendingLength += n;
+    offset += static_cast<uint32_t>(n);
+    i += n;
+
+    if (pendingLength == MQTT_SPILL_RECORD_SIZE)
+      commit();
+  }
+}
+
+template <typename FileSystem>
+void MqttSpillQueue<FileSystem>::stampLine(uint8_t port, uint32_t offset,
+                                           uint32_t arrival) {
+  if (!mounted)
+    return;
+  if (pendingLength > 0 &&
+      (port != pendingPort ||
+       offset != pendingOffset + static_cast<uint32_t>(pendingLength) ||
+       pendingStampCount == MQTT_SPILL_RECORD_STAMPS)) {
+    commit();
+  }
+  if (pendingLength == 0) {
+    pendingStampCount = 0;
+    pendingPort = port;
+    pendingOffset = offset;
+    pendingSince = millis();
+  }
+  if (pendingStampCount < MQTT_SPILL_RECORD_STAMPS)
+    pendingStamps[pendingStampCount++] = {offset, arrival};
+}
+
+template <typename FileSystem> void MqttSpillQueue<FileSystem>::commitIfDue() {
+  if (pendingLength > 0 && millis() - pendingSince >= MQTT_SPILL_COMMIT_MS)
+    commit();
+}
+
+template <typename FileSystem> void MqttSpillQueue<FileSystem>::commit() {
+  if (pendingLength == 0)
+    return;
+
+  pending[0] = pendingStampCount > 0 ? MAGIC_STAMPED : MAGIC;
+  pending[1] = pendingPort;
+  pending[2] = static_cast<uint8_t>(pendingOffset >> 24);
+  pending[3] = static_cast<uint8_t>(pendingOffset >> 16);
+  pending[4] = static_cast<uint8_t>(pendingOffset >> 8);
+  pending[5] = static_cast<uint8_t>(pendingOffset);
+  pending[6] = static_cast<uint8_t>(pendingLength >> 8);
+  pending[7] = static_cast<uint8_t>(pendingLength);
+  size_t recordSize = RECORD_HEADER_SIZE + pendingLength;
+  if (pendingStampCount > 0) {
+    uint8_t *out = pending.data() + recordSize;
+    *out++ = static_cast<uint8_t>(pendingStampCount);
+    for (size_t i = 0; i < pendingStampCount; ++i) {
+      const uint16_t index =
+          static_cast<uint16_t>(pendingStamps[i].offset - pendingOffset);
+      const uint32_t arrival = pendingStamps[i].millis;
+      *out++ = static_cast<uint8_t>(index >> 8);
+      *out++ = static_cast<uint8_t>(index);
+      *out++ = static_cast<uint8_t>(arrival >> 24);
+      *out++ = static_cast<uint8_t>(arrival >> 16);
+      *out++ = static_cast<uint8_t>(arrival >> 8);
+      *out++ = static_cast<uint8_t>(arrival);
+    }
+    recordSize += 1 + pendingStampCount * STAMP_SIZE;
+  }
+
+  if (tailSize > 0 &&
+      tailSize + recordSize > MQTT_SPILL_SEGMENT_SIZE) {
+    if (tailSegment - headSegment + 1 >= MQTT_SPILL_MAX_SEGMENTS)
+      dropHeadSegment();
+    if (tailSize > 0) {
+      tailSegment++;
+      tailSize = 0;
+      unreadBytes(tailSegment) = 0;
+    }
+  }
+
+  // A full partition gives up the oldest output before the newest
+  bool written = writePending(recordSize);
+  while (!written && headSegment != tailSegment) {
+    dropHeadSegment();
+    written = writePending(recordSize);
+  }
+  if (!written) {
+    LOG_WARN("MQTT spill: write failed, dropped %u bytes",
+             (unsigned)pendingLength);
+    droppedBytes += pendingLength;
+  }
+  pendingLength = 0;
+  pendingStampCount = 0;
+}
+
+template <typename FileSystem>
+bool MqttSpillQueue<FileSystem>::writePending(size_t recordSize) {
+  char path[PATH_SIZE];
+  segmentPath(tailSegment, path);
+  if (!fs.append(path, pending.data(), recordSize)) {
+    // A torn record makes peek() drop the rest of this segment
+    tailSize = fs.size(path);
+    return false;
+  }
+  tailSize += recordSize;
+  unreadBytes(tailSegment) += pendingLength;
+  storedBytes += pendingLength;
+  return true;
+}
+
+template <typename FileSystem>
+bool MqttSpillQueue<FileSystem>::peek(Record &record, uint8_t *payload) {
+  peeked = false;
+  char path[PATH_SIZE];
+
+  while (storedBytes > 0) {
+    segmentPath(headSegment, path);
+    const size_t segmentSize =
+        headSegment == tailSegment ? tailSize : fs.size(path);
+
+    if (unreadBytes(headSegment) == 0) {
+      if (headSegment == tailSegment)
+        break; // accounting is off; start over below
+      fs.remove(path);
+      headSegment++;
+      headPosition = 0;
+      continue;
+    }
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    const bool valid =
+        headPosition + RECORD_HEADER_SIZE <= segmentSize &&
+        fs.read(path, headPosition, header, sizeof(header)) ==
+            sizeof(header) &&
+        (header[0] == MAGIC || header[0] == MAGIC_STAMPED);
+    const uint16_t length = valid ? static_cast<uint16_t>(
+                                        (header[6] << 8) | header[7])
+                                  : 0;
+    // Stamped records carry a count byte and the stamps after the payload
+    const bool stamped = valid && header[0] == MAGIC_STAMPED;
+    const size_t stampsAt = headPosition + RECORD_HEADER_SIZE + length;
+    uint8_t stampCount = 0;
+    const bool stampsValid =
+        !stamped ||
+        (stampsAt < segmentSize &&
+         fs.read(path, stampsAt, &stampCount, 1) == 1 && stampCount > 0 &&
+         stampCount <= MQTT_SPILL_RECORD_STAMPS);
+    const size_t stampBytes = stamped ? 1 + stampCount * STAMP_SIZE : 0;
+    uint8_t stamps[MQTT_SPILL_RECORD_STAMPS * STAMP_SIZE];
+    if (!valid || length == 0 || length > MQTT_SPILL_RECORD_SIZE ||
+        !stampsValid || stampsAt + stampBytes > segmentSize ||
+        fs.read(path, headPosition + RECORD_HEADER_SIZE, payload, length) !=
+            length ||
+        (stampCount > 0 &&
+         fs.read(path, stampsAt + 1, stamps, stampCount * STAMP_SIZE) !=
+             stampCount * STAMP_SIZE)) {
+      LOG_WARN("MQTT spill: corrupt record in segment %u, skipping it",
+               (unsigned)headSegment);
+      dropHeadSegment();
+      continue;
+    }
+
+    record.port = header[1];
+    record.offset = (static_cast<uint32_t>(header[2]) << 24) |
+                    (static_cast<uint32_t>(header[3]) << 16) |
+                    (static_cast<uint32_t>(header[4]) << 8) | header[5];
+    record.length = length;
+    record.stampCount = stampCount;
+    for (size_t i = 0; i < stampCount; ++i) {
+      const uint8_t *stamp = stamps + i * STAMP_SIZE;
+      record.stamps[i].offset =
+          record.offset + static_cast<uint32_t>((stamp[0] << 8) | stamp[1]);
+      record.stamps[i].millis = (static_cast<uint32_t>(stamp[2]) << 24) |
+                                (static_cast<uint32_t>(stamp[3]) << 16) |
+                                (static_cast<uint32_t>(stamp[4]) << 8) |
+                                stamp[5];
+    }
+    peeked = true;
+    peekedSize = RECORD_HEADER_SIZE + length + stampBytes;
+    peekedLength = length;
+    return true;
+  }
+
+  if (storedBytes > 0) {
+    droppedBytes += storedBytes;
+    clear();
+  }
+  return false;
+}
+
+template <typename FileSystem> void MqttSpillQueue<FileSystem>::pop() {
+  if (!peeked)
+    return;
+  peeked = false;
+
+  const size_t length = peekedLength;
+  headPosition += peekedSize;
+  unreadBytes(headSegment) -= length;
+  storedBytes -= length;
+  if (storedBytes == 0)
+    clear(); // everything replayed: free the flash right away
+}
+
+template <typename FileSystem>
+void MqttSpillQueue<FileSystem>::dropHeadSegment() {
+  char path[PATH_SIZE];
+  segmentPath(headSegment, path);
+  fs.remove(path);
+
+  size_t &unread = unreadBytes(headSegment);
+  droppedBytes += unread;
+  storedBytes -= unread;
+  unread = 0;
+  if (headSegment == tailSegment)
+    tailSize = 0;
+  else
+    headSegment++;
+  headPosition = 0;
+  peeked = false;
+}
+
+template <typename FileSystem> void MqttSpillQueue<FileSystem>::clear() {
+  char path[PATH_SIZE];
+  for (uint32_t index = headSegment; index != tailSegment + 1; ++index) {
+    segmentPath(index, path);
+    fs.remove(path);
+  }
+  headSegment = tailSegment;
+  headPosition = 0;
+  tailSize = 0;
+  segmentBytes.fill(0);
+  storedBytes = 0;
+  peeked = false;
+}
+
+template <typename FileSystem>
+void MqttSpillQueue<FileSystem>::segmentPath(uint32_t index, char *out) {
+  snprintf(out, PATH_SIZE, "%s/%08lx", SPILL_DIRECTORY,
+           static_cast<unsigned long>(index));
+}
+} // namespace internal
+
+// Explicit instantiation for production and test builds
+template class internal::MqttSpillQueue<FileSystemPolicy>;
+} // namespace jrb::wifi_serial
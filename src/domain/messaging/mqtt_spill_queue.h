@@ -0,0 +1,163 @@
+#pragma once
+
+#include "config.h"
+#include "infrastructure/storage/file_system_policy.h"
+#include "infrastructure/types.hpp"
+#include <array>
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+namespace internal {
+/**
+ * @class MqttSpillQueue
+ * @brief Bounded flash FIFO for tty output produced while MQTT is offline.
+ * @tparam FileSystem File system policy (LittleFsFileSystem or FileSystemTest)
+ *
+ * Records are appended to numbered segment files under /spill and read back
+ * oldest first. Each record is:
+ *
+ *   byte 0     MAGIC
+ *   byte 1     port
+ *   bytes 2-5  stream offset of the first payload byte (big-endian)
+ *   bytes 6-7  payload length (big-endian)
+ *   bytes 8-   payload (up to MQTT_SPILL_RECORD_SIZE bytes)
+ *
+ * A record with line stamps (JSON output) starts with MAGIC_STAMPED and is
+ * followed by a stamp count byte and, per stamp, the payload index of a
+ * line start (2 bytes) and its arrival time in millis (4 bytes). Outage
+ * output can be replayed long after the line clock has moved on, so the
+ * times travel with the bytes. A record holds at most
+ * MQTT_SPILL_RECORD_STAMPS of them and is committed early when full.
+ *
+ * Bytes are collected in RAM and written as one record when it is full, when
+ * the port or offset changes, or after MQTT_SPILL_COMMIT_MS, so flash sees
+ * few large writes. Once MQTT_SPILL_MAX_SEGMENTS are in use the oldest
+ * segment is deleted: the queue keeps the most recent output and the dropped
+ * range shows up as an offset gap on the receiver.
+ *
+ * Not thread-safe; owned by the MQTT task.
+ */
+template <typename FileSystem> class MqttSpillQueue final {
+public:
+  struct LineStamp {
+    uint32_t offset; // stream offset of the line's first byte
+    uint32_t millis; // when it arrived
+  };
+
+  struct Record {
+    uint8_t port{0};
+    uint32_t offset{0};
+    uint16_t length{0};
+    uint8_t stampCount{0};
+    std::array<LineStamp, MQTT_SPILL_RECORD_STAMPS> stamps{};
+  };
+
+  /**
+   * @brief Mount the file system and discard segments from a previous boot
+   * @return false if no file system is available (queue stays unusable)
+   */
+  bool begin();
+
+  bool available() const { return mounted; }
+
+  /**
+   * @brief Queue tty bytes whose first byte has the given stream offset
+   */
+  void append(uint8_t port, uint32_t offset,
+              const types::span<const uint8_t> &data);
+
+  /**
+   * @brief Record that a line starts at the given offset, which is the
+   * next byte append() gets for this port
+   */
+  void stampLine(uint8_t port, uint32_t offset, uint32_t arrival);
+
+  /**
+   * @brief Write the record being collected to flash
+   */
+  void commit();
+
+  /**
+   * @brief commit() if the record being collected is older than
+   * MQTT_SPILL_COMMIT_MS
+   */
+  void commitIfDue();
+
+  /**
+   * @brief Read the oldest committed record without removing it
+   * @param payload At least MQTT_SPILL_RECORD_SIZE bytes
+   * @return false if nothing is committed
+   */
+  bool peek(Record &record, uint8_t *payload);
+
+  /**
+   * @brief Remove the record returned by the last peek()
+   *
+   * No-op if that record's segment was dropped in the meantime.
+   */
+  void pop();
+
+  bool empty() const { return storedBytes == 0 && pendingLength == 0; }
+
+  /**
+   * @brief Payload bytes queued, committed or not
+   */
+  size_t size() const { return storedBytes + pendingLength; }
+
+  /**
+   * @brief Payload bytes lost to a full queue since begin()
+   */
+  size_t dropped() const { return droppedBytes; }
+
+private:
+  static constexpr uint8_t MAGIC = 0xA5;
+  static constexpr uint8_t MAGIC_STAMPED = 0xA6;
+  static constexpr size_t RECORD_HEADER_SIZE = 8;
+  static constexpr size_t STAMP_SIZE = 6;
+  static_assert(MQTT_SPILL_RECORD_STAMPS <= 255 &&
+                    MQTT_SPILL_RECORD_STAMPS <= MQTT_LINE_STAMPS,
+                "a replayed record's stamps must fit the line clock");
+  static constexpr size_t PATH_SIZE = 24;
+
+  FileSystem fs;
+  bool mounted{false};
+
+  // Live segments are [headSegment, tailSegment]
+  uint32_t headSegment{0};
+  uint32_t tailSegment{0};
+  size_t headPosition{0}; // read position in the head segment
+  size_t tailSize{0};     // bytes written to the tail segment
+  // Unread payload bytes per live segment, indexed modulo the segment limit
+  std::array<size_t, MQTT_SPILL_MAX_SEGMENTS> segmentBytes{};
+  size_t storedBytes{0};
+  size_t droppedBytes{0};
+
+  // Record being collected (header filled in by commit())
+  std::array<uint8_t, RECORD_HEADER_SIZE + MQTT_SPILL_RECORD_SIZE + 1 +
+                         MQTT_SPILL_RECORD_STAMPS * STAMP_SIZE>
+      pending;
+  size_t pendingLength{0};
+  std::array<LineStamp, MQTT_SPILL_RECORD_STAMPS> pendingStamps;
+  size_t pendingStampCount{0};
+  uint8_t pendingPort{0};
+  uint32_t pendingOffset{0};
+  unsigned long pendingSince{0};
+
+  // Record handed out by peek()
+  bool peeked{false};
+  size_t peekedSize{0};
+  size_t peekedLength{0}; // payload bytes of that record
+
+  static void segmentPath(uint32_t index, char *out);
+  size_t &unreadBytes(uint32_t index) {
+    return segmentBytes[index % MQTT_SPILL_MAX_SEGMENTS];
+  }
+  bool writePending(size_t recordSize);
+  void dropHeadSegment();
+  void clear();
+};
+} // namespace internal
+
+using MqttSpillQueue = internal::MqttSpillQueue<FileSystemPolicy>;
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Inbound MQTT topic -> handler table with `+`/`#` wildcards
+ *
+ * Built once when subscribing, queried for every received PUBLISH. All
+ * hashing of the filters happens in add(); a lookup hashes the incoming
+ * topic once and then:
+ * - exact filters: one probe in an open-addressing index keyed by the
+ *   topic's FNV-1a hash, confirmed with a single strcmp
+ * - wildcard filters: level-by-level comparison of precomputed level hashes
+ *   and lengths; bytes are only compared on a hash hit
+ *
+ * A topic is handed to one handler: an exact filter wins, otherwise the
+ * first matching wildcard filter in registration order. As in MQTT,
+ * wildcards at the first level don't match topics starting with '$', and
+ * "a/#" also matches "a".
+ *
+ * Handlers are plain function pointers with a context pointer; they run in
+ * the caller's task (the MQTT task for MqttClient).
+ */
+template <size_t MAX_ROUTES, size_t MAX_LEVELS = 8> class MqttTopicRouter {
+public:
+  using Handler = void (*)(void *context, const char *topic,
+                           const types::span<const uint8_t> &payload);
+
+  /**
+   * @brief Register a topic filter
+   * @return false if the table is full or the filter is malformed ('#' not
+   *         last, wildcard sharing a level, more than MAX_LEVELS levels)
+   */
+  bool add(const char *filter, Handler handler, void *context = nullptr) {
+    if (count == MAX_ROUTES || !filter || !*filter || !handler)
+      return false;
+
+    Route &route = routes[count];
+    route.filter = filter;
+    route.handler = handler;
+    route.context = context;
+    if (!parseFilter(route))
+      return false;
+
+    if (!route.wildcard) {
+      for (size_t i = 0; i < count; ++i) {
+        if (!routes[i].wildcard && routes[i].hash == route.hash &&
+            routes[i].filter == route.filter)
+          return false; // duplicate exact filter
+      }
+      size_t slot = route.hash & (INDEX_SIZE - 1);
+      while (index[slot] != 0)
+        slot = (slot + 1) & (INDEX_SIZE - 1);
+      index[slot] = static_cast<uint8_t>(count + 1);
+    }
+    count++;
+    return true;
+  }
+
+  void clear() {
+    count = 0;
+    index.fill(0);
+  }
+
+  size_t size() const { return count; }
+
+  /**
+   * @brief Filter of route i, e.g. to subscribe to it
+   */
+  const char *filter(size_t i) const { return routes[i].filter.c_str(); }
+
+  /**
+   * @brief Index of the route handling topic, -1 if none
+   */
+  int match(const char *topic) const {
+    Levels levels;
+    const uint32_t hash = splitTopic(topic, levels);
+
+    size_t slot = hash & (INDEX_SIZE - 1);
+    while (index[slot] != 0) {
+      const Route &route = routes[index[slot] - 1];
+      if (route.hash == hash && route.filter == topic)
+        return index[slot] - 1;
+      slot = (slot + 1) & (INDEX_SIZE - 1);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      if (routes[i].wildcard && matchWildcard(routes[i], topic, levels))
+        return static_cast<int>(i);
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Call the handler for topic
+   * @return false if no route matches
+   */
+  bool dispatch(const char *topic,
+                const types::span<const uint8_t> &payload) const {
+    const int i = match(topic);
+    if (i < 0)
+      return false;
+    routes[i].handler(routes[i].context, topic, payload);
+    return true;
+  }
+
+private:
+  static_assert(MAX_ROUTES > 0 && MAX_ROUTES < 255,
+                "route indices are stored in a byte");
+
+  // At most half full so probe chains stay short
+  static constexpr size_t INDEX_SIZE = [] {
+    size_t n = 1;
+    while (n < 2 * MAX_ROUTES)
+      n <<= 1;
+    return n;
+  }();
+
+  enum class LevelKind : uint8_t { Literal, SingleLevel, MultiLevel };
+
+  struct Level {
+    uint32_t hash{0};
+    uint16_t start{0};
+    uint16_t length{0};
+    LevelKind kind{LevelKind::Literal};
+  };
+
+  struct Route {
+    types::string filter;
+    Handler handler{nullptr};
+    void *context{nullptr};
+    uint32_t hash{0}; // whole filter, used for exact lookups
+    bool wildcard{false};
+    uint8_t levelCount{0};
+    std::array<Level, MAX_LEVELS> levels;
+  };
+
+  // Incoming topic split into levels; count may exceed MAX_LEVELS, only the
+  // first MAX_LEVELS are recorded (deeper levels can only match '#')
+  struct Levels {
+    size_t count{0};
+    std::array<Level, MAX_LEVELS> level;
+  };
+
+  std::array<Route, MAX_ROUTES> routes;
+  std::array<uint8_t, INDEX_SIZE> index{}; // route index + 1, 0 = empty
+  size_t count{0};
+
+  static constexpr uint32_t FNV_OFFSET = 2166136261u;
+  static constexpr uint32_t FNV_PRIME = 16777619u;
+
+  /**
+   * @brief Hash the whole topic and each level in one pass
+   */
+  static uint32_t splitTopic(const char *topic, Levels &levels) {
+    uint32_t hash = FNV_OFFSET;
+    uint32_t levelHash = FNV_OFFSET;
+    size_t start = 0;
+    size_t i = 0;
+    for (;; ++i) {
+      const char c = topic[i];
+      if (c == '/' || c == '\0') {
+        if (levels.count < MAX_LEVELS) {
+          Level &level = levels.level[levels.count];
+          level.hash = levelHash;
+          level.start = static_cast<uint16_t>(start);
+          level.length = static_cast<uint16_t>(i - start);
+        }
+        levels.count++;
+        if (c == '\0')
+          break;
+        levelHash = FNV_OFFSET;
+        start = i + 1;
+      } else {
+        levelHash = (levelHash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+      }
+      hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+    }
+    return hash;
+  }
+
+  static bool parseFilter(Route &route) {
+    Levels levels;
+    route.hash = splitTopic(route.filter.c_str(), levels);
+    if (levels.count > MAX_LEVELS)
+      return false;
+
+    route.wildcard = false;
+    route.levelCount = static_cast<uint8_t>(levels.count);
+    for (size_t i = 0; i < levels.count; ++i) {
+      Level &level = route.levels[i];
+      level = levels.level[i];
+      const char *text = route.filter.c_str() + level.start;
+      const bool hasPlus = memchr(text, '+', level.length) != nullptr;
+      const bool hasHash = memchr(text, '#', level.length) != nullptr;
+      if ((hasPlus || hasHash) && level.length != 1)
+        return false;
+      if (hasHash && i + 1 != levels.count)
+        return false;
+      if (hasPlus || hasHash) {
+        level.kind = hasHash ? LevelKind::MultiLevel : LevelKind::SingleLevel;
+        route.wildcard = true;
+      }
+    }
+    return true;
+  }
+
+  static bool matchWildcard(const Route &route, const char *topic,
+                            const Levels &levels) {
+    if (topic[0] == '$' && route.levels[0].kind != LevelKind::Literal)
+      return false;
+
+    for (size_t i = 0; i < route.levelCount; ++i) {
+      const Level &pattern = route.levels[i];
+      if (pattern.kind == LevelKind::MultiLevel)
+        return true; // also matches the parent level ("a/#" vs "a")
+      if (i >= levels.count || i >= MAX_LEVELS)
+        return false;
+      if (pattern.kind == LevelKind::SingleLevel)
+        continue;
+      const Level &level = levels.level[i];
+      if (pattern.hash != level.hash || pattern.length != level.length ||
+          memcmp(route.filter.c_str() + pattern.start, topic + level.start,
+                 level.length) != 0)
+        return false;
+    }
+    return levels.count == route.levelCount;
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "config.h"
+#include "infrastructure/types.hpp"
+#include <cstdint>
+#include <cstdio>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Reassembles a chunked upload to one tty
+ *
+ * Payloads bigger than a single MQTT packet are sent as chunks on the
+ * port's upload topic:
+ *
+ *   bytes 0-1  transfer id (big-endian), must change between uploads
+ *   bytes 2-5  offset of the first data byte in the upload (big-endian)
+ *   byte  6    flags, FLAG_FINAL on the last chunk
+ *   bytes 7-   data (up to MQTT_UPLOAD_CHUNK_SIZE bytes)
+ *
+ * A chunk at offset 0 with a new id starts a transfer. Data is handed on in
+ * offset order only; each receive() returns the ack to publish, carrying the
+ * next offset the receiver expects:
+ * - Ok/Done: chunk accepted (retransmitted bytes are skipped)
+ * - Busy: the tty queue is full, resend from the acked offset later
+ * - Gap: a chunk went missing, resend from the acked offset
+ * - Unknown: no such transfer in progress, restart from offset 0
+ * - Malformed: header missing or chunk too large
+ */
+class MqttUploadReceiver {
+public:
+  static constexpr size_t HEADER_SIZE = 7;
+  static constexpr uint8_t FLAG_FINAL = 0x01;
+
+  enum class Status : uint8_t { Ok, Done, Busy, Gap, Unknown, Malformed };
+
+  struct Ack {
+    uint16_t transferId{0};
+    uint32_t offset{0}; // next byte expected
+    Status status{Status::Ok};
+  };
+
+  /**
+   * @brief Handle one chunk
+   * @param write bool(const types::span<const uint8_t> &): queue bytes for
+   *        the tty, all or nothing
+   */
+  template <typename Write>
+  Ack receive(const types::span<const uint8_t> &payload, Write &&write) {
+    if (payload.size() < HEADER_SIZE)
+      return {transferId, expected, Status::Malformed};
+
+    const uint8_t *header = payload.data();
+    const uint16_t id = static_cast<uint16_t>((header[0] << 8) | header[1]);
+    const uint32_t offset = (static_cast<uint32_t>(header[2]) << 24) |
+                            (static_cast<uint32_t>(header[3]) << 16) |
+                            (static_cast<uint32_t>(header[4]) << 8) |
+                            header[5];
+    const bool final = (header[6] & FLAG_FINAL) != 0;
+    const auto data = payload.subspan(HEADER_SIZE);
+    if (data.size() > MQTT_UPLOAD_CHUNK_SIZE)
+      return {id, id == transferId ? expected : 0, Status::Malformed};
+
+    if (offset == 0 && (!started || id != transferId)) {
+      transferId = id;
+      expected = 0;
+      started = true;
+      finished = false;
+    }
+    if (!started || id != transferId)
+      return {id, 0, Status::Unknown};
+    if (finished)
+      return {id, expected, Status::Done}; // retransmitted tail
+    if (offset > expected)
+      return {id, expected, Status::Gap};
+
+    // Resent chunks may overlap what was already written
+    const size_t skip = expected - offset;
+    if (skip < data.size()) {
+      if (!write(data.subspan(skip)))
+        return {id, expected, Status::Busy};
+      expected += static_cast<uint32_t>(data.size() - skip);
+    }
+    if (final && offset + data.size() == expected) {
+      finished = true;
+      return {id, expected, Status::Done};
+    }
+    return {id, expected, Status::Ok};
+  }
+
+  /**
+   * @brief Ack as JSON, e.g. {"id":7,"offset":960,"status":"ok","window":512}
+   * @param window Bytes the tty queue can take right now
+   * @return Length written (truncated to size - 1)
+   */
+  static size_t formatAck(const Ack &ack, size_t window, char *out,
+                          size_t size) {
+    static constexpr const char *NAMES[] = {"ok",  "done",    "busy",
+                                            "gap", "unknown", "malformed"};
+    const int n = snprintf(out, size,
+                           "{\"id\":%u,\"offset\":%lu,\"status\":\"%s\","
+                           "\"window\":%u}",
+                           static_cast<unsigned>(ack.transferId),
+                           static_cast<unsigned long>(ack.offset),
+                           NAMES[static_cast<uint8_t>(ack.status)],
+                           static_cast<unsigned>(window));
+    if (n < 0 || size == 0)
+      return 0;
+    return static_cast<size_t>(n) < size ? static_cast<size_t>(n) : size - 1;
+  }
+
+  bool inProgress() const { return started && !finished; }
+
+private:
+  uint16_t transferId{0};
+  uint32_t expected{0};
+  bool started{false};
+  bool finished{false};
+};
+
+} // namespace jrb::wifi_serial
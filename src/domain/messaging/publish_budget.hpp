@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Token bucket for the publishes of one MQTT connection
+ *
+ * Refills at RATE publishes per second up to BURST; every publish takes one
+ * token. All priority classes draw from the same bucket, but the lower ones
+ * must leave a reserve: Bulk only spends tokens above half the burst, Info
+ * above a tenth, Control may take the last one. A console flooding the
+ * broker with lines runs dry long before info and control messages do.
+ *
+ * Tokens are kept in thousandths so integer refills don't lose fractions.
+ * Callers record what they postponed (deferred) or gave up (dropped) when
+ * take() refuses; both counters only grow.
+ */
+template <uint32_t RATE, uint32_t BURST> class PublishBudget {
+public:
+  enum class Priority : uint8_t { Control, Info, Bulk };
+
+  explicit PublishBudget(unsigned long nowMs = 0) { reset(nowMs); }
+
+  /**
+   * @brief Full bucket, e.g. for a new connection
+   */
+  void reset(unsigned long nowMs) {
+    milliTokens = BURST * 1000;
+    lastRefillMs = nowMs;
+  }
+
+  /**
+   * @brief Whether take() would succeed at nowMs
+   */
+  bool available(Priority priority, unsigned long nowMs) const {
+    return refilled(nowMs) >= (reserve(priority) + 1) * 1000;
+  }
+
+  bool take(Priority priority, unsigned long nowMs) {
+    milliTokens = refilled(nowMs);
+    lastRefillMs = nowMs;
+    if (milliTokens < (reserve(priority) + 1) * 1000)
+      return false;
+    milliTokens -= 1000;
+    return true;
+  }
+
+  void countDeferred() { deferredCount++; }
+  void countDropped() { droppedCount++; }
+  uint32_t deferred() const { return deferredCount; }
+  uint32_t dropped() const { return droppedCount; }
+
+  uint32_t tokens(unsigned long nowMs) const { return refilled(nowMs) / 1000; }
+
+private:
+  static_assert(RATE > 0 && BURST >= 10, "budget too small for its reserves");
+
+  uint32_t milliTokens{0};
+  unsigned long lastRefillMs{0};
+  uint32_t deferredCount{0};
+  uint32_t droppedCount{0};
+
+  static constexpr uint32_t reserve(Priority priority) {
+    return priority == Priority::Bulk   ? BURST / 2
+           : priority == Priority::Info ? BURST / 10
+                                        : 0;
+  }
+
+  uint32_t refilled(unsigned long nowMs) const {
+    // RATE tokens per second = RATE thousandths per millisecond
+    const uint64_t added = static_cast<uint64_t>(nowMs - lastRefillMs) * RATE;
+    return static_cast<uint32_t>(std::min<uint64_t>(
+        milliTokens + added, static_cast<uint64_t>(BURST) * 1000));
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "infrastructure/logging/logger.h"
+#include "infrastructure/types.hpp"
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Info topic document kept as pre-rendered `"key":value` fragments
+ *
+ * Every setter renders its field and compares it with the cached fragment;
+ * only a different value replaces the fragment and sets the field's dirty
+ * bit. delta() joins the dirty fragments, full() all of them, and full() is
+ * only re-joined when a field changed since the last call. The dirty bits
+ * stay set until markPublished(), so a publish that fails is retried with
+ * the same fields. Strings keep
+ * their capacity, so once every field has been seen publishing doesn't
+ * allocate.
+ *
+ * Keys are stored by pointer and must outlive the document (string
+ * literals). Fields appear in the order they were first set; a new field
+ * past MAX_FIELDS is refused, and the first refusal is logged.
+ */
+template <size_t MAX_FIELDS> class TelemetryDocument {
+public:
+  TelemetryDocument() {
+    scratch.reserve(64);
+    fullText.reserve(1024);
+    deltaText.reserve(256);
+  }
+
+  bool setString(const char *key, const char *value) {
+    scratch.clear();
+    appendKey(key);
+    scratch += '"';
+    for (const char *c = value; *c; ++c) {
+      if (*c == '"' || *c == '\\') {
+        scratch += '\\';
+        scratch += *c;
+      } else if (static_cast<uint8_t>(*c) < 0x20) {
+        char escaped[8];
+        snprintf(escaped, sizeof(escaped), "\\u%04x",
+                 static_cast<unsigned>(*c));
+        scratch += escaped;
+      } else {
+        scratch += *c;
+      }
+    }
+    scratch += '"';
+    return store(key);
+  }
+
+  bool setNumber(const char *key, long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%ld", value);
+    scratch.clear();
+    appendKey(key);
+    scratch += text;
+    return store(key);
+  }
+
+  bool setBool(const char *key, bool value) {
+    scratch.clear();
+    appendKey(key);
+    scratch += value ? "true" : "false";
+    return store(key);
+  }
+
+  /**
+   * @brief Any field changed since the last markPublished()
+   */
+  bool changed() const { return dirty != 0; }
+
+  /**
+   * @brief Object with the fields changed since the last markPublished()
+   */
+  const types::string &delta() {
+    deltaText.clear();
+    deltaText += '{';
+    for (size_t i = 0; i < count; ++i) {
+      if (!(dirty & (uint64_t{1} << i)))
+        continue;
+      if (deltaText.size() > 1)
+        deltaText += ',';
+      deltaText += fields[i].fragment;
+    }
+    deltaText += '}';
+    return deltaText;
+  }
+
+  /**
+   * @brief Object with every field
+   */
+  const types::string &full() {
+    if (fullStale) {
+      fullText.clear();
+      fullText += '{';
+      for (size_t i = 0; i < count; ++i) {
+        if (i > 0)
+          fullText += ',';
+        fullText += fields[i].fragment;
+      }
+      fullText += '}';
+      fullStale = false;
+    }
+    return fullText;
+  }
+
+  /**
+   * @brief The last delta() or full() reached the broker
+   *
+   * After full() this also drops pending deltas: the full document
+   * superseded them.
+   */
+  void markPublished() { dirty = 0; }
+
+  size_t size() const { return count; }
+
+private:
+  static_assert(MAX_FIELDS <= 64, "dirty bits are kept in a uint64_t");
+
+  struct Field {
+    const char *key{nullptr};
+    types::string fragment;
+  };
+
+  std::array<Field, MAX_FIELDS> fields;
+  size_t count{0};
+  uint64_t dirty{0};
+  bool fullStale{true};
+  bool refusedLogged{false};
+  types::string scratch;
+  types::string fullText;
+  types::string deltaText;
+
+  void appendKey(const char *key) {
+    scratch += '"';
+    scratch += key;
+    scratch += "\":";
+  }
+
+  // Swap scratch in if the field's fragment differs
+  bool store(const char *key) {
+    size_t i = 0;
+    while (i < count && fields[i].key != key && strcmp(fields[i].key, key) != 0)
+      ++i;
+    if (i == count) {
+      if (count == MAX_FIELDS) {
+        if (!refusedLogged)
+          LOG_WARN("Telemetry: no room for field %s (%u fields)", key,
+                   (unsigned)MAX_FIELDS);
+        refusedLogged = true;
+        return false;
+      }
+      fields[count++].key = key;
+    } else if (fields[i].fragment == scratch) {
+      return true;
+    }
+    fields[i].fragment.swap(scratch);
+    dirty |= uint64_t{1} << i;
+    fullStale = true;
+    return true;
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,198 @@
+/**
+ * @file tty_compression.h
+ * @brief Small-window streaming LZSS codec for framed tty payloads.
+ *
+ * Both ends keep the last WINDOW_SIZE bytes of the stream, so a match may
+ * point into earlier publishes. That is where the gain comes from: a single
+ * 256-byte frame of console output rarely repeats itself, but it repeats the
+ * previous frames (timestamps, unit names, prompts) all the time.
+ *
+ * Compressed payload: a control byte announces the next 8 tokens, LSB first
+ * (0 = literal byte, 1 = match). A match is 2 bytes, big-endian:
+ *
+ *   bits 15-6  distance - 1  (1..WINDOW_SIZE bytes back)
+ *   bits 5-0   length - MIN_MATCH
+ *
+ * Encoder RAM: WINDOW_SIZE + 2 * HASH_SIZE bytes (2 KB). No allocation, no
+ * platform dependencies; the decompressor is for host tools.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jrb::wifi_serial::tty_compression {
+
+constexpr size_t WINDOW_BITS = 10;
+constexpr size_t WINDOW_SIZE = size_t{1} << WINDOW_BITS;
+constexpr size_t MIN_MATCH = 3;
+constexpr size_t MAX_MATCH = MIN_MATCH + 63;
+
+/**
+ * @brief Worst case output size for n input bytes (all literals)
+ */
+constexpr size_t maxCompressedSize(size_t n) { return n + (n + 7) / 8; }
+
+class Compressor {
+public:
+  static constexpr size_t HASH_BITS = 9;
+  static constexpr size_t HASH_SIZE = size_t{1} << HASH_BITS;
+
+  /**
+   * @brief Forget the history; the next payload only references itself
+   */
+  void reset() { position = 0; }
+
+  /**
+   * @brief Bytes of history since the last reset
+   */
+  uint32_t historySize() const { return position; }
+
+  /**
+   * @brief Compress a chunk and append it to the history
+   * @param out At least maxCompressedSize(length) bytes
+   * @return Bytes written to out
+   *
+   * The history is updated even if the caller ends up sending the chunk
+   * uncompressed, which is exactly what the decompressor's absorb() does.
+   */
+  size_t compress(const uint8_t *in, size_t length, uint8_t *out) {
+    size_t written = 0;
+    size_t control = 0;
+    uint8_t bit = 8;
+
+    for (size_t i = 0; i < length;) {
+      if (bit == 8) {
+        control = written++;
+        out[control] = 0;
+        bit = 0;
+      }
+
+      size_t matchLength = 0;
+      size_t distance = 0;
+      if (i + MIN_MATCH <= length) {
+        const size_t slot = hash(in + i);
+        distance = static_cast<uint16_t>(position - hashTable[slot]);
+        hashTable[slot] = static_cast<uint16_t>(position);
+        if (distance > 0 && distance <= WINDOW_SIZE && distance <= position)
+          matchLength = matchAt(in + i, length - i, distance);
+      }
+
+      if (matchLength >= MIN_MATCH) {
+        const uint16_t token = static_cast<uint16_t>(
+            ((distance - 1) << 6) | (matchLength - MIN_MATCH));
+        out[control] |= static_cast<uint8_t>(1u << bit);
+        out[written++] = static_cast<uint8_t>(token >> 8);
+        out[written++] = static_cast<uint8_t>(token);
+        // Index the covered positions too: next line's match often starts
+        // inside this one
+        for (size_t k = 0; k < matchLength; ++k) {
+          if (k > 0 && i + k + MIN_MATCH <= length)
+            hashTable[hash(in + i + k)] = static_cast<uint16_t>(position);
+          push(in[i + k]);
+        }
+        i += matchLength;
+      } else {
+        out[written++] = in[i];
+        push(in[i]);
+        i++;
+      }
+      bit++;
+    }
+    return written;
+  }
+
+private:
+  std::array<uint8_t, WINDOW_SIZE> window{};
+  std::array<uint16_t, HASH_SIZE> hashTable{};
+  // Stream bytes since reset(). Hash entries hold it modulo 2^16; stale or
+  // aliased entries are harmless because every candidate is verified below.
+  uint32_t position{0};
+
+  void push(uint8_t byte) {
+    window[position & (WINDOW_SIZE - 1)] = byte;
+    position++;
+  }
+
+  size_t matchAt(const uint8_t *in, size_t available, size_t distance) const {
+    const size_t limit = available < MAX_MATCH ? available : MAX_MATCH;
+    size_t n = 0;
+    while (n < limit) {
+      // Overlapping matches read bytes of this chunk not yet pushed
+      const uint8_t source =
+          n < distance ? window[(position - distance + n) & (WINDOW_SIZE - 1)]
+                       : in[n - distance];
+      if (source != in[n])
+        break;
+      n++;
+    }
+    return n;
+  }
+
+  static size_t hash(const uint8_t *p) {
+    const uint32_t v = (static_cast<uint32_t>(p[0]) << 16) |
+                       (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+  }
+};
+
+class Decompressor {
+public:
+  void reset() { position = 0; }
+
+  /**
+   * @brief Add bytes that were sent uncompressed to the history
+   */
+  void absorb(const uint8_t *in, size_t length) {
+    for (size_t i = 0; i < length; ++i)
+      push(in[i]);
+  }
+
+  /**
+   * @brief Expand one payload, appending to out
+   * @return false on a malformed payload or a reference before the history
+   */
+  bool decompress(const uint8_t *in, size_t length, std::vector<uint8_t> &out) {
+    size_t i = 0;
+    while (i < length) {
+      const uint8_t control = in[i++];
+      for (uint8_t bit = 0; bit < 8 && i < length; ++bit) {
+        if (!(control & (1u << bit))) {
+          out.push_back(in[i]);
+          push(in[i++]);
+          continue;
+        }
+        if (i + 2 > length)
+          return false;
+        const uint16_t token =
+            static_cast<uint16_t>((in[i] << 8) | in[i + 1]);
+        i += 2;
+        const size_t distance = (token >> 6) + 1;
+        const size_t matchLength = (token & 0x3F) + MIN_MATCH;
+        if (distance > position)
+          return false;
+        for (size_t k = 0; k < matchLength; ++k) {
+          const uint8_t byte =
+              window[(position - distance) & (WINDOW_SIZE - 1)];
+          out.push_back(byte);
+          push(byte);
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  std::array<uint8_t, WINDOW_SIZE> window{};
+  uint32_t position{0};
+
+  void push(uint8_t byte) {
+    window[position & (WINDOW_SIZE - 1)] = byte;
+    position++;
+  }
+};
+
+} // namespace jrb::wifi_serial::tty_compression
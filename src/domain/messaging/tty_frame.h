@@ -0,0 +1,68 @@
+/**
+ * @file tty_frame.h
+ * @brief Wire format of framed MQTT tty publishes.
+ *
+ * With framing enabled each publish on a tty tx topic is:
+ *
+ *   byte 0     version (high nibble) | port (low nibble)
+ *   byte 1     flags
+ *   bytes 2-5  stream offset of the first payload byte (big-endian, wraps)
+ *   bytes 6-   payload (any number of lines, possibly partial)
+ *
+ * With FLAG_COMPRESSED the payload is tty_compression data and the offset
+ * still counts uncompressed bytes. Compressed payloads may reference any
+ * byte sent on the port since the last FLAG_HISTORY_RESET frame, so after a
+ * loss a receiver waits for the next reset to decode again.
+ *
+ * Offsets count every byte the tty produced, including bytes the bridge
+ * had to drop, so a receiver can reassemble the stream and report missing
+ * ranges exactly (see TtyFrameDecoder). Platform-neutral on purpose: host
+ * tools include this header as-is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jrb::wifi_serial::tty_frame {
+
+constexpr uint8_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 6;
+constexpr uint8_t MAX_PORT = 0x0F;
+
+// Header flags
+constexpr uint8_t FLAG_STREAM_START = 0x01; // first frame since device boot
+constexpr uint8_t FLAG_COMPRESSED = 0x02;   // payload is tty_compression data
+constexpr uint8_t FLAG_HISTORY_RESET = 0x04; // compression history restarts here
+
+struct Header {
+  uint8_t port{0};
+  uint8_t flags{0};
+  uint32_t offset{0};
+};
+
+inline void encodeHeader(const Header &header, uint8_t *out) {
+  out[0] = static_cast<uint8_t>((VERSION << 4) | (header.port & MAX_PORT));
+  out[1] = header.flags;
+  out[2] = static_cast<uint8_t>(header.offset >> 24);
+  out[3] = static_cast<uint8_t>(header.offset >> 16);
+  out[4] = static_cast<uint8_t>(header.offset >> 8);
+  out[5] = static_cast<uint8_t>(header.offset);
+}
+
+/**
+ * @return false if the payload is too short or has an unknown version
+ */
+inline bool decodeHeader(const uint8_t *in, size_t length, Header &header) {
+  if (length < HEADER_SIZE || (in[0] >> 4) != VERSION)
+    return false;
+  header.port = in[0] & MAX_PORT;
+  header.flags = in[1];
+  header.offset = (static_cast<uint32_t>(in[2]) << 24) |
+                  (static_cast<uint32_t>(in[3]) << 16) |
+                  (static_cast<uint32_t>(in[4]) << 8) | in[5];
+  return true;
+}
+
+} // namespace jrb::wifi_serial::tty_frame
@@ -0,0 +1,170 @@
+/**
+ * @file tty_frame_decoder.h
+ * @brief Host-side reassembly of framed MQTT tty publishes.
+ *
+ * Feed the payload of every message received on a framed tx topic to
+ * feed(). The decoder hands out the tty stream in order and reports:
+ * - gaps: byte ranges the bridge produced but never delivered
+ * - restarts: the device rebooted and its offsets started over
+ * - duplicates: bytes already delivered (trimmed, never handed out twice)
+ *
+ * Compressed frames are expanded against the port's history. A compressed
+ * frame that can't be decoded (history incomplete after a loss) is skipped;
+ * its range is reported as part of the gap in front of the next frame that
+ * can.
+ *
+ * Only depends on the standard library so log pipelines and CLI tools can
+ * include it directly (see tty_frame.h for the wire format).
+ */
+
+#pragma once
+
+#include "tty_compression.h"
+#include "tty_frame.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace jrb::wifi_serial {
+
+class TtyFrameDecoder {
+public:
+  using DataHandler =
+      std::function<void(uint8_t port, const uint8_t *data, size_t length)>;
+  using GapHandler =
+      std::function<void(uint8_t port, uint32_t offset, uint32_t length)>;
+  using RestartHandler = std::function<void(uint8_t port)>;
+
+  struct Stats {
+    uint64_t frames{0};
+    uint64_t bytes{0};
+    uint64_t gaps{0};
+    uint64_t lostBytes{0};
+    uint64_t duplicateBytes{0};
+    uint64_t restarts{0};
+    uint64_t malformed{0};
+    uint64_t undecodable{0}; // compressed frames skipped for lack of history
+    uint64_t compressedBytes{0}; // compressed payload bytes received
+  };
+
+  void onData(DataHandler handler) { dataHandler = std::move(handler); }
+  void onGap(GapHandler handler) { gapHandler = std::move(handler); }
+  void onRestart(RestartHandler handler) { restartHandler = std::move(handler); }
+
+  /**
+   * @brief Process one MQTT payload
+   * @return false if the payload is not a valid frame (ignored)
+   */
+  bool feed(const uint8_t *payload, size_t length) {
+    tty_frame::Header header;
+    if (!tty_frame::decodeHeader(payload, length, header)) {
+      counters.malformed++;
+      return false;
+    }
+    counters.frames++;
+
+    const uint8_t *data = payload + tty_frame::HEADER_SIZE;
+    size_t size = length - tty_frame::HEADER_SIZE;
+    Port &port = ports[header.port];
+    const bool historyReset = header.flags & tty_frame::FLAG_HISTORY_RESET;
+
+    if (header.flags & tty_frame::FLAG_STREAM_START) {
+      if (port.synced) {
+        counters.restarts++;
+        if (restartHandler)
+          restartHandler(header.port);
+      }
+      // Everything the device produced since boot is expected
+      port.synced = true;
+      port.expected = 0;
+    } else if (!port.synced) {
+      // Joined mid-stream: nothing before this frame is owed to us
+      port.synced = true;
+      port.expected = header.offset;
+    }
+
+    if (historyReset) {
+      port.history.reset();
+      port.historyValid = true;
+    }
+
+    const int32_t delta = static_cast<int32_t>(header.offset - port.expected);
+    if (delta > 0 && !historyReset) {
+      // The missing bytes were part of the sender's history
+      port.historyValid = false;
+    }
+
+    const bool compressed = header.flags & tty_frame::FLAG_COMPRESSED;
+    if (compressed) {
+      counters.compressedBytes += size;
+      // Without a reset, the payload refers to a history that ended at its
+      // offset; ours already runs past it. The sender resets the history on
+      // every resend that doesn't continue it, so this is a plain duplicate.
+      if (delta < 0 && !historyReset)
+        return true;
+      if (!port.historyValid) {
+        counters.undecodable++;
+        return true;
+      }
+      scratch.clear();
+      if (!port.history.decompress(data, size, scratch)) {
+        counters.malformed++;
+        port.historyValid = false;
+        return false;
+      }
+      data = scratch.data();
+      size = scratch.size();
+    }
+
+    uint32_t offset = header.offset;
+    size_t seen = 0;
+    if (delta > 0) {
+      counters.gaps++;
+      counters.lostBytes += static_cast<uint32_t>(delta);
+      if (gapHandler)
+        gapHandler(header.port, port.expected, static_cast<uint32_t>(delta));
+    } else if (delta < 0) {
+      seen = std::min<size_t>(static_cast<uint32_t>(-delta), size);
+      counters.duplicateBytes += seen;
+    }
+
+    // A history restarted by this frame needs all of it, duplicates included;
+    // otherwise it already holds the bytes seen before
+    if (port.historyValid && !compressed) {
+      const size_t from = historyReset ? 0 : seen;
+      port.history.absorb(data + from, size - from);
+    }
+    data += seen;
+    size -= seen;
+    offset += static_cast<uint32_t>(seen);
+    if (size == 0)
+      return true;
+
+    counters.bytes += size;
+    if (dataHandler)
+      dataHandler(header.port, data, size);
+    port.expected = offset + static_cast<uint32_t>(size);
+    return true;
+  }
+
+  const Stats &stats() const { return counters; }
+
+private:
+  struct Port {
+    bool synced{false};
+    uint32_t expected{0};
+    bool historyValid{false};
+    tty_compression::Decompressor history;
+  };
+
+  std::array<Port, tty_frame::MAX_PORT + 1> ports;
+  Stats counters;
+  std::vector<uint8_t> scratch;
+  DataHandler dataHandler;
+  GapHandler gapHandler;
+  RestartHandler restartHandler;
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,238 @@
+/**
+ * @file tty_json.h
+ * @brief Line records of JSON tty publishes.
+ *
+ * With JSON output each publish on a tty tx topic is an array of records,
+ * one per line:
+ *
+ *   [{"ts":81234,"port":1,"seq":5120,"line":"login: "},...]
+ *
+ *   ts       device uptime in ms when the line's first byte reached the
+ *            bridge
+ *   port     tty port
+ *   seq      stream offset of the record's first byte (the offsets framed
+ *            output uses, so gaps are detectable the same way)
+ *   line     the line without its "\n" or "\r\n"
+ *   partial  only present, as true, when the line continues in the next
+ *            record: it didn't end before the publish or the batch filled
+ *
+ * Text is escaped per RFC 8259. Bytes that aren't valid UTF-8 (including a
+ * character split between two records) become U+FFFD, so every payload
+ * parses. Platform-neutral on purpose: host tools include this header as-is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial::tty_json {
+
+/**
+ * @brief Appends records to a caller-owned buffer; never allocates
+ *
+ * Space for closing the open record and the array is kept free at all
+ * times, so whatever fits is always a complete document.
+ */
+class BatchWriter {
+public:
+  // Room to close a record and the array: " ,"partial":true } ]
+  static constexpr size_t CLOSE_SIZE = 18;
+  // Longest record without text
+  static constexpr size_t MAX_HEADER_SIZE =
+      sizeof(",{\"ts\":4294967295,\"port\":255,\"seq\":4294967295,\"line\":\"") -
+      1;
+
+  BatchWriter(uint8_t *out, size_t capacity) : out{out}, capacity{capacity} {}
+
+  /**
+   * @return false if the record doesn't fit; the batch is unchanged
+   */
+  bool beginRecord(uint32_t ts, uint8_t port, uint32_t seq) {
+    if (length + MAX_HEADER_SIZE + CLOSE_SIZE > capacity)
+      return false;
+    recordStart = length;
+    put(records == 0 ? '[' : ',');
+    putLiteral("{\"ts\":");
+    putNumber(ts);
+    putLiteral(",\"port\":");
+    putNumber(port);
+    putLiteral(",\"seq\":");
+    putNumber(seq);
+    putLiteral(",\"line\":\"");
+    records++;
+    return true;
+  }
+
+  /**
+   * @brief Escape as much of the line text as fits
+   * @return Input bytes consumed; a character is never split
+   */
+  size_t appendText(const uint8_t *text, size_t size) {
+    size_t used = 0;
+    while (used < size) {
+      const uint8_t byte = text[used];
+      if (byte >= 0x20 && byte < 0x80 && byte != '"' && byte != '\\') {
+        if (free() < 1)
+          break;
+        put(static_cast<char>(byte));
+        used++;
+        continue;
+      }
+      if (byte < 0x80) {
+        if (!putEscape(byte))
+          break;
+        used++;
+        continue;
+      }
+      const size_t sequence = utf8Length(text + used, size - used);
+      if (sequence == 0) {
+        if (free() < 6)
+          break;
+        putLiteral("\\ufffd");
+        used++;
+        continue;
+      }
+      if (free() < sequence)
+        break;
+      memcpy(out + length, text + used, sequence);
+      length += sequence;
+      used += sequence;
+    }
+    return used;
+  }
+
+  void endRecord(bool partial) {
+    put('"');
+    if (partial)
+      putLiteral(",\"partial\":true");
+    put('}');
+  }
+
+  /**
+   * @brief Drop the open record, e.g. when none of its text fit
+   */
+  void cancelRecord() {
+    length = recordStart;
+    records--;
+  }
+
+  /**
+   * @return Length of the finished document, 0 for an empty batch
+   */
+  size_t finish() {
+    if (records == 0)
+      return 0;
+    put(']');
+    return length;
+  }
+
+  size_t recordCount() const { return records; }
+
+private:
+  uint8_t *out;
+  size_t capacity;
+  size_t length{0};
+  size_t recordStart{0};
+  size_t records{0};
+
+  // Text space left once the record and the array are closed
+  size_t free() const {
+    return capacity > length + CLOSE_SIZE ? capacity - length - CLOSE_SIZE : 0;
+  }
+
+  void put(char c) { out[length++] = static_cast<uint8_t>(c); }
+
+  template <size_t N> void putLiteral(const char (&text)[N]) {
+    memcpy(out + length, text, N - 1);
+    length += N - 1;
+  }
+
+  void putNumber(uint32_t value) {
+    char digits[10];
+    size_t count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (count > 0)
+      put(digits[--count]);
+  }
+
+  bool putEscape(uint8_t byte) {
+    char shortForm = 0;
+    switch (byte) {
+    case '"':
+      shortForm = '"';
+      break;
+    case '\\':
+      shortForm = '\\';
+      break;
+    case '\b':
+      shortForm = 'b';
+      break;
+    case '\f':
+      shortForm = 'f';
+      break;
+    case '\n':
+      shortForm = 'n';
+      break;
+    case '\r':
+      shortForm = 'r';
+      break;
+    case '\t':
+      shortForm = 't';
+      break;
+    default:
+      break;
+    }
+    if (shortForm != 0) {
+      if (free() < 2)
+        return false;
+      put('\\');
+      put(shortForm);
+      return true;
+    }
+    if (free() < 6)
+      return false;
+    static constexpr char HEX[] = "0123456789abcdef";
+    putLiteral("\\u00");
+    put(HEX[byte >> 4]);
+    put(HEX[byte & 0x0F]);
+    return true;
+  }
+
+  // Length of the well-formed UTF-8 sequence at text, 0 if there is none
+  static size_t utf8Length(const uint8_t *text, size_t size) {
+    const uint8_t lead = text[0];
+    size_t sequence = 0;
+    uint8_t low = 0x80, high = 0xBF; // range of the second byte
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      sequence = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      sequence = 3;
+      if (lead == 0xE0)
+        low = 0xA0; // overlong
+      else if (lead == 0xED)
+        high = 0x9F; // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      sequence = 4;
+      if (lead == 0xF0)
+        low = 0x90; // overlong
+      else if (lead == 0xF4)
+        high = 0x8F; // beyond U+10FFFF
+    } else {
+      return 0;
+    }
+    if (size < sequence || text[1] < low || text[1] > high)
+      return 0;
+    for (size_t i = 2; i < sequence; ++i) {
+      if ((text[i] & 0xC0) != 0x80)
+        return 0;
+    }
+    return sequence;
+  }
+};
+
+} // namespace jrb::wifi_serial::tty_json
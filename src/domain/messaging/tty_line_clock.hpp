@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Arrival times of a port's recent lines, by stream offset
+ *
+ * The MQTT task stamps each line start as it moves tty output into the
+ * stream and looks the times up again when the lines are published, which
+ * can be seconds later. Once SIZE lines are stamped the oldest stamp is
+ * overwritten; a line older than every stamp kept gets the oldest time
+ * still known.
+ */
+template <size_t SIZE> class TtyLineClock {
+public:
+  void stamp(uint32_t offset, uint32_t millis) {
+    entries[(first + count) % SIZE] = {offset, millis};
+    if (count < SIZE)
+      count++;
+    else
+      first = (first + 1) % SIZE;
+  }
+
+  /**
+   * @brief Arrival time of the line holding the byte at offset
+   * @param fallback Returned when nothing has been stamped
+   */
+  uint32_t arrival(uint32_t offset, uint32_t fallback) const {
+    if (count == 0)
+      return fallback;
+    // Newest first: lines are published soon after they are stamped
+    for (size_t i = count; i-- > 0;) {
+      const Entry &entry = entries[(first + i) % SIZE];
+      if (static_cast<int32_t>(offset - entry.offset) >= 0)
+        return entry.millis;
+    }
+    return entries[first].millis;
+  }
+
+  size_t size() const { return count; }
+
+private:
+  struct Entry {
+    uint32_t offset;
+    uint32_t millis;
+  };
+  Entry entries[SIZE]{};
+  size_t first{0};
+  size_t count{0};
+};
+
+} // namespace jrb::wifi_serial
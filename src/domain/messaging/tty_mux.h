@@ -0,0 +1,116 @@
+/**
+ * @file tty_mux.h
+ * @brief Wire format of multiplexed MQTT tty publishes.
+ *
+ * With multiplexing one topic pair carries every port. Each publish is a
+ * sequence of sections, back to back:
+ *
+ *   byte 0     port
+ *   bytes 1-2  section length n (big-endian)
+ *   bytes 3-   n bytes of section data
+ *
+ * On the mux tx topic every section is one tty_frame (header included), so
+ * offsets, gap detection and compression work per port exactly as on the
+ * per-port framed topics (see TtyMuxDecoder). On the mux rx topic sections
+ * are raw bytes for the port's UART.
+ *
+ * Platform-neutral on purpose: host tools include this header as-is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial::tty_mux {
+
+constexpr size_t SECTION_HEADER_SIZE = 3;
+constexpr size_t MAX_SECTION_SIZE = 0xFFFF;
+
+struct Section {
+  uint8_t port{0};
+  const uint8_t *data{nullptr};
+  size_t size{0};
+};
+
+/**
+ * @brief Appends sections to a caller-owned buffer; never allocates
+ */
+class Writer {
+public:
+  Writer(uint8_t *out, size_t capacity) : out{out}, capacity{capacity} {}
+
+  bool fits(size_t size) const {
+    return size <= MAX_SECTION_SIZE &&
+           length + SECTION_HEADER_SIZE + size <= capacity;
+  }
+
+  /**
+   * @return false if the section doesn't fit; the payload is unchanged
+   */
+  bool append(uint8_t port, const uint8_t *data, size_t size) {
+    if (!fits(size))
+      return false;
+    out[length] = port;
+    out[length + 1] = static_cast<uint8_t>(size >> 8);
+    out[length + 2] = static_cast<uint8_t>(size);
+    memcpy(out + length + SECTION_HEADER_SIZE, data, size);
+    length += SECTION_HEADER_SIZE + size;
+    count++;
+    return true;
+  }
+
+  void clear() {
+    length = 0;
+    count = 0;
+  }
+
+  const uint8_t *data() const { return out; }
+  size_t size() const { return length; }
+  size_t sections() const { return count; }
+  bool empty() const { return count == 0; }
+
+private:
+  uint8_t *out;
+  size_t capacity;
+  size_t length{0};
+  size_t count{0};
+};
+
+/**
+ * @brief Walks the sections of one payload without copying
+ */
+class Reader {
+public:
+  Reader(const uint8_t *in, size_t length) : in{in}, length{length} {}
+
+  /**
+   * @return false at the end of the payload or at a truncated section
+   */
+  bool next(Section &section) {
+    if (length - position < SECTION_HEADER_SIZE)
+      return false;
+    const size_t size = (static_cast<size_t>(in[position + 1]) << 8) |
+                        in[position + 2];
+    if (length - position - SECTION_HEADER_SIZE < size)
+      return false;
+    section.port = in[position];
+    section.data = in + position + SECTION_HEADER_SIZE;
+    section.size = size;
+    position += SECTION_HEADER_SIZE + size;
+    return true;
+  }
+
+  /**
+   * @brief Whether next() stopped before the end of the payload
+   */
+  bool malformed() const { return position != length; }
+
+private:
+  const uint8_t *in;
+  size_t length;
+  size_t position{0};
+};
+
+} // namespace jrb::wifi_serial::tty_mux
@@ -0,0 +1,72 @@
+/**
+ * @file tty_mux_decoder.h
+ * @brief Host-side demultiplexing of the mux tx topic.
+ *
+ * Feed the payload of every message received on the mux tx topic to
+ * feed(). Each section's frame goes through one TtyFrameDecoder, so the
+ * handlers registered on frames() see every port's stream with the same
+ * gap, restart and duplicate reporting as the per-port framed topics.
+ *
+ * Host tools that write to the device build mux rx payloads with
+ * tty_mux::Writer, one section per port.
+ *
+ * Only depends on the standard library (see tty_mux.h for the wire format).
+ */
+
+#pragma once
+
+#include "tty_frame_decoder.h"
+#include "tty_mux.h"
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+
+class TtyMuxDecoder {
+public:
+  struct Stats {
+    uint64_t publishes{0};
+    uint64_t sections{0};
+    uint64_t malformed{0}; // truncated payloads and mislabeled sections
+  };
+
+  /**
+   * @brief Per-port reassembly; register onData/onGap/onRestart here
+   */
+  TtyFrameDecoder &frames() { return decoder; }
+
+  /**
+   * @brief Process one MQTT payload
+   * @return false if any part of it was malformed (the rest is still used)
+   */
+  bool feed(const uint8_t *payload, size_t length) {
+    counters.publishes++;
+    bool valid = true;
+    tty_mux::Reader reader(payload, length);
+    tty_mux::Section section;
+    while (reader.next(section)) {
+      counters.sections++;
+      tty_frame::Header header;
+      // The frame names its port too; a section that disagrees is corrupt
+      if (!tty_frame::decodeHeader(section.data, section.size, header) ||
+          header.port != section.port) {
+        counters.malformed++;
+        valid = false;
+        continue;
+      }
+      valid = decoder.feed(section.data, section.size) && valid;
+    }
+    if (reader.malformed()) {
+      counters.malformed++;
+      valid = false;
+    }
+    return valid;
+  }
+
+  const Stats &stats() const { return counters; }
+
+private:
+  TtyFrameDecoder decoder;
+  Stats counters;
+};
+
+} // namespace jrb::wifi_serial
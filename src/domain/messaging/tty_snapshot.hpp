@@ -0,0 +1,46 @@
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include "infrastructure/memory/circular_buffer.hpp"
+#include <algorithm>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Most recent output of one tty, published as a retained message
+ *
+ * Keeps the last SIZE bytes and whether any arrived since the last publish.
+ * render() rotates the ring in place so the snapshot can be published
+ * straight from it, without a second SIZE-byte buffer.
+ */
+template <size_t SIZE>
+class TtySnapshot : public CircularBuffer<uint8_t, SIZE> {
+public:
+  bool dirty() const { return this->hasNewData; }
+  void markPublished() { this->hasNewData = false; }
+
+  /**
+   * @brief Snapshot contents, oldest byte first
+   *
+   * Once older output has been overwritten the first line is usually torn,
+   * so the snapshot then starts after the first newline (if there is one).
+   */
+  types::span<const uint8_t> render() {
+    std::rotate(this->buffer.begin(), this->buffer.begin() + this->tail,
+                this->buffer.end());
+    this->tail = 0;
+    this->head = this->size_field & (SIZE - 1);
+
+    size_t start = 0;
+    if (this->full()) {
+      const auto newline =
+          std::find(this->buffer.begin(), this->buffer.end(), '\n');
+      if (newline != this->buffer.end() && newline + 1 != this->buffer.end())
+        start = static_cast<size_t>(newline - this->buffer.begin()) + 1;
+    }
+    return types::span<const uint8_t>(this->buffer.data() + start,
+                                      this->size_field - start);
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,184 @@
+#include "ssh_authorized_keys.h"
+#include "infrastructure/logging/logger.h"
+#include <cstring>
+
+namespace jrb::wifi_serial {
+namespace internal {
+namespace {
+
+// Key types libssh accepts for user authentication
+constexpr const char *AUTHORIZED_KEY_TYPES[] = {
+    "ssh-ed25519", "ecdsa-sha2-nistp256", "ecdsa-sha2-nistp384",
+    "ecdsa-sha2-nistp521", "ssh-rsa"};
+
+bool isKeyType(const char *token, size_t length) {
+  for (const char *type : AUTHORIZED_KEY_TYPES) {
+    if (strlen(type) == length && memcmp(type, token, length) == 0)
+      return true;
+  }
+  return false;
+}
+
+int base64Value(char c) {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 26;
+  if (c >= '0' && c <= '9')
+    return c - '0' + 52;
+  if (c == '+')
+    return 62;
+  if (c == '/')
+    return 63;
+  return -1;
+}
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+} // namespace
+
+bool decodeBase64(const char *text, size_t length,
+                  std::vector<uint8_t> &out) {
+  out.clear();
+  while (length > 0 && text[length - 1] == '=')
+    length--;
+  if (length % 4 == 1)
+    return false;
+  out.reserve(length * 3 / 4);
+  uint32_t bits = 0;
+  int count = 0;
+  for (size_t i = 0; i < length; ++i) {
+    const int value = base64Value(text[i]);
+    if (value < 0)
+      return false;
+    bits = (bits << 6) | static_cast<uint32_t>(value);
+    count += 6;
+    if (count >= 8) {
+      count -= 8;
+      out.push_back(static_cast<uint8_t>(bits >> count));
+    }
+  }
+  return true;
+}
+
+template <typename FileSystem> bool SshAuthorizedKeys<FileSystem>::begin() {
+  mounted = fs.begin();
+  if (!mounted)
+    LOG_WARN("SSH authorized keys: file system not available");
+  return mounted;
+}
+
+template <typename FileSystem> size_t SshAuthorizedKeys<FileSystem>::load() {
+  entries.clear();
+  blobs.clear();
+  if (!mounted)
+    return 0;
+  const size_t size = fs.size(path);
+  if (size == 0)
+    return 0;
+  if (size > SSH_AUTHORIZED_KEYS_MAX_SIZE) {
+    LOG_WARN("SSH authorized keys: %s is larger than %u bytes, ignoring it",
+             path, (unsigned)SSH_AUTHORIZED_KEYS_MAX_SIZE);
+    return 0;
+  }
+
+  std::vector<uint8_t> file(size);
+  if (fs.read(path, 0, file.data(), size) != size) {
+    LOG_ERROR("SSH authorized keys: reading %s failed", path);
+    return 0;
+  }
+  const char *text = reinterpret_cast<const char *>(file.data());
+  unsigned lineNumber = 0;
+  for (size_t start = 0; start < size;) {
+    const char *end =
+        static_cast<const char *>(memchr(text + start, '\n', size - start));
+    const size_t length = end ? end - (text + start) : size - start;
+    lineNumber++;
+    const char *skipped = parseLine(text + start, length);
+    if (skipped)
+      LOG_WARN("SSH authorized keys: %s line %u skipped: %s", path,
+               lineNumber, skipped);
+    start += length + 1;
+  }
+  entries.shrink_to_fit();
+  blobs.shrink_to_fit();
+  return entries.size();
+}
+
+template <typename FileSystem>
+const char *SshAuthorizedKeys<FileSystem>::parseLine(const char *line,
+                                                     size_t length) {
+  size_t i = 0;
+  while (i < length && isBlank(line[i]))
+    i++;
+  if (i == length || line[i] == '#')
+    return nullptr; // blank or comment: nothing to load, nothing wrong
+
+  const size_t typeStart = i;
+  while (i < length && !isBlank(line[i]))
+    i++;
+  const size_t typeLength = i - typeStart;
+  if (!isKeyType(line + typeStart, typeLength))
+    return "options or unsupported key type";
+  while (i < length && isBlank(line[i]))
+    i++;
+  const size_t keyStart = i;
+  while (i < length && !isBlank(line[i]))
+    i++;
+
+  std::vector<uint8_t> blob;
+  if (!decodeBase64(line + keyStart, i - keyStart, blob) || blob.size() < 4)
+    return "key is not valid base64";
+  // The blob starts with its own type name, which must match the line's
+  const size_t nameLength = (static_cast<size_t>(blob[0]) << 24) |
+                            (static_cast<size_t>(blob[1]) << 16) |
+                            (static_cast<size_t>(blob[2]) << 8) | blob[3];
+  if (nameLength != typeLength || blob.size() < 4 + nameLength ||
+      memcmp(blob.data() + 4, line + typeStart, typeLength) != 0)
+    return "key doesn't match its type";
+
+  if (contains(blob.data(), blob.size()))
+    return "duplicate key";
+  if (entries.size() == SSH_AUTHORIZED_KEYS_MAX)
+    return "too many keys";
+  if (blobs.size() + blob.size() > UINT16_MAX)
+    return "keys too large";
+  entries.push_back({hash(blob.data(), blob.size()),
+                     static_cast<uint16_t>(blobs.size()),
+                     static_cast<uint16_t>(blob.size())});
+  blobs.insert(blobs.end(), blob.begin(), blob.end());
+  return nullptr;
+}
+
+template <typename FileSystem>
+bool SshAuthorizedKeys<FileSystem>::contains(const uint8_t *blob,
+                                             size_t length) const {
+  const uint32_t blobHash = hash(blob, length);
+  for (const Entry &entry : entries) {
+    if (entry.hash == blobHash && entry.length == length &&
+        memcmp(&blobs[entry.offset], blob, length) == 0)
+      return true;
+  }
+  return false;
+}
+
+template <typename FileSystem>
+bool SshAuthorizedKeys<FileSystem>::contains(const char *base64) const {
+  std::vector<uint8_t> blob;
+  return base64 && decodeBase64(base64, strlen(base64), blob) &&
+         contains(blob.data(), blob.size());
+}
+
+template <typename FileSystem>
+uint32_t SshAuthorizedKeys<FileSystem>::hash(const uint8_t *data,
+                                             size_t length) {
+  uint32_t value = 2166136261u; // FNV-1a
+  for (size_t i = 0; i < length; ++i)
+    value = (value ^ data[i]) * 16777619u;
+  return value;
+}
+
+} // namespace internal
+// Explicit instantiation for production and test builds
+template class internal::SshAuthorizedKeys<FileSystemPolicy>;
+} // namespace jrb::wifi_serial
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "config.h"
+#include "infrastructure/storage/file_system_policy.h"
+#include "infrastructure/types.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace internal {
+/**
+ * @class SshAuthorizedKeys
+ * @brief Public keys allowed to log in over SSH, read from flash once.
+ * @tparam FileSystem File system policy (LittleFsFileSystem or FileSystemTest)
+ *
+ * The file uses the OpenSSH authorized_keys format, one key per line:
+ *
+ *   type base64-key [comment]
+ *
+ * load() parses it into a table of decoded key blobs (the form a client
+ * sends its key in), packed into one buffer with a hash per key. After
+ * that, checking a login is a hash compare and a memcmp per key, with no
+ * file access or parsing. Lines with options (from=..., command=...) are
+ * skipped rather than loaded without their restrictions, as are key types
+ * libssh doesn't support and anything that doesn't decode.
+ */
+template <typename FileSystem> class SshAuthorizedKeys final {
+public:
+  explicit SshAuthorizedKeys(const char *path) : path{path} {}
+
+  /**
+   * @brief Mount the file system
+   * @return false if there is none; load() then finds no keys
+   */
+  bool begin();
+
+  /**
+   * @brief Read and parse the file, replacing the keys loaded before
+   * @return Number of keys loaded (0 without a file)
+   */
+  size_t load();
+
+  /**
+   * @param blob Public key blob, as sent by the client
+   */
+  bool contains(const uint8_t *blob, size_t length) const;
+
+  /**
+   * @brief contains() for a key in base64, as libssh exports it
+   */
+  bool contains(const char *base64) const;
+
+  size_t size() const { return entries.size(); }
+  const char *getPath() const { return path; }
+
+private:
+  struct Entry {
+    uint32_t hash;   // FNV-1a of the blob
+    uint16_t offset; // into blobs
+    uint16_t length;
+  };
+
+  FileSystem fs;
+  const char *path;
+  bool mounted{false};
+  std::vector<Entry> entries;
+  std::vector<uint8_t> blobs;
+
+  /**
+   * @return nullptr if the line holds a key, otherwise why it was skipped
+   */
+  const char *parseLine(const char *line, size_t length);
+  static uint32_t hash(const uint8_t *data, size_t length);
+};
+
+/**
+ * @brief Decode standard base64 with optional '=' padding
+ * @return false on any other character or a truncated group
+ */
+bool decodeBase64(const char *text, size_t length,
+                  std::vector<uint8_t> &out);
+} // namespace internal
+
+using SshAuthorizedKeys = internal::SshAuthorizedKeys<FileSystemPolicy>;
+
+} // namespace jrb::wifi_serial
@@ -6,8 +6,10 @@ namespace jrb::wifi_serial {
 SshFlushPolicy::SshFlushPolicy(SSHServer &sshServer, const char *name)
     : sshServer(sshServer), name(name) {}
 
+bool SshFlushPolicy::active() const { return sshServer.isRunning(); }
+
 void SshFlushPolicy::flush(const types::span<const uint8_t> &buffer,
-                           const char *name) {
+                           uint32_t offset, const char *name) {
   sshServer.sendToSSHClients(buffer);
 }
 
@@ -1,20 +1,32 @@
 #pragma once
 
 #include "infrastructure/types.hpp"
+#include <cstdint>
 
 namespace jrb::wifi_serial {
 
 class SSHServer;
 
+/**
+ * @brief Flushes tty output into the SSH server queue
+ *
+ * Active while the SSH server runs, with or without sessions: the output
+ * also fills the scrollback a new session replays. Before the server
+ * listens, output is discarded (INACTIVE_BACKLOG = 0).
+ */
 class SshFlushPolicy final {
 private:
   SSHServer &sshServer;
   const char *name;
 
 public:
+  static constexpr size_t INACTIVE_BACKLOG = 0;
+
   explicit SshFlushPolicy(SSHServer &sshServer, const char *name);
   ~SshFlushPolicy() = default;
-  void flush(const types::span<const uint8_t> &buffer,
+
+  bool active() const;
+  void flush(const types::span<const uint8_t> &buffer, uint32_t offset,
              const char *name = "ssh");
 };
 
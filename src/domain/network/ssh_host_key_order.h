@@ -0,0 +1,110 @@
+/**
+ * @file ssh_host_key_order.h
+ * @brief Which host keys the SSH server offers, and in what order.
+ *
+ * SSH_HOST_KEY_ORDER lists key types by name ("ed25519,ecdsa,rsa"). The
+ * server keeps one stored key per listed type and offers the matching host
+ * key algorithms in that order. The client picks the first algorithm of its
+ * own list that the server offers; OpenSSH lists Ed25519 and ECDSA before
+ * RSA, so leaving "rsa" in only serves clients that know nothing else (or
+ * already pinned the RSA key).
+ *
+ * Signing the exchange hash with the host key is the expensive step of
+ * every handshake, and Ed25519 signs much faster than RSA-2048 (see
+ * ssh_host_key_benchmark_test.cpp).
+ */
+
+#pragma once
+
+#include "config.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial {
+
+enum class SshHostKeyType : uint8_t { Ed25519, EcdsaP256, Rsa };
+
+struct SshHostKeyInfo {
+  SshHostKeyType type;
+  const char *name;       // as written in SSH_HOST_KEY_ORDER
+  const char *algorithms; // host key algorithms signed with this key
+  const char *path;       // file kept by SshHostKeyStore
+};
+
+constexpr SshHostKeyInfo SSH_HOST_KEYS[] = {
+    {SshHostKeyType::Ed25519, "ed25519", "ssh-ed25519",
+     SSH_HOST_KEY_ED25519_PATH},
+    {SshHostKeyType::EcdsaP256, "ecdsa", "ecdsa-sha2-nistp256",
+     SSH_HOST_KEY_ECDSA_PATH},
+    // The RSA key keeps the original path so upgraded devices keep it;
+    // SHA-1 "ssh-rsa" signatures are not offered
+    {SshHostKeyType::Rsa, "rsa", "rsa-sha2-512,rsa-sha2-256",
+     SSH_HOST_KEY_PATH},
+};
+
+/**
+ * @class SshHostKeyOrder
+ * @brief Parses a comma-separated list of host key type names
+ *
+ * Unknown and repeated names are skipped (and counted). An order that
+ * names nothing usable falls back to Ed25519 alone.
+ */
+class SshHostKeyOrder final {
+public:
+  static constexpr size_t MAX_KEYS =
+      sizeof(SSH_HOST_KEYS) / sizeof(SSH_HOST_KEYS[0]);
+
+  explicit SshHostKeyOrder(const char *order) {
+    const char *name = order ? order : "";
+    while (*name) {
+      const char *end = strchr(name, ',');
+      const size_t length = end ? end - name : strlen(name);
+      add(name, length);
+      if (!end)
+        break;
+      name = end + 1;
+    }
+    if (count == 0)
+      add("ed25519", 7);
+  }
+
+  size_t size() const { return count; }
+  const SshHostKeyInfo &operator[](size_t index) const { return *keys[index]; }
+
+  /**
+   * @brief Names in the list that were not used
+   */
+  size_t skipped() const { return skippedNames; }
+
+private:
+  const SshHostKeyInfo *keys[MAX_KEYS]{};
+  size_t count{0};
+  size_t skippedNames{0};
+
+  void add(const char *name, size_t length) {
+    while (length > 0 && *name == ' ') {
+      name++;
+      length--;
+    }
+    while (length > 0 && name[length - 1] == ' ')
+      length--;
+    if (length == 0)
+      return;
+    for (const SshHostKeyInfo &info : SSH_HOST_KEYS) {
+      if (strlen(info.name) != length || strncmp(info.name, name, length) != 0)
+        continue;
+      for (size_t i = 0; i < count; ++i) {
+        if (keys[i] == &info) {
+          skippedNames++;
+          return;
+        }
+      }
+      keys[count++] = &info;
+      return;
+    }
+    skippedNames++;
+  }
+};
+
+} // namespace jrb::wifi_serial
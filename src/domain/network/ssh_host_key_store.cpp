@@ -0,0 +1,90 @@
+#include "ssh_host_key_store.h"
+#include "infrastructure/logging/logger.h"
+#include <cstring>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace internal {
+
+template <typename FileSystem> bool SshHostKeyStore<FileSystem>::begin() {
+  mounted = fs.begin();
+  if (!mounted)
+    LOG_WARN("SSH host key store: file system not available");
+  return mounted;
+}
+
+template <typename FileSystem>
+bool SshHostKeyStore<FileSystem>::load(types::string &key) {
+  if (!mounted)
+    return false;
+  const size_t size = fs.size(path);
+  if (size == 0)
+    return false;
+
+  std::vector<uint8_t> file(size);
+  const size_t length = size > HEADER_SIZE ? size - HEADER_SIZE : 0;
+  bool valid = length > 0 && length <= SSH_HOST_KEY_MAX_SIZE &&
+               fs.read(path, 0, file.data(), size) == size &&
+               memcmp(file.data(), MAGIC, sizeof(MAGIC)) == 0;
+  if (valid) {
+    const size_t stored = (static_cast<size_t>(file[4]) << 8) | file[5];
+    const uint32_t storedHash = (static_cast<uint32_t>(file[6]) << 24) |
+                                (static_cast<uint32_t>(file[7]) << 16) |
+                                (static_cast<uint32_t>(file[8]) << 8) |
+                                file[9];
+    valid = stored == length &&
+            storedHash == hash(file.data() + HEADER_SIZE, length);
+  }
+  if (!valid) {
+    LOG_WARN("SSH host key store: %s is damaged, discarding it", path);
+    fs.remove(path);
+    return false;
+  }
+  key.assign(reinterpret_cast<const char *>(file.data() + HEADER_SIZE),
+             length);
+  return true;
+}
+
+template <typename FileSystem>
+bool SshHostKeyStore<FileSystem>::save(const types::string &key) {
+  if (!mounted || key.empty() || key.size() > SSH_HOST_KEY_MAX_SIZE)
+    return false;
+
+  const auto *data = reinterpret_cast<const uint8_t *>(key.data());
+  const uint32_t keyHash = hash(data, key.size());
+  std::vector<uint8_t> file(HEADER_SIZE + key.size());
+  memcpy(file.data(), MAGIC, sizeof(MAGIC));
+  file[4] = static_cast<uint8_t>(key.size() >> 8);
+  file[5] = static_cast<uint8_t>(key.size());
+  file[6] = static_cast<uint8_t>(keyHash >> 24);
+  file[7] = static_cast<uint8_t>(keyHash >> 16);
+  file[8] = static_cast<uint8_t>(keyHash >> 8);
+  file[9] = static_cast<uint8_t>(keyHash);
+  memcpy(file.data() + HEADER_SIZE, data, key.size());
+
+  fs.remove(path);
+  if (!fs.append(path, file.data(), file.size())) {
+    LOG_ERROR("SSH host key store: writing %s failed", path);
+    fs.remove(path); // never leave half a key behind
+    return false;
+  }
+  return true;
+}
+
+template <typename FileSystem> bool SshHostKeyStore<FileSystem>::remove() {
+  return mounted && fs.remove(path);
+}
+
+template <typename FileSystem>
+uint32_t SshHostKeyStore<FileSystem>::hash(const uint8_t *data,
+                                           size_t length) {
+  uint32_t value = 2166136261u; // FNV-1a
+  for (size_t i = 0; i < length; ++i)
+    value = (value ^ data[i]) * 16777619u;
+  return value;
+}
+
+} // namespace internal
+// Explicit instantiation for production and test builds
+template class internal::SshHostKeyStore<FileSystemPolicy>;
+} // namespace jrb::wifi_serial
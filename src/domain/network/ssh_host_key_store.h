@@ -0,0 +1,66 @@
+#pragma once
+
+#include "config.h"
+#include "infrastructure/storage/file_system_policy.h"
+#include "infrastructure/types.hpp"
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+namespace internal {
+/**
+ * @class SshHostKeyStore
+ * @brief Keeps the SSH server's private host key on flash across reboots.
+ * @tparam FileSystem File system policy (LittleFsFileSystem or FileSystemTest)
+ *
+ * The key is the base64 (OpenSSH/PEM) text libssh exports, in one file:
+ *
+ *   bytes 0-3  MAGIC
+ *   bytes 4-5  key length (big-endian)
+ *   bytes 6-9  FNV-1a hash of the key (big-endian)
+ *   bytes 10-  key
+ *
+ * The file systems can only append, so save() removes the old file first.
+ * A reboot in between leaves no key or a truncated one; load() rejects
+ * (and deletes) anything that doesn't check out, and the server generates
+ * a new key as on first boot.
+ */
+template <typename FileSystem> class SshHostKeyStore final {
+public:
+  static constexpr size_t HEADER_SIZE = 10;
+
+  explicit SshHostKeyStore(const char *path) : path{path} {}
+
+  /**
+   * @brief Mount the file system
+   * @return false if there is none; load() and save() then fail
+   */
+  bool begin();
+
+  /**
+   * @return false if no valid key is stored
+   */
+  bool load(types::string &key);
+
+  bool save(const types::string &key);
+
+  /**
+   * @brief Forget the stored key; the next boot generates a new one
+   */
+  bool remove();
+
+  const char *getPath() const { return path; }
+
+private:
+  static constexpr uint8_t MAGIC[4] = {'S', 'H', 'K', '1'};
+
+  FileSystem fs;
+  const char *path;
+  bool mounted{false};
+
+  static uint32_t hash(const uint8_t *data, size_t length);
+};
+} // namespace internal
+
+using SshHostKeyStore = internal::SshHostKeyStore<FileSystemPolicy>;
+
+} // namespace jrb::wifi_serial
@@ -4,28 +4,35 @@
 #include "libssh_esp32.h"
 #include "system_info.h"
 #include <WiFi.h>
+#include <atomic>
+#include <esp_vfs_eventfd.h>
 #include <libssh/libssh.h>
 #include <libssh/server.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace jrb::wifi_serial {
 
 SSHServer::SSHServer(PreferencesStorage &storage, SystemInfo &sysInfo,
                      SpecialCharacterHandler &specialCharacterHandler)
     : preferencesStorage(storage), systemInfo(sysInfo), sshBind(nullptr),
-      hostKey(nullptr), running(false), sshTaskHandle(nullptr),
-      serialWrite(nullptr), serialToSSHQueue(nullptr), activeSSHSession(false),
-      specialCharacterMode(false),
+      hostKeyOrder(SSH_HOST_KEY_ORDER),
+      authorizedKeys(SSH_AUTHORIZED_KEYS_PATH), hostKeys{}, running(false),
+      sshTaskHandle(nullptr), serialWrite(nullptr),
       specialCharacterHandler(specialCharacterHandler),
-      sshLog(SshFlushPolicy(*this, "ssh"), "ssh") {
+      outputMutex(nullptr), sshLog(SshFlushPolicy(*this, "ssh"), "ssh") {
   LOG_DEBUG(__PRETTY_FUNCTION__);
 
-  // Create FreeRTOS queue for thread-safe serial→SSH data transfer
-  serialToSSHQueue = xQueueCreate(SSH_QUEUE_SIZE, SSH_QUEUE_ITEM_SIZE);
-  if (!serialToSSHQueue) {
-    LOG_ERROR("SSH: Failed to create serialToSSH queue");
+  for (Session &session : sessions)
+    session.server = this;
+
+  outputMutex = xSemaphoreCreateMutex();
+  if (!outputMutex) {
+    LOG_ERROR("SSH: Failed to create output mutex");
   } else {
-    LOG_INFO("SSH: Queue created successfully (size=%d, item_size=%d)",
-             SSH_QUEUE_SIZE, SSH_QUEUE_ITEM_SIZE);
+    LOG_INFO("SSH: Up to %d sessions, %d bytes of backlog each",
+             SSH_MAX_SESSIONS, SSH_SESSION_BACKLOG);
   }
 }
 
@@ -35,14 +42,22 @@ SSHServer::~SSHServer() {
     ssh_bind_free((ssh_bind)sshBind);
     sshBind = nullptr;
   }
-  // Free hostKey AFTER freeing sshBind (sshBind may reference it)
-  if (hostKey) {
-    ssh_key_free((ssh_key)hostKey);
-    hostKey = nullptr;
+  // Free hostKeys AFTER freeing sshBind (sshBind may reference them)
+  for (void *&hostKey : hostKeys) {
+    if (hostKey) {
+      ssh_key_free((ssh_key)hostKey);
+      hostKey = nullptr;
+    }
   }
-  if (serialToSSHQueue) {
-    vQueueDelete(serialToSSHQueue);
-    serialToSSHQueue = nullptr;
+  if (outputMutex) {
+    vSemaphoreDelete(outputMutex);
+    outputMutex = nullptr;
+  }
+  for (Session &session : sessions) {
+    if (session.wakeFd >= 0) {
+      close(session.wakeFd);
+      session.wakeFd = -1;
+    }
   }
 }
 
@@ -51,22 +66,23 @@ void SSHServer::setSerialWriteCallback(SerialWriteCallback writeCallback) {
 }
 
 void SSHServer::sendToSSHClients(const types::span<const uint8_t> &data) {
-  if (!running || !serialToSSHQueue || data.empty() || !activeSSHSession)
+  // Kept with nobody logged in too: it is the scrollback of the next session
+  if (!running || !outputMutex || data.empty())
     return;
 
-  size_t copySize = data.size() < SSH_QUEUE_PAYLOAD_SIZE
-                        ? data.size()
-                        : SSH_QUEUE_PAYLOAD_SIZE;
-  if (copySize < data.size()) {
-    LOG_WARN("SSH: Truncating %d bytes to %d", (int)data.size(), (int)copySize);
+  // The main loop and the web server task both write here; the lock is
+  // only held for the copy, sessions never hold it
+  if (xSemaphoreTake(outputMutex, portMAX_DELAY) == pdTRUE) {
+    output.append(data);
+    xSemaphoreGive(outputMutex);
   }
-
-  uint8_t queueItem[SSH_QUEUE_ITEM_SIZE] = {0};
-  queueItem[0] = static_cast<uint8_t>(copySize);
-  memcpy(queueItem + 1, data.data(), copySize);
-
-  if (xQueueSend(serialToSSHQueue, queueItem, 0) != pdTRUE) {
-    LOG_WARN("SSH: Queue full, dropping %d bytes", (int)data.size());
+  // Wake the sessions sleeping in waitForEvent(); the others will see the
+  // data before they go to sleep
+  for (Session &session : sessions) {
+    if (session.waiting.exchange(false) && session.wakeFd >= 0) {
+      const uint64_t one = 1;
+      write(session.wakeFd, &one, sizeof(one));
+    }
   }
 }
 
@@ -83,6 +99,26 @@ bool SSHServer::authenticateUser(const char *user, const char *password) {
   return success;
 }
 
+bool SSHServer::authenticateKey(const char *user, void *key) {
+  if (!user || !key || preferencesStorage.webUser != user)
+    return false;
+
+  // The table holds decoded blobs; libssh hands the key out as base64
+  char *base64 = nullptr;
+  if (ssh_pki_export_pubkey_base64((ssh_key)key, &base64) != SSH_OK)
+    return false;
+  const bool success = authorizedKeys.contains(base64);
+  ssh_string_free_char(base64);
+  return success;
+}
+
+int SSHServer::authMethods() const {
+  int methods = SSH_PASSWORD_AUTH ? SSH_AUTH_METHOD_PASSWORD : 0;
+  if (authorizedKeys.size() > 0)
+    methods |= SSH_AUTH_METHOD_PUBLICKEY;
+  return methods;
+}
+
 void SSHServer::sendWelcomeMessage(void *channel) {
   if (!channel)
     return;
@@ -120,13 +156,57 @@ void SSHServer::sendWelcomeMessage(void *channel) {
   ssh_channel_write(chan, sysInfoBuf, strlen(sysInfoBuf));
 }
 
-types::string SSHServer::handleSpecialCharacter(char c) {
+namespace {
+
+// Clears the eventfd so the next poll sleeps again
+int drainWakeFd(socket_t fd, int revents, void *userdata) {
+  uint64_t count = 0;
+  read(fd, &count, sizeof(count));
+  return 0;
+}
+
+} // namespace
+
+bool SSHServer::waitForEvent(Session &session, uint32_t since,
+                             uint32_t timeoutMs) {
+  // Returns on socket data (handled into libssh's buffers), a wake-up, or
+  // the end of the timeout; only a broken connection is an error
+  const uint32_t elapsed = millis() - since;
+  int remaining = elapsed < timeoutMs ? timeoutMs - elapsed : 0;
+  // Nothing would wake it for output: look again soon instead
+  if (!session.wakeRegistered)
+    remaining = std::min(remaining, static_cast<int>(SSH_UNWAKEABLE_POLL_MS));
+  return ssh_event_dopoll((ssh_event)session.event, remaining) != SSH_ERROR;
+}
+
+void SSHServer::startReplay(Session &session, void *channel,
+                            size_t length) {
+  // The session loop streams it from the ring like live output, a batch
+  // per write; it only needs the cursor moved back
+  const size_t end = output.writePosition();
+  const size_t start = output.replayPosition(length);
+  if (static_cast<ptrdiff_t>(end - start) <= 0)
+    return;
+  char msg[64];
+  const int size =
+      snprintf(msg, sizeof(msg), "--- last %u bytes of ttyS1 ---\r\n",
+               (unsigned)(end - start));
+  ssh_channel_write((ssh_channel)channel, msg, size);
+  session.cursor = start;
+  session.replayEnd = end;
+  session.replaying = true;
+}
+
+types::string SSHServer::handleSpecialCharacter(char c,
+                                                bool &specialCharacterMode) {
   if (c == CMD_PREFIX) {
     specialCharacterMode = true;
     return
         R"(Special characters for SSH interface:
     Ctrl+Y i: print system information
     Ctrl+Y x: terminate the SSH session
+    Ctrl+Y t: replay the recent ttyS1 output
+    Ctrl+Y k: rotate the SSH host keys (used after the next reset)
     Ctrl+Y n: reset the device (INMEDIATELY)
     )";
   }
@@ -138,6 +218,10 @@ types::string SSHServer::handleSpecialCharacter(char c) {
     return systemInfo.getWelcomeString();
   case CMD_DISCONNECT_SSH:
     return "TERMINATE";
+  case CMD_ROTATE_SSH_KEY:
+    return "ROTATE_KEY";
+  case CMD_TAIL_SSH:
+    return "TAIL";
   case CMD_RESET:
     return "RESET";
   default:
@@ -145,22 +229,24 @@ types::string SSHServer::handleSpecialCharacter(char c) {
   }
 }
 
-bool SSHServer::authenticateSession(void *session) {
-  ssh_session sshSession = (ssh_session)session;
+bool SSHServer::authenticateSession(Session &state) {
+  ssh_session sshSession = (ssh_session)state.session;
   ssh_message message;
   uint32_t startTime = millis();
 
   while (millis() - startTime < SSH_AUTH_TIMEOUT_MS) {
     message = ssh_message_get(sshSession);
     if (!message) {
-      vTaskDelay(pdMS_TO_TICKS(10));
+      if (!waitForEvent(state, startTime, SSH_AUTH_TIMEOUT_MS))
+        return false;
       continue;
     }
 
     int type = ssh_message_type(message);
     int subtype = ssh_message_subtype(message);
 
-    if (type == SSH_REQUEST_AUTH && subtype == SSH_AUTH_METHOD_PASSWORD) {
+    if (type == SSH_REQUEST_AUTH && subtype == SSH_AUTH_METHOD_PASSWORD &&
+        SSH_PASSWORD_AUTH) {
       const char *user = ssh_message_auth_user(message);
       const char *pass = ssh_message_auth_password(message);
 
@@ -169,7 +255,31 @@ bool SSHServer::authenticateSession(void *session) {
         ssh_message_free(message);
         return true;
       }
-      ssh_message_auth_set_methods(message, SSH_AUTH_METHOD_PASSWORD);
+      ssh_message_auth_set_methods(message, authMethods());
+      ssh_message_reply_default(message);
+    } else if (type == SSH_REQUEST_AUTH &&
+               subtype == SSH_AUTH_METHOD_PUBLICKEY) {
+      const char *user = ssh_message_auth_user(message);
+      const int state = ssh_message_auth_publickey_state(message);
+      const bool authorized =
+          authenticateKey(user, ssh_message_auth_pubkey(message));
+      if (authorized && state == SSH_PUBLICKEY_STATE_NONE) {
+        // The client asks whether this key would do before signing
+        ssh_message_auth_reply_pk_ok_simple(message);
+      } else if (authorized && state == SSH_PUBLICKEY_STATE_VALID) {
+        LOG_INFO("SSH auth attempt - user: %s, key: SUCCESS", user);
+        ssh_message_auth_reply_success(message, 0);
+        ssh_message_free(message);
+        return true;
+      } else {
+        if (state != SSH_PUBLICKEY_STATE_NONE)
+          LOG_INFO("SSH auth attempt - user: %s, key: FAILED",
+                   user ? user : "");
+        ssh_message_auth_set_methods(message, authMethods());
+        ssh_message_reply_default(message);
+      }
+    } else if (type == SSH_REQUEST_AUTH) {
+      ssh_message_auth_set_methods(message, authMethods());
       ssh_message_reply_default(message);
     } else {
       ssh_message_reply_default(message);
@@ -181,15 +291,16 @@ bool SSHServer::authenticateSession(void *session) {
   return false;
 }
 
-bool SSHServer::waitForChannelSession(void *session, void **channel) {
-  ssh_session sshSession = (ssh_session)session;
+bool SSHServer::waitForChannelSession(Session &state, void **channel) {
+  ssh_session sshSession = (ssh_session)state.session;
   ssh_message message;
   uint32_t startTime = millis();
 
   while (millis() - startTime < SSH_CHANNEL_TIMEOUT_MS) {
     message = ssh_message_get(sshSession);
     if (!message) {
-      vTaskDelay(pdMS_TO_TICKS(10));
+      if (!waitForEvent(state, startTime, SSH_CHANNEL_TIMEOUT_MS))
+        return false;
       continue;
     }
 
@@ -207,15 +318,16 @@ bool SSHServer::waitForChannelSession(void *session, void **channel) {
   return false;
 }
 
-bool SSHServer::waitForShellRequest(void *session, void *channel) {
-  ssh_session sshSession = (ssh_session)session;
+bool SSHServer::waitForShellRequest(Session &state, void *channel) {
+  ssh_session sshSession = (ssh_session)state.session;
   ssh_message message;
   uint32_t startTime = millis();
 
   while (millis() - startTime < SSH_SHELL_TIMEOUT_MS) {
     message = ssh_message_get(sshSession);
     if (!message) {
-      vTaskDelay(pdMS_TO_TICKS(10));
+      if (!waitForEvent(state, startTime, SSH_SHELL_TIMEOUT_MS))
+        return false;
       continue;
     }
 
@@ -237,12 +349,14 @@ bool SSHServer::waitForShellRequest(void *session, void *channel) {
   return false;
 }
 
-void SSHServer::handleSSHSession(void *session) {
-  if (!session)
-    return;
-  specialCharacterMode = false;
+void SSHServer::handleSSHSession(Session &state) {
+  ssh_session session = (ssh_session)state.session;
+  state.specialCharacterMode = false;
 
-  if (!authenticateSession(session)) {
+  // Until the shell opens, ssh_message_get() only returns what has arrived
+  // and the waits below sleep in waitForEvent()
+  ssh_set_blocking(session, 0);
+  if (!authenticateSession(state)) {
     LOG_WARN("SSH: Authentication failed");
     return;
   }
@@ -250,41 +364,50 @@ void SSHServer::handleSSHSession(void *session) {
   LOG_INFO("SSH: User authenticated successfully");
 
   ssh_channel channel = nullptr;
-  if (!waitForChannelSession(session, (void **)&channel)) {
+  if (!waitForChannelSession(state, (void **)&channel)) {
     LOG_ERROR("SSH: No channel session requested");
     return;
   }
 
   LOG_INFO("SSH: Channel opened");
 
-  if (!waitForShellRequest(session, channel)) {
+  if (!waitForShellRequest(state, channel)) {
     LOG_ERROR("SSH: No shell requested");
     ssh_channel_close(channel);
     ssh_channel_free(channel);
     return;
   }
+  ssh_set_blocking(session, 1); // channel writes wait for the window
 
-  LOG_INFO("SSH: Shell session started");
-  activeSSHSession = true;
+  const int active = ++activeSessions;
+  LOG_INFO("SSH: Shell session started (%d active)", active);
   sendWelcomeMessage(channel);
+  state.cursor = output.writePosition();
+  state.replaying = false;
+  startReplay(state, channel, SSH_SCROLLBACK_REPLAY);
 
   uint8_t sshToSerialBuffer[128];
-  uint8_t serialToSSHBuffer[SSH_QUEUE_ITEM_SIZE];
+  WriteBatch<SSH_WRITE_BATCH_SIZE> &batch = state.pending;
   uint32_t sessionStartTime = millis();
 
   while (ssh_channel_is_open(channel) && !ssh_channel_is_eof(channel)) {
-    if (millis() - sessionStartTime > 3600000) { // 1 hour timeout
+    const uint32_t elapsed = millis() - sessionStartTime;
+    if (elapsed > SSH_SESSION_TIMEOUT_MS) {
       LOG_WARN("SSH: Session timeout after 1 hour");
       ssh_channel_write(
           channel, "\r\nSSH session timeout (1 hour). Disconnecting...\r\n",
           52);
       break;
     }
+    bool idle = true;
+    batch.clear();
     int nbytes = ssh_channel_read_nonblocking(channel, sshToSerialBuffer,
                                               sizeof(sshToSerialBuffer), 0);
+    if (nbytes > 0)
+      idle = false;
     if (nbytes > 0 && serialWrite) {
-      types::string specialCharacterResponse =
-          handleSpecialCharacter(sshToSerialBuffer[0]);
+      types::string specialCharacterResponse = handleSpecialCharacter(
+          sshToSerialBuffer[0], state.specialCharacterMode);
       // Replace \n with \r\n for SSH
       size_t pos = 0;
       while ((pos = specialCharacterResponse.find("\n", pos)) !=
@@ -299,9 +422,18 @@ void SSHServer::handleSSHSession(void *session) {
       if (specialCharacterResponse == "TERMINATE") {
         const char *msg = "See you later alligator!...\r\n";
         ssh_channel_write(channel, msg, strlen(msg));
-        ssh_channel_close(channel);
-        ssh_channel_free(channel);
-        return;
+        break;
+      }
+      if (specialCharacterResponse == "TAIL") {
+        startReplay(state, channel, SSH_SESSION_BACKLOG);
+        continue;
+      }
+      if (specialCharacterResponse == "ROTATE_KEY") {
+        const char *msg = "Generating new host keys, please wait...\r\n";
+        ssh_channel_write(channel, msg, strlen(msg));
+        const types::string reply = rotateHostKey();
+        ssh_channel_write(channel, reply.c_str(), reply.length());
+        continue;
       }
       if (specialCharacterResponse == "RESET") {
         const char *msg = "Bye bye, cruel world… BRB rebooting!...\r\n";
@@ -316,31 +448,188 @@ void SSHServer::handleSSHSession(void *session) {
         continue;
       }
       LOG_VERBOSE("$ssh->ttyS1$: %d bytes", nbytes);
-      ssh_channel_write(channel, sshToSerialBuffer,
-                        nbytes); // echo back to SSH client
+      batch.append(sshToSerialBuffer, nbytes); // echo, sent with the output
       serialWrite(types::span<const uint8_t>(sshToSerialBuffer,
                                              static_cast<size_t>(nbytes)));
     }
 
-    if (serialToSSHQueue &&
-        xQueueReceive(serialToSSHQueue, serialToSSHBuffer,
-                      pdMS_TO_TICKS(SSH_QUEUE_TIMEOUT_MS)) == pdTRUE) {
-      size_t actualSize = serialToSSHBuffer[0];
-      if (actualSize > 0 && actualSize <= SSH_QUEUE_PAYLOAD_SIZE) {
-        LOG_VERBOSE("$ttyS1->ssh$: %d bytes", actualSize);
-        ssh_channel_write(channel, serialToSSHBuffer + 1, actualSize);
-      }
+    // Drain as much output as the client's window takes along with the
+    // echo: one write, so as few packets as possible. A nearly closed
+    // window doesn't stop the batch; the write then waits for it to open.
+    const size_t window = ssh_channel_window_size(channel);
+    size_t room = batch.room() - SSH_NOTE_RESERVE;
+    if (window > batch.size() + SSH_NOTE_RESERVE)
+      room = std::min(room, window - batch.size() - SSH_NOTE_RESERVE);
+    size_t lost = 0;
+    const size_t start = batch.size();
+    const size_t actualSize =
+        output.read(state.cursor, batch.tail(), room, lost);
+    batch.commit(actualSize);
+    if (lost > 0) {
+      // Only this client was too slow; the others got these bytes
+      LOG_WARN("SSH: Session fell behind, %u bytes of output dropped",
+               (unsigned)lost);
+      char note[48];
+      const int length = snprintf(
+          note, sizeof(note), "\r\n[... %u bytes dropped ...]\r\n",
+          (unsigned)lost);
+      batch.insert(start, note, length);
+    }
+    if (actualSize > 0) {
+      idle = false;
+      LOG_VERBOSE("$ttyS1->ssh$: %d bytes", actualSize);
+    }
+    if (state.replaying &&
+        static_cast<ptrdiff_t>(state.cursor - state.replayEnd) >= 0) {
+      state.replaying = false;
+      const char *msg = "\r\n--- end of scrollback ---\r\n";
+      batch.append(msg, strlen(msg));
+    }
+    if (!batch.empty() &&
+        ssh_channel_write(channel, batch.data(), batch.size()) == SSH_ERROR)
+      break;
+    if (idle) {
+      // Announce the sleep before the last look, so output appended in
+      // between either is seen here or wakes the poll
+      state.waiting = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const bool sleep = output.pending(state.cursor) == 0 &&
+                         ssh_channel_poll(channel, 0) == 0;
+      const bool alive =
+          !sleep ||
+          waitForEvent(state, sessionStartTime, SSH_SESSION_TIMEOUT_MS);
+      state.waiting = false;
+      if (!alive)
+        break;
     }
   }
 
-  LOG_INFO("SSH: Session ended");
+  LOG_INFO("SSH: Session ended (%d active)", --activeSessions);
   ssh_channel_close(channel);
   ssh_channel_free(channel);
-  activeSSHSession = false;
+}
+
+namespace {
+
+ssh_keytypes_e libsshKeyType(SshHostKeyType type) {
+  switch (type) {
+  case SshHostKeyType::Ed25519:
+    return SSH_KEYTYPE_ED25519;
+  case SshHostKeyType::EcdsaP256:
+    return SSH_KEYTYPE_ECDSA_P256;
+  case SshHostKeyType::Rsa:
+    break;
+  }
+  return SSH_KEYTYPE_RSA;
+}
+
+} // namespace
+
+void *SSHServer::loadOrGenerateHostKey(const SshHostKeyInfo &info) {
+  const unsigned long start = millis();
+  SshHostKeyStore store(info.path);
+  store.begin();
+  types::string stored;
+  if (store.load(stored)) {
+    ssh_key key = nullptr;
+    if (ssh_pki_import_privkey_base64(stored.c_str(), nullptr, nullptr,
+                                      nullptr, &key) == SSH_OK &&
+        key && ssh_key_type(key) == libsshKeyType(info.type)) {
+      LOG_INFO("SSH: %s host key loaded from %s in %lu ms (%s)", info.name,
+               store.getPath(), millis() - start, fingerprint(key).c_str());
+      return key;
+    }
+    ssh_key_free(key);
+    LOG_WARN("SSH: Stored %s host key can't be imported, generating a new one",
+             info.name);
+  }
+
+  LOG_INFO("SSH: Generating %s host key%s", info.name,
+           info.type == SshHostKeyType::Rsa ? ", this may take a while..."
+                                            : "");
+  ssh_key key = static_cast<ssh_key>(generateHostKey(info, store));
+  if (key) {
+    LOG_INFO("SSH: %s host key generated in %lu ms (%s)", info.name,
+             millis() - start, fingerprint(key).c_str());
+  }
+  return key;
+}
+
+void *SSHServer::generateHostKey(const SshHostKeyInfo &info,
+                                 SshHostKeyStore &store) {
+  ssh_key key = nullptr;
+  const int bits = info.type == SshHostKeyType::Rsa         ? SSH_RSA_KEY_BITS
+                   : info.type == SshHostKeyType::EcdsaP256 ? 256
+                                                            : 0;
+  if (ssh_pki_generate(libsshKeyType(info.type), bits, &key) != SSH_OK ||
+      !key) {
+    LOG_ERROR("SSH: Failed to generate %s host key", info.name);
+    return nullptr;
+  }
+  // Without a stored copy the key is still good for this boot
+  char *exported = nullptr;
+  if (ssh_pki_export_privkey_base64(key, nullptr, nullptr, nullptr,
+                                    &exported) == SSH_OK &&
+      exported && store.save(exported)) {
+    LOG_INFO("SSH: %s host key stored in %s", info.name, store.getPath());
+  } else {
+    LOG_WARN("SSH: %s host key not stored, the next boot generates another",
+             info.name);
+  }
+  if (exported)
+    ssh_string_free_char(exported);
+  return key;
+}
+
+types::string SSHServer::rotateHostKey() {
+  if (rotatingHostKeys.exchange(true))
+    return "Another session is rotating the host keys\r\n";
+  // The running listener keeps its keys; a new bind would drop this session
+  types::string reply;
+  for (size_t i = 0; i < hostKeyOrder.size(); ++i) {
+    const SshHostKeyInfo &info = hostKeyOrder[i];
+    SshHostKeyStore store(info.path);
+    store.begin();
+    ssh_key key = static_cast<ssh_key>(generateHostKey(info, store));
+    if (!key) {
+      reply += types::string("Rotating the ") + info.name +
+               " host key failed, keeping the current one\r\n";
+      continue;
+    }
+    const types::string print = fingerprint(key);
+    reply += types::string("New ") + info.name + " host key " + print + "\r\n";
+    LOG_INFO("SSH: %s host key rotated (%s)", info.name, print.c_str());
+    ssh_key_free(key);
+  }
+  rotatingHostKeys = false;
+  return reply + "The new keys are used after the next reset (Ctrl+Y Ctrl+N); "
+                 "clients will warn about the change.\r\n";
+}
+
+types::string SSHServer::fingerprint(void *key) {
+  ssh_key publicKey = nullptr;
+  if (ssh_pki_export_privkey_to_pubkey(static_cast<ssh_key>(key),
+                                       &publicKey) != SSH_OK)
+    return "unknown fingerprint";
+  unsigned char *hash = nullptr;
+  size_t hashLength = 0;
+  types::string result = "unknown fingerprint";
+  if (ssh_get_publickey_hash(publicKey, SSH_PUBLICKEY_HASH_SHA256, &hash,
+                             &hashLength) == SSH_OK) {
+    char *text =
+        ssh_get_fingerprint_hash(SSH_PUBLICKEY_HASH_SHA256, hash, hashLength);
+    if (text) {
+      result = text;
+      ssh_string_free_char(text);
+    }
+    ssh_clean_pubkey_hash(&hash);
+  }
+  ssh_key_free(publicKey);
+  return result;
 }
 
 void SSHServer::setup() {
-  LOG_INFO("%s: please wait this may take a while...", __PRETTY_FUNCTION__);
+  LOG_INFO("%s: Starting SSH server", __PRETTY_FUNCTION__);
 
   if (WiFi.status() != WL_CONNECTED) {
     LOG_ERROR("%s: WiFi not connected, cannot setup SSH server",
@@ -369,32 +658,105 @@ void SSHServer::setup() {
   LOG_INFO("%s: Configuring SSH bind options", __PRETTY_FUNCTION__);
   ssh_bind_options_set((ssh_bind)sshBind, SSH_BIND_OPTIONS_BINDPORT_STR, "22");
 
-  LOG_INFO("%s: Generating RSA host key", __PRETTY_FUNCTION__);
-  ssh_key tempHostkey = nullptr;
-  rc = ssh_pki_generate(SSH_KEYTYPE_RSA, SSH_RSA_KEY_BITS, &tempHostkey);
-  if (rc != SSH_OK || !tempHostkey) {
-    LOG_ERROR("%s: Failed to generate RSA host key", __PRETTY_FUNCTION__);
+  // Output wake-ups for the sessions, see waitForEvent()
+  esp_vfs_eventfd_config_t eventfdConfig = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+  eventfdConfig.max_fds = SSH_MAX_SESSIONS;
+  const esp_err_t eventfdError = esp_vfs_eventfd_register(&eventfdConfig);
+  if (eventfdError != ESP_OK && eventfdError != ESP_ERR_INVALID_STATE) {
+    LOG_WARN("%s: eventfd unavailable (%d), SSH output waits for input",
+             __PRETTY_FUNCTION__, eventfdError);
+  }
+  // One per slot for the server's lifetime: sendToSSHClients() may still
+  // hold a slot's fd while its session ends, so it must never be reused
+  for (Session &session : sessions) {
+    if (session.wakeFd < 0)
+      session.wakeFd = eventfd(0, 0);
+  }
+
+  // Generating a host key (first boot, damaged file) takes tens of seconds
+  // for RSA and would hold up UART, MQTT and web if done here. The task
+  // loads or generates the keys, then starts listening.
+  LOG_INFO("%s: Starting SSH task", __PRETTY_FUNCTION__);
+  xTaskCreate(sshTask, "SSH_Server",
+              SSH_TASK_STACK_SIZE, // Stack size
+              this,
+              SSH_TASK_PRIORITY, // Priority
+              &sshTaskHandle);
+
+  if (sshTaskHandle) {
+    LOG_INFO("%s: Task created successfully", __PRETTY_FUNCTION__);
+  } else {
+    LOG_ERROR("%s: Failed to create task", __PRETTY_FUNCTION__);
     ssh_bind_free((ssh_bind)sshBind);
     sshBind = nullptr;
     ssh_finalize();
-    return;
   }
+}
 
-  LOG_INFO("%s: Setting host key for SSH bind", __PRETTY_FUNCTION__);
-  rc = ssh_bind_options_set((ssh_bind)sshBind, SSH_BIND_OPTIONS_IMPORT_KEY,
-                            tempHostkey);
-  if (rc != SSH_OK) {
-    LOG_ERROR("%s: Failed to set host key", __PRETTY_FUNCTION__);
-    ssh_key_free(tempHostkey);
+bool SSHServer::startListening() {
+  const unsigned long start = millis();
+  if (hostKeyOrder.skipped() > 0) {
+    LOG_WARN("%s: Ignored %u unknown or repeated names in \"%s\"",
+             __PRETTY_FUNCTION__, (unsigned)hostKeyOrder.skipped(),
+             SSH_HOST_KEY_ORDER);
+  }
+  size_t keyCount = 0;
+  for (size_t i = 0; i < hostKeyOrder.size(); ++i) {
+    ssh_key tempHostkey =
+        static_cast<ssh_key>(loadOrGenerateHostKey(hostKeyOrder[i]));
+    if (!tempHostkey)
+      continue;
+    LOG_INFO("%s: Setting %s host key for SSH bind", __PRETTY_FUNCTION__,
+             hostKeyOrder[i].name);
+    if (ssh_bind_options_set((ssh_bind)sshBind, SSH_BIND_OPTIONS_IMPORT_KEY,
+                             tempHostkey) != SSH_OK) {
+      LOG_ERROR("%s: Failed to set %s host key", __PRETTY_FUNCTION__,
+                hostKeyOrder[i].name);
+      ssh_key_free(tempHostkey);
+      continue;
+    }
+    // Store hostkey for later cleanup - DO NOT free here as sshBind
+    // references it
+    hostKeys[i] = tempHostkey;
+    keyCount++;
+  }
+  if (keyCount == 0) {
+    LOG_ERROR("%s: No host key available", __PRETTY_FUNCTION__);
     ssh_bind_free((ssh_bind)sshBind);
     sshBind = nullptr;
     ssh_finalize();
-    return;
+    return false;
   }
 
-  // Store hostkey for later cleanup - DO NOT free here as sshBind references it
-  hostKey = tempHostkey;
-  LOG_INFO("SSH Server: RSA host key generated successfully");
+  // Only offer algorithms we hold a key for, in the configured order
+  types::string algorithms;
+  for (size_t i = 0; i < hostKeyOrder.size(); ++i) {
+    if (!hostKeys[i])
+      continue;
+    if (!algorithms.empty())
+      algorithms += ',';
+    algorithms += hostKeyOrder[i].algorithms;
+  }
+  LOG_INFO("%s: Host key algorithms: %s", __PRETTY_FUNCTION__,
+           algorithms.c_str());
+  if (ssh_bind_options_set((ssh_bind)sshBind,
+                           SSH_BIND_OPTIONS_HOSTKEY_ALGORITHMS,
+                           algorithms.c_str()) != SSH_OK) {
+    LOG_WARN("%s: Failed to set host key algorithms, using libssh defaults",
+             __PRETTY_FUNCTION__);
+  }
+
+  // Parsed once here; logins only look keys up
+  authorizedKeys.begin();
+  const size_t authorizedKeyCount = authorizedKeys.load();
+  LOG_INFO("%s: %u authorized keys from %s, password login %s",
+           __PRETTY_FUNCTION__, (unsigned)authorizedKeyCount,
+           authorizedKeys.getPath(), SSH_PASSWORD_AUTH ? "on" : "off");
+  if (!SSH_PASSWORD_AUTH && authorizedKeyCount == 0) {
+    LOG_WARN("%s: Password login is off and there are no authorized keys: "
+             "nobody can log in",
+             __PRETTY_FUNCTION__);
+  }
 
   LOG_INFO("%s: Starting listening", __PRETTY_FUNCTION__);
   if (ssh_bind_listen((ssh_bind)sshBind) < 0) {
@@ -403,28 +765,17 @@ void SSHServer::setup() {
     ssh_bind_free((ssh_bind)sshBind);
     sshBind = nullptr;
     ssh_finalize();
-    return;
+    return false;
   }
 
-  running = true;
-  LOG_INFO("SSH Server: Started successfully on port 22");
+  LOG_INFO("SSH Server: Started successfully on port 22, %lu ms after boot "
+           "(host keys ready in %lu ms)",
+           millis(), millis() - start);
   LOG_INFO("SSH Server: Connect with: ssh %s@%s",
            preferencesStorage.webUser.c_str(),
            WiFi.localIP().toString().c_str());
 
-  LOG_INFO("%s: Starting SSH task", __PRETTY_FUNCTION__);
-  xTaskCreate(sshTask, "SSH_Server",
-              SSH_TASK_STACK_SIZE, // Stack size
-              this,
-              SSH_TASK_PRIORITY, // Priority
-              &sshTaskHandle);
-
-  if (sshTaskHandle) {
-    LOG_INFO("%s: Task created successfully", __PRETTY_FUNCTION__);
-  } else {
-    LOG_ERROR("%s: Failed to create task", __PRETTY_FUNCTION__);
-    running = false;
-  }
+  return true;
 }
 
 void SSHServer::stop() {
@@ -433,6 +784,12 @@ void SSHServer::stop() {
     vTaskDelete(sshTaskHandle);
     sshTaskHandle = nullptr;
   }
+  for (Session &session : sessions) {
+    if (session.inUse && session.task) {
+      vTaskDelete(session.task);
+      session.task = nullptr;
+    }
+  }
 }
 
 void SSHServer::sshTask(void *parameter) {
@@ -443,6 +800,13 @@ void SSHServer::sshTask(void *parameter) {
 void SSHServer::runSSHTask() {
   LOG_INFO("%s: Started", __PRETTY_FUNCTION__);
 
+  if (!startListening()) {
+    sshTaskHandle = nullptr;
+    vTaskDelete(nullptr);
+    return;
+  }
+  running = true;
+
   while (running) {
     ssh_session newSession = ssh_new();
     if (!newSession) {
@@ -457,25 +821,86 @@ void SSHServer::runSSHTask() {
       continue;
     }
 
-    LOG_INFO("SSH Task: New connection accepted");
-
-    if (ssh_handle_key_exchange(newSession) != SSH_OK) {
-      LOG_ERROR("SSH Task: Key exchange failed: %s", ssh_get_error(newSession));
+    Session *slot = nullptr;
+    for (Session &session : sessions) {
+      bool expected = false;
+      if (session.inUse.compare_exchange_strong(expected, true)) {
+        slot = &session;
+        break;
+      }
+    }
+    if (!slot) {
+      LOG_WARN("SSH Task: Connection refused, all %d sessions in use",
+               SSH_MAX_SESSIONS);
       ssh_disconnect(newSession);
       ssh_free(newSession);
       continue;
     }
 
-    LOG_INFO("SSH Task: Key exchange successful");
-    handleSSHSession(newSession);
-    ssh_disconnect(newSession);
-    ssh_free(newSession);
+    LOG_INFO("SSH Task: New connection accepted");
+    // The key exchange runs in the session task too, so a slow handshake
+    // doesn't hold up the next connection
+    slot->session = newSession;
+    if (xTaskCreate(sessionTask, "SSH_Session", SSH_SESSION_TASK_STACK_SIZE,
+                    slot, SSH_TASK_PRIORITY, &slot->task) != pdPASS) {
+      LOG_ERROR("SSH Task: Failed to create session task");
+      ssh_disconnect(newSession);
+      ssh_free(newSession);
+      slot->session = nullptr;
+      slot->task = nullptr;
+      slot->inUse = false;
+    }
   }
 
   LOG_INFO("SSH Task: Stopped");
   vTaskDelete(nullptr);
 }
 
+void SSHServer::sessionTask(void *parameter) {
+  Session *session = static_cast<Session *>(parameter);
+  session->server->runSession(*session);
+  session->task = nullptr;
+  session->inUse = false;
+  vTaskDelete(nullptr);
+}
+
+void SSHServer::runSession(Session &session) {
+  ssh_session sshSession = (ssh_session)session.session;
+  const unsigned long kexStart = millis();
+  if (ssh_handle_key_exchange(sshSession) != SSH_OK) {
+    LOG_ERROR("SSH Task: Key exchange failed: %s", ssh_get_error(sshSession));
+  } else {
+    LOG_INFO("SSH Task: Key exchange successful in %lu ms (%s)",
+             millis() - kexStart, ssh_get_kex_algo(sshSession));
+    ssh_event event = ssh_event_new();
+    if (!event || ssh_event_add_session(event, sshSession) != SSH_OK) {
+      LOG_ERROR("SSH Task: Failed to create session event");
+    } else {
+      session.wakeRegistered =
+          session.wakeFd >= 0 &&
+          ssh_event_add_fd(event, session.wakeFd, POLLIN, drainWakeFd,
+                           nullptr) == SSH_OK;
+      if (!session.wakeRegistered) {
+        // Still works, waitForEvent() then polls for output
+        LOG_WARN("SSH Task: No wake-up fd, output may be delayed");
+      }
+      session.event = event;
+      handleSSHSession(session);
+      session.event = nullptr;
+      if (session.wakeRegistered) {
+        ssh_event_remove_fd(event, session.wakeFd);
+        session.wakeRegistered = false;
+      }
+      ssh_event_remove_session(event, sshSession);
+    }
+    if (event)
+      ssh_event_free(event);
+  }
+  ssh_disconnect(sshSession);
+  ssh_free(sshSession);
+  session.session = nullptr;
+}
+
 bool SSHServer::isRunning() const { return running; }
 
 } // namespace jrb::wifi_serial
@@ -2,11 +2,17 @@
 
 #include "domain/config/preferences_storage_policy.h"
 #include "domain/config/special_character_handler.h"
+#include "infrastructure/memory/broadcast_ring.hpp"
+#include "infrastructure/memory/write_batch.hpp"
+#include "ssh_authorized_keys.h"
 #include "ssh_buffer.h"
+#include "ssh_host_key_order.h"
+#include "ssh_host_key_store.h"
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
+#include <atomic>
 #include <functional>
 
 namespace jrb::wifi_serial {
@@ -21,8 +27,29 @@ class SystemInfo;
  * the existing web credentials for authentication and runs in its own task
  * to avoid blocking the main loop.
  *
- * Uses a FreeRTOS queue for thread-safe communication of serial data from
- * the main loop to the SSH task.
+ * Up to SSH_MAX_SESSIONS operators can be logged in at once, each served by
+ * its own task. Serial output goes into one BroadcastRing; every session
+ * reads it through its own cursor, so a slow client only falls behind (and
+ * past SSH_SESSION_BACKLOG bytes loses) its own output while the others
+ * and the serial path keep going. The ring is fed even with nobody logged
+ * in, so it doubles as scrollback: a new session starts with the last
+ * SSH_SCROLLBACK_REPLAY bytes, and Ctrl+Y t replays all it holds.
+ *
+ * Session tasks don't poll: they sleep in libssh's event loop until the
+ * client's socket is readable or sendToSSHClients() signals new output
+ * through the session's eventfd. Each wake-up then sends everything ready
+ * for the client (echo, output, notes) in one channel write, since every
+ * write costs at least one encrypted packet with its own MAC and padding.
+ *
+ * The host keys are generated once and kept in SshHostKeyStore, so later
+ * boots load them instead of spending a long time on key generation and
+ * clients see the same fingerprints. Ctrl+Y k in a session rotates them.
+ * SSH_HOST_KEY_ORDER picks the key types offered (see SshHostKeyOrder);
+ * Ed25519 comes first because it makes each key exchange much cheaper.
+ *
+ * Users log in with the web credentials or, with the web user name, with a
+ * key from SshAuthorizedKeys, which parses the file once when the server
+ * starts. SSH_PASSWORD_AUTH false leaves keys as the only way in.
  */
 class SSHServer final {
 public:
@@ -32,29 +59,56 @@ private:
   PreferencesStorage &preferencesStorage;
   SystemInfo &systemInfo;
   void *sshBind; // Opaque pointer to libssh bind
-  void *hostKey; // Opaque pointer to ssh_key (must outlive sshBind)
+  SshHostKeyOrder hostKeyOrder;
+  SshAuthorizedKeys authorizedKeys;
+  // Opaque pointers to ssh_key, as listed in hostKeyOrder (must outlive
+  // sshBind)
+  void *hostKeys[SshHostKeyOrder::MAX_KEYS];
   bool running;
   TaskHandle_t sshTaskHandle;
-  volatile bool activeSSHSession;
-  bool specialCharacterMode;
+  std::atomic<int> activeSessions{0};
+  std::atomic<bool> rotatingHostKeys{false};
   SerialWriteCallback serialWrite;
   SpecialCharacterHandler &specialCharacterHandler;
 
-  // FreeRTOS queue for thread-safe serial→SSH data transfer
-  QueueHandle_t serialToSSHQueue;
-  static constexpr size_t SSH_QUEUE_SIZE = 10;
-  static constexpr size_t SSH_QUEUE_PAYLOAD_SIZE = 127;
-  static constexpr size_t SSH_QUEUE_ITEM_SIZE =
-      SSH_QUEUE_PAYLOAD_SIZE + 1; // +1 length byte
+  /**
+   * @brief One connection, from key exchange to disconnect
+   */
+  struct Session {
+    SSHServer *server{nullptr};
+    void *session{nullptr}; // Opaque pointer to ssh_session
+    TaskHandle_t task{nullptr};
+    size_t cursor{0};    // read position in output
+    size_t replayEnd{0}; // output position where a replay catches up
+    bool replaying{false};
+    bool specialCharacterMode{false};
+    std::atomic<bool> inUse{false};
+    void *event{nullptr}; // Opaque pointer to ssh_event: socket + wakeFd
+    int wakeFd{-1};       // eventfd, signalled when output arrives; kept
+                          // for the slot's lifetime, see begin()
+    bool wakeRegistered{false};       // wakeFd is polled by event
+    std::atomic<bool> waiting{false}; // blocked in waitForEvent()
+    WriteBatch<SSH_WRITE_BATCH_SIZE> pending; // next channel write
+  };
+  Session sessions[SSH_MAX_SESSIONS];
+
+  // Serial→SSH output for all sessions; writers are serialized by
+  // outputMutex since the ring takes a single producer
+  BroadcastRing<SSH_SESSION_BACKLOG> output;
+  SemaphoreHandle_t outputMutex;
+  // Batch space kept free for a drop note and the end-of-scrollback marker
+  static constexpr size_t SSH_NOTE_RESERVE = 64;
   static constexpr int SSH_PORT = 22;
   static constexpr int SSH_RSA_KEY_BITS = 2048;
   static constexpr uint32_t SSH_TASK_STACK_SIZE = 8192;
+  static constexpr uint32_t SSH_SESSION_TASK_STACK_SIZE = 8192;
   static constexpr UBaseType_t SSH_TASK_PRIORITY = 1;
-  static constexpr TickType_t SSH_QUEUE_TIMEOUT_MS = 10;
   static constexpr uint32_t SSH_AUTH_TIMEOUT_MS = 30000;
   static constexpr uint32_t SSH_CHANNEL_TIMEOUT_MS = 10000;
   static constexpr uint32_t SSH_SHELL_TIMEOUT_MS = 10000;
   static constexpr uint32_t SSH_SESSION_TIMEOUT_MS = 3600000; // 1 hour
+  // Longest sleep in waitForEvent() when output can't wake the session
+  static constexpr uint32_t SSH_UNWAKEABLE_POLL_MS = 20;
   SshLog sshLog;
 
 public:
@@ -65,7 +119,8 @@ public:
   /**
    * @brief Initialize the SSH server and start the FreeRTOS task
    *
-   * Starts listening on port 22 for incoming SSH connections
+   * Returns without waiting for the host keys: the task loads or generates
+   * them in the background and only then starts listening on port 22.
    */
   void setup();
 
@@ -84,8 +139,9 @@ public:
   /**
    * @brief Send data to connected SSH clients (called from main loop)
    *
-   * This method is thread-safe and non-blocking. Data is queued for
-   * transmission to SSH clients.
+   * This method is thread-safe and never waits for a client. Every open
+   * session gets the data; one that is too far behind loses its oldest
+   * unsent output.
    *
    * @param data Data to send to SSH clients
    */
@@ -98,18 +154,39 @@ public:
    */
   bool isRunning() const;
 
+  /**
+   * @return true while at least one shell session is open
+   */
+  bool hasActiveSession() const { return activeSessions.load() > 0; }
+
   SshLog &getStream() { return sshLog; }
 
 private:
   static void sshTask(void *parameter);
   void runSSHTask();
-  void handleSSHSession(void *session);
+  bool startListening();
+  static void sessionTask(void *parameter);
+  void runSession(Session &session);
+  void handleSSHSession(Session &session);
   bool authenticateUser(const char *user, const char *password);
+  bool authenticateKey(const char *user, void *key);
+  int authMethods() const;
   void sendWelcomeMessage(void *channel);
-  types::string handleSpecialCharacter(char c);
-  bool authenticateSession(void *session);
-  bool waitForChannelSession(void *session, void **channel);
-  bool waitForShellRequest(void *session, void *channel);
+  void startReplay(Session &session, void *channel, size_t length);
+  types::string handleSpecialCharacter(char c, bool &specialCharacterMode);
+  bool authenticateSession(Session &state);
+  bool waitForChannelSession(Session &state, void **channel);
+  bool waitForShellRequest(Session &state, void *channel);
+  /**
+   * @brief Sleep until the client sends data, output arrives or timeoutMs
+   *        after `since` (a millis() value) has passed
+   * @return false if the connection broke
+   */
+  bool waitForEvent(Session &session, uint32_t since, uint32_t timeoutMs);
+  void *loadOrGenerateHostKey(const SshHostKeyInfo &info);
+  void *generateHostKey(const SshHostKeyInfo &info, SshHostKeyStore &store);
+  types::string rotateHostKey();
+  static types::string fingerprint(void *key);
 };
 
 } // namespace jrb::wifi_serial
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "infrastructure/types.hpp"
 #include "infrastructure/memory/circular_buffer.hpp"
 #include <algorithm>
 namespace jrb::wifi_serial {
@@ -8,6 +9,14 @@ namespace jrb::wifi_serial {
 template <size_t SIZE>
 class ByteCircularBuffer : public CircularBuffer<uint8_t, SIZE> {
 public:
+  // The ring is its own backlog: it always accepts data and the web poller
+  // drains whatever is left when it next asks.
+  static constexpr size_t INACTIVE_BACKLOG = SIZE;
+
+  bool active() const { return true; }
+  void retain(uint8_t byte) { this->append(byte); }
+  void retain(const types::span<const uint8_t> &data) { this->append(data); }
+
   size_t drainTo(uint8_t *buffer, size_t size) {
     size_t n = this->size();
     if (n == 0 || size == 0)
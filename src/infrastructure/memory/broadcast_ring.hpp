@@ -0,0 +1,145 @@
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Single-producer byte ring read by any number of independent readers
+ *
+ * Every reader keeps its own cursor (a free-running position, like the
+ * SpscRing indices) and sees every byte written after it attached. The
+ * producer never waits for readers: it overwrites the oldest bytes, so a
+ * reader that falls more than SIZE bytes behind loses the overwritten part,
+ * and only that reader. The others, and the producer, don't notice.
+ *
+ * Readers don't write shared state, so there is no limit on their number.
+ * Because the producer may overwrite bytes while a reader copies them, it
+ * announces the range it is about to write (`reserved`) before touching the
+ * buffer; a reader checks that announcement after copying and discards
+ * whatever may have been overwritten underneath it.
+ *
+ * One producer only: callers with several writers serialize them.
+ */
+template <size_t SIZE> class BroadcastRing {
+public:
+  BroadcastRing() {
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0,
+                  "BroadcastRing SIZE must be power of two");
+  }
+  BroadcastRing(const BroadcastRing &) = delete;
+  BroadcastRing &operator=(const BroadcastRing &) = delete;
+
+  // ---- Producer side ----
+
+  void append(const types::span<const uint8_t> &data) {
+    write(data.data(), data.size());
+  }
+
+  /**
+   * @brief Copy data in, overwriting the oldest bytes if needed
+   *
+   * Only the last SIZE bytes of a larger write are kept.
+   */
+  void write(const uint8_t *data, size_t length) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    reserved.store(h + length, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const size_t kept = std::min(length, SIZE);
+    copyIn(h + length - kept, data + length - kept, kept);
+    head.store(h + length, std::memory_order_release);
+  }
+
+  /**
+   * @brief Free-running position of the next byte written
+   *
+   * A new reader starts here to see only bytes written from now on.
+   */
+  size_t writePosition() const { return head.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Position `length` bytes back from the newest byte, for a reader
+   *        that wants recent history
+   *
+   * Never further back than the ring holds or than was ever written.
+   */
+  size_t replayPosition(size_t length) const {
+    const size_t h = head.load(std::memory_order_acquire);
+    return h - std::min({length, h, SIZE});
+  }
+
+  // ---- Reader side (any task, one cursor per reader) ----
+
+  /**
+   * @brief Read up to `size` bytes from `cursor` on and advance it
+   * @param lostBefore Set to the number of bytes overwritten before this
+   *        reader got to them, right in front of the bytes returned
+   * @return Bytes copied into buffer (0 with lostBefore > 0 is possible)
+   */
+  size_t read(size_t &cursor, uint8_t *buffer, size_t size,
+              size_t &lostBefore) const {
+    lostBefore = 0;
+    const size_t h = head.load(std::memory_order_acquire);
+    if (h - cursor > SIZE) {
+      lostBefore = h - SIZE - cursor;
+      cursor = h - SIZE;
+    }
+    const size_t n = std::min(size, h - cursor);
+    copyOut(cursor, buffer, n);
+
+    // Anything below reserved - SIZE may have been rewritten while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const size_t oldestIntact =
+        reserved.load(std::memory_order_relaxed) - SIZE;
+    size_t torn = 0;
+    if (static_cast<ptrdiff_t>(oldestIntact - cursor) > 0)
+      torn = std::min(n, oldestIntact - cursor);
+    if (torn > 0) {
+      memmove(buffer, buffer + torn, n - torn);
+      lostBefore += torn;
+    }
+    cursor += n;
+    return n - torn;
+  }
+
+  /**
+   * @brief Bytes written but not yet read through this cursor (may exceed
+   *        SIZE if the reader already lost some)
+   */
+  size_t pending(size_t cursor) const {
+    return head.load(std::memory_order_acquire) - cursor;
+  }
+
+  static constexpr size_t capacity() { return SIZE; }
+
+private:
+  std::array<uint8_t, SIZE> buffer{};
+  std::atomic<size_t> head{0};     // next write position
+  std::atomic<size_t> reserved{0}; // end of the write in progress
+
+  void copyIn(size_t position, const uint8_t *data, size_t length) {
+    if (length == 0)
+      return;
+    const size_t offset = position & (SIZE - 1);
+    const size_t first = std::min(length, SIZE - offset);
+    memcpy(&buffer[offset], data, first);
+    memcpy(buffer.data(), data + first, length - first);
+  }
+
+  void copyOut(size_t position, uint8_t *data, size_t length) const {
+    if (length == 0)
+      return;
+    const size_t offset = position & (SIZE - 1);
+    const size_t first = std::min(length, SIZE - offset);
+    memcpy(data, &buffer[offset], first);
+    memcpy(data + first, buffer.data(), length - first);
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -3,27 +3,75 @@
 #include "config.h"
 #include "infrastructure/logging/logger.h"
 #include "infrastructure/types.hpp"
+#include <algorithm>
 #include <array>
 #include <cstdint>
 
 namespace jrb::wifi_serial {
 
-template <typename FlushPolicy, size_t SIZE> class BufferedStream final {
+/**
+ * @brief Line-buffered byte sink that hands complete chunks to a FlushPolicy
+ *
+ * The FlushPolicy decides whether anybody is listening (`active()`) and how
+ * many of the most recent bytes to keep while nobody is
+ * (`INACTIVE_BACKLOG`, 0 = discard). Retained bytes are replayed by the first
+ * flush after the sink becomes active again.
+ *
+ * Every byte that reaches the stream gets a 32-bit stream offset, including
+ * bytes that are later dropped (overflow, trimmed backlog, skip()). Each flush
+ * passes the offset of its first byte, so a receiver can tell exactly which
+ * ranges never arrived.
+ *
+ * With MAX_IN_FLIGHT > 0 and setAckWindow(n), flush() publishes through
+ * `FlushPolicy::publishAcked()` instead: each chunk stays in the ring until
+ * acknowledge() gets its packet id, at most n chunks are outstanding, and
+ * resendInFlight() makes them all go out again on the next flush. Chunks
+ * are released strictly in order, so the ring is the retransmit buffer.
+ */
+template <typename FlushPolicy, size_t SIZE, size_t MAX_IN_FLIGHT = 0>
+class BufferedStream final {
+public:
+  static constexpr size_t INACTIVE_BACKLOG = FlushPolicy::INACTIVE_BACKLOG;
+
 private:
+  // A published chunk awaiting its acknowledgement
+  struct InFlight {
+    uint16_t packetId;
+    uint16_t length;
+    bool acked;
+  };
+
   std::array<uint8_t, SIZE> buffer;
   size_t head{0};
   size_t tail{0};
   size_t size{0};
+  uint32_t tailOffset{0}; // stream offset of buffer[tail]
+  bool lineFlush{true};
   FlushPolicy flusher;
   const char *name;
 
+  // Acknowledged mode: the first `sent` bytes from tail are in flight
+  std::array<InFlight, MAX_IN_FLIGHT> inFlight;
+  size_t inFlightFirst{0};
+  size_t inFlightCount{0};
+  size_t ackWindow{0};
+  size_t sent{0};
+  bool flushHeld{false}; // a flush left bytes behind for lack of window
+
 public:
   explicit BufferedStream(FlushPolicy &&flusher_, const char *name_)
       : flusher(flusher_), name(name_) {
     static_assert((SIZE & (SIZE - 1)) == 0,
                   "MQTT_BUFFER_SIZE must be power of two");
+    static_assert(INACTIVE_BACKLOG <= SIZE,
+                  "INACTIVE_BACKLOG must fit in the stream buffer");
   }
 
+  /**
+   * @brief Cheap check whether the flush target currently has a consumer
+   */
+  bool active() const { return flusher.active(); }
+
   void append(uint8_t byte) {
     // Overflow check
     if (needsFlushForOverflow(1)) {
@@ -35,13 +83,13 @@ public:
 
     if (full()) {
       LOG_WARN("MQTT buffer overflow");
-      tail = (tail + 1) & (SIZE - 1);
+      dropOldest();
     } else {
       size++;
     }
 
     // Delimiter check
-    if (byte == '\n') {
+    if (byte == '\n' && lineFlush) {
       flush();
     }
   }
@@ -60,35 +108,264 @@ public:
     }
   }
 
+  /**
+   * @brief Keep a byte that arrived while the sink was inactive
+   *
+   * No delimiter or overflow flushing happens here: the oldest byte is
+   * dropped once INACTIVE_BACKLOG bytes are held.
+   */
+  void retain(uint8_t byte) {
+    if constexpr (INACTIVE_BACKLOG == 0) {
+      return;
+    } else {
+      if (size >= INACTIVE_BACKLOG) {
+        dropOldest();
+        size--;
+      }
+      buffer[head] = byte;
+      head = (head + 1) & (SIZE - 1);
+      size++;
+    }
+  }
+
+  void retain(const types::span<const uint8_t> &data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      retain(data[i]);
+    }
+  }
+
+  /**
+   * @brief Account for bytes that bypass the stream (dropped or stored
+   * elsewhere)
+   *
+   * Buffered bytes are older than the hole: they are flushed first while
+   * active and discarded otherwise, so offsets stay contiguous per flush.
+   * The ring can't hold a hole: in acknowledged mode whatever is still held
+   * afterwards (in flight, or waiting for window) is dropped with it.
+   */
+  void skip(size_t count) {
+    if (count == 0)
+      return;
+    if (!empty()) {
+      if (active())
+        flush();
+      tailOffset += static_cast<uint32_t>(size);
+      tail = head;
+      size = 0;
+      forgetInFlight();
+    }
+    tailOffset += static_cast<uint32_t>(count);
+  }
+
   void flush() {
+    if constexpr (MAX_IN_FLIGHT > 0) {
+      if (ackWindow > 0) {
+        publishUnsent();
+        return;
+      }
+    }
+    drain([this](const types::span<const uint8_t> &chunk, uint32_t offset) {
+      flusher.flush(chunk, offset, name);
+    });
+  }
+
+  /**
+   * @brief Publish with acknowledgements, at most `window` chunks in flight
+   *
+   * 0 returns to fire-and-forget flushes; bytes still in flight then count
+   * as delivered. Clamped to MAX_IN_FLIGHT.
+   */
+  void setAckWindow(size_t window) {
+    window = std::min(window, MAX_IN_FLIGHT);
+    if (window == 0 && ackWindow > 0)
+      release(sent);
+    ackWindow = window;
+  }
+
+  size_t getAckWindow() const { return ackWindow; }
+
+  /**
+   * @brief Release the chunk published as packetId
+   *
+   * The ring is only trimmed up to the oldest chunk still unacknowledged.
+   * @return false if packetId isn't one of this stream's chunks
+   */
+  bool acknowledge(uint16_t packetId) {
+    if constexpr (MAX_IN_FLIGHT == 0) {
+      return false;
+    } else {
+      if (packetId == 0)
+        return false;
+      bool found = false;
+      for (size_t i = 0; i < inFlightCount && !found; ++i) {
+        InFlight &chunk = inFlight[(inFlightFirst + i) % MAX_IN_FLIGHT];
+        if (chunk.packetId == packetId && !chunk.acked) {
+          chunk.acked = true;
+          found = true;
+        }
+      }
+      size_t released = 0;
+      for (size_t i = 0; i < inFlightCount; ++i) {
+        const InFlight &chunk = inFlight[(inFlightFirst + i) % MAX_IN_FLIGHT];
+        if (!chunk.acked)
+          break;
+        released += chunk.length;
+      }
+      release(released);
+      return found;
+    }
+  }
+
+  /**
+   * @brief Publish every unacknowledged byte again on the next flush
+   *
+   * For a lost connection: its packet ids mean nothing to the next one.
+   */
+  void resendInFlight() {
+    if (sent > 0)
+      flushHeld = true;
+    forgetInFlight();
+  }
+
+  /**
+   * @brief Finish a flush that ran out of window; no-op otherwise
+   */
+  void flushHeldBytes() {
+    if (flushHeld)
+      flush();
+  }
+
+  size_t inFlightChunks() const { return inFlightCount; }
+  size_t unacknowledged() const { return sent; }
+
+  /**
+   * @brief Hand every buffered byte to fn(chunk, offset) and empty the stream
+   *
+   * A wrapped buffer takes two calls. Lets the owner route the bytes
+   * somewhere other than the flush policy without losing their offsets.
+   */
+  template <typename Fn> void drain(Fn &&fn) {
+    forgetInFlight();
     if (empty())
       return;
 
-    if (head > tail || full()) {
+    if (tail + size <= SIZE) {
       // Contiguous segment
-      types::span<const uint8_t> span(&buffer[tail], size);
-      flusher.flush(span, name);
+      fn(types::span<const uint8_t>(&buffer[tail], size), tailOffset);
     } else {
-      // Wrapped segment: send two chunks
+      // Wrapped segment: two chunks
       types::span<const uint8_t> span1(&buffer[tail], SIZE - tail);
-      flusher.flush(span1, name);
+      fn(span1, tailOffset);
       if (head > 0) {
-        types::span<const uint8_t> span2(&buffer[0], head);
-        flusher.flush(span2, name);
+        fn(types::span<const uint8_t>(&buffer[0], head),
+           tailOffset + static_cast<uint32_t>(span1.size()));
       }
     }
 
+    tailOffset += static_cast<uint32_t>(size);
     tail = head;
     size = 0;
   }
 
+  /**
+   * @brief Flush on '\n' (default) or leave batching to the owner
+   */
+  void setLineFlush(bool enabled) { lineFlush = enabled; }
+
   bool full() const { return size == SIZE; }
   bool empty() const { return size == 0; }
+  size_t buffered() const { return size; }
+  size_t unsent() const { return size - sent; }
+
+  /**
+   * @brief Bytes append() (active) or retain() takes without dropping any
+   */
+  size_t room() const {
+    const size_t limit = active() ? SIZE : INACTIVE_BACKLOG;
+    return size < limit ? limit - size : 0;
+  }
+
+  FlushPolicy &flushPolicy() { return flusher; }
+
+  /**
+   * @brief Stream offset the next appended byte will get
+   */
+  uint32_t nextOffset() const {
+    return tailOffset + static_cast<uint32_t>(size);
+  }
 
 private:
   bool needsFlushForOverflow(size_t dataSize) const {
     return (size + dataSize) > SIZE;
   }
+
+  // Advance past buffer[tail]; size is the caller's. An in-flight byte
+  // shrinks its chunk, whose acknowledgement then releases the rest.
+  void dropOldest() {
+    tail = (tail + 1) & (SIZE - 1);
+    tailOffset++;
+    if constexpr (MAX_IN_FLIGHT > 0) {
+      if (sent == 0)
+        return;
+      sent--;
+      if (--inFlight[inFlightFirst].length == 0)
+        popInFlight();
+    }
+  }
+
+  void publishUnsent() {
+    if constexpr (MAX_IN_FLIGHT > 0) {
+      flushHeld = false;
+      while (sent < size) {
+        if (inFlightCount == ackWindow) {
+          flushHeld = true;
+          return;
+        }
+        // One contiguous run per publish; a wrapped ring takes two
+        const size_t start = (tail + sent) & (SIZE - 1);
+        const size_t length = std::min(size - sent, SIZE - start);
+        const uint16_t packetId = flusher.publishAcked(
+            types::span<const uint8_t>(&buffer[start], length),
+            tailOffset + static_cast<uint32_t>(sent));
+        if (packetId == 0) {
+          // Not connected or the send queue is full: retried later
+          flushHeld = true;
+          return;
+        }
+        inFlight[(inFlightFirst + inFlightCount) % MAX_IN_FLIGHT] = {
+            packetId, static_cast<uint16_t>(length), false};
+        inFlightCount++;
+        sent += length;
+      }
+    }
+  }
+
+  // Drop `count` acknowledged bytes from the tail along with their chunks
+  void release(size_t count) {
+    if constexpr (MAX_IN_FLIGHT > 0) {
+      tail = (tail + count) & (SIZE - 1);
+      tailOffset += static_cast<uint32_t>(count);
+      size -= count;
+      sent -= count;
+      while (count > 0) {
+        count -= inFlight[inFlightFirst].length;
+        popInFlight();
+      }
+    }
+  }
+
+  void popInFlight() {
+    if constexpr (MAX_IN_FLIGHT > 0) {
+      inFlightFirst = (inFlightFirst + 1) % MAX_IN_FLIGHT;
+      inFlightCount--;
+    }
+  }
+
+  void forgetInFlight() {
+    inFlightFirst = 0;
+    inFlightCount = 0;
+    sent = 0;
+  }
 };
 
 } // namespace jrb::wifi_serial
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "infrastructure/memory/spsc_ring.hpp"
+#include "infrastructure/types.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief SPSC byte ring that tells the consumer where bytes were dropped
+ *
+ * A plain SpscRing drops whatever doesn't fit and only counts it. Here the
+ * producer also remembers how many bytes it lost and, right before the next
+ * byte it manages to write, publishes a (position, count) record in a small
+ * side ring. The record is published before the bytes behind it, so the
+ * consumer always learns about a hole before it reads past it.
+ *
+ * If the side ring is full the producer keeps dropping (and counting) until
+ * it can record the hole, so positions reported to the consumer stay exact.
+ */
+template <size_t SIZE, size_t GAP_RECORDS_SIZE = 128> class LossTrackingRing {
+public:
+  LossTrackingRing() = default;
+  LossTrackingRing(const LossTrackingRing &) = delete;
+  LossTrackingRing &operator=(const LossTrackingRing &) = delete;
+
+  // ---- Producer side ----
+
+  void append(uint8_t byte) { append(types::span<const uint8_t>(&byte, 1)); }
+
+  void append(const types::span<const uint8_t> &data) {
+    if (data.empty())
+      return;
+    if (lost > 0 && (bytes.freeSpace() == 0 || !recordGap())) {
+      lost += data.size();
+      return;
+    }
+    lost += data.size() - bytes.write(data.data(), data.size());
+  }
+
+  /**
+   * @brief Free-running ring position of the next byte that gets written
+   */
+  size_t writePosition() const { return bytes.writePosition(); }
+
+  // ---- Consumer side ----
+
+  /**
+   * @brief Read surviving bytes, stopping at the next hole
+   * @param lostBefore Set to the number of bytes dropped right before the
+   *        first byte returned (0 if none)
+   * @return Bytes copied into buffer
+   */
+  size_t read(uint8_t *buffer, size_t size, size_t &lostBefore) {
+    lostBefore = 0;
+    // Load the fill level first: any hole in front of those bytes was
+    // recorded before they were published
+    const size_t available = bytes.size();
+    if (available == 0)
+      return 0;
+
+    if (!gapPending)
+      gapPending = popGap();
+    const uint32_t position = static_cast<uint32_t>(bytes.readPosition());
+    if (gapPending && gapPosition == position) {
+      lostBefore = gapLength;
+      gapPending = popGap();
+    }
+
+    size_t limit = std::min(size, available);
+    if (gapPending)
+      limit = std::min<size_t>(limit, gapPosition - position);
+    return bytes.read(buffer, limit);
+  }
+
+  /**
+   * @brief Free-running ring position of the next byte read() returns
+   */
+  size_t readPosition() const { return bytes.readPosition(); }
+
+  // ---- Either side (snapshot values) ----
+
+  size_t size() const { return bytes.size(); }
+  bool empty() const { return bytes.empty(); }
+
+private:
+  static constexpr size_t GAP_RECORD_SIZE = 8; // position, count (BE u32)
+
+  SpscRing<SIZE> bytes;
+  SpscRing<GAP_RECORDS_SIZE> gaps;
+
+  // Producer-only
+  size_t lost{0};
+
+  // Consumer-only
+  bool gapPending{false};
+  uint32_t gapPosition{0};
+  uint32_t gapLength{0};
+
+  bool recordGap() {
+    uint8_t record[GAP_RECORD_SIZE];
+    putU32(record, static_cast<uint32_t>(bytes.writePosition()));
+    putU32(record + 4, static_cast<uint32_t>(lost));
+    if (!gaps.pushMessage(types::span<const uint8_t>(record, sizeof(record))))
+      return false;
+    lost = 0;
+    return true;
+  }
+
+  bool popGap() {
+    uint8_t record[GAP_RECORD_SIZE];
+    size_t length = 0;
+    if (!gaps.popMessage(record, sizeof(record), length))
+      return false;
+    gapPosition = getU32(record);
+    gapLength = getU32(record + 4);
+    return true;
+  }
+
+  static void putU32(uint8_t *out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+  }
+
+  static uint32_t getU32(const uint8_t *in) {
+    return (static_cast<uint32_t>(in[0]) << 24) |
+           (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | in[3];
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Lock-free single-producer/single-consumer byte ring
+ *
+ * Hands bytes between exactly two tasks without a mutex or a FreeRTOS queue:
+ * the producer only writes `head`, the consumer only writes `tail`, and both
+ * indices run freely (masked on access), so `head - tail` is always the fill
+ * level. Acquire/release ordering publishes the payload before the index.
+ *
+ * Unlike CircularBuffer a full ring never overwrites: the producer side drops
+ * what doesn't fit and counts it, because the consumer may be reading the
+ * oldest bytes at that very moment.
+ *
+ * Besides the raw byte stream the ring can carry length-prefixed messages
+ * (pushMessage/popMessage) when record boundaries matter.
+ */
+template <size_t SIZE> class SpscRing {
+public:
+  SpscRing() {
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0,
+                  "SpscRing SIZE must be power of two");
+  }
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  // ---- Producer side ----
+
+  void append(uint8_t byte) { write(&byte, 1); }
+
+  void append(const types::span<const uint8_t> &data) {
+    write(data.data(), data.size());
+  }
+
+  /**
+   * @brief Copy as much of the data as fits
+   * @return Bytes accepted; the rest is counted in dropped()
+   */
+  size_t write(const uint8_t *data, size_t length) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t t = tail.load(std::memory_order_acquire);
+    const size_t n = std::min(length, SIZE - (h - t));
+    copyIn(h, data, n);
+    head.store(h + n, std::memory_order_release);
+    if (n < length)
+      droppedBytes.fetch_add(length - n, std::memory_order_relaxed);
+    return n;
+  }
+
+  /**
+   * @brief Queue one length-prefixed message, all or nothing
+   */
+  bool pushMessage(const types::span<const uint8_t> &message) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t t = tail.load(std::memory_order_acquire);
+    const size_t needed = message.size() + MESSAGE_HEADER_SIZE;
+    if (message.size() > UINT16_MAX || needed > SIZE - (h - t)) {
+      droppedBytes.fetch_add(message.size(), std::memory_order_relaxed);
+      return false;
+    }
+    const uint8_t header[MESSAGE_HEADER_SIZE] = {
+        static_cast<uint8_t>(message.size() >> 8),
+        static_cast<uint8_t>(message.size() & 0xFF)};
+    copyIn(h, header, MESSAGE_HEADER_SIZE);
+    copyIn(h + MESSAGE_HEADER_SIZE, message.data(), message.size());
+    head.store(h + needed, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Free-running index of the next byte the producer writes
+   */
+  size_t writePosition() const { return head.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Room left for the producer
+   */
+  size_t freeSpace() const {
+    return SIZE - (head.load(std::memory_order_relaxed) -
+                   tail.load(std::memory_order_acquire));
+  }
+
+  // ---- Consumer side ----
+
+  /**
+   * @brief Move up to `size` bytes out of the ring
+   * @return Bytes copied into buffer
+   */
+  size_t read(uint8_t *buffer, size_t size) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    const size_t h = head.load(std::memory_order_acquire);
+    const size_t n = std::min(size, h - t);
+    copyOut(t, buffer, n);
+    tail.store(t + n, std::memory_order_release);
+    return n;
+  }
+
+  /**
+   * @brief Pop the next message pushed with pushMessage()
+   *
+   * A message larger than `size` is consumed and discarded so the ring
+   * stays in sync.
+   *
+   * @return false if no message is queued or it did not fit
+   */
+  bool popMessage(uint8_t *buffer, size_t size, size_t &length) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    const size_t h = head.load(std::memory_order_acquire);
+    if (h - t < MESSAGE_HEADER_SIZE)
+      return false;
+    uint8_t header[MESSAGE_HEADER_SIZE];
+    copyOut(t, header, MESSAGE_HEADER_SIZE);
+    length = (static_cast<size_t>(header[0]) << 8) | header[1];
+    const bool fits = length <= size;
+    if (fits)
+      copyOut(t + MESSAGE_HEADER_SIZE, buffer, length);
+    tail.store(t + MESSAGE_HEADER_SIZE + length, std::memory_order_release);
+    return fits;
+  }
+
+  /**
+   * @brief Free-running index of the next byte the consumer reads
+   */
+  size_t readPosition() const { return tail.load(std::memory_order_relaxed); }
+
+  // ---- Either side (snapshot values) ----
+
+  size_t size() const {
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  size_t dropped() const { return droppedBytes.load(std::memory_order_relaxed); }
+  static constexpr size_t capacity() { return SIZE; }
+
+private:
+  static constexpr size_t MESSAGE_HEADER_SIZE = 2; // big-endian length
+
+  std::array<uint8_t, SIZE> buffer;
+  std::atomic<size_t> head{0}; // next write position (producer)
+  std::atomic<size_t> tail{0}; // next read position (consumer)
+  std::atomic<size_t> droppedBytes{0};
+
+  void copyIn(size_t position, const uint8_t *data, size_t length) {
+    if (length == 0)
+      return;
+    const size_t offset = position & (SIZE - 1);
+    const size_t first = std::min(length, SIZE - offset);
+    memcpy(&buffer[offset], data, first);
+    memcpy(buffer.data(), data + first, length - first);
+  }
+
+  void copyOut(size_t position, uint8_t *data, size_t length) const {
+    if (length == 0)
+      return;
+    const size_t offset = position & (SIZE - 1);
+    const size_t first = std::min(length, SIZE - offset);
+    memcpy(data, &buffer[offset], first);
+    memcpy(data + first, buffer.data(), length - first);
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief Fixed buffer that gathers bytes from several sources into one write
+ *
+ * Callers append what is ready, or fill tail() directly and commit(), then
+ * hand data()/size() to a single write and clear(). Nothing is ever split:
+ * an append or insert that doesn't fit changes nothing and returns false.
+ */
+template <size_t SIZE> class WriteBatch {
+public:
+  WriteBatch() = default;
+  WriteBatch(const WriteBatch &) = delete;
+  WriteBatch &operator=(const WriteBatch &) = delete;
+
+  bool append(const void *data, size_t length) {
+    return insert(used, data, length);
+  }
+
+  /**
+   * @brief Insert bytes at `position`, moving the bytes after it along
+   */
+  bool insert(size_t position, const void *data, size_t length) {
+    if (length > room() || position > used)
+      return false;
+    memmove(&buffer[position + length], &buffer[position], used - position);
+    memcpy(&buffer[position], data, length);
+    used += length;
+    return true;
+  }
+
+  /**
+   * @brief Free space, for a caller that writes into tail() itself
+   */
+  uint8_t *tail() { return buffer.data() + used; }
+  size_t room() const { return SIZE - used; }
+
+  /**
+   * @brief Account for `length` bytes written at tail() (at most room())
+   */
+  void commit(size_t length) { used += std::min(length, room()); }
+
+  const uint8_t *data() const { return buffer.data(); }
+  size_t size() const { return used; }
+  bool empty() const { return used == 0; }
+  void clear() { used = 0; }
+  static constexpr size_t capacity() { return SIZE; }
+
+private:
+  std::array<uint8_t, SIZE> buffer{};
+  size_t used{0};
+};
+
+} // namespace jrb::wifi_serial
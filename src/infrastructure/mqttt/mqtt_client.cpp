@@ -4,10 +4,12 @@
 #include "infrastructure/logging/logger.h"
 #include "infrastructure/types.hpp"
 #include "infrastructure/mqttt/pub_sub_client_policy.h"
+#include "domain/messaging/tty_mux.h"
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
-#include <string_view>
+#include <type_traits>
 
 #ifndef ESP_PLATFORM
 #include "infrastructure/platform/arduino_compat.h"
@@ -22,8 +24,15 @@ constexpr size_t MQTT_CALLBACK_BUFFER_SIZE = 512;
 constexpr uint8_t MQTT_QOS_LEVEL = 1;
 constexpr uint16_t MQTT_KEEPALIVE_SEC = 60;
 constexpr uint16_t MQTT_SOCKET_TIMEOUT_SEC = 15;
-constexpr uint8_t MQTT_SUBSCRIPTION_DELAY_MS = 10;
-constexpr uint8_t MQTT_LOOP_ITERATIONS = 3;
+constexpr size_t MQTT_DRAIN_CHUNK_SIZE = 64;
+constexpr size_t MQTT_UPLOAD_ACK_SIZE = 96;
+
+// A chunk is queued as one rx ring message and must fit one MQTT packet
+static_assert(MQTT_UPLOAD_CHUNK_SIZE < MQTT_CALLBACK_BUFFER_SIZE,
+              "upload chunks must fit the rx dispatch buffer");
+static_assert(MQTT_UPLOAD_CHUNK_SIZE + MqttUploadReceiver::HEADER_SIZE + 128 <=
+                  MQTT_BUFFER_SIZE,
+              "upload chunks must fit an MQTT packet with its topic");
 } // namespace
 
 template <typename PubSubClientPolicy>
@@ -33,18 +42,42 @@ MqttClient<PubSubClientPolicy>::MqttClient(
     : mqttClient{mqttClient}, preferencesStorage{preferencesStorage},
       connected{false}, lastReconnectAttempt{0}, onTty0Callback{nullptr},
       onTty1Callback{nullptr},
-      tty0Stream{MqttFlushPolicy<PubSubClientPolicy>{mqttClient, topicTty0Tx}, "tty0"},
-      tty1Stream{MqttFlushPolicy<PubSubClientPolicy>{mqttClient, topicTty1Tx}, "tty1"},
-      tty0LastFlushMillis{0}, tty1LastFlushMillis{0} {
+      muxBatch{mqttClient, topicMuxTx, preferencesStorage.mqttMultiplex},
+      tty0Stream{MqttFlushPolicy<PubSubClientPolicy>{
+                     mqttClient, topicTty0Tx, connected,
+                     preferencesStorage.mqttFramed,
+                     preferencesStorage.mqttCompressed,
+                     preferencesStorage.mqttJson, 0, &muxBatch},
+                 "tty0"},
+      tty1Stream{MqttFlushPolicy<PubSubClientPolicy>{
+                     mqttClient, topicTty1Tx, connected,
+                     preferencesStorage.mqttFramed,
+                     preferencesStorage.mqttCompressed,
+                     preferencesStorage.mqttJson, 1, &muxBatch},
+                 "tty1"},
+      tty0LastFlushMillis{0}, tty1LastFlushMillis{0}, publishBudget{millis()},
+      spillEnabled{false}, spillPacketId{0}, spillAcked{false},
+      spillNextReplayMillis{0} {
 
   mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
   mqttClient.setCallback([&](char *topic, byte *payload, unsigned int length) {
     mqttCallback(topic, payload, length);
   });
+  mqttClient.setPubAckCallback([&](uint16_t packetId) {
+    if (packetId != 0 && packetId == spillPacketId)
+      spillAcked = true;
+    else if (!tty0Stream.acknowledge(packetId))
+      tty1Stream.acknowledge(packetId);
+  });
   mqttClient.setKeepAlive(MQTT_KEEPALIVE_SEC);
   mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT_SEC);
+  // Set once: a broker refusing MQTT 5 leaves the client on 3.1.1
+  mqttClient.setProtocolVersion(preferencesStorage.mqttVersion5 ? 5 : 4);
   setTopics(preferencesStorage.topicTty0Rx, preferencesStorage.topicTty0Tx,
             preferencesStorage.topicTty1Rx, preferencesStorage.topicTty1Tx);
+  // Boot output changes fast: the first snapshot waits one interval too
+  for (auto &snapshot : snapshots)
+    snapshot.lastPublishMillis = millis();
 }
 
 template <typename PubSubClientPolicy>
@@ -68,7 +101,57 @@ void MqttClient<PubSubClientPolicy>::setTopics(const types::string &tty0Rx,
       topicInfo = topicInfo.substr(0, lastSlash) + "/info";
     }
   }
+  topicInfoDelta = topicInfo + "/delta";
   LOG_INFO("MQTT info topic set to: %s", topicInfo.c_str());
+
+  // Multiplexed topics sit next to the info topic: .../info -> .../mux/tx
+  types::string base = topicInfo;
+  if (base.size() >= 5 && base.substr(base.size() - 5) == "/info")
+    base.resize(base.size() - 5);
+  topicMuxTx = base + "/mux/tx";
+  topicMuxRx = base + "/mux/rx";
+
+  if (preferencesStorage.mqttMultiplex) {
+    // One subscription for every port's rx
+    router.add(topicMuxRx.c_str(), &MqttClient::receiveMux, this);
+  } else {
+    // A port without a tx topic isn't bridged, so its rx isn't subscribed
+    if (topicTty0Tx.length() > 0)
+      router.add(topicTty0Rx.c_str(), &MqttClient::queueRx, &tty0RxRing);
+    if (topicTty1Tx.length() > 0)
+      router.add(topicTty1Rx.c_str(), &MqttClient::queueRx, &tty1RxRing);
+  }
+
+  // Upload topics sit next to the rx topics: .../ttyS1/rx -> .../upload
+  const types::string *rxTopics[] = {&topicTty0Rx, &topicTty1Rx};
+  const types::string *txTopics[] = {&topicTty0Tx, &topicTty1Tx};
+  SpscRing<MQTT_RX_RING_SIZE> *rxRings[] = {&tty0RxRing, &tty1RxRing};
+  for (size_t port = 0; port < uploads.size(); ++port) {
+    Upload &upload = uploads[port];
+    upload.ring = rxRings[port];
+    upload.topic = *rxTopics[port];
+    if (upload.topic.empty() || txTopics[port]->empty()) {
+      upload.topic.clear();
+      continue;
+    }
+    if (upload.topic.size() >= 3 &&
+        upload.topic.substr(upload.topic.size() - 3) == "/rx")
+      upload.topic.resize(upload.topic.size() - 3);
+    upload.topic += "/upload";
+    upload.statusTopic = upload.topic + "/status";
+    router.add(upload.topic.c_str(), &MqttClient::receiveUpload, &upload);
+  }
+
+  // Snapshot topics sit next to the tx topics: .../ttyS1/tx -> .../snapshot
+  for (size_t port = 0; port < snapshots.size(); ++port) {
+    types::string &topic = snapshots[port].topic;
+    topic = *txTopics[port];
+    if (topic.empty())
+      continue;
+    if (topic.size() >= 3 && topic.substr(topic.size() - 3) == "/tx")
+      topic.resize(topic.size() - 3);
+    topic += "/snapshot";
+  }
 }
 
 template <typename PubSubClientPolicy>
@@ -79,6 +162,30 @@ void MqttClient<PubSubClientPolicy>::setCallbacks(
   onTty1Callback = tty1;
 }
 
+template <typename PubSubClientPolicy>
+bool MqttClient<PubSubClientPolicy>::setupSpill() {
+  spillEnabled = spillQueue.begin();
+  if (spillEnabled) {
+    LOG_INFO("MQTT offline spill enabled (%u x %u byte segments)",
+             (unsigned)MQTT_SPILL_MAX_SEGMENTS,
+             (unsigned)MQTT_SPILL_SEGMENT_SIZE);
+  }
+  return spillEnabled;
+}
+
+template <typename PubSubClientPolicy>
+bool MqttClient<PubSubClientPolicy>::addRoute(const char *filter,
+                                              Router::Handler handler,
+                                              void *context) {
+  if (!router.add(filter, handler, context)) {
+    LOG_ERROR("MQTT cannot route topic filter: %s", filter ? filter : "");
+    return false;
+  }
+  if (connected)
+    mqttClient.subscribe(filter, MQTT_QOS_LEVEL);
+  return true;
+}
+
 template <typename PubSubClientPolicy>
 bool MqttClient<PubSubClientPolicy>::connect(const char *broker, int port,
                                              const char *user,
@@ -100,15 +207,25 @@ bool MqttClient<PubSubClientPolicy>::connect(const char *broker, int port,
     result = mqttClient.connect(clientId.c_str());
   }
 
-  connected = result;
   if (!result) {
+    connected = false;
     LOG_ERROR("MQTT connection failed! State: %d", mqttClient.state());
     return false;
   }
 
+  // A non-blocking client only starts the handshake here; loop() picks up
+  // the CONNACK and subscribes via handleConnectionStateChange()
+  connected = mqttClient.connected();
+  if (!connected) {
+    LOG_INFO("MQTT connection in progress...");
+    return true;
+  }
+
   LOG_INFO("MQTT connected successfully!");
 
+  publishBudget.reset(millis());
   subscribeToConfiguredTopics();
+  replayRetainedOutput();
 
   return true;
 }
@@ -139,21 +256,18 @@ bool MqttClient<PubSubClientPolicy>::reconnect() {
 
 template <typename PubSubClientPolicy>
 void MqttClient<PubSubClientPolicy>::subscribeToConfiguredTopics() {
-  if (topicTty0Tx.length() > 0) {
-    LOG_INFO("Subscribing to tty0Rx: %s", topicTty0Rx.c_str());
-    mqttClient.subscribe(topicTty0Rx.c_str(), MQTT_QOS_LEVEL);
-    mqttClient.loop();
-    delay(MQTT_SUBSCRIPTION_DELAY_MS);
-    mqttClient.loop();
+  for (size_t i = 0; i < router.size(); ++i) {
+    LOG_INFO("Subscribing to %s", router.filter(i));
+    mqttClient.subscribe(router.filter(i), MQTT_QOS_LEVEL);
   }
+}
 
-  if (topicTty1Tx.length() > 0) {
-    LOG_INFO("Subscribing to tty1Rx: %s", topicTty1Rx.c_str());
-    mqttClient.subscribe(topicTty1Rx.c_str(), MQTT_QOS_LEVEL);
-    mqttClient.loop();
-    delay(MQTT_SUBSCRIPTION_DELAY_MS);
-    mqttClient.loop();
-  }
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::replayRetainedOutput() {
+  // Streams keep the most recent tty output while offline; publish it now
+  tty0Stream.flush();
+  tty1Stream.flush();
+  muxBatch.publish();
 }
 
 template <typename PubSubClientPolicy>
@@ -161,24 +275,52 @@ void MqttClient<PubSubClientPolicy>::handleConnectionStateChange(
     bool wasConnected) {
   if (wasConnected && !connected) {
     LOG_WARN("MQTT connection lost!");
+    // An unacknowledged replay publish is sent again after reconnecting, and
+    // so are the tty chunks still held for their PUBACK. Whatever was in
+    // flight may never arrive, so compression restarts too.
+    spillPacketId = 0;
+    spillAcked = false;
+    tty0Stream.resendInFlight();
+    tty1Stream.resendInFlight();
+    tty0Stream.flushPolicy().restartHistory();
+    tty1Stream.flushPolicy().restartHistory();
     return;
   }
 
   if (!wasConnected && connected) {
     LOG_INFO("MQTT reconnected successfully!");
+    if (!spillQueue.empty()) {
+      LOG_INFO("MQTT replaying %u bytes of offline tty output (%u dropped)",
+               (unsigned)spillQueue.size(), (unsigned)spillQueue.dropped());
+    }
+    publishBudget.reset(millis());
     subscribeToConfiguredTopics();
+    replayRetainedOutput();
   }
 }
 
 template <typename PubSubClientPolicy>
 void MqttClient<PubSubClientPolicy>::flushBuffersIfNeeded() {
-  if ((millis() - tty0LastFlushMillis >= MQTT_PUBLISH_INTERVAL_MS)) {
+  if (muxBatch.active()) {
+    flushMuxIfNeeded();
+    return;
+  }
+  if (batchedOutput()) {
+    flushFramesIfNeeded(tty0Stream, tty0LastFlushMillis);
+    flushFramesIfNeeded(tty1Stream, tty1LastFlushMillis);
+    return;
+  }
+
+  // Over budget the interval flush is retried every loop until it fits
+  if ((millis() - tty0LastFlushMillis >= MQTT_PUBLISH_INTERVAL_MS) &&
+      spend(Budget::Priority::Bulk)) {
     LOG_VERBOSE("Flushing tty0 buffer due to interval");
     tty0LastFlushMillis = millis();
     tty0Stream.flush();
   }
 
-  if ((millis() - tty1LastFlushMillis >= MQTT_PUBLISH_INTERVAL_MS)) {
+  if ((millis() - tty1LastFlushMillis >= MQTT_PUBLISH_INTERVAL_MS) &&
+      spend(Budget::Priority::Bulk)) {
     LOG_VERBOSE("Flushing tty1 buffer due to interval");
     tty1LastFlushMillis = millis();
     tty1Stream.flush();
@@ -186,38 +328,394 @@ void MqttClient<PubSubClientPolicy>::flushBuffersIfNeeded() {
 }
 
 template <typename PubSubClientPolicy>
-void MqttClient<PubSubClientPolicy>::loop() {
-  if (!mqttClient.connected())
+void MqttClient<PubSubClientPolicy>::flushFramesIfNeeded(
+    TtyStream &stream, unsigned long &lastFlushMillis) {
+  // Frames and JSON records carry their own offsets, so lines can be
+  // batched: publish when enough is queued or the oldest queued byte has
+  // waited long enough
+  if (stream.unsent() == 0)
     return;
-
-  // Transfer pending data from web task to MQTT buffers
-  while (!tty0PendingBuffer.empty()) {
-    tty0Stream.append(tty0PendingBuffer.popFront());
+  const unsigned long now = millis();
+  // Over budget the batch keeps growing; a full stream publishes itself
+  if ((stream.unsent() >= MQTT_FRAME_MIN_BYTES ||
+       now - lastFlushMillis >= MQTT_FRAME_MAX_DELAY_MS) &&
+      spend(Budget::Priority::Bulk)) {
+    stream.flush();
+    lastFlushMillis = now;
   }
+}
 
-  while (!tty1PendingBuffer.empty()) {
-    tty1Stream.append(tty1PendingBuffer.popFront());
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::flushMuxIfNeeded() {
+  // Batched like frames, but one publish carries both ports: once either is
+  // due, whatever the other has queued leaves with it
+  const unsigned long now = millis();
+  const auto due = [now](TtyStream &stream, unsigned long lastFlushMillis) {
+    return stream.unsent() >= MQTT_FRAME_MIN_BYTES ||
+           (stream.unsent() > 0 &&
+            now - lastFlushMillis >= MQTT_FRAME_MAX_DELAY_MS);
+  };
+  if (!due(tty0Stream, tty0LastFlushMillis) &&
+      !due(tty1Stream, tty1LastFlushMillis))
+    return;
+  if (!spend(Budget::Priority::Bulk))
+    return;
+  if (tty0Stream.unsent() > 0) {
+    tty0Stream.flush();
+    tty0LastFlushMillis = now;
+  }
+  if (tty1Stream.unsent() > 0) {
+    tty1Stream.flush();
+    tty1LastFlushMillis = now;
   }
+  muxBatch.publish();
+}
 
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::loop() {
   const bool wasConnected = connected;
 
-  // Process pending MQTT messages (PubSubClient requires multiple calls)
-  for (uint8_t i = 0; i < MQTT_LOOP_ITERATIONS; i++) {
-    mqttClient.loop();
-  }
+  // Always drive the client: while connecting this is what completes the
+  // handshake. One call processes everything that is already available.
+  mqttClient.loop();
 
   connected = mqttClient.connected();
 
   handleConnectionStateChange(wasConnected);
+  if (connected)
+    publishUploadAcks();
+
+  // Framed and JSON publishes are batched by flushFramesIfNeeded() instead
+  // of per line
+  tty0Stream.setLineFlush(!batchedOutput());
+  tty1Stream.setLineFlush(!batchedOutput());
+  const size_t ackWindow =
+      static_cast<size_t>(std::max<int32_t>(preferencesStorage.mqttInflight, 0));
+  tty0Stream.setAckWindow(ackWindow);
+  tty1Stream.setAckWindow(ackWindow);
+  // A batch's delay counts from the loop that found nothing left to send
+  if (tty0Stream.unsent() == 0)
+    tty0LastFlushMillis = millis();
+  if (tty1Stream.unsent() == 0)
+    tty1LastFlushMillis = millis();
+
+  if (spillEnabled && (!connected || !spillQueue.empty())) {
+    // Offline, or still catching up: new output queues behind the spill so
+    // the broker sees everything in order
+    spillInto(tty0Sink, tty0Stream, 0);
+    spillInto(tty0PendingBuffer, tty0Stream, 0);
+    spillInto(tty1Sink, tty1Stream, 1);
+    spillInto(tty1PendingBuffer, tty1Stream, 1);
+    if (!connected) {
+      spillQueue.commitIfDue();
+      return;
+    }
+    replaySpill();
+    publishSnapshotsIfNeeded();
+    return;
+  }
+
+  // Move tty output from the UART and web producers into the streams even
+  // while offline so the rings never fill up; the streams retain it
+  drainInto(tty0Sink, tty0Stream, 0);
+  drainInto(tty0PendingBuffer, tty0Stream, 0);
+  drainInto(tty1Sink, tty1Stream, 1);
+  drainInto(tty1PendingBuffer, tty1Stream, 1);
 
   if (!connected)
     return;
 
+  // PUBACKs processed above may have opened the in-flight window
+  tty0Stream.flushHeldBytes();
+  tty1Stream.flushHeldBytes();
+  flushDeferredLines();
   flushBuffersIfNeeded();
+  // Frames a full stream flushed on its own while draining
+  muxBatch.publish();
+  publishSnapshotsIfNeeded();
+}
+
+template <typename PubSubClientPolicy>
+template <typename Ring>
+void MqttClient<PubSubClientPolicy>::drainInto(Ring &ring, TtyStream &stream,
+                                               uint8_t port) {
+  // Only what is queued now: a busy producer can't keep us here forever
+  size_t remaining = ring.size();
+  // Unacknowledged output must not be overwritten; the rest waits in the
+  // producer ring, which is where a producer that keeps outrunning the
+  // broker loses bytes
+  if (stream.getAckWindow() > 0)
+    remaining = std::min(remaining, stream.room());
+  uint8_t chunk[MQTT_DRAIN_CHUNK_SIZE];
+  while (remaining > 0) {
+    size_t lost = 0;
+    const uint32_t position = static_cast<uint32_t>(ring.readPosition());
+    const size_t n = ring.read(chunk, std::min(remaining, sizeof(chunk)), lost);
+    // Dropped producer bytes still consume stream offsets
+    stream.skip(lost);
+    if (n == 0)
+      break;
+    remaining -= n;
+    types::span<const uint8_t> data(chunk, n);
+    snapshots[port].output.append(data);
+    if (preferencesStorage.mqttJson) {
+      const uint32_t offset = stream.nextOffset();
+      stampLines(ring, position, data, port,
+                 [&stream, offset](size_t i, uint32_t arrival) {
+                   stream.flushPolicy().stampLine(
+                       offset + static_cast<uint32_t>(i), arrival);
+                 });
+    }
+    if (stream.active()) {
+      appendLines(stream, data, port);
+    } else {
+      stream.retain(data);
+    }
+  }
+}
+
+template <typename PubSubClientPolicy>
+bool MqttClient<PubSubClientPolicy>::spend(
+    typename Budget::Priority priority) {
+  return publishBudget.take(priority, millis());
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::appendLines(
+    TtyStream &stream, const types::span<const uint8_t> &data, uint8_t port) {
+  if (batchedOutput()) {
+    stream.append(data);
+    return;
+  }
+  // One publish per line while the budget lasts; past it lines pile up in
+  // the stream and leave together. Only a full stream publishes regardless.
+  size_t start = 0;
+  while (start < data.size()) {
+    const auto *newline = static_cast<const uint8_t *>(
+        memchr(data.data() + start, '\n', data.size() - start));
+    const size_t end =
+        newline ? static_cast<size_t>(newline - data.data()) + 1 : data.size();
+    if (newline) {
+      const bool publish = spend(Budget::Priority::Bulk);
+      stream.setLineFlush(publish);
+      if (!publish) {
+        publishBudget.countDeferred();
+        ttyDeferred[port] = true;
+      }
+    }
+    stream.append(data.subspan(start, end - start));
+    start = end;
+  }
+  stream.setLineFlush(true);
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::flushDeferredLines() {
+  TtyStream *streams[] = {&tty0Stream, &tty1Stream};
+  for (size_t port = 0; port < ttyDeferred.size(); ++port) {
+    if (!ttyDeferred[port])
+      continue;
+    if (streams[port]->unsent() == 0) {
+      ttyDeferred[port] = false; // an overflow or interval flush took them
+      continue;
+    }
+    if (!spend(Budget::Priority::Bulk))
+      return;
+    streams[port]->flush();
+    ttyDeferred[port] = false;
+  }
+}
+
+template <typename PubSubClientPolicy>
+template <typename Ring, typename Stamp>
+void MqttClient<PubSubClientPolicy>::stampLines(
+    Ring &ring, uint32_t position, const types::span<const uint8_t> &data,
+    uint8_t port, Stamp stamp) {
+  // The UART sink knows when each line arrived; web input arrives now
+  const uint32_t now = static_cast<uint32_t>(millis());
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (lineStart[port]) {
+      uint32_t arrival = now;
+      if constexpr (std::is_same_v<Ring, MqttTxSink>)
+        ring.lineArrival(position + static_cast<uint32_t>(i), arrival);
+      stamp(i, arrival);
+    }
+    lineStart[port] = data[i] == '\n';
+  }
+}
+
+template <typename PubSubClientPolicy>
+template <typename Ring>
+void MqttClient<PubSubClientPolicy>::spillInto(Ring &ring, TtyStream &stream,
+                                               uint8_t port) {
+  // What the stream still holds is older than anything in the ring
+  stream.drain([&](const types::span<const uint8_t> &chunk, uint32_t offset) {
+    spillQueue.append(port, offset, chunk);
+  });
+
+  size_t remaining = ring.size();
+  uint8_t chunk[MQTT_DRAIN_CHUNK_SIZE];
+  while (remaining > 0) {
+    size_t lost = 0;
+    const uint32_t position = static_cast<uint32_t>(ring.readPosition());
+    const size_t n = ring.read(chunk, std::min(remaining, sizeof(chunk)), lost);
+    stream.skip(lost);
+    if (n == 0)
+      break;
+    remaining -= n;
+    types::span<const uint8_t> data(chunk, n);
+    snapshots[port].output.append(data);
+    // The stream only hands out offsets; the bytes go straight to the spill
+    const uint32_t offset = stream.nextOffset();
+    size_t from = 0;
+    if (preferencesStorage.mqttJson) {
+      // Replay may come long after the line clock has moved on, so arrival
+      // times are kept in the spill records with their lines
+      stampLines(ring, position, data, port,
+                 [&](size_t i, uint32_t arrival) {
+                   spillQueue.append(port,
+                                     offset + static_cast<uint32_t>(from),
+                                     data.subspan(from, i - from));
+                   spillQueue.stampLine(
+                       port, offset + static_cast<uint32_t>(i), arrival);
+                   from = i;
+                 });
+    }
+    spillQueue.append(port, offset + static_cast<uint32_t>(from),
+                      data.subspan(from, n - from));
+    stream.skip(n);
+  }
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::replaySpill() {
+  // Stop-and-wait: a record is trimmed only once the broker has it
+  if (spillPacketId != 0) {
+    if (!spillAcked)
+      return;
+    spillQueue.pop();
+    spillPacketId = 0;
+    spillAcked = false;
+  }
+  if (static_cast<long>(millis() - spillNextReplayMillis) < 0)
+    return;
+
+  uint8_t payload[MQTT_SPILL_RECORD_SIZE];
+  wifi_serial::MqttSpillQueue::Record record;
+  if (!spillQueue.peek(record, payload)) {
+    // Only the record still being collected is left
+    spillQueue.commit();
+    if (!spillQueue.peek(record, payload))
+      return;
+  }
+
+  TtyStream &stream = record.port == 0 ? tty0Stream : tty1Stream;
+  const types::string &topic = record.port == 0 ? topicTty0Tx : topicTty1Tx;
+  if (topic.length() == 0) {
+    spillQueue.pop(); // nowhere to publish it
+    return;
+  }
+
+  // Replay is bulk output too; over budget it waits like the send queue
+  if (!spend(Budget::Priority::Bulk)) {
+    publishBudget.countDeferred();
+    return;
+  }
+  for (size_t i = 0; i < record.stampCount; ++i)
+    stream.flushPolicy().stampLine(record.stamps[i].offset,
+                                   record.stamps[i].millis);
+  // 0 means the send queue is full; the same record is retried next loop
+  spillPacketId = stream.flushPolicy().publishAcked(
+      types::span<const uint8_t>(payload, record.length), record.offset);
+  if (spillPacketId != 0) {
+    spillNextReplayMillis =
+        millis() + record.length * 1000UL / MQTT_SPILL_REPLAY_BYTES_PER_SEC;
+  }
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::publishSnapshotsIfNeeded() {
+  if (preferencesStorage.mqttSnapshotInterval <= 0)
+    return;
+  const unsigned long interval =
+      static_cast<unsigned long>(preferencesStorage.mqttSnapshotInterval) *
+      1000UL;
+
+  for (auto &snapshot : snapshots) {
+    // Unchanged output is already retained on the broker
+    if (!snapshot.output.dirty() || snapshot.topic.empty() ||
+        millis() - snapshot.lastPublishMillis < interval) {
+      continue;
+    }
+    if (!spend(Budget::Priority::Info)) {
+      publishBudget.countDeferred(); // still dirty, retried next loop
+      continue;
+    }
+    const auto payload = snapshot.output.render();
+    if (mqttClient.publish(snapshot.topic.c_str(), payload.data(),
+                           payload.size(), true)) {
+      snapshot.output.markPublished();
+      snapshot.lastPublishMillis = millis();
+    } else {
+      LOG_WARN("MQTT snapshot publish failed for topic: %s",
+               snapshot.topic.c_str());
+    }
+  }
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::publishUploadAcks() {
+  for (auto &upload : uploads) {
+    if (!upload.ackPending)
+      continue;
+    if (!spend(Budget::Priority::Control)) {
+      publishBudget.countDeferred();
+      return;
+    }
+    // Each chunk costs its length plus a small header in the ring, so the
+    // window is a hint rather than an exact credit
+    char ack[MQTT_UPLOAD_ACK_SIZE];
+    const size_t length = MqttUploadReceiver::formatAck(
+        upload.ack, upload.ring->freeSpace(), ack, sizeof(ack));
+    if (mqttClient.publish(upload.statusTopic.c_str(),
+                           reinterpret_cast<const uint8_t *>(ack), length))
+      upload.ackPending = false;
+  }
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::dispatchInbound() {
+  dispatchRing(tty0RxRing, onTty0Callback);
+  dispatchRing(tty1RxRing, onTty1Callback);
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::dispatchRing(
+    SpscRing<MQTT_RX_RING_SIZE> &ring,
+    void (*callback)(const types::span<const uint8_t> &)) {
+  uint8_t payload[MQTT_CALLBACK_BUFFER_SIZE];
+  size_t length = 0;
+  while (!ring.empty()) {
+    if (ring.popMessage(payload, sizeof(payload), length) && callback) {
+      callback(types::span<const uint8_t>(payload, length));
+    }
+  }
 }
 
 template <typename PubSubClientPolicy>
 bool MqttClient<PubSubClientPolicy>::publishInfo(const types::string &data) {
+  return publishInfoTo(topicInfo, data);
+}
+
+template <typename PubSubClientPolicy>
+bool MqttClient<PubSubClientPolicy>::publishInfoDelta(
+    const types::string &data) {
+  return publishInfoTo(topicInfoDelta, data);
+}
+
+template <typename PubSubClientPolicy>
+bool MqttClient<PubSubClientPolicy>::publishInfoTo(const types::string &topic,
+                                                   const types::string &data) {
   if (!mqttClient.connected()) {
     LOG_ERROR("MQTT publishInfo failed: mqttClient is null");
     return false;
@@ -234,10 +732,18 @@ bool MqttClient<PubSubClientPolicy>::publishInfo(const types::string &data) {
     return false;
   }
 
-  LOG_DEBUG("MQTT publishing info to %s (%d bytes)", topicInfo.c_str(),
+  // The next document supersedes this one, so it isn't kept
+  if (!spend(Budget::Priority::Info)) {
+    publishBudget.countDropped();
+    LOG_WARN("MQTT publish budget exhausted, info to %s dropped",
+             topic.c_str());
+    return false;
+  }
+
+  LOG_DEBUG("MQTT publishing info to %s (%d bytes)", topic.c_str(),
             data.length());
 
-  bool result = mqttClient.publish(topicInfo.c_str(), (uint8_t *)data.c_str(),
+  bool result = mqttClient.publish(topic.c_str(), (uint8_t *)data.c_str(),
                                    data.length(), false);
   if (!result) {
     LOG_ERROR("MQTT publishInfo failed! State: %d", mqttClient.state());
@@ -252,41 +758,81 @@ bool MqttClient<PubSubClientPolicy>::publishInfo(const types::string &data) {
 template <typename PubSubClientPolicy>
 void MqttClient<PubSubClientPolicy>::appendToTty0Buffer(
     const types::span<const uint8_t> &data) {
-  // Accumulate only - main loop transfers to MQTT
+  // Accumulate only - the MQTT task transfers to the stream
   tty0PendingBuffer.append(data);
 }
 
 template <typename PubSubClientPolicy>
 void MqttClient<PubSubClientPolicy>::appendToTty1Buffer(
     const types::span<const uint8_t> &data) {
-  // Accumulate only - main loop transfers to MQTT
+  // Accumulate only - the MQTT task transfers to the stream
   tty1PendingBuffer.append(data);
 }
 
 template <typename PubSubClientPolicy>
 void MqttClient<PubSubClientPolicy>::mqttCallback(char *topic, uint8_t *payload,
                                                   unsigned int length) {
-  if (length >= MQTT_CALLBACK_BUFFER_SIZE)
-    return;
-  types::string_view topicStr(topic); // More efficient than String
-
-  types::span<const uint8_t> payloadSpan(payload, length);
-  if (topicStr == topicTty0Rx) {
-    onTty0Callback(payloadSpan);
-    return;
-  } else if (topicStr == topicTty1Rx) {
-    onTty1Callback(payloadSpan);
-    return;
-  } else {
+  // Runs in the MQTT task: handlers only hand the payload over
+  if (!router.dispatch(topic, types::span<const uint8_t>(payload, length)))
     LOG_ERROR("MQTT callback received for unknown topic: %s", topic);
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::queueRx(
+    void *ring, const char *topic, const types::span<const uint8_t> &payload) {
+  // Queue for dispatchInbound() on the main loop
+  if (payload.size() >= MQTT_CALLBACK_BUFFER_SIZE) {
+    LOG_WARN("MQTT rx payload of %u bytes on %s dropped, use the upload topic",
+             (unsigned)payload.size(), topic);
     return;
   }
+  auto &rxRing = *static_cast<SpscRing<MQTT_RX_RING_SIZE> *>(ring);
+  if (!rxRing.pushMessage(payload)) {
+    LOG_WARN("MQTT rx ring full for %s, dropped %u bytes", topic,
+             (unsigned)payload.size());
+  }
+}
+
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::receiveUpload(
+    void *context, const char *topic,
+    const types::span<const uint8_t> &payload) {
+  auto &upload = *static_cast<Upload *>(context);
+  // Only the latest ack is published: offsets are cumulative
+  upload.ack = upload.receiver.receive(
+      payload, [&upload](const types::span<const uint8_t> &data) {
+        return upload.ring->pushMessage(data);
+      });
+  upload.ackPending = true;
+  if (upload.ack.status == MqttUploadReceiver::Status::Done) {
+    LOG_INFO("MQTT upload %u on %s complete, %lu bytes",
+             (unsigned)upload.ack.transferId, topic,
+             (unsigned long)upload.ack.offset);
+  }
+}
+template <typename PubSubClientPolicy>
+void MqttClient<PubSubClientPolicy>::receiveMux(
+    void *context, const char *topic,
+    const types::span<const uint8_t> &payload) {
+  auto &client = *static_cast<MqttClient *>(context);
+  SpscRing<MQTT_RX_RING_SIZE> *rings[] = {&client.tty0RxRing,
+                                          &client.tty1RxRing};
+  tty_mux::Reader reader(payload.data(), payload.size());
+  tty_mux::Section section;
+  while (reader.next(section)) {
+    if (section.port >= 2) {
+      LOG_WARN("MQTT mux section for unknown port %u on %s dropped",
+               (unsigned)section.port, topic);
+      continue;
+    }
+    // Each section is one rx message, as if it came on the port's rx topic
+    queueRx(rings[section.port], topic,
+            types::span<const uint8_t>(section.data, section.size));
+  }
+  if (reader.malformed())
+    LOG_WARN("MQTT malformed mux payload on %s, rest dropped", topic);
 }
 } // namespace internal
 // Explicit instantiation for production and test builds
-#ifdef ESP_PLATFORM
-template class internal::MqttClient<PubSubClient>;
-#else
-template class internal::MqttClient<PubSubClientTest>;
-#endif
+template class internal::MqttClient<PubSubClientPolicy>;
 } // namespace jrb::wifi_serial
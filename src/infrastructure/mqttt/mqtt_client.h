@@ -2,16 +2,22 @@
 
 #include "config.h"
 #include "domain/messaging/mqtt_buffer.h"
-#include "infrastructure/memory/circular_buffer.hpp"
+#include "domain/messaging/mqtt_mux_batch.h"
+#include "domain/messaging/mqtt_spill_queue.h"
+#include "domain/messaging/mqtt_topic_router.hpp"
+#include "domain/messaging/mqtt_upload_receiver.hpp"
+#include "domain/messaging/publish_budget.hpp"
+#include "domain/messaging/tty_snapshot.hpp"
+#include "infrastructure/memory/loss_tracking_ring.hpp"
+#include "infrastructure/memory/spsc_ring.hpp"
 #include "domain/config/preferences_storage_policy.h"
 #include "infrastructure/types.hpp"
+#include <array>
 #include <functional>
 #include <memory>
 
 #include <vector>
 
-class WiFiClient;
-
 namespace jrb::wifi_serial {
 
 namespace internal {
@@ -19,29 +25,101 @@ namespace internal {
 template <typename PubSubClientPolicy>
 class MqttClient final {
 public:
+  // Same type as MqttLog for the platform's PubSubClientPolicy
+  using TtyStream = BufferedStream<MqttFlushPolicy<PubSubClientPolicy>,
+                                   MQTT_BUFFER_SIZE, MQTT_MAX_INFLIGHT>;
+
   MqttClient(PubSubClientPolicy &mqttClient, wifi_serial::PreferencesStorage &preferencesStorage);
   ~MqttClient() = default;
 
+  using Router = MqttTopicRouter<MQTT_MAX_ROUTES>;
+  using Budget = PublishBudget<MQTT_PUBLISH_RATE, MQTT_PUBLISH_BURST>;
+
   // Registers callbacks for Rx topics.
   void setCallbacks(void (*tty0)(const types::span<const uint8_t> &),
                     void (*tty1)(const types::span<const uint8_t> &));
 
+  /**
+   * @brief Route another inbound topic filter ('+'/'#' allowed) to handler.
+   *
+   * Subscribed on the next (re)connect. The handler runs in the MQTT task,
+   * so it should only hand the payload over (see the tty rx rings).
+   * @return false if the filter is malformed or the table is full
+   */
+  bool addRoute(const char *filter, Router::Handler handler, void *context);
+
+  /**
+   * @brief Enable the offline spill (call once the file system can mount).
+   *
+   * Without it tty output produced while disconnected is limited to the
+   * streams' in-memory backlog.
+   */
+  bool setupSpill();
+
   bool connect(const char *broker, int port, const char *user = nullptr,
                const char *password = nullptr);
   void disconnect();
   bool reconnect();
+
+  /**
+   * @brief Drive the connection and publish queued tty output.
+   *
+   * Runs in the MQTT task. Received rx payloads are only queued here; the
+   * registered callbacks run from dispatchInbound().
+   */
   void loop();
 
+  /**
+   * @brief Hand queued rx payloads to the tty callbacks (main loop side).
+   */
+  void dispatchInbound();
+
   bool publishInfo(const types::string &data);
 
+  /**
+   * @brief Publish changed telemetry fields to "<info topic>/delta".
+   */
+  bool publishInfoDelta(const types::string &data);
+
   // Connection state query.
   bool isConnected() const { return connected; }
   void setConnected(bool state) { connected = state; }
 
   void appendToTty0Buffer(const types::span<const uint8_t> &data);
   void appendToTty1Buffer(const types::span<const uint8_t> &data);
-  MqttLog &getTty0Stream() { return tty0Stream; }
-  MqttLog &getTty1Stream() { return tty1Stream; }
+  TtyStream &getTty0Stream() { return tty0Stream; }
+  TtyStream &getTty1Stream() { return tty1Stream; }
+
+  // Producer ends for the UART broadcasters, drained by loop()
+  MqttTxSink &getTty0Sink() { return tty0Sink; }
+  MqttTxSink &getTty1Sink() { return tty1Sink; }
+
+  const wifi_serial::MqttSpillQueue &getSpillQueue() const { return spillQueue; }
+
+  // Publishes of this connection: upload acks (Control) before info and
+  // snapshots (Info) before tty output (Bulk). Over budget, tty output is
+  // coalesced into later publishes (deferred) and info is dropped.
+  const Budget &getPublishBudget() const { return publishBudget; }
+
+  // Retained scrollback topic of a port ("<tx topic minus /tx>/snapshot")
+  const types::string &getSnapshotTopic(uint8_t port) const {
+    return snapshots[port].topic;
+  }
+
+  // Chunked upload topic of a port ("<rx topic minus /rx>/upload"); acks go
+  // to "<upload topic>/status"
+  const types::string &getUploadTopic(uint8_t port) const {
+    return uploads[port].topic;
+  }
+  const types::string &getUploadStatusTopic(uint8_t port) const {
+    return uploads[port].statusTopic;
+  }
+
+  // Multiplexed topics ("<info topic minus /info>/mux/tx" and ".../mux/rx").
+  // With mqttMultiplex set when the client is created, mux rx replaces the
+  // per-port rx subscriptions.
+  const types::string &getMuxTxTopic() const { return topicMuxTx; }
+  const types::string &getMuxRxTopic() const { return topicMuxRx; }
 
 private:
   PubSubClientPolicy &mqttClient;
@@ -49,33 +127,111 @@ private:
   types::string topicTty0Rx, topicTty0Tx;
   types::string topicTty1Rx, topicTty1Tx;
   types::string topicInfo;
+  types::string topicInfoDelta;
+  types::string topicMuxTx, topicMuxRx;
   bool connected;
   unsigned long lastReconnectAttempt;
 
   void (*onTty0Callback)(const types::span<const uint8_t> &);
   void (*onTty1Callback)(const types::span<const uint8_t> &);
 
-  // Pending buffers for cross-task data transfer (web task → main loop)
-  CircularBuffer<uint8_t, MQTT_BUFFER_SIZE> tty0PendingBuffer;
-  CircularBuffer<uint8_t, MQTT_BUFFER_SIZE> tty1PendingBuffer;
-
-  MqttLog tty0Stream;
+  // Inbound topic filters -> handlers, subscribed on every (re)connect
+  Router router;
+
+  // Cross-task rings; each has exactly one producer and one consumer.
+  // web task -> MQTT task
+  LossTrackingRing<MQTT_BUFFER_SIZE> tty0PendingBuffer;
+  LossTrackingRing<MQTT_BUFFER_SIZE> tty1PendingBuffer;
+  // main loop (UART) -> MQTT task
+  MqttTxSink tty0Sink;
+  MqttTxSink tty1Sink;
+  // MQTT task -> main loop, one message per rx PUBLISH (or mux section)
+  SpscRing<MQTT_RX_RING_SIZE> tty0RxRing;
+  SpscRing<MQTT_RX_RING_SIZE> tty1RxRing;
+
+  // Multiplexed output: both streams' frames, published once per loop
+  MqttMuxBatch<PubSubClientPolicy> muxBatch;
+  TtyStream tty0Stream;
   unsigned long tty0LastFlushMillis;
-  MqttLog tty1Stream;
+  TtyStream tty1Stream;
   unsigned long tty1LastFlushMillis;
 
+  Budget publishBudget;
+  // Line mode: lines held back by the budget, published by the next
+  // loop() that can afford it
+  std::array<bool, 2> ttyDeferred{};
+  // JSON output: the next byte drained for a port starts a line
+  std::array<bool, 2> lineStart{{true, true}};
+
+  // Offline spill: filled while disconnected, replayed one acknowledged
+  // publish at a time after reconnecting
+  wifi_serial::MqttSpillQueue spillQueue;
+  bool spillEnabled;
+  uint16_t spillPacketId; // replay publish awaiting PUBACK, 0 = none
+  bool spillAcked;
+  unsigned long spillNextReplayMillis;
+
+  // Retained scrollback per port, republished when dirty at most every
+  // mqttSnapshotInterval seconds
+  struct Snapshot {
+    TtySnapshot<MQTT_SNAPSHOT_SIZE> output;
+    types::string topic;
+    unsigned long lastPublishMillis{0};
+  };
+  std::array<Snapshot, 2> snapshots;
+
+  // Chunked uploads feed the same rx rings as plain rx messages; the latest
+  // ack of each port is published from loop()
+  struct Upload {
+    MqttUploadReceiver receiver;
+    SpscRing<MQTT_RX_RING_SIZE> *ring{nullptr};
+    types::string topic;
+    types::string statusTopic;
+    MqttUploadReceiver::Ack ack;
+    bool ackPending{false};
+  };
+  std::array<Upload, 2> uploads;
+
   void subscribeToConfiguredTopics();
   void handleConnectionStateChange(bool wasConnected);
+  void replayRetainedOutput();
   void flushBuffersIfNeeded();
+  void flushFramesIfNeeded(TtyStream &stream, unsigned long &lastFlushMillis);
+  void flushMuxIfNeeded();
+  bool batchedOutput() const {
+    return preferencesStorage.mqttFramed || preferencesStorage.mqttJson ||
+           preferencesStorage.mqttMultiplex;
+  }
+  bool spend(typename Budget::Priority priority);
+  void appendLines(TtyStream &stream, const types::span<const uint8_t> &data,
+                   uint8_t port);
+  void flushDeferredLines();
+  // Calls stamp(index, arrival) for each line start in data
+  template <typename Ring, typename Stamp>
+  void stampLines(Ring &ring, uint32_t position,
+                  const types::span<const uint8_t> &data, uint8_t port,
+                  Stamp stamp);
+  template <typename Ring>
+  void drainInto(Ring &ring, TtyStream &stream, uint8_t port);
+  template <typename Ring>
+  void spillInto(Ring &ring, TtyStream &stream, uint8_t port);
+  void replaySpill();
+  void publishSnapshotsIfNeeded();
+  void publishUploadAcks();
+  bool publishInfoTo(const types::string &topic, const types::string &data);
+  void dispatchRing(SpscRing<MQTT_RX_RING_SIZE> &ring,
+                    void (*callback)(const types::span<const uint8_t> &));
   void setTopics(const types::string &tty0Rx, const types::string &tty0Tx,
                  const types::string &tty1Rx, const types::string &tty1Tx);
   void mqttCallback(char *topic, uint8_t *payload, unsigned int length);
+  static void queueRx(void *ring, const char *topic,
+                      const types::span<const uint8_t> &payload);
+  static void receiveUpload(void *upload, const char *topic,
+                            const types::span<const uint8_t> &payload);
+  static void receiveMux(void *client, const char *topic,
+                         const types::span<const uint8_t> &payload);
 };
 } // namespace internal
 // Type aliases for convenience
-#ifdef ESP_PLATFORM
-using MqttClient = internal::MqttClient<PubSubClient>;
-#else
-using MqttClient = internal::MqttClient<PubSubClientTest>;
-#endif
+using MqttClient = internal::MqttClient<PubSubClientPolicy>;
 } // namespace jrb::wifi_serial
\ No newline at end of file
@@ -0,0 +1,805 @@
+#include "mqtt_engine.h"
+#include "infrastructure/logging/logger.h"
+#include "infrastructure/mqttt/mqtt_transport.h"
+#include "infrastructure/mqttt/socket_transport.h"
+#include <algorithm>
+#include <cstring>
+
+#ifndef ESP_PLATFORM
+#include "infrastructure/platform/arduino_compat.h"
+#else
+#include <Arduino.h>
+#endif
+
+namespace jrb::wifi_serial {
+
+namespace internal {
+namespace {
+constexpr uint8_t MQTT_PROTOCOL_LEVEL_311 = 4;
+constexpr uint8_t MQTT_PROTOCOL_LEVEL_5 = 5;
+constexpr uint8_t CONNECT_FLAG_CLEAN_SESSION = 0x02;
+constexpr uint8_t CONNECT_FLAG_PASSWORD = 0x40;
+constexpr uint8_t CONNECT_FLAG_USERNAME = 0x80;
+constexpr size_t DEFAULT_RX_BUFFER_SIZE = 256;
+
+// MQTT 5 property identifiers
+constexpr uint8_t PROPERTY_MESSAGE_EXPIRY = 0x02;
+constexpr uint8_t PROPERTY_SERVER_KEEP_ALIVE = 0x13;
+constexpr uint8_t PROPERTY_TOPIC_ALIAS_MAXIMUM = 0x22;
+constexpr uint8_t PROPERTY_TOPIC_ALIAS = 0x23;
+constexpr uint8_t PROPERTY_USER = 0x26;
+constexpr uint8_t PROPERTY_MAXIMUM_PACKET_SIZE = 0x27;
+
+// CONNACK codes of a broker that doesn't support the requested level
+constexpr uint8_t CONNACK_BAD_PROTOCOL_311 = 0x01;
+constexpr uint8_t CONNACK_BAD_PROTOCOL_5 = 0x84;
+} // namespace
+
+template <typename TransportPolicy>
+MqttEngine<TransportPolicy>::MqttEngine()
+    : rxBuffer(DEFAULT_RX_BUFFER_SIZE) {}
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::setServer(const char *domain, int port) {
+  host = domain ? domain : "";
+  this->port = static_cast<uint16_t>(port);
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::setCallback(Callback callback) {
+  this->callback = std::move(callback);
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::setPubAckCallback(PubAckCallback callback) {
+  pubAckCallback = std::move(callback);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::setBufferSize(size_t size) {
+  if (size == 0)
+    return false;
+  rxBuffer.resize(size);
+  return true;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::setKeepAlive(uint16_t keepAliveSec) {
+  keepAliveMs = static_cast<uint32_t>(keepAliveSec) * 1000;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::setSocketTimeout(uint16_t timeoutSec) {
+  socketTimeoutMs = static_cast<uint32_t>(timeoutSec) * 1000;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::setProtocolVersion(uint8_t version) {
+  this->version =
+      version == MQTT_PROTOCOL_LEVEL_5 ? MQTT_PROTOCOL_LEVEL_5 :
+                                         MQTT_PROTOCOL_LEVEL_311;
+}
+
+// ============================================================================
+// Connection
+// ============================================================================
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::connect(const char *clientId) {
+  return connect(clientId, nullptr, nullptr);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::connect(const char *clientId,
+                                          const char *user,
+                                          const char *password) {
+  if (phase == Phase::Connected)
+    return true;
+
+  // An attempt is already running; let loop() finish or time it out
+  if (phase != Phase::Idle &&
+      millis() - phaseStartMillis < socketTimeoutMs) {
+    return true;
+  }
+
+  return startConnect(clientId, user, password);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::startConnect(const char *clientId,
+                                               const char *user,
+                                               const char *password) {
+  fail(STATE_DISCONNECTED);
+
+  if (!transport.open(host.c_str(), port)) {
+    LOG_ERROR("MqttEngine: cannot open connection to %s:%d", host.c_str(),
+              port);
+    stateCode = STATE_CONNECT_FAILED;
+    return false;
+  }
+
+  // Variable header + payload; CONNECT is rare so a heap buffer is fine here
+  std::vector<uint8_t> body;
+  putString(body, "MQTT");
+  body.push_back(version);
+  uint8_t flags = CONNECT_FLAG_CLEAN_SESSION;
+  if (user) {
+    flags |= CONNECT_FLAG_USERNAME;
+    if (password)
+      flags |= CONNECT_FLAG_PASSWORD;
+  }
+  body.push_back(flags);
+  const uint16_t keepAliveSec = static_cast<uint16_t>(keepAliveMs / 1000);
+  body.push_back(static_cast<uint8_t>(keepAliveSec >> 8));
+  body.push_back(static_cast<uint8_t>(keepAliveSec & 0xFF));
+  if (version == MQTT_PROTOCOL_LEVEL_5) {
+    // The broker drops what wouldn't fit our buffer instead of sending it
+    const uint32_t maxPacket = static_cast<uint32_t>(rxBuffer.size());
+    body.push_back(5); // property length
+    body.push_back(PROPERTY_MAXIMUM_PACKET_SIZE);
+    for (int shift = 24; shift >= 0; shift -= 8)
+      body.push_back(static_cast<uint8_t>(maxPacket >> shift));
+  }
+  putString(body, clientId ? clientId : "");
+  if (user) {
+    putString(body, user);
+    if (password)
+      putString(body, password);
+  }
+
+  uint8_t header[MAX_FIXED_HEADER];
+  header[0] = CONNECT;
+  size_t headerLen = 1 + encodeLength(header + 1, body.size());
+  const types::span<const uint8_t> segments[] = {
+      {header, headerLen}, {body.data(), body.size()}};
+  if (!queueBytes(segments, 2, 0)) {
+    fail(STATE_CONNECT_FAILED);
+    return false;
+  }
+
+  phase = Phase::TcpConnecting;
+  phaseStartMillis = millis();
+  return true;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::disconnect() {
+  if (phase == Phase::Connected) {
+    const uint8_t packet[] = {DISCONNECT, 0};
+    const types::span<const uint8_t> segment(packet, sizeof(packet));
+    sendPacket(&segment, 1);
+    flushTx();
+  }
+  fail(STATE_DISCONNECTED);
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::fail(int code) {
+  transport.close();
+  phase = Phase::Idle;
+  stateCode = code;
+  pingOutstanding = false;
+  txTail = txHead = 0;
+  rxPhase = RxPhase::FixedHeader;
+  // Aliases only live as long as the network connection
+  brokerTopicAliasMax = 0;
+  aliasCount = 0;
+}
+
+// ============================================================================
+// Outbound packets
+// ============================================================================
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::subscribe(const char *topic, uint8_t qos) {
+  if (!connected() || !topic)
+    return false;
+
+  const uint16_t topicLen = static_cast<uint16_t>(strlen(topic));
+  const uint16_t packetId = allocatePacketId();
+  const bool v5 = version == MQTT_PROTOCOL_LEVEL_5;
+  uint8_t header[MAX_FIXED_HEADER + 5];
+  header[0] = SUBSCRIBE;
+  size_t n = 1 + encodeLength(header + 1, 2 + (v5 ? 1 : 0) + 2 + topicLen + 1);
+  header[n++] = static_cast<uint8_t>(packetId >> 8);
+  header[n++] = static_cast<uint8_t>(packetId & 0xFF);
+  if (v5)
+    header[n++] = 0; // no properties
+  header[n++] = static_cast<uint8_t>(topicLen >> 8);
+  header[n++] = static_cast<uint8_t>(topicLen & 0xFF);
+  const uint8_t requestedQos = qos > 1 ? 1 : qos;
+
+  const types::span<const uint8_t> segments[] = {
+      {header, n},
+      {reinterpret_cast<const uint8_t *>(topic), topicLen},
+      {&requestedQos, 1}};
+  return sendPacket(segments, 3);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::publish(const char *topic,
+                                          const uint8_t *payload,
+                                          unsigned int length) {
+  return publish(topic, payload, length, false);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::publish(const char *topic,
+                                          const uint8_t *payload,
+                                          unsigned int length, bool retained) {
+  return sendPublish(topic, payload, length, retained ? 1 : 0, 0, nullptr);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::publish(
+    const char *topic, const uint8_t *payload, unsigned int length,
+    bool retained, const MqttPublishProperties &properties) {
+  return sendPublish(topic, payload, length, retained ? 1 : 0, 0,
+                     &properties);
+}
+
+template <typename TransportPolicy>
+uint16_t MqttEngine<TransportPolicy>::publishAcked(const char *topic,
+                                                   const uint8_t *payload,
+                                                   unsigned int length) {
+  if (!connected() || !topic)
+    return 0;
+  const uint16_t packetId = allocatePacketId();
+  return sendPublish(topic, payload, length, 1 << 1, packetId, nullptr)
+             ? packetId
+             : 0;
+}
+
+template <typename TransportPolicy>
+uint16_t MqttEngine<TransportPolicy>::publishAcked(
+    const char *topic, const uint8_t *payload, unsigned int length,
+    const MqttPublishProperties &properties) {
+  if (!connected() || !topic)
+    return 0;
+  const uint16_t packetId = allocatePacketId();
+  return sendPublish(topic, payload, length, 1 << 1, packetId, &properties)
+             ? packetId
+             : 0;
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::sendPublish(
+    const char *topic, const uint8_t *payload, unsigned int length,
+    uint8_t flags, uint16_t packetId,
+    const MqttPublishProperties *properties) {
+  if (!connected() || !topic)
+    return false;
+
+  // MQTT 5: the topic goes out once per connection, then only its alias
+  uint16_t alias = 0;
+  bool newAlias = false;
+  uint8_t propertyBuffer[MAX_PUBLISH_PROPERTIES];
+  size_t propertyStart = 0;
+  size_t propertyLength = 0;
+  if (version == MQTT_PROTOCOL_LEVEL_5) {
+    for (uint16_t i = 0; i < aliasCount && alias == 0; ++i) {
+      if (aliasTopics[i] == topic)
+        alias = i + 1;
+    }
+    const uint16_t aliasLimit =
+        std::min<uint16_t>(brokerTopicAliasMax, MQTT_TOPIC_ALIASES);
+    if (alias == 0 && aliasCount < aliasLimit) {
+      alias = aliasCount + 1;
+      newAlias = true;
+    }
+    propertyLength = encodePublishProperties(alias, properties,
+                                             propertyBuffer, propertyStart);
+  }
+
+  const bool sendTopic = alias == 0 || newAlias;
+  const uint16_t topicLen =
+      sendTopic ? static_cast<uint16_t>(strlen(topic)) : 0;
+  const size_t idLen = packetId != 0 ? 2 : 0;
+  uint8_t header[MAX_FIXED_HEADER + 2];
+  header[0] = PUBLISH | flags;
+  size_t n = 1 + encodeLength(header + 1, 2 + topicLen + idLen +
+                                              propertyLength + length);
+  header[n++] = static_cast<uint8_t>(topicLen >> 8);
+  header[n++] = static_cast<uint8_t>(topicLen & 0xFF);
+  const uint8_t id[] = {static_cast<uint8_t>(packetId >> 8),
+                        static_cast<uint8_t>(packetId & 0xFF)};
+
+  const types::span<const uint8_t> segments[] = {
+      {header, n},
+      {reinterpret_cast<const uint8_t *>(topic), topicLen},
+      {id, idLen},
+      {propertyBuffer + propertyStart, propertyLength},
+      {payload, payload ? length : 0}};
+  if (!sendPacket(segments, 5))
+    return false;
+  // Only a sent packet tells the broker about the alias
+  if (newAlias)
+    aliasTopics[aliasCount++] = topic;
+  return true;
+}
+
+template <typename TransportPolicy>
+size_t MqttEngine<TransportPolicy>::encodePublishProperties(
+    uint16_t alias, const MqttPublishProperties *properties, uint8_t *out,
+    size_t &start) {
+  // Properties are written after room for their variable-length size
+  uint8_t *body = out + 4;
+  const size_t capacity = MAX_PUBLISH_PROPERTIES - 4;
+  size_t n = 0;
+  if (properties && properties->messageExpirySec > 0) {
+    body[n++] = PROPERTY_MESSAGE_EXPIRY;
+    for (int shift = 24; shift >= 0; shift -= 8)
+      body[n++] = static_cast<uint8_t>(properties->messageExpirySec >> shift);
+  }
+  if (alias != 0) {
+    body[n++] = PROPERTY_TOPIC_ALIAS;
+    body[n++] = static_cast<uint8_t>(alias >> 8);
+    body[n++] = static_cast<uint8_t>(alias & 0xFF);
+  }
+  for (size_t i = 0; properties && i < properties->userCount; ++i) {
+    const auto &user = properties->user[i];
+    const size_t keyLen = strlen(user.key);
+    const size_t valueLen = strlen(user.value);
+    if (n + 1 + 2 + keyLen + 2 + valueLen > capacity) {
+      LOG_WARN("MqttEngine: user property '%s' doesn't fit, skipped",
+               user.key);
+      continue;
+    }
+    body[n++] = PROPERTY_USER;
+    const char *strings[] = {user.key, user.value};
+    const size_t lengths[] = {keyLen, valueLen};
+    for (size_t j = 0; j < 2; ++j) {
+      body[n++] = static_cast<uint8_t>(lengths[j] >> 8);
+      body[n++] = static_cast<uint8_t>(lengths[j] & 0xFF);
+      memcpy(body + n, strings[j], lengths[j]);
+      n += lengths[j];
+    }
+  }
+
+  uint8_t size[4];
+  const size_t sizeLen = encodeLength(size, static_cast<uint32_t>(n));
+  start = 4 - sizeLen;
+  memcpy(out + start, size, sizeLen);
+  return sizeLen + n;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::sendAck(uint8_t type, uint16_t packetId) {
+  const uint8_t packet[] = {type, 2, static_cast<uint8_t>(packetId >> 8),
+                            static_cast<uint8_t>(packetId & 0xFF)};
+  const types::span<const uint8_t> segment(packet, sizeof(packet));
+  sendPacket(&segment, 1);
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::sendPacket(
+    const types::span<const uint8_t> *segments, size_t count) {
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i)
+    total += segments[i].size();
+
+  // Never start a packet the queue couldn't finish: a half-written packet
+  // would corrupt the stream
+  if (total > MQTT_TX_QUEUE_SIZE - pendingTxBytes())
+    return false;
+
+  const bool socketWritable =
+      phase == Phase::AwaitConnAck || phase == Phase::Connected;
+  if (!socketWritable || pendingTxBytes() > 0) {
+    // Keep ordering behind bytes that are already waiting
+    return queueBytes(segments, count, 0);
+  }
+
+  int written = transport.write(segments, count);
+  if (written < 0) {
+    fail(STATE_CONNECTION_LOST);
+    return false;
+  }
+  if (written > 0)
+    lastOutMillis = millis();
+  if (static_cast<size_t>(written) < total)
+    return queueBytes(segments, count, static_cast<size_t>(written));
+  return true;
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::queueBytes(
+    const types::span<const uint8_t> *segments, size_t count, size_t skip) {
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i)
+    total += segments[i].size();
+  const size_t needed = total - skip;
+
+  if (MQTT_TX_QUEUE_SIZE - txHead < needed && txTail > 0) {
+    std::memmove(txQueue.data(), txQueue.data() + txTail, txHead - txTail);
+    txHead -= txTail;
+    txTail = 0;
+  }
+  if (MQTT_TX_QUEUE_SIZE - txHead < needed)
+    return false;
+
+  for (size_t i = 0; i < count; ++i) {
+    const auto &segment = segments[i];
+    if (skip >= segment.size()) {
+      skip -= segment.size();
+      continue;
+    }
+    const size_t len = segment.size() - skip;
+    std::memcpy(txQueue.data() + txHead, segment.data() + skip, len);
+    txHead += len;
+    skip = 0;
+  }
+  return true;
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::flushTx() {
+  while (txTail < txHead) {
+    const types::span<const uint8_t> segment(txQueue.data() + txTail,
+                                             txHead - txTail);
+    int written = transport.write(&segment, 1);
+    if (written < 0)
+      return false;
+    if (written == 0)
+      break;
+    txTail += static_cast<size_t>(written);
+    lastOutMillis = millis();
+  }
+  if (txTail == txHead)
+    txTail = txHead = 0;
+  return true;
+}
+
+// ============================================================================
+// Main loop
+// ============================================================================
+
+template <typename TransportPolicy> bool MqttEngine<TransportPolicy>::loop() {
+  const unsigned long now = millis();
+
+  if (phase == Phase::Idle)
+    return false;
+
+  if (phase == Phase::TcpConnecting) {
+    auto status = transport.poll();
+    if (status == TransportPolicy::Status::Failed) {
+      LOG_ERROR("MqttEngine: TCP connect to %s:%d failed", host.c_str(),
+                port);
+      fail(STATE_CONNECT_FAILED);
+      return false;
+    }
+    if (status == TransportPolicy::Status::Pending) {
+      if (now - phaseStartMillis >= socketTimeoutMs)
+        fail(STATE_CONNECTION_TIMEOUT);
+      return false;
+    }
+    phase = Phase::AwaitConnAck;
+    lastInMillis = lastOutMillis = now;
+  }
+
+  const bool wasConnected = connected();
+  if (!flushTx() || !receive()) {
+    fail(wasConnected ? STATE_CONNECTION_LOST : STATE_CONNECT_FAILED);
+    return false;
+  }
+
+  if (phase == Phase::AwaitConnAck) {
+    if (now - phaseStartMillis >= socketTimeoutMs)
+      fail(STATE_CONNECTION_TIMEOUT);
+    return false;
+  }
+  if (phase != Phase::Connected)
+    return false;
+
+  if (keepAliveMs > 0 && (now - lastInMillis >= keepAliveMs ||
+                          now - lastOutMillis >= keepAliveMs)) {
+    if (pingOutstanding) {
+      LOG_WARN("MqttEngine: keep-alive timeout");
+      fail(STATE_CONNECTION_TIMEOUT);
+      return false;
+    }
+    const uint8_t packet[] = {PINGREQ, 0};
+    const types::span<const uint8_t> segment(packet, sizeof(packet));
+    if (sendPacket(&segment, 1)) {
+      pingOutstanding = true;
+      lastInMillis = now;
+    }
+  }
+  return connected();
+}
+
+// ============================================================================
+// Inbound packets
+// ============================================================================
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::receive() {
+  uint8_t chunk[RX_CHUNK_SIZE];
+  for (size_t i = 0; i < MAX_RX_CHUNKS_PER_LOOP; ++i) {
+    int n = transport.read(chunk, sizeof(chunk));
+    if (n < 0)
+      return false;
+    if (n == 0)
+      break;
+    lastInMillis = millis();
+    consume(chunk, static_cast<size_t>(n));
+    if (phase == Phase::Idle)
+      break;
+  }
+  return true;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::consume(const uint8_t *data, size_t length) {
+  size_t i = 0;
+  while (i < length && phase != Phase::Idle) {
+    switch (rxPhase) {
+    case RxPhase::FixedHeader:
+      rxHeader = data[i++];
+      rxRemaining = 0;
+      rxMultiplier = 1;
+      rxLengthBytes = 0;
+      rxFill = 0;
+      rxPhase = RxPhase::RemainingLength;
+      break;
+
+    case RxPhase::RemainingLength: {
+      const uint8_t b = data[i++];
+      rxRemaining += (b & 0x7F) * rxMultiplier;
+      rxMultiplier *= 128;
+      if (++rxLengthBytes > 4) {
+        LOG_ERROR("MqttEngine: malformed remaining length");
+        fail(STATE_CONNECTION_LOST);
+        return;
+      }
+      if ((b & 0x80) == 0) {
+        if (rxRemaining == 0) {
+          handlePacket();
+          rxPhase = RxPhase::FixedHeader;
+        } else {
+          rxPhase = RxPhase::Body;
+        }
+      }
+      break;
+    }
+
+    case RxPhase::Body: {
+      const size_t take = std::min<size_t>(length - i, rxRemaining - rxFill);
+      // Bytes past the buffer are skipped; the packet is dropped below
+      if (rxFill < rxBuffer.size()) {
+        const size_t fits = std::min(take, rxBuffer.size() - rxFill);
+        std::memcpy(rxBuffer.data() + rxFill, data + i, fits);
+      }
+      rxFill += take;
+      i += take;
+      if (rxFill == rxRemaining) {
+        if (rxRemaining <= rxBuffer.size()) {
+          handlePacket();
+        } else {
+          LOG_WARN("MqttEngine: dropping %u byte packet (buffer %u)",
+                   (unsigned)rxRemaining, (unsigned)rxBuffer.size());
+        }
+        rxPhase = RxPhase::FixedHeader;
+      }
+      break;
+    }
+    }
+  }
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::handlePacket() {
+  switch (rxHeader & 0xF0) {
+  case CONNACK:
+    handleConnAck();
+    break;
+  case PUBLISH:
+    if (phase == Phase::Connected)
+      handlePublish();
+    break;
+  case PUBACK:
+    if (phase == Phase::Connected)
+      handlePubAck();
+    break;
+  case PINGRESP:
+    pingOutstanding = false;
+    break;
+  default:
+    // SUBACK: subscriptions are not tracked
+    break;
+  }
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::handleConnAck() {
+  if (phase != Phase::AwaitConnAck || rxRemaining < 2)
+    return;
+  const uint8_t code = rxBuffer[1];
+  if (code != 0) {
+    if (version == MQTT_PROTOCOL_LEVEL_5 &&
+        (code == CONNACK_BAD_PROTOCOL_311 || code == CONNACK_BAD_PROTOCOL_5)) {
+      LOG_WARN("MqttEngine: broker doesn't support MQTT 5, next attempt "
+               "uses 3.1.1");
+      version = MQTT_PROTOCOL_LEVEL_311;
+    }
+    LOG_ERROR("MqttEngine: broker refused connection (rc=%d)", code);
+    fail(code);
+    return;
+  }
+
+  // MQTT 5 CONNACK properties; only the ones that change our behaviour
+  size_t pos = 2;
+  uint32_t propertyLength = 0;
+  if (version == MQTT_PROTOCOL_LEVEL_5 && rxRemaining > 2 &&
+      decodeLength(rxBuffer.data(), rxRemaining, pos, propertyLength)) {
+    const size_t end = std::min<size_t>(pos + propertyLength, rxRemaining);
+    while (pos < end) {
+      const uint8_t property = rxBuffer[pos++];
+      if ((property == PROPERTY_TOPIC_ALIAS_MAXIMUM ||
+           property == PROPERTY_SERVER_KEEP_ALIVE) &&
+          pos + 2 <= end) {
+        const uint16_t value =
+            static_cast<uint16_t>((rxBuffer[pos] << 8) | rxBuffer[pos + 1]);
+        pos += 2;
+        if (property == PROPERTY_TOPIC_ALIAS_MAXIMUM)
+          brokerTopicAliasMax = value;
+        else
+          keepAliveMs = static_cast<uint32_t>(value) * 1000;
+      } else if (!skipProperty(property, rxBuffer.data(), end, pos)) {
+        break;
+      }
+    }
+  }
+
+  phase = Phase::Connected;
+  stateCode = STATE_CONNECTED;
+  pingOutstanding = false;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::handlePublish() {
+  uint8_t *body = rxBuffer.data();
+  const size_t length = rxRemaining;
+  if (length < 2)
+    return;
+
+  const uint8_t qos = (rxHeader >> 1) & 0x03;
+  const size_t topicLen = (static_cast<size_t>(body[0]) << 8) | body[1];
+  size_t pos = 2 + topicLen;
+  uint16_t packetId = 0;
+  if (qos > 0) {
+    if (pos + 2 > length)
+      return;
+    packetId = static_cast<uint16_t>((body[pos] << 8) | body[pos + 1]);
+    pos += 2;
+  }
+  if (version == MQTT_PROTOCOL_LEVEL_5) {
+    // No inbound aliases were offered, so the properties can be skipped
+    uint32_t propertyLength = 0;
+    if (!decodeLength(body, length, pos, propertyLength))
+      return;
+    pos += propertyLength;
+  }
+  if (pos > length)
+    return;
+
+  // Shift the topic over its length prefix to NUL-terminate it in place
+  std::memmove(body, body + 2, topicLen);
+  body[topicLen] = '\0';
+
+  if (callback) {
+    callback(reinterpret_cast<char *>(body), body + pos,
+             static_cast<unsigned int>(length - pos));
+  }
+  if (qos == 1)
+    sendAck(PUBACK, packetId);
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::handlePubAck() {
+  if (rxRemaining < 2)
+    return;
+  const uint16_t packetId =
+      static_cast<uint16_t>((rxBuffer[0] << 8) | rxBuffer[1]);
+  // No retransmission: with a clean session the caller re-publishes whatever
+  // was not acknowledged after a reconnect
+  if (pubAckCallback)
+    pubAckCallback(packetId);
+}
+
+// ============================================================================
+// Encoding helpers
+// ============================================================================
+
+template <typename TransportPolicy>
+uint16_t MqttEngine<TransportPolicy>::allocatePacketId() {
+  if (++nextPacketId == 0)
+    nextPacketId = 1;
+  return nextPacketId;
+}
+
+template <typename TransportPolicy>
+size_t MqttEngine<TransportPolicy>::encodeLength(uint8_t *out,
+                                                 uint32_t length) {
+  size_t n = 0;
+  do {
+    uint8_t digit = length % 128;
+    length /= 128;
+    if (length > 0)
+      digit |= 0x80;
+    out[n++] = digit;
+  } while (length > 0 && n < 4);
+  return n;
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::decodeLength(const uint8_t *data,
+                                               size_t size, size_t &pos,
+                                               uint32_t &length) {
+  length = 0;
+  uint32_t multiplier = 1;
+  for (size_t i = 0; i < 4 && pos < size; ++i) {
+    const uint8_t digit = data[pos++];
+    length += (digit & 0x7F) * multiplier;
+    if ((digit & 0x80) == 0)
+      return true;
+    multiplier *= 128;
+  }
+  return false;
+}
+
+template <typename TransportPolicy>
+bool MqttEngine<TransportPolicy>::skipProperty(uint8_t id, const uint8_t *data,
+                                               size_t end, size_t &pos) {
+  size_t size = 0;
+  switch (id) {
+  case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28:
+  case 0x29: case 0x2A:
+    size = 1;
+    break;
+  case 0x13: case 0x21: case 0x22: case 0x23:
+    size = 2;
+    break;
+  case 0x02: case 0x11: case 0x18: case 0x27:
+    size = 4;
+    break;
+  case 0x0B: {
+    uint32_t ignored = 0;
+    return decodeLength(data, end, pos, ignored);
+  }
+  case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16:
+  case 0x1A: case 0x1C: case 0x1F: case PROPERTY_USER:
+    // Length-prefixed string or binary; a user property is two strings
+    for (int i = id == PROPERTY_USER ? 2 : 1; i > 0; --i) {
+      if (pos + 2 > end)
+        return false;
+      pos += 2 + ((static_cast<size_t>(data[pos]) << 8) | data[pos + 1]);
+    }
+    return pos <= end;
+  default:
+    return false; // unknown property: its size can't be known
+  }
+  pos += size;
+  return pos <= end;
+}
+
+template <typename TransportPolicy>
+void MqttEngine<TransportPolicy>::putString(std::vector<uint8_t> &out,
+                                            const char *str) {
+  const size_t len = strlen(str);
+  out.push_back(static_cast<uint8_t>(len >> 8));
+  out.push_back(static_cast<uint8_t>(len & 0xFF));
+  out.insert(out.end(), str, str + len);
+}
+
+} // namespace internal
+
+// Explicit instantiation for production and test builds
+template class internal::MqttEngine<SocketTransport>;
+template class internal::MqttEngine<MqttTransport>;
+
+} // namespace jrb::wifi_serial
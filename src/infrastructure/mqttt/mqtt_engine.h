@@ -0,0 +1,208 @@
+#pragma once
+
+#include "config.h"
+#include "infrastructure/mqttt/mqtt_properties.h"
+#include "infrastructure/types.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace jrb::wifi_serial {
+
+namespace internal {
+
+/**
+ * @class MqttEngine
+ * @brief Non-blocking MQTT 3.1.1 / 5 client implemented as a state machine.
+ * @tparam TransportPolicy Non-blocking byte transport (see SocketTransport)
+ *
+ * Drop-in replacement for PubSubClient behind PubSubClientPolicy. Unlike
+ * PubSubClient nothing here waits on the socket:
+ * - connect() only starts the TCP handshake and queues CONNECT; loop()
+ *   advances the connection and connected() turns true on CONNACK
+ * - publish() and subscribe() never wait for the broker, so publishes are
+ *   pipelined back to back
+ * - loop() parses whatever bytes are available, one partial packet at a time
+ *
+ * Publish payloads are written with a gather write straight from the caller's
+ * buffer (header + topic + payload, no staging copy). Only the tail the
+ * socket can't accept right now is copied into the bounded send queue, which
+ * also preserves ordering for packets behind it. A full queue makes publish()
+ * return false instead of blocking.
+ *
+ * With setProtocolVersion(5) the client speaks MQTT 5. Outgoing topics then
+ * get topic aliases (up to the broker's Topic Alias Maximum and
+ * MQTT_TOPIC_ALIASES): the first publish to a topic carries the topic and
+ * its alias, later ones only the 2-byte alias. A broker that rejects
+ * protocol level 5 makes the next attempt fall back to 3.1.1.
+ */
+template <typename TransportPolicy> class MqttEngine final {
+public:
+  using Callback = std::function<void(char *, uint8_t *, unsigned int)>;
+  using PubAckCallback = std::function<void(uint16_t)>;
+
+  // PubSubClient compatible state() codes
+  static constexpr int STATE_CONNECTION_TIMEOUT = -4;
+  static constexpr int STATE_CONNECTION_LOST = -3;
+  static constexpr int STATE_CONNECT_FAILED = -2;
+  static constexpr int STATE_DISCONNECTED = -1;
+  static constexpr int STATE_CONNECTED = 0;
+
+  MqttEngine();
+  MqttEngine(const MqttEngine &) = delete;
+  MqttEngine &operator=(const MqttEngine &) = delete;
+  ~MqttEngine() = default;
+
+  // PubSubClient compatible configuration
+  void setServer(const char *domain, int port);
+  void setCallback(Callback callback);
+  void setPubAckCallback(PubAckCallback callback);
+  bool setBufferSize(size_t size);
+  void setKeepAlive(uint16_t keepAliveSec);
+  void setSocketTimeout(uint16_t timeoutSec);
+
+  /**
+   * @brief MQTT protocol level for the next connect: 4 (3.1.1) or 5
+   */
+  void setProtocolVersion(uint8_t version);
+  uint8_t protocolVersion() const { return version; }
+
+  /**
+   * @brief Start connecting. Returns true if the attempt is under way (or
+   * already established); completion is reported by connected().
+   */
+  bool connect(const char *clientId);
+  bool connect(const char *clientId, const char *user, const char *password);
+  void disconnect();
+
+  bool connected() const { return phase == Phase::Connected; }
+  int state() const { return stateCode; }
+
+  bool subscribe(const char *topic, uint8_t qos);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length,
+               bool retained);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length,
+               bool retained, const MqttPublishProperties &properties);
+
+  /**
+   * @brief Publish with QoS 1. The broker's PUBACK is reported to the
+   * PubAckCallback with the returned packet id.
+   * @return Packet id, 0 if the packet could not be queued
+   */
+  uint16_t publishAcked(const char *topic, const uint8_t *payload,
+                        unsigned int length);
+  uint16_t publishAcked(const char *topic, const uint8_t *payload,
+                        unsigned int length,
+                        const MqttPublishProperties &properties);
+
+  /**
+   * @brief Topic aliases the broker accepts on this connection (MQTT 5)
+   */
+  uint16_t topicAliasMaximum() const { return brokerTopicAliasMax; }
+
+  /**
+   * @brief Advance the state machine: connect, send, receive, keep alive.
+   * @return false when not connected (PubSubClient semantics)
+   */
+  bool loop();
+
+  /**
+   * @brief Bytes waiting in the send queue (test/diagnostic helper).
+   */
+  size_t pendingTxBytes() const { return txHead - txTail; }
+
+  TransportPolicy &getTransport() { return transport; }
+
+private:
+  enum class Phase { Idle, TcpConnecting, AwaitConnAck, Connected };
+  enum class RxPhase { FixedHeader, RemainingLength, Body };
+
+  // MQTT control packet types (upper nibble of the fixed header)
+  static constexpr uint8_t CONNECT = 0x10;
+  static constexpr uint8_t CONNACK = 0x20;
+  static constexpr uint8_t PUBLISH = 0x30;
+  static constexpr uint8_t PUBACK = 0x40;
+  static constexpr uint8_t SUBSCRIBE = 0x82; // reserved flags 0b0010
+  static constexpr uint8_t SUBACK = 0x90;
+  static constexpr uint8_t PINGREQ = 0xC0;
+  static constexpr uint8_t PINGRESP = 0xD0;
+  static constexpr uint8_t DISCONNECT = 0xE0;
+
+  static constexpr size_t MAX_FIXED_HEADER = 5; // type + 4 length bytes
+  static constexpr size_t RX_CHUNK_SIZE = 128;
+  static constexpr size_t MAX_RX_CHUNKS_PER_LOOP = 8; // bounds loop() time
+  // Property length + expiry + alias + user properties that fit
+  static constexpr size_t MAX_PUBLISH_PROPERTIES = 4 + 5 + 3 + 96;
+
+  TransportPolicy transport;
+  Callback callback;
+  PubAckCallback pubAckCallback;
+  types::string host;
+  uint16_t port{0};
+  uint32_t keepAliveMs{15000};
+  uint32_t socketTimeoutMs{15000};
+
+  Phase phase{Phase::Idle};
+  int stateCode{STATE_DISCONNECTED};
+  unsigned long phaseStartMillis{0};
+  unsigned long lastOutMillis{0};
+  unsigned long lastInMillis{0};
+  bool pingOutstanding{false};
+  uint16_t nextPacketId{1};
+
+  uint8_t version{4}; // protocol level, see setProtocolVersion()
+  // Outgoing topic aliases of the current MQTT 5 connection; alias n is
+  // aliasTopics[n - 1]
+  uint16_t brokerTopicAliasMax{0};
+  std::array<types::string, MQTT_TOPIC_ALIASES> aliasTopics;
+  uint16_t aliasCount{0};
+
+  // Send queue: bytes [txTail, txHead) are waiting for the socket
+  std::array<uint8_t, MQTT_TX_QUEUE_SIZE> txQueue;
+  size_t txTail{0};
+  size_t txHead{0};
+
+  // Incremental parser state
+  std::vector<uint8_t> rxBuffer;
+  RxPhase rxPhase{RxPhase::FixedHeader};
+  uint8_t rxHeader{0};
+  uint32_t rxRemaining{0};
+  uint32_t rxMultiplier{1};
+  uint8_t rxLengthBytes{0};
+  size_t rxFill{0};
+
+  bool startConnect(const char *clientId, const char *user,
+                    const char *password);
+  bool sendPacket(const types::span<const uint8_t> *segments, size_t count);
+  bool sendPublish(const char *topic, const uint8_t *payload,
+                   unsigned int length, uint8_t flags, uint16_t packetId,
+                   const MqttPublishProperties *properties);
+  static size_t encodePublishProperties(uint16_t alias,
+                                        const MqttPublishProperties *properties,
+                                        uint8_t *out, size_t &start);
+  void handleConnAck();
+  bool queueBytes(const types::span<const uint8_t> *segments, size_t count,
+                  size_t skip);
+  bool flushTx();
+  bool receive();
+  void consume(const uint8_t *data, size_t length);
+  void handlePacket();
+  void handlePublish();
+  void handlePubAck();
+  void sendAck(uint8_t type, uint16_t packetId);
+  void fail(int code);
+  uint16_t allocatePacketId();
+
+  static size_t encodeLength(uint8_t *out, uint32_t length);
+  static bool decodeLength(const uint8_t *data, size_t size, size_t &pos,
+                           uint32_t &length);
+  static bool skipProperty(uint8_t id, const uint8_t *data, size_t end,
+                           size_t &pos);
+  static void putString(std::vector<uint8_t> &out, const char *str);
+};
+
+} // namespace internal
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @brief MQTT 5 properties of an outgoing PUBLISH
+ *
+ * Only encoded on MQTT 5 connections; a 3.1.1 connection publishes the same
+ * message without them. Keys and values are borrowed and must stay valid
+ * until publish() returns.
+ */
+struct MqttPublishProperties {
+  struct UserProperty {
+    const char *key;
+    const char *value;
+  };
+  static constexpr size_t MAX_USER_PROPERTIES = 2;
+
+  uint32_t messageExpirySec{0}; // 0 = never expires
+  std::array<UserProperty, MAX_USER_PROPERTIES> user{};
+  size_t userCount{0};
+
+  bool addUserProperty(const char *key, const char *value) {
+    if (userCount == MAX_USER_PROPERTIES)
+      return false;
+    user[userCount++] = {key, value};
+    return true;
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @file mqtt_transport.h
+ * @brief Central header for the MQTT transport (plain TCP or TLS).
+ *
+ * - ESP32: TLS through mbedTLS (MbedTlsPolicy)
+ * - Test/Native: TLS through OpenSSL (OpenSslTlsPolicy)
+ */
+
+#include "infrastructure/mqttt/tls_transport.h"
+
+#ifdef ESP_PLATFORM
+#include "infrastructure/mqttt/policy/tls_policy_mbedtls.h"
+#else
+#include "infrastructure/mqttt/policy/tls_policy_openssl.h"
+#endif
+
+namespace jrb::wifi_serial {
+
+#ifdef ESP_PLATFORM
+using TlsPolicy = MbedTlsPolicy;
+#else
+using TlsPolicy = OpenSslTlsPolicy;
+#endif
+
+using MqttTransport = internal::TlsTransport<TlsPolicy>;
+
+} // namespace jrb::wifi_serial
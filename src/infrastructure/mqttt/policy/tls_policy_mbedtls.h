@@ -0,0 +1,196 @@
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <lwip/sockets.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+
+// mbedTLS 3 hides struct members behind MBEDTLS_PRIVATE(); 2.x doesn't
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+namespace jrb::wifi_serial {
+
+/**
+ * @class MbedTlsPolicy
+ * @brief TLS policy for the ESP32, backed by the mbedTLS in ESP-IDF.
+ *
+ * RNG, configuration, CA chain and the SSL context with its record buffers
+ * (the bulk of the ~40 KB a TLS connection costs) are set up once in begin()
+ * and only reset between connections. The session of the last handshake is
+ * copied out and offered on the next connect to the same host; the broker
+ * resumes it from a session ticket or its session ID cache.
+ */
+class MbedTlsPolicy {
+public:
+  enum class Handshake { Pending, Done, Failed };
+
+  MbedTlsPolicy() { init(); }
+  MbedTlsPolicy(const MbedTlsPolicy &) = delete;
+  MbedTlsPolicy &operator=(const MbedTlsPolicy &) = delete;
+  ~MbedTlsPolicy() { release(); }
+
+  /**
+   * @brief Build the context; called again only when the CA changes
+   */
+  bool begin(const char *caCertPem) {
+    release();
+    init();
+    static constexpr char PERSONALIZATION[] = "wifi_serial_mqtt";
+    if (mbedtls_ctr_drbg_seed(
+            &drbg, mbedtls_entropy_func, &entropy,
+            reinterpret_cast<const unsigned char *>(PERSONALIZATION),
+            sizeof(PERSONALIZATION) - 1) != 0) {
+      return false;
+    }
+    if (mbedtls_ssl_config_defaults(&config, MBEDTLS_SSL_IS_CLIENT,
+                                    MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+      return false;
+    }
+    mbedtls_ssl_conf_rng(&config, mbedtls_ctr_drbg_random, &drbg);
+    if (caCertPem) {
+      // The PEM parser wants the terminating NUL in the length
+      if (mbedtls_x509_crt_parse(
+              &ca, reinterpret_cast<const unsigned char *>(caCertPem),
+              strlen(caCertPem) + 1) < 0) {
+        return false;
+      }
+      mbedtls_ssl_conf_ca_chain(&config, &ca, nullptr);
+      mbedtls_ssl_conf_authmode(&config, MBEDTLS_SSL_VERIFY_REQUIRED);
+    } else {
+      mbedtls_ssl_conf_authmode(&config, MBEDTLS_SSL_VERIFY_NONE);
+    }
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&config,
+                                     MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    return mbedtls_ssl_setup(&ssl, &config) == 0;
+  }
+
+  /**
+   * @brief Prepare a handshake on a connected socket
+   */
+  bool start(int fd, const char *host) {
+    if (mbedtls_ssl_session_reset(&ssl) != 0)
+      return false;
+    net.fd = fd;
+    mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, mbedtls_net_recv,
+                        nullptr);
+    // mbedTLS only matches DNS names; for an IP address the chain is still
+    // verified, the name isn't
+    in_addr address;
+    const bool numeric = inet_pton(AF_INET, host, &address) == 1;
+    if (mbedtls_ssl_set_hostname(&ssl, numeric ? nullptr : host) != 0)
+      return false;
+    if (sessionValid && sessionHost == host)
+      mbedtls_ssl_set_session(&ssl, &session);
+    sessionHost = host;
+    established = false;
+    fullHandshake = false;
+    return true;
+  }
+
+  Handshake handshake() {
+    // Stepped by hand to see whether the server sent its certificate,
+    // which only happens in a full handshake
+    while (ssl.MBEDTLS_PRIVATE(state) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+      if (ssl.MBEDTLS_PRIVATE(state) == MBEDTLS_SSL_SERVER_CERTIFICATE)
+        fullHandshake = true;
+      const int rc = mbedtls_ssl_handshake_step(&ssl);
+      if (rc == MBEDTLS_ERR_SSL_WANT_READ || rc == MBEDTLS_ERR_SSL_WANT_WRITE)
+        return Handshake::Pending;
+      if (rc != 0)
+        return Handshake::Failed;
+    }
+    established = true;
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_session_init(&session);
+    sessionValid = mbedtls_ssl_get_session(&ssl, &session) == 0;
+    return Handshake::Done;
+  }
+
+  bool resumed() const { return established && !fullHandshake; }
+
+  /**
+   * @return Bytes written, 0 if the socket would block, -1 on error
+   */
+  int write(const uint8_t *data, size_t length) {
+    const int n = mbedtls_ssl_write(&ssl, data, length);
+    if (n >= 0)
+      return n;
+    return wouldBlock(n) ? 0 : -1;
+  }
+
+  /**
+   * @return Bytes read, 0 if nothing is pending, -1 on error or close
+   */
+  int read(uint8_t *buffer, size_t size) {
+    const int n = mbedtls_ssl_read(&ssl, buffer, size);
+    if (n > 0)
+      return n;
+    return n < 0 && wouldBlock(n) ? 0 : -1;
+  }
+
+  /**
+   * @brief Send close_notify if possible; the session stays resumable
+   */
+  void stop() {
+    if (established)
+      mbedtls_ssl_close_notify(&ssl);
+    established = false;
+    net.fd = -1; // owned by SocketTransport
+  }
+
+  void forgetSession() {
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_session_init(&session);
+    sessionValid = false;
+  }
+
+private:
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_config config;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_x509_crt ca;
+  mbedtls_net_context net;
+  mbedtls_ssl_session session;
+  types::string sessionHost;
+  bool sessionValid{false};
+  bool established{false};
+  bool fullHandshake{false};
+
+  static bool wouldBlock(int rc) {
+    return rc == MBEDTLS_ERR_SSL_WANT_READ || rc == MBEDTLS_ERR_SSL_WANT_WRITE;
+  }
+
+  void init() {
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&config);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_net_init(&net);
+    mbedtls_ssl_session_init(&session);
+    sessionValid = false;
+  }
+
+  void release() {
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&config);
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include <arpa/inet.h>
+#include <cstddef>
+#include <cstdint>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @class OpenSslTlsPolicy
+ * @brief TLS policy for native builds, backed by OpenSSL.
+ *
+ * Mirrors MbedTlsPolicy: one SSL_CTX and one SSL object for the lifetime of
+ * the transport, cleared between connections, and the last session kept for
+ * resumption. Capped at TLS 1.2 like mbedTLS on the ESP32 Arduino core, so
+ * native measurements exercise the same handshakes.
+ */
+class OpenSslTlsPolicy {
+public:
+  enum class Handshake { Pending, Done, Failed };
+
+  OpenSslTlsPolicy() = default;
+  OpenSslTlsPolicy(const OpenSslTlsPolicy &) = delete;
+  OpenSslTlsPolicy &operator=(const OpenSslTlsPolicy &) = delete;
+
+  ~OpenSslTlsPolicy() {
+    forgetSession();
+    SSL_free(ssl);
+    SSL_CTX_free(context);
+  }
+
+  /**
+   * @brief Build the context; called again only when the CA changes
+   */
+  bool begin(const char *caCertPem) {
+    SSL_free(ssl);
+    SSL_CTX_free(context);
+    ssl = nullptr;
+    forgetSession();
+    verify = caCertPem != nullptr;
+
+    context = SSL_CTX_new(TLS_client_method());
+    if (!context)
+      return false;
+    SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_mode(context, SSL_MODE_ENABLE_PARTIAL_WRITE);
+    SSL_CTX_set_verify(context, verify ? SSL_VERIFY_PEER : SSL_VERIFY_NONE,
+                       nullptr);
+    if (verify && !loadCa(caCertPem))
+      return false;
+    ssl = SSL_new(context);
+    return ssl != nullptr;
+  }
+
+  /**
+   * @brief Prepare a handshake on a connected socket
+   */
+  bool start(int fd, const char *host) {
+    SSL_clear(ssl);
+    if (SSL_set_fd(ssl, fd) != 1)
+      return false;
+    SSL_set_connect_state(ssl);
+
+    in_addr address;
+    const bool numeric = inet_pton(AF_INET, host, &address) == 1;
+    if (!numeric)
+      SSL_set_tlsext_host_name(ssl, host);
+    if (verify) {
+      X509_VERIFY_PARAM *param = SSL_get0_param(ssl);
+      if (numeric)
+        X509_VERIFY_PARAM_set1_ip_asc(param, host);
+      else
+        X509_VERIFY_PARAM_set1_host(param, host, 0);
+    }
+    // SSL_clear() keeps the previous session; offer only the cached one
+    SSL_set_session(ssl, session && sessionHost == host ? session : nullptr);
+    sessionHost = host;
+    established = false;
+    return true;
+  }
+
+  Handshake handshake() {
+    const int rc = SSL_connect(ssl);
+    if (rc != 1) {
+      const int error = SSL_get_error(ssl, rc);
+      if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+        return Handshake::Pending;
+      ERR_clear_error();
+      return Handshake::Failed;
+    }
+    established = true;
+    SSL_SESSION_free(session);
+    session = SSL_get1_session(ssl);
+    return Handshake::Done;
+  }
+
+  bool resumed() const { return SSL_session_reused(ssl) == 1; }
+
+  /**
+   * @return Bytes written, 0 if the socket would block, -1 on error
+   */
+  int write(const uint8_t *data, size_t length) {
+    const int n = SSL_write(ssl, data, static_cast<int>(length));
+    return n > 0 ? n : wouldBlock(n) ? 0 : -1;
+  }
+
+  /**
+   * @return Bytes read, 0 if nothing is pending, -1 on error or close
+   */
+  int read(uint8_t *buffer, size_t size) {
+    const int n = SSL_read(ssl, buffer, static_cast<int>(size));
+    return n > 0 ? n : wouldBlock(n) ? 0 : -1;
+  }
+
+  /**
+   * @brief Send close_notify if possible; the session stays resumable
+   */
+  void stop() {
+    if (established)
+      SSL_shutdown(ssl);
+    established = false;
+    ERR_clear_error();
+  }
+
+  void forgetSession() {
+    SSL_SESSION_free(session);
+    session = nullptr;
+  }
+
+private:
+  SSL_CTX *context{nullptr};
+  SSL *ssl{nullptr};
+  SSL_SESSION *session{nullptr};
+  types::string sessionHost;
+  bool verify{false};
+  bool established{false};
+
+  bool wouldBlock(int rc) {
+    const int error = SSL_get_error(ssl, rc);
+    if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+      return true;
+    ERR_clear_error();
+    return false;
+  }
+
+  bool loadCa(const char *pem) {
+    BIO *bio = BIO_new_mem_buf(pem, -1);
+    if (!bio)
+      return false;
+    X509_STORE *store = SSL_CTX_get_cert_store(context);
+    size_t loaded = 0;
+    while (X509 *cert = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) {
+      if (X509_STORE_add_cert(store, cert) == 1)
+        loaded++;
+      X509_free(cert);
+    }
+    BIO_free(bio);
+    ERR_clear_error(); // end of input
+    return loaded > 0;
+  }
+};
+
+} // namespace jrb::wifi_serial
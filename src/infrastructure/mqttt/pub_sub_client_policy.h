@@ -1,9 +1,9 @@
 #pragma once
 
-
 #ifdef ESP_PLATFORM
-// ESP32 Platform - Use PubSubClient library
-#include <PubSubClient.h>
+// ESP32 Platform - Use the non-blocking in-house MQTT engine
+#include "infrastructure/mqttt/mqtt_engine.h"
+#include "infrastructure/mqttt/mqtt_transport.h"
 #else
 // Test/Native Platform - Use mock PubSubClient
 #include "infrastructure/mqttt/pub_sub_client_test.h"
@@ -13,8 +13,8 @@ namespace jrb::wifi_serial {
 
 // Type aliases for convenience
 #ifdef ESP_PLATFORM
-using PubSubClientPolicy = PubSubClient;
+using PubSubClientPolicy = internal::MqttEngine<MqttTransport>;
 #else
 using PubSubClientPolicy = PubSubClientTest;
 #endif
-} // namespace jrb::wifi_serial
\ No newline at end of file
+} // namespace jrb::wifi_serial
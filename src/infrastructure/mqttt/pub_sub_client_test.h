@@ -12,9 +12,11 @@
 
 #pragma once
 
+#include "infrastructure/mqttt/mqtt_properties.h"
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace jrb::wifi_serial {
@@ -36,10 +38,17 @@ private:
   uint16_t keepAlive_{15};
   uint16_t socketTimeout_{15};
   std::function<void(char *, uint8_t *, unsigned int)> callback_;
+  std::function<void(uint16_t)> pubAckCallback_;
+  uint16_t lastPacketId_{0};
+  uint8_t protocolVersion_{4};
 
   // Test tracking
   std::vector<std::string> subscribedTopics_;
   std::vector<std::string> publishedTopics_;
+  std::vector<std::vector<uint8_t>> publishedPayloads_;
+  std::vector<bool> publishedRetained_;
+  uint32_t lastMessageExpiry_{0};
+  std::vector<std::pair<std::string, std::string>> lastUserProperties_;
 
 public:
   PubSubClientTest() = default;
@@ -62,6 +71,13 @@ public:
     callback_ = callback;
   }
 
+  /**
+   * @brief Set the callback for PUBACKs of publishAcked() messages.
+   */
+  void setPubAckCallback(std::function<void(uint16_t)> callback) {
+    pubAckCallback_ = callback;
+  }
+
   /**
    * @brief Set the buffer size for messages.
    */
@@ -77,6 +93,12 @@ public:
    */
   void setSocketTimeout(uint16_t timeout) { socketTimeout_ = timeout; }
 
+  /**
+   * @brief Set the MQTT protocol level (4 or 5).
+   */
+  void setProtocolVersion(uint8_t version) { protocolVersion_ = version; }
+  uint8_t protocolVersion() const { return protocolVersion_; }
+
   /**
    * @brief Connect to MQTT broker without credentials.
    */
@@ -148,16 +170,48 @@ public:
    */
   bool publish(const char *topic, const uint8_t *payload, unsigned int length,
                bool retained) {
-    (void)payload;
-    (void)length;
-    (void)retained;
     if (connected_) {
       publishedTopics_.push_back(topic);
+      publishedPayloads_.emplace_back(payload, payload + length);
+      publishedRetained_.push_back(retained);
       return true;
     }
     return false;
   }
 
+  /**
+   * @brief Publish with MQTT 5 properties; the last ones are recorded.
+   */
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length,
+               bool retained, const MqttPublishProperties &properties) {
+    if (!publish(topic, payload, length, retained))
+      return false;
+    recordProperties(properties);
+    return true;
+  }
+
+  /**
+   * @brief Publish with QoS 1; acknowledge with simulatePubAck().
+   * @return Packet id, 0 when not connected
+   */
+  uint16_t publishAcked(const char *topic, const uint8_t *payload,
+                        unsigned int length) {
+    if (!publish(topic, payload, length, false))
+      return 0;
+    if (++lastPacketId_ == 0)
+      lastPacketId_ = 1;
+    return lastPacketId_;
+  }
+
+  uint16_t publishAcked(const char *topic, const uint8_t *payload,
+                        unsigned int length,
+                        const MqttPublishProperties &properties) {
+    const uint16_t packetId = publishAcked(topic, payload, length);
+    if (packetId != 0)
+      recordProperties(properties);
+    return packetId;
+  }
+
   // Test-specific methods for verification
 
   /**
@@ -174,6 +228,35 @@ public:
     return publishedTopics_;
   }
 
+  /**
+   * @brief Get payloads of published messages, parallel to topics (test helper).
+   */
+  const std::vector<std::vector<uint8_t>> &getPublishedPayloads() const {
+    return publishedPayloads_;
+  }
+
+  /**
+   * @brief Retained flags of published messages, parallel to topics (test
+   * helper).
+   */
+  const std::vector<bool> &getPublishedRetained() const {
+    return publishedRetained_;
+  }
+
+  /**
+   * @brief Message expiry of the last publish with properties (test helper).
+   */
+  uint32_t getLastMessageExpiry() const { return lastMessageExpiry_; }
+
+  /**
+   * @brief User properties of the last publish with properties (test
+   * helper).
+   */
+  const std::vector<std::pair<std::string, std::string>> &
+  getLastUserProperties() const {
+    return lastUserProperties_;
+  }
+
   /**
    * @brief Reset mock state (test helper).
    */
@@ -182,6 +265,10 @@ public:
     state_ = -1;
     subscribedTopics_.clear();
     publishedTopics_.clear();
+    publishedPayloads_.clear();
+    publishedRetained_.clear();
+    lastMessageExpiry_ = 0;
+    lastUserProperties_.clear();
   }
 
   /**
@@ -197,6 +284,19 @@ public:
     }
   }
 
+  /**
+   * @brief Packet id returned by the last publishAcked() (test helper).
+   */
+  uint16_t getLastPacketId() const { return lastPacketId_; }
+
+  /**
+   * @brief Simulate the broker acknowledging a QoS 1 publish (test helper).
+   */
+  void simulatePubAck(uint16_t packetId) {
+    if (pubAckCallback_ && connected_)
+      pubAckCallback_(packetId);
+  }
+
   /**
    * @brief Set connection state for testing (test helper).
    */
@@ -204,6 +304,15 @@ public:
     connected_ = connected;
     state_ = connected ? 0 : -1;
   }
+
+private:
+  void recordProperties(const MqttPublishProperties &properties) {
+    lastMessageExpiry_ = properties.messageExpirySec;
+    lastUserProperties_.clear();
+    for (size_t i = 0; i < properties.userCount; ++i)
+      lastUserProperties_.emplace_back(properties.user[i].key,
+                                       properties.user[i].value);
+  }
 };
 
 } // namespace jrb::wifi_serial
@@ -0,0 +1,206 @@
+/**
+ * @file socket_transport.h
+ * @brief Non-blocking TCP transport for MqttEngine built on BSD sockets.
+ *
+ * The same code runs on lwIP (ESP32) and POSIX (native tests): lwIP exposes
+ * the BSD socket API, so only the include set differs between platforms.
+ * Nothing in here ever blocks except the DNS lookup for non-numeric hosts,
+ * which is cached per host name.
+ */
+
+#pragma once
+
+#include "infrastructure/types.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace jrb::wifi_serial {
+
+/**
+ * @class SocketTransport
+ * @brief Transport policy: non-blocking connect, gather write, partial read.
+ */
+class SocketTransport final {
+public:
+  enum class Status { Pending, Ready, Failed };
+
+  SocketTransport() = default;
+  SocketTransport(const SocketTransport &) = delete;
+  SocketTransport &operator=(const SocketTransport &) = delete;
+  ~SocketTransport() { close(); }
+
+  /**
+   * @brief Start a non-blocking connect. Completion is reported by poll().
+   * @return false if the host can't be resolved or the socket can't be made
+   */
+  bool open(const char *host, uint16_t port) {
+    close();
+    sockaddr_in addr{};
+    if (!resolve(host, port, addr))
+      return false;
+
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      return false;
+
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int rc = ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    if (rc < 0 && errno != EINPROGRESS) {
+      close();
+      return false;
+    }
+    connected = (rc == 0);
+    return true;
+  }
+
+  /**
+   * @brief Check connect progress without blocking.
+   */
+  Status poll() {
+    if (fd < 0)
+      return Status::Failed;
+    if (connected)
+      return Status::Ready;
+
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    timeval zero{0, 0};
+    int rc = ::select(fd + 1, nullptr, &writable, nullptr, &zero);
+    if (rc == 0)
+      return Status::Pending;
+    if (rc < 0)
+      return Status::Failed;
+
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 ||
+        error != 0) {
+      return Status::Failed;
+    }
+    connected = true;
+    return Status::Ready;
+  }
+
+  /**
+   * @brief Gather-write segments straight from the callers' buffers.
+   * @return Bytes accepted by the socket, 0 if it would block, -1 on error
+   */
+  int write(const types::span<const uint8_t> *segments, size_t count) {
+    if (fd < 0 || !connected)
+      return -1;
+
+    iovec iov[MAX_SEGMENTS];
+    size_t used = 0;
+    for (size_t i = 0; i < count && used < MAX_SEGMENTS; ++i) {
+      if (segments[i].empty())
+        continue;
+      iov[used].iov_base = const_cast<uint8_t *>(segments[i].data());
+      iov[used].iov_len = segments[i].size();
+      used++;
+    }
+    if (used == 0)
+      return 0;
+
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = used;
+    ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0)
+      return wouldBlock() ? 0 : -1;
+    return static_cast<int>(n);
+  }
+
+  /**
+   * @brief Read whatever is available.
+   * @return Bytes read, 0 if nothing is pending, -1 on error or peer close
+   */
+  int read(uint8_t *buffer, size_t size) {
+    if (fd < 0 || !connected)
+      return -1;
+    ssize_t n = ::recv(fd, buffer, size, MSG_DONTWAIT);
+    if (n > 0)
+      return static_cast<int>(n);
+    if (n < 0 && wouldBlock())
+      return 0;
+    return -1;
+  }
+
+  void close() {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+    connected = false;
+  }
+
+  bool isOpen() const { return fd >= 0; }
+
+  /**
+   * @brief Socket descriptor, for a TLS layer on top (-1 when closed)
+   */
+  int nativeHandle() const { return fd; }
+
+  static constexpr size_t MAX_SEGMENTS = 8;
+
+private:
+  int fd{-1};
+  bool connected{false};
+  types::string cachedHost;
+  in_addr cachedAddr{};
+
+  static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+
+  bool resolve(const char *host, uint16_t port, sockaddr_in &addr) {
+    if (!host || !*host)
+      return false;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+
+    if (::inet_pton(AF_INET, host, &addr.sin_addr) == 1)
+      return true;
+    if (cachedHost == host) {
+      addr.sin_addr = cachedAddr;
+      return true;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (::getaddrinfo(host, nullptr, &hints, &result) != 0 || !result)
+      return false;
+    addr.sin_addr = reinterpret_cast<sockaddr_in *>(result->ai_addr)->sin_addr;
+    ::freeaddrinfo(result);
+
+    cachedHost = host;
+    cachedAddr = addr.sin_addr;
+    return true;
+  }
+};
+
+} // namespace jrb::wifi_serial
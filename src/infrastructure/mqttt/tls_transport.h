@@ -0,0 +1,218 @@
+/**
+ * @file tls_transport.h
+ * @brief Non-blocking transport for MqttEngine: plain TCP or TLS on top of
+ * SocketTransport.
+ *
+ * TLS is off until setTls(true). The TLS context (RNG, configuration, CA
+ * chain, record buffers) is set up on the first TLS connect and reused by
+ * every later one. The session of the last successful handshake is kept and
+ * offered on the next connect to the same host, so a reconnect resumes it
+ * (session ticket or session ID) and skips the certificate exchange and key
+ * agreement.
+ */
+
+#pragma once
+
+#include "config.h"
+#include "infrastructure/logging/logger.h"
+#include "infrastructure/mqttt/socket_transport.h"
+#include "infrastructure/types.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifndef ESP_PLATFORM
+#include "infrastructure/platform/arduino_compat.h"
+#else
+#include <Arduino.h>
+#endif
+
+namespace jrb::wifi_serial {
+namespace internal {
+
+/**
+ * @class TlsTransport
+ * @brief Transport policy with optional TLS.
+ * @tparam TlsPolicy TLS library binding (MbedTlsPolicy or OpenSslTlsPolicy)
+ *
+ * poll() reports Pending until the TCP connect and the TLS handshake are
+ * both done, so MqttEngine's connect timeout covers the handshake too.
+ *
+ * TLS can't gather-write, so write() copies the segments into one staging
+ * buffer of up to MQTT_TLS_WRITE_SIZE bytes and reports them as accepted;
+ * a record the socket couldn't take is retried with the same buffer before
+ * anything new is accepted.
+ */
+template <typename TlsPolicy> class TlsTransport final {
+public:
+  using Status = SocketTransport::Status;
+  static constexpr size_t MAX_SEGMENTS = SocketTransport::MAX_SEGMENTS;
+
+  TlsTransport() = default;
+  TlsTransport(const TlsTransport &) = delete;
+  TlsTransport &operator=(const TlsTransport &) = delete;
+  ~TlsTransport() { close(); }
+
+  /**
+   * @brief Use TLS for the next open()
+   * @param caCertPem CA chain to verify the broker against; nullptr
+   *        encrypts without verifying. Must stay valid while TLS is used.
+   */
+  void setTls(bool enabled, const char *caCertPem = nullptr) {
+    if (caCertPem != caCert)
+      contextReady = false; // rebuilt with the new chain on next open()
+    tlsEnabled = enabled;
+    caCert = caCertPem;
+  }
+
+  bool tlsActive() const { return tlsEnabled; }
+
+  /**
+   * @brief Drop the cached session; the next handshake is a full one
+   */
+  void forgetSession() { tls.forgetSession(); }
+
+  /**
+   * @brief Duration of the last completed handshake, TCP connect excluded
+   */
+  uint32_t lastHandshakeMs() const { return handshakeMs; }
+
+  /**
+   * @brief The last handshake resumed a cached session
+   */
+  bool lastHandshakeResumed() const { return resumed; }
+
+  bool open(const char *host, uint16_t port) {
+    close();
+    if (tlsEnabled && !contextReady) {
+      if (caCert == nullptr)
+        LOG_WARN("TLS: no CA certificate, broker identity is not verified");
+      contextReady = tls.begin(caCert);
+      if (!contextReady) {
+        LOG_ERROR("TLS: context setup failed");
+        return false;
+      }
+    }
+    hostName = host ? host : "";
+    handshaking = tlsEnabled;
+    return tcp.open(host, port);
+  }
+
+  Status poll() {
+    const Status status = tcp.poll();
+    if (status != Status::Ready || !handshaking)
+      return status;
+
+    if (!tlsStarted) {
+      if (!tls.start(tcp.nativeHandle(), hostName.c_str()))
+        return Status::Failed;
+      tlsStarted = true;
+      handshakeStart = millis();
+    }
+    switch (tls.handshake()) {
+    case TlsPolicy::Handshake::Pending:
+      return Status::Pending;
+    case TlsPolicy::Handshake::Failed:
+      LOG_ERROR("TLS: handshake with %s failed", hostName.c_str());
+      return Status::Failed;
+    case TlsPolicy::Handshake::Done:
+      break;
+    }
+    handshaking = false;
+    handshakeMs = static_cast<uint32_t>(millis() - handshakeStart);
+    resumed = tls.resumed();
+    LOG_INFO("TLS: %s handshake in %u ms", resumed ? "resumed" : "full",
+             static_cast<unsigned>(handshakeMs));
+    return Status::Ready;
+  }
+
+  /**
+   * @return Bytes accepted, 0 if the socket would block, -1 on error
+   */
+  int write(const types::span<const uint8_t> *segments, size_t count) {
+    if (!tlsEnabled)
+      return tcp.write(segments, count);
+    if (!tlsStarted || handshaking)
+      return -1;
+
+    const int pending = flushStaged();
+    if (pending <= 0)
+      return pending;
+
+    size_t accepted = 0;
+    for (size_t i = 0; i < count && accepted < staged.size(); ++i) {
+      const size_t length =
+          std::min(segments[i].size(), staged.size() - accepted);
+      memcpy(staged.data() + accepted, segments[i].data(), length);
+      accepted += length;
+    }
+    if (accepted == 0)
+      return 0;
+    stagedLength = accepted;
+    stagedSent = 0;
+    return flushStaged() < 0 ? -1 : static_cast<int>(accepted);
+  }
+
+  /**
+   * @return Bytes read, 0 if nothing is pending, -1 on error or peer close
+   */
+  int read(uint8_t *buffer, size_t size) {
+    if (!tlsEnabled)
+      return tcp.read(buffer, size);
+    if (!tlsStarted || handshaking)
+      return -1;
+    // Nothing else may push a staged record out once the engine's queue
+    // is empty
+    if (flushStaged() < 0)
+      return -1;
+    return tls.read(buffer, size);
+  }
+
+  void close() {
+    if (tlsStarted)
+      tls.stop(); // keeps the session for the next connect
+    tlsStarted = false;
+    handshaking = false;
+    stagedLength = stagedSent = 0;
+    tcp.close();
+  }
+
+  bool isOpen() const { return tcp.isOpen(); }
+
+private:
+  SocketTransport tcp;
+  TlsPolicy tls;
+  const char *caCert{nullptr};
+  types::string hostName;
+  bool tlsEnabled{false};
+  bool contextReady{false};
+  bool tlsStarted{false};
+  bool handshaking{false};
+  bool resumed{false};
+  unsigned long handshakeStart{0};
+  uint32_t handshakeMs{0};
+
+  std::array<uint8_t, MQTT_TLS_WRITE_SIZE> staged;
+  size_t stagedLength{0};
+  size_t stagedSent{0};
+
+  // 1 when nothing is staged, 0 while the record is still pending, -1 on
+  // error
+  int flushStaged() {
+    while (stagedSent < stagedLength) {
+      const int n =
+          tls.write(staged.data() + stagedSent, stagedLength - stagedSent);
+      if (n < 0)
+        return -1;
+      if (n == 0)
+        return 0;
+      stagedSent += static_cast<size_t>(n);
+    }
+    stagedLength = stagedSent = 0;
+    return 1;
+  }
+};
+
+} // namespace internal
+} // namespace jrb::wifi_serial
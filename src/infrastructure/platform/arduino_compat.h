@@ -10,6 +10,7 @@
 
 #ifndef ESP_PLATFORM
 
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <chrono>
@@ -18,13 +19,22 @@
 using byte = uint8_t;
 
 namespace {
+// Added to millis(): tests step the clock with advanceMillis() instead of
+// sleeping through long intervals
+std::atomic<unsigned long> millisOffset{0};
+
 // Simple mock for millis() - returns milliseconds since epoch
 inline unsigned long millis() {
   auto now = std::chrono::steady_clock::now();
   auto duration = now.time_since_epoch();
-  return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+             .count() +
+         millisOffset.load();
 }
 
+// Moves millis() forward; it never goes back
+inline void advanceMillis(unsigned long ms) { millisOffset += ms; }
+
 // Simple mock for delay() - does nothing in tests (can be enhanced if needed)
 inline void delay(unsigned long ms) {
   (void)ms;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <LittleFS.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @class LittleFsFileSystem
+ * @brief File system policy backed by the Arduino LittleFS instance.
+ *
+ * Only the handful of operations the firmware needs: append-only writes,
+ * positional reads and flat directory listings.
+ */
+class LittleFsFileSystem {
+public:
+  /**
+   * @brief Mount (no-op if the web server already did)
+   */
+  bool begin() { return LittleFS.begin(true); }
+
+  bool mkdir(const char *path) {
+    return LittleFS.exists(path) || LittleFS.mkdir(path);
+  }
+
+  size_t size(const char *path) {
+    File file = LittleFS.open(path, FILE_READ);
+    return file ? file.size() : 0;
+  }
+
+  bool append(const char *path, const uint8_t *data, size_t length) {
+    File file = LittleFS.open(path, FILE_APPEND);
+    return file && file.write(data, length) == length;
+  }
+
+  size_t read(const char *path, size_t offset, uint8_t *buffer,
+              size_t length) {
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file || !file.seek(offset))
+      return 0;
+    return file.read(buffer, length);
+  }
+
+  bool remove(const char *path) { return LittleFS.remove(path); }
+
+  /**
+   * @brief Call fn(name) for every file in dir (names without the path)
+   */
+  template <typename Fn> void list(const char *dir, Fn &&fn) {
+    File root = LittleFS.open(dir);
+    if (!root || !root.isDirectory())
+      return;
+    for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+      if (!file.isDirectory())
+        fn(file.name());
+    }
+  }
+};
+
+} // namespace jrb::wifi_serial
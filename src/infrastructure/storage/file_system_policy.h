@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * @file file_system_policy.h
+ * @brief Central header for file system policy selection based on platform.
+ *
+ * - ESP32: LittleFsFileSystem on the "spiffs" data partition (shared with
+ *   the web assets)
+ * - Test/Native: FileSystemTest, an in-memory file system
+ */
+
+#ifdef ESP_PLATFORM
+#include "infrastructure/storage/file_system_littlefs.h"
+#else
+#include "infrastructure/storage/file_system_test.h"
+#endif
+
+namespace jrb::wifi_serial {
+
+#ifdef ESP_PLATFORM
+using FileSystemPolicy = LittleFsFileSystem;
+#else
+using FileSystemPolicy = FileSystemTest;
+#endif
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+
+/**
+ * @class FileSystemTest
+ * @brief In-memory file system policy for native tests.
+ *
+ * Files live in static storage so they survive a new policy instance, like
+ * flash survives a reboot (see TestStoragePolicy). Tests call reset() and
+ * can cap the total size to simulate a full partition.
+ */
+class FileSystemTest {
+private:
+  static inline std::map<std::string, std::vector<uint8_t>> files;
+  static inline size_t capacity = SIZE_MAX;
+  static inline bool mounted = true;
+
+  static size_t used() {
+    size_t total = 0;
+    for (const auto &entry : files)
+      total += entry.second.size();
+    return total;
+  }
+
+public:
+  bool begin() { return mounted; }
+
+  bool mkdir(const char *path) {
+    (void)path; // directories are implicit
+    return true;
+  }
+
+  size_t size(const char *path) {
+    auto it = files.find(path);
+    return it == files.end() ? 0 : it->second.size();
+  }
+
+  bool append(const char *path, const uint8_t *data, size_t length) {
+    if (used() + length > capacity)
+      return false;
+    auto &file = files[path];
+    file.insert(file.end(), data, data + length);
+    return true;
+  }
+
+  size_t read(const char *path, size_t offset, uint8_t *buffer,
+              size_t length) {
+    auto it = files.find(path);
+    if (it == files.end() || offset >= it->second.size())
+      return 0;
+    const size_t n = std::min(length, it->second.size() - offset);
+    std::memcpy(buffer, it->second.data() + offset, n);
+    return n;
+  }
+
+  bool remove(const char *path) { return files.erase(path) > 0; }
+
+  template <typename Fn> void list(const char *dir, Fn &&fn) {
+    const std::string prefix = std::string(dir) + "/";
+    for (const auto &entry : files) {
+      if (entry.first.compare(0, prefix.size(), prefix) == 0 &&
+          entry.first.find('/', prefix.size()) == std::string::npos)
+        fn(entry.first.c_str() + prefix.size());
+    }
+  }
+
+  // Test helpers
+
+  static void reset() {
+    files.clear();
+    capacity = SIZE_MAX;
+    mounted = true;
+  }
+  static void setCapacity(size_t bytes) { capacity = bytes; }
+  static void setMounted(bool state) { mounted = state; }
+  static size_t fileCount() { return files.size(); }
+  static size_t totalBytes() { return used(); }
+};
+
+} // namespace jrb::wifi_serial
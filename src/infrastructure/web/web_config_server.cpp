@@ -231,6 +231,27 @@ void WebConfigServer::setup(WebConfigServer::SerialWriteCallback onTtyS0Write,
         preferencesStorage.mqttPassword = newMqttPassword.c_str();
       }
     }
+    // Checkboxes are only posted when ticked; "broker" marks the MQTT form
+    if (request->hasParam("broker", true)) {
+      preferencesStorage.mqttFramed = request->hasParam("mqtt_framed", true);
+      preferencesStorage.mqttCompressed =
+          request->hasParam("mqtt_compressed", true);
+      preferencesStorage.mqttVersion5 = request->hasParam("mqtt_v5", true);
+      preferencesStorage.mqttTls = request->hasParam("mqtt_tls", true);
+      preferencesStorage.mqttJson = request->hasParam("mqtt_json", true);
+      preferencesStorage.mqttMultiplex = request->hasParam("mqtt_mux", true);
+    }
+    if (request->hasParam("mqtt_snapshot", true)) {
+      const long seconds =
+          request->getParam("mqtt_snapshot", true)->value().toInt();
+      preferencesStorage.mqttSnapshotInterval = seconds > 0 ? seconds : 0;
+    }
+    if (request->hasParam("mqtt_inflight", true)) {
+      const long window =
+          request->getParam("mqtt_inflight", true)->value().toInt();
+      preferencesStorage.mqttInflight =
+          std::clamp<long>(window, 0, MQTT_MAX_INFLIGHT);
+    }
 
     // Process Web User settings
     if (request->hasParam("web_user", true)) {
@@ -327,6 +348,30 @@ String WebConfigServer::processor(const String &var) {
   if (var == "MQTT_PASSWORD_HAS_VALUE") {
     return preferencesStorage.mqttPassword.length() > 0 ? "1" : "0";
   }
+  if (var == "MQTT_FRAMED_CHECKED") {
+    return preferencesStorage.mqttFramed ? "checked" : "";
+  }
+  if (var == "MQTT_COMPRESSED_CHECKED") {
+    return preferencesStorage.mqttCompressed ? "checked" : "";
+  }
+  if (var == "MQTT_V5_CHECKED") {
+    return preferencesStorage.mqttVersion5 ? "checked" : "";
+  }
+  if (var == "MQTT_TLS_CHECKED") {
+    return preferencesStorage.mqttTls ? "checked" : "";
+  }
+  if (var == "MQTT_JSON_CHECKED") {
+    return preferencesStorage.mqttJson ? "checked" : "";
+  }
+  if (var == "MQTT_MUX_CHECKED") {
+    return preferencesStorage.mqttMultiplex ? "checked" : "";
+  }
+  if (var == "MQTT_SNAPSHOT_INTERVAL") {
+    return String(preferencesStorage.mqttSnapshotInterval);
+  }
+  if (var == "MQTT_INFLIGHT") {
+    return String(preferencesStorage.mqttInflight);
+  }
   if (var == "TOPIC_TTY0_RX") {
     return String(escapeHTML(preferencesStorage.topicTty0Rx).c_str());
   }
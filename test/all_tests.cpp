@@ -9,12 +9,46 @@
 #include "domain/config/special_character_handler_test.cpp"
 #include "domain/messaging/buffered_stream_test.cpp"
 #include "domain/messaging/mqtt_flush_policy_test.cpp"
+#include "domain/messaging/mqtt_mux_batch_test.cpp"
+#include "domain/messaging/mqtt_spill_queue_test.cpp"
+#include "domain/messaging/mqtt_topic_router_benchmark_test.cpp"
+#include "domain/messaging/mqtt_topic_router_test.cpp"
+#include "domain/messaging/mqtt_upload_receiver_test.cpp"
+#include "domain/messaging/publish_budget_test.cpp"
+#include "domain/messaging/telemetry_document_test.cpp"
+#include "domain/messaging/tty_compression_benchmark_test.cpp"
+#include "domain/messaging/tty_compression_test.cpp"
+#include "domain/messaging/tty_frame_test.cpp"
+#include "domain/messaging/tty_json_benchmark_test.cpp"
+#include "domain/messaging/tty_json_test.cpp"
+#include "domain/messaging/tty_line_clock_test.cpp"
+#include "domain/messaging/tty_mux_test.cpp"
+#include "domain/messaging/tty_snapshot_test.cpp"
+#include "domain/network/ssh_authorized_keys_benchmark_test.cpp"
+#include "domain/network/ssh_authorized_keys_test.cpp"
+#include "domain/network/ssh_channel_write_benchmark_test.cpp"
+#include "domain/network/ssh_host_key_benchmark_test.cpp"
+#include "domain/network/ssh_host_key_order_test.cpp"
+#include "domain/network/ssh_host_key_store_test.cpp"
 #include "domain/network/ssh_server_test.cpp"
+#include "domain/network/ssh_session_fanout_benchmark_test.cpp"
+#include "domain/network/ssh_session_loop_benchmark_test.cpp"
 #include "domain/network/ssh_subscriber_test.cpp"
 #include "domain/serial/serial_log_test.cpp"
 #include "infrastructure/hardware/button_handler_test.cpp"
+#include "infrastructure/memory/broadcast_ring_test.cpp"
 #include "infrastructure/memory/circular_buffer_test.cpp"
+#include "infrastructure/memory/loss_tracking_ring_test.cpp"
+#include "infrastructure/memory/spsc_ring_test.cpp"
+#include "infrastructure/memory/write_batch_test.cpp"
 #include "infrastructure/mqttt/mqtt_client_test.cpp"
+#include "infrastructure/mqttt/mqtt_client_mux_benchmark_test.cpp"
+#include "infrastructure/mqttt/mqtt_client_throughput_benchmark_test.cpp"
+#include "infrastructure/mqttt/mqtt_engine_test.cpp"
+#include "infrastructure/mqttt/mqtt_engine_wire_benchmark_test.cpp"
+#include "infrastructure/mqttt/mqtt_task_latency_test.cpp"
+#include "infrastructure/mqttt/tls_handshake_benchmark_test.cpp"
+#include "infrastructure/mqttt/tls_transport_test.cpp"
 #include "infrastructure/web/web_config_server_test.cpp"
 #include "infrastructure/wifi/wifi_manager_test.cpp"
 
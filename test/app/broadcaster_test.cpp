@@ -1,20 +1,72 @@
-// Placeholder test file
-// TODO: Implement once Arduino dependencies are abstracted
+#include "app/broadcaster.hpp"
 
 #include <gtest/gtest.h>
+#include <vector>
 
 namespace jrb::wifi_serial {
 namespace {
 
+// Subscriber that records how it was fed
+template <size_t BACKLOG> struct FakeSink {
+  static constexpr size_t INACTIVE_BACKLOG = BACKLOG;
+
+  bool isActive{true};
+  std::vector<uint8_t> appended;
+  std::vector<uint8_t> retained;
+
+  bool active() const { return isActive; }
+  void append(uint8_t byte) { appended.push_back(byte); }
+  void append(const types::span<const uint8_t> &data) {
+    appended.insert(appended.end(), data.begin(), data.end());
+  }
+  void retain(uint8_t byte) { retained.push_back(byte); }
+  void retain(const types::span<const uint8_t> &data) {
+    retained.insert(retained.end(), data.begin(), data.end());
+  }
+};
+
+using KeepingSink = FakeSink<4>;
+using DiscardingSink = FakeSink<0>;
+
 class BroadcasterTest : public ::testing::Test {
 protected:
-  void SetUp() override {}
-  void TearDown() override {}
+  KeepingSink keeping;
+  DiscardingSink discarding;
+  Broadcaster<KeepingSink, DiscardingSink> broadcaster{keeping, discarding};
 };
 
-TEST_F(BroadcasterTest, PlaceholderTest) {
-  // Add the tests here once dependencies are resolved
-  EXPECT_TRUE(true);
+TEST_F(BroadcasterTest, ActiveSubscribersReceiveBytes) {
+  broadcaster.append(0x41);
+
+  EXPECT_EQ(keeping.appended, std::vector<uint8_t>({0x41}));
+  EXPECT_EQ(discarding.appended, std::vector<uint8_t>({0x41}));
+}
+
+TEST_F(BroadcasterTest, ActiveSubscribersReceiveSpans) {
+  const uint8_t data[] = {1, 2, 3};
+  broadcaster.append(types::span<const uint8_t>(data, sizeof(data)));
+
+  EXPECT_EQ(keeping.appended, std::vector<uint8_t>({1, 2, 3}));
+  EXPECT_EQ(discarding.appended, std::vector<uint8_t>({1, 2, 3}));
+}
+
+TEST_F(BroadcasterTest, InactiveSubscriberWithBacklogRetains) {
+  keeping.isActive = false;
+  broadcaster.append(0x42);
+
+  EXPECT_TRUE(keeping.appended.empty());
+  EXPECT_EQ(keeping.retained, std::vector<uint8_t>({0x42}));
+  EXPECT_EQ(discarding.appended, std::vector<uint8_t>({0x42}));
+}
+
+TEST_F(BroadcasterTest, InactiveSubscriberWithoutBacklogDiscards) {
+  discarding.isActive = false;
+  const uint8_t data[] = {7, 8};
+  broadcaster.append(types::span<const uint8_t>(data, sizeof(data)));
+
+  EXPECT_TRUE(discarding.appended.empty());
+  EXPECT_TRUE(discarding.retained.empty());
+  EXPECT_EQ(keeping.appended, std::vector<uint8_t>({7, 8}));
 }
 
 } // namespace
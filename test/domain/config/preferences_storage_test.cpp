@@ -1,4 +1,5 @@
 #include "domain/config/preferences_storage.cpp" // Include implementation for tests
+#include "domain/messaging/telemetry_document.hpp"
 #include <gtest/gtest.h>
 
 namespace jrb::wifi_serial {
@@ -166,6 +167,35 @@ TEST_F(PreferencesStorageTest, SerializeMasksPasswords) {
   EXPECT_NE(json.find("********"), types::string::npos);
 }
 
+TEST_F(PreferencesStorageTest, DescribeToMatchesSerializeKeys) {
+  PreferencesStorage storage;
+  storage.mqttPassword = "secret123";
+  storage.mqttPort = 8883;
+
+  TelemetryDocument<MQTT_INFO_MAX_FIELDS> document;
+  storage.describeTo(document);
+  // Application adds macAddress and 8 fields of its own (INFO_FIELDS)
+  EXPECT_EQ(document.size() + 9, 32u);
+  const types::string json = document.full();
+
+  EXPECT_NE(json.find("\"mqttPort\":8883"), types::string::npos);
+  EXPECT_NE(json.find("\"mqttPassword\":\"********\""), types::string::npos);
+  EXPECT_NE(json.find("\"debugEnabled\":false"), types::string::npos);
+  EXPECT_EQ(json.find("secret123"), types::string::npos);
+
+  // Every key except the network ones supplied by the caller
+  const types::string serialized = storage.serialize("", "", "");
+  for (size_t pos = serialized.find("\n  \""); pos != types::string::npos;
+       pos = serialized.find("\n  \"", pos + 1)) {
+    const size_t start = pos + 4;
+    const types::string key =
+        serialized.substr(start, serialized.find('"', start) - start);
+    if (key == "ipAddress" || key == "macAddress" || key == "ssid")
+      continue;
+    EXPECT_NE(json.find("\"" + key + "\":"), types::string::npos) << key;
+  }
+}
+
 // ============================================================================
 // Topic Generation Tests
 // ============================================================================
@@ -1,20 +1,283 @@
-// Placeholder test file
-// TODO: Implement once Arduino dependencies are abstracted
+#include "infrastructure/memory/buffered_stream.hpp"
 
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 
 namespace jrb::wifi_serial {
 namespace {
 
-class BufferedStreamTest : public ::testing::Test {
+// Flush policy that records every flushed chunk
+template <size_t BACKLOG> struct RecordingFlushPolicy {
+  static constexpr size_t INACTIVE_BACKLOG = BACKLOG;
+
+  bool &isActive;
+  std::vector<std::string> &chunks;
+  std::vector<uint32_t> &offsets;
+
+  bool active() const { return isActive; }
+  void flush(const types::span<const uint8_t> &buffer, uint32_t offset,
+             const char *) {
+    chunks.emplace_back(reinterpret_cast<const char *>(buffer.data()),
+                        buffer.size());
+    offsets.push_back(offset);
+  }
+  // Packet id = position of the chunk in `chunks`, counting from 1
+  uint16_t publishAcked(const types::span<const uint8_t> &buffer,
+                        uint32_t offset) {
+    flush(buffer, offset, nullptr);
+    return static_cast<uint16_t>(chunks.size());
+  }
+};
+
+template <size_t BACKLOG, size_t IN_FLIGHT = 0> class BufferedStreamFixture {
 protected:
-  void SetUp() override {}
-  void TearDown() override {}
+  bool isActive{true};
+  std::vector<std::string> chunks;
+  std::vector<uint32_t> offsets;
+  BufferedStream<RecordingFlushPolicy<BACKLOG>, 16, IN_FLIGHT> stream{
+      RecordingFlushPolicy<BACKLOG>{isActive, chunks, offsets}, "test"};
+
+  void appendString(const std::string &s) {
+    stream.append(types::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(s.data()), s.size()));
+  }
+  void retainString(const std::string &s) {
+    stream.retain(types::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(s.data()), s.size()));
+  }
+  std::string joined() const {
+    std::string all;
+    for (const auto &c : chunks)
+      all += c;
+    return all;
+  }
 };
 
-TEST_F(BufferedStreamTest, PlaceholderTest) {
-  // Add the tests here once dependencies are resolved
-  EXPECT_TRUE(true);
+class BufferedStreamTest : public ::testing::Test,
+                           public BufferedStreamFixture<8> {};
+class DiscardingBufferedStreamTest : public ::testing::Test,
+                                     public BufferedStreamFixture<0> {};
+class AcknowledgedBufferedStreamTest : public ::testing::Test,
+                                       public BufferedStreamFixture<8, 2> {};
+
+TEST_F(BufferedStreamTest, FlushesOnNewline) {
+  appendString("hello\n");
+
+  ASSERT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(chunks[0], "hello\n");
+  EXPECT_TRUE(stream.empty());
+}
+
+TEST_F(BufferedStreamTest, ActiveFollowsFlushPolicy) {
+  EXPECT_TRUE(stream.active());
+  isActive = false;
+  EXPECT_FALSE(stream.active());
+}
+
+TEST_F(BufferedStreamTest, RetainDoesNotFlushOnNewline) {
+  isActive = false;
+  retainString("a\nb\n");
+
+  EXPECT_TRUE(chunks.empty());
+  EXPECT_FALSE(stream.empty());
+}
+
+TEST_F(BufferedStreamTest, RetainKeepsMostRecentBacklogBytes) {
+  isActive = false;
+  retainString("0123456789ABCDEF");
+
+  isActive = true;
+  stream.flush();
+
+  EXPECT_EQ(joined(), "89ABCDEF");
+}
+
+TEST_F(BufferedStreamTest, RetainedBytesReplayBeforeNewData) {
+  isActive = false;
+  retainString("old");
+
+  isActive = true;
+  appendString("new\n");
+
+  EXPECT_EQ(joined(), "oldnew\n");
+}
+
+TEST_F(BufferedStreamTest, WrappedBacklogIsFlushedInOrder) {
+  appendString("0123456789\n"); // moves head/tail to the middle
+  chunks.clear();
+
+  isActive = false;
+  retainString("abcdefghijkl");
+  stream.flush();
+
+  EXPECT_EQ(joined(), "efghijkl");
+}
+
+TEST_F(BufferedStreamTest, FlushesCarryContiguousOffsets) {
+  appendString("ab\n");
+  appendString("cde\n");
+
+  ASSERT_EQ(offsets.size(), 2u);
+  EXPECT_EQ(offsets[0], 0u);
+  EXPECT_EQ(offsets[1], 3u);
+  EXPECT_EQ(stream.nextOffset(), 7u);
+}
+
+TEST_F(BufferedStreamTest, TrimmedBacklogAdvancesOffset) {
+  isActive = false;
+  retainString("0123456789"); // backlog 8: "01" trimmed
+
+  isActive = true;
+  stream.flush();
+
+  ASSERT_EQ(offsets.size(), 1u);
+  EXPECT_EQ(offsets[0], 2u);
+  EXPECT_EQ(chunks[0], "23456789");
+}
+
+TEST_F(BufferedStreamTest, WrappedFlushOffsetsFollowEachChunk) {
+  appendString("0123456789\n");
+  isActive = false;
+  retainString("abcdefgh");
+  isActive = true;
+  stream.flush();
+
+  ASSERT_EQ(offsets.size(), 3u);
+  EXPECT_EQ(offsets[1], 11u);
+  EXPECT_EQ(offsets[2], 11u + chunks[1].size());
+}
+
+TEST_F(BufferedStreamTest, SkipFlushesBufferedBytesThenJumps) {
+  appendString("abc");
+  stream.skip(5);
+  appendString("d\n");
+
+  ASSERT_EQ(chunks.size(), 2u);
+  EXPECT_EQ(chunks[0], "abc");
+  EXPECT_EQ(offsets[0], 0u);
+  EXPECT_EQ(chunks[1], "d\n");
+  EXPECT_EQ(offsets[1], 8u);
+}
+
+TEST_F(BufferedStreamTest, SkipWhileInactiveDiscardsOlderBacklog) {
+  isActive = false;
+  retainString("old");
+  stream.skip(2);
+  retainString("new");
+
+  isActive = true;
+  stream.flush();
+
+  ASSERT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(chunks[0], "new");
+  EXPECT_EQ(offsets[0], 5u);
+}
+
+TEST_F(BufferedStreamTest, DrainBypassesFlushPolicyAndKeepsOffsets) {
+  appendString("0123456789\n");
+  isActive = false;
+  retainString("abcdefgh");
+
+  std::string drained;
+  std::vector<uint32_t> drainedOffsets;
+  stream.drain([&](const types::span<const uint8_t> &chunk, uint32_t offset) {
+    drained.append(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+    drainedOffsets.push_back(offset);
+  });
+
+  EXPECT_EQ(chunks.size(), 1u); // only the line flushed before
+  EXPECT_EQ(drained, "abcdefgh");
+  ASSERT_EQ(drainedOffsets.size(), 2u); // wrapped
+  EXPECT_EQ(drainedOffsets[0], 11u);
+  EXPECT_TRUE(stream.empty());
+  EXPECT_EQ(stream.nextOffset(), 19u);
+}
+
+TEST_F(BufferedStreamTest, LineFlushCanBeDisabledForBatching) {
+  stream.setLineFlush(false);
+  appendString("one\ntwo\n");
+
+  EXPECT_TRUE(chunks.empty());
+  EXPECT_EQ(stream.buffered(), 8u);
+
+  stream.flush();
+  ASSERT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(chunks[0], "one\ntwo\n");
+}
+
+TEST_F(AcknowledgedBufferedStreamTest, WindowLimitsChunksInFlight) {
+  stream.setAckWindow(2);
+  appendString("a\nb\nc\n");
+
+  ASSERT_EQ(chunks, (std::vector<std::string>{"a\n", "b\n"}));
+  EXPECT_EQ(stream.buffered(), 6u); // held until acknowledged
+  EXPECT_EQ(stream.unsent(), 2u);
+
+  EXPECT_TRUE(stream.acknowledge(1));
+  EXPECT_EQ(stream.buffered(), 4u);
+  stream.flushHeldBytes();
+  ASSERT_EQ(chunks.size(), 3u);
+  EXPECT_EQ(chunks[2], "c\n");
+  EXPECT_EQ(offsets, (std::vector<uint32_t>{0, 2, 4}));
+}
+
+TEST_F(AcknowledgedBufferedStreamTest, RingTrimmedOnlyUpToOldestUnacked) {
+  stream.setAckWindow(2);
+  appendString("a\nb\n");
+
+  EXPECT_TRUE(stream.acknowledge(2));
+  EXPECT_EQ(stream.buffered(), 4u);
+  EXPECT_FALSE(stream.acknowledge(7));
+  EXPECT_TRUE(stream.acknowledge(1));
+  EXPECT_TRUE(stream.empty());
+  EXPECT_EQ(stream.inFlightChunks(), 0u);
+  EXPECT_EQ(stream.nextOffset(), 4u);
+}
+
+TEST_F(AcknowledgedBufferedStreamTest, ResendRepublishesFromOldestUnacked) {
+  stream.setAckWindow(2);
+  appendString("a\nb\n");
+  stream.acknowledge(1);
+
+  stream.resendInFlight();
+  EXPECT_EQ(stream.inFlightChunks(), 0u);
+  EXPECT_FALSE(stream.acknowledge(2)); // the old packet id is gone
+  stream.flushHeldBytes();
+
+  ASSERT_EQ(chunks.size(), 3u);
+  EXPECT_EQ(chunks[2], "b\n");
+  EXPECT_EQ(offsets[2], 2u);
+}
+
+TEST_F(AcknowledgedBufferedStreamTest, OverflowShrinksOldestChunkInFlight) {
+  stream.setAckWindow(1);
+  appendString("0123456789\n");
+  stream.setLineFlush(false);
+  appendString("ABCDEFGH"); // no window: 3 in-flight bytes are dropped
+
+  EXPECT_EQ(stream.buffered(), 16u);
+  EXPECT_EQ(stream.unacknowledged(), 8u);
+  EXPECT_TRUE(stream.acknowledge(1));
+  EXPECT_EQ(stream.buffered(), 8u);
+
+  // Wrapped: one publish per contiguous run
+  stream.flushHeldBytes();
+  EXPECT_TRUE(stream.acknowledge(2));
+  stream.flushHeldBytes();
+  ASSERT_EQ(chunks.size(), 3u);
+  EXPECT_EQ(chunks[1] + chunks[2], "ABCDEFGH");
+  EXPECT_EQ(offsets[1], 11u);
+  EXPECT_EQ(offsets[2], 11u + chunks[1].size());
+}
+
+TEST_F(DiscardingBufferedStreamTest, RetainDiscardsData) {
+  isActive = false;
+  retainString("dropped");
+
+  EXPECT_TRUE(stream.empty());
+  stream.flush();
+  EXPECT_TRUE(chunks.empty());
 }
 
 } // namespace
@@ -0,0 +1,537 @@
+#pragma once
+
+/**
+ * @file console_corpus.hpp
+ * @brief Console text used to size the tty compression.
+ *
+ * Three typical sessions on the bridged port of a Raspberry Pi 4 running
+ * Debian bookworm: kernel boot, systemd start-up ending in a login prompt,
+ * and an interactive shell with a followed journal. Hostnames, addresses
+ * and serials are placeholders.
+ */
+
+namespace jrb::wifi_serial::console_corpus {
+
+inline constexpr const char KERNEL_BOOT[] = R"corpus(
+[    0.000000] Booting Linux on physical CPU 0x0000000000 [0x410fd083]
+[    0.000000] Linux version 6.1.21-v8+ (dom@buildbot) (aarch64-linux-gnu-gcc-8 (Ubuntu/Linaro 8.4.0-3ubuntu1) 8.4.0, GNU ld (GNU Binutils for Ubuntu) 2.34) #1642 SMP PREEMPT Mon Apr  3 17:24:16 BST 2023
+[    0.000000] random: crng init done
+[    0.000000] Machine model: Raspberry Pi 4 Model B Rev 1.4
+[    0.000000] efi: UEFI not found.
+[    0.000000] Reserved memory: created CMA memory pool at 0x000000001ec00000, size 256 MiB
+[    0.000000] OF: reserved mem: initialized node linux,cma, compatible id shared-dma-pool
+[    0.000000] Zone ranges:
+[    0.000000]   DMA      [mem 0x0000000000000000-0x000000003fffffff]
+[    0.000000]   DMA32    [mem 0x0000000040000000-0x00000000ffffffff]
+[    0.000000]   Normal   [mem 0x0000000100000000-0x00000001ffffffff]
+[    0.000000] Movable zone start for each node
+[    0.000000] Early memory node ranges
+[    0.000000]   node   0: [mem 0x0000000000000000-0x000000003b3fffff]
+[    0.000000]   node   0: [mem 0x0000000040000000-0x00000000fbffffff]
+[    0.000000]   node   0: [mem 0x0000000100000000-0x00000001ffffffff]
+[    0.000000] Initmem setup node 0 [mem 0x0000000000000000-0x00000001ffffffff]
+[    0.000000] On node 0, zone DMA32: 19456 pages in unavailable ranges
+[    0.000000] On node 0, zone Normal: 16384 pages in unavailable ranges
+[    0.000000] percpu: Embedded 29 pages/cpu s79656 r8192 d30936 u118784
+[    0.000000] Detected PIPT I-cache on CPU0
+[    0.000000] CPU features: detected: Spectre-v2
+[    0.000000] CPU features: detected: Spectre-v3a
+[    0.000000] CPU features: detected: Spectre-v4
+[    0.000000] CPU features: detected: Spectre-BHB
+[    0.000000] CPU features: kernel page table isolation forced ON by KASLR
+[    0.000000] CPU features: detected: Kernel page table isolation (KPTI)
+[    0.000000] CPU features: detected: ARM erratum 1742098
+[    0.000000] CPU features: detected: ARM errata 1165522, 1319367, or 1530923
+[    0.000000] alternatives: applying boot alternatives
+[    0.000000] Built 1 zonelists, mobility grouping on.  Total pages: 2028848
+[    0.000000] Kernel command line: coherent_pool=1M 8250.nr_uarts=1 snd_bcm2835.enable_headphones=0 bcm2708_fb.fbwidth=0 bcm2708_fb.fbheight=0 bcm2708_fb.fbswap=1 smsc95xx.macaddr=DC:A6:32:00:00:00 vc_mem.mem_base=0x3ec00000 vc_mem.mem_size=0x40000000  console=ttyS0,115200 console=tty1 root=PARTUUID=00000000-02 rootfstype=ext4 fsck.repair=yes rootwait
+[    0.000000] Dentry cache hash table entries: 1048576 (order: 11, 8388608 bytes, linear)
+[    0.000000] Inode-cache hash table entries: 524288 (order: 10, 4194304 bytes, linear)
+[    0.000000] mem auto-init: stack:off, heap alloc:off, heap free:off
+[    0.000000] software IO TLB: area num 4.
+[    0.000000] software IO TLB: mapped [mem 0x0000000037400000-0x000000003b400000] (64MB)
+[    0.000000] Memory: 7711048K/8245248K available (12160K kernel code, 2144K rwdata, 4052K rodata, 4160K init, 1085K bss, 271656K reserved, 262144K cma-reserved)
+[    0.000000] SLUB: HWalign=64, Order=0-3, MinObjects=0, CPUs=4, Nodes=1
+[    0.000000] ftrace: allocating 40130 entries in 157 pages
+[    0.000000] ftrace: allocated 157 pages with 5 groups
+[    0.000000] trace event string verifier disabled
+[    0.000000] rcu: Preemptible hierarchical RCU implementation.
+[    0.000000] rcu: 	RCU event tracing is enabled.
+[    0.000000] rcu: 	RCU restricting CPUs from NR_CPUS=256 to nr_cpu_ids=4.
+[    0.000000] 	Trampoline variant of Tasks RCU enabled.
+[    0.000000] 	Rude variant of Tasks RCU enabled.
+[    0.000000] 	Tracing variant of Tasks RCU enabled.
+[    0.000000] rcu: RCU calculated value of scheduler-enlistment delay is 25 jiffies.
+[    0.000000] rcu: Adjusting geometry for rcu_fanout_leaf=16, nr_cpu_ids=4
+[    0.000000] NR_IRQS: 64, nr_irqs: 64, preallocated irqs: 0
+[    0.000000] Root IRQ handler: gic_handle_irq
+[    0.000000] GIC: Using split EOI/Deactivate mode
+[    0.000000] rcu: srcu_init: Setting srcu_struct sizes based on contention.
+[    0.000000] arch_timer: cp15 timer(s) running at 54.00MHz (phys).
+[    0.000000] clocksource: arch_sys_counter: mask: 0xffffffffffffff max_cycles: 0xc743ce346, max_idle_ns: 440795203123 ns
+[    0.000001] sched_clock: 56 bits at 54MHz, resolution 18ns, wraps every 4398046511102ns
+[    0.000306] Console: colour dummy device 80x25
+[    0.000370] printk: console [tty1] enabled
+[    0.000424] Calibrating delay loop (skipped), value calculated using timer frequency.. 108.00 BogoMIPS (lpj=216000)
+[    0.000448] pid_max: default: 32768 minimum: 301
+[    0.000523] LSM: Security Framework initializing
+[    0.000684] Mount-cache hash table entries: 16384 (order: 5, 131072 bytes, linear)
+[    0.000774] Mountpoint-cache hash table entries: 16384 (order: 5, 131072 bytes, linear)
+[    0.001968] cgroup: Disabling memory control group subsystem
+[    0.003579] cblist_init_generic: Setting adjustable number of callback queues.
+[    0.003607] cblist_init_generic: Setting shift to 2 and lim to 1.
+[    0.003738] cblist_init_generic: Setting shift to 2 and lim to 1.
+[    0.003863] cblist_init_generic: Setting shift to 2 and lim to 1.
+[    0.004070] rcu: Hierarchical SRCU implementation.
+[    0.004085] rcu: 	Max phase no-delay instances is 1000.
+[    0.005181] EFI services will not be available.
+[    0.005580] smp: Bringing up secondary CPUs ...
+[    0.006267] Detected PIPT I-cache on CPU1
+[    0.006408] CPU1: Booted secondary processor 0x0000000001 [0x410fd083]
+[    0.007181] Detected PIPT I-cache on CPU2
+[    0.007298] CPU2: Booted secondary processor 0x0000000002 [0x410fd083]
+[    0.008058] Detected PIPT I-cache on CPU3
+[    0.008175] CPU3: Booted secondary processor 0x0000000003 [0x410fd083]
+[    0.008275] smp: Brought up 1 node, 4 CPUs
+[    0.008309] SMP: Total of 4 processors activated.
+[    0.008327] CPU features: detected: 32-bit EL0 Support
+[    0.008341] CPU features: detected: 32-bit EL1 Support
+[    0.008358] CPU features: detected: CRC32 instructions
+[    0.008484] CPU: All CPU(s) started at EL2
+[    0.008518] alternatives: applying system-wide alternatives
+[    0.010137] devtmpfs: initialized
+[    0.023108] Enabled cp15_barrier support
+[    0.023145] Enabled setend support
+[    0.023329] clocksource: jiffies: mask: 0xffffffff max_cycles: 0xffffffff, max_idle_ns: 7645041785100000 ns
+[    0.023365] futex hash table entries: 1024 (order: 4, 65536 bytes, linear)
+[    0.036153] pinctrl core: initialized pinctrl subsystem
+[    0.037036] DMI not present or invalid.
+[    0.037743] NET: Registered PF_NETLINK/PF_ROUTE protocol family
+[    0.041138] DMA: preallocated 1024 KiB GFP_KERNEL pool for atomic allocations
+[    0.041493] DMA: preallocated 1024 KiB GFP_KERNEL|GFP_DMA pool for atomic allocations
+[    0.042468] DMA: preallocated 1024 KiB GFP_KERNEL|GFP_DMA32 pool for atomic allocations
+[    0.042573] audit: initializing netlink subsys (disabled)
+[    0.042795] audit: type=2000 audit(0.040:1): state=initialized audit_enabled=0 res=1
+[    0.043335] thermal_sys: Registered thermal governor 'step_wise'
+[    0.043438] cpuidle: using governor menu
+[    0.043732] hw-breakpoint: found 6 breakpoint and 4 watchpoint registers.
+[    0.043863] ASID allocator initialised with 32768 entries
+[    0.043990] Serial: AMBA PL011 UART driver
+[    0.054153] bcm2835-mbox fe00b880.mailbox: mailbox enabled
+[    0.068733] raspberrypi-firmware soc:firmware: Attached to firmware from 2023-03-17T10:52:42, variant start
+[    0.072744] raspberrypi-firmware soc:firmware: Firmware hash is 82f3750a65fadae9a38077e3c2e217ad158c8d54
+[    0.116149] KASLR enabled
+[    0.130508] bcm2835-dma fe007000.dma: DMA legacy API manager, dmachans=0x1
+[    0.132612] iommu: Default domain type: Translated
+[    0.132631] iommu: DMA domain TLB invalidation policy: strict mode
+[    0.133008] SCSI subsystem initialized
+[    0.133195] usbcore: registered new interface driver usbfs
+[    0.133256] usbcore: registered new interface driver hub
+[    0.133321] usbcore: registered new device driver usb
+[    0.133597] pps_core: LinuxPPS API ver. 1 registered
+[    0.133610] pps_core: Software ver. 5.3.6 - Copyright 2005-2007 Rodolfo Giometti <giometti@linux.it>
+[    0.133643] PTP clock support registered
+[    0.134583] vgaarb: loaded
+[    0.135078] clocksource: Switched to clocksource arch_sys_counter
+[    0.135686] VFS: Disk quotas dquot_6.6.0
+[    0.135760] VFS: Dquot-cache hash table entries: 512 (order 0, 4096 bytes)
+[    0.135911] FS-Cache: Loaded
+[    0.136057] CacheFiles: Loaded
+[    0.145041] NET: Registered PF_INET protocol family
+[    0.145654] IP idents hash table entries: 131072 (order: 8, 1048576 bytes, linear)
+[    0.150779] tcp_listen_portaddr_hash hash table entries: 4096 (order: 4, 65536 bytes, linear)
+[    0.150831] Table-perturb hash table entries: 65536 (order: 6, 262144 bytes, linear)
+[    0.150858] TCP established hash table entries: 65536 (order: 7, 524288 bytes, linear)
+[    0.151230] TCP bind hash table entries: 65536 (order: 9, 2097152 bytes, linear)
+[    0.153183] TCP: Hash tables configured (established 65536 bind 65536)
+[    0.153479] UDP hash table entries: 4096 (order: 5, 131072 bytes, linear)
+[    0.153571] UDP-Lite hash table entries: 4096 (order: 5, 131072 bytes, linear)
+[    0.153842] NET: Registered PF_UNIX/PF_LOCAL protocol family
+[    0.154438] RPC: Registered named UNIX socket transport module.
+[    0.154452] RPC: Registered udp transport module.
+[    0.154463] RPC: Registered tcp transport module.
+[    0.154473] RPC: Registered tcp NFSv4.1 backchannel transport module.
+[    0.154495] PCI: CLS 0 bytes, default 64
+[    0.156505] hw perfevents: enabled with armv8_cortex_a72 PMU driver, 7 counters available
+[    0.156805] kvm [1]: IPA Size Limit: 44 bits
+[    0.158001] kvm [1]: vgic interrupt IRQ9
+[    0.158177] kvm [1]: Hyp mode initialized successfully
+[    1.310718] Initialise system trusted keyrings
+[    1.311059] workingset: timestamp_bits=46 max_order=21 bucket_order=0
+[    1.317437] zbud: loaded
+[    1.320154] NFS: Registering the id_resolver key type
+[    1.320203] Key type id_resolver registered
+[    1.320215] Key type id_legacy registered
+[    1.320322] nfs4filelayout_init: NFSv4 File Layout Driver Registering...
+[    1.320340] nfs4flexfilelayout_init: NFSv4 Flexfile Layout Driver Registering...
+[    1.321423] Key type asymmetric registered
+[    1.321439] Asymmetric key parser 'x509' registered
+[    1.321596] Block layer SCSI generic (bsg) driver version 0.4 loaded (major 247)
+[    1.321856] io scheduler mq-deadline registered
+[    1.321871] io scheduler kyber registered
+[    1.327553] brcm-pcie fd500000.pcie: host bridge /scb/pcie@7d500000 ranges:
+[    1.327595] brcm-pcie fd500000.pcie:   No bus range found for /scb/pcie@7d500000, using [bus 00-ff]
+[    1.327664] brcm-pcie fd500000.pcie:      MEM 0x0600000000..0x0603ffffff -> 0x00f8000000
+[    1.327734] brcm-pcie fd500000.pcie:   IB MEM 0x0000000000..0x00bfffffff -> 0x0400000000
+[    1.328768] brcm-pcie fd500000.pcie: PCI host bridge to bus 0000:00
+[    1.328789] pci_bus 0000:00: root bus resource [bus 00-ff]
+[    1.328807] pci_bus 0000:00: root bus resource [mem 0x600000000-0x603ffffff] (bus address [0xf8000000-0xfbffffff])
+[    1.328873] pci 0000:00:00.0: [14e4:2711] type 01 class 0x060400
+[    1.329136] pci 0000:00:00.0: PME# supported from D0 D3hot
+[    1.332679] pci 0000:00:00.0: bridge configuration invalid ([bus 00-00]), reconfiguring
+[    1.449220] brcm-pcie fd500000.pcie: link up, 5.0 GT/s PCIe x1 (SSC)
+[    1.449338] pci 0000:01:00.0: [1106:3483] type 00 class 0x0c0330
+[    1.449442] pci 0000:01:00.0: reg 0x10: [mem 0x00000000-0x00000fff 64bit]
+[    1.449795] pci 0000:01:00.0: PME# supported from D0 D3cold
+[    1.453353] pci 0000:00:00.0: BAR 8: assigned [mem 0x600000000-0x6000fffff]
+[    1.453385] pci 0000:01:00.0: BAR 0: assigned [mem 0x600000000-0x600000fff 64bit]
+[    1.453423] pci 0000:00:00.0: PCI bridge to [bus 01]
+[    1.453444] pci 0000:00:00.0:   bridge window [mem 0x600000000-0x6000fffff]
+[    1.453719] pcieport 0000:00:00.0: enabling device (0000 -> 0002)
+[    1.453871] pcieport 0000:00:00.0: PME: Signaling with IRQ 53
+[    1.454242] pcieport 0000:00:00.0: AER: enabled with IRQ 53
+[    1.454549] pci 0000:01:00.0: enabling device (0000 -> 0002)
+[    1.462212] Serial: 8250/16550 driver, 1 ports, IRQ sharing enabled
+[    1.464090] iproc-rng200 fe104000.rng: hwrng registered
+[    1.464398] vc-mem: phys_addr:0x00000000 mem_base=0x3ec00000 mem_size:0x40000000(1024 MiB)
+[    1.465110] gpiomem-bcm2835 fe200000.gpiomem: Initialised: Registers at 0xfe200000
+[    1.474839] brd: module loaded
+[    1.482061] loop: module loaded
+[    1.482740] Loading iSCSI transport class v2.0-870.
+[    1.485396] usbcore: registered new interface driver r8152
+[    1.485447] usbcore: registered new interface driver lan78xx
+[    1.485491] usbcore: registered new interface driver smsc95xx
+[    1.486140] bcmgenet fd580000.ethernet: GENET 5.0 EPHY: 0x0000
+[    1.541263] unimac-mdio unimac-mdio.-19: Broadcom UniMAC MDIO bus
+[    1.542112] xhci_hcd 0000:01:00.0: xHCI Host Controller
+[    1.542147] xhci_hcd 0000:01:00.0: new USB bus registered, assigned bus number 1
+[    1.542825] xhci_hcd 0000:01:00.0: hcc params 0x002841eb hci version 0x100 quirks 0x0b00040000000890
+[    1.543571] xhci_hcd 0000:01:00.0: xHCI Host Controller
+[    1.543594] xhci_hcd 0000:01:00.0: new USB bus registered, assigned bus number 2
+[    1.543620] xhci_hcd 0000:01:00.0: Host supports USB 3.0 SuperSpeed
+[    1.543983] usb usb1: New USB device found, idVendor=1d6b, idProduct=0002, bcdDevice= 6.01
+[    1.544006] usb usb1: New USB device strings: Mfr=3, Product=2, SerialNumber=1
+[    1.544024] usb usb1: Product: xHCI Host Controller
+[    1.544039] usb usb1: Manufacturer: Linux 6.1.21-v8+ xhci-hcd
+[    1.544054] usb usb1: SerialNumber: 0000:01:00.0
+[    1.544671] hub 1-0:1.0: USB hub found
+[    1.544757] hub 1-0:1.0: 1 port detected
+[    1.545562] usb usb2: New USB device found, idVendor=1d6b, idProduct=0003, bcdDevice= 6.01
+[    1.545587] usb usb2: New USB device strings: Mfr=3, Product=2, SerialNumber=1
+[    1.545604] usb usb2: Product: xHCI Host Controller
+[    1.545619] usb usb2: Manufacturer: Linux 6.1.21-v8+ xhci-hcd
+[    1.545634] usb usb2: SerialNumber: 0000:01:00.0
+[    1.546194] hub 2-0:1.0: USB hub found
+[    1.546301] hub 2-0:1.0: 4 ports detected
+[    1.548296] dwc_otg: version 3.00a 10-AUG-2012 (platform bus)
+[    1.548817] usbcore: registered new interface driver uas
+[    1.548906] usbcore: registered new interface driver usb-storage
+[    1.549120] mousedev: PS/2 mouse device common for all mice
+[    1.551895] sdhci: Secure Digital Host Controller Interface driver
+[    1.551911] sdhci: Copyright(c) Pierre Ossman
+[    1.552378] sdhci-pltfm: SDHCI platform and OF driver helper
+[    1.555162] ledtrig-cpu: registered to indicate activity on CPUs
+[    1.555583] hid: raw HID events driver (C) Jiri Kosina
+[    1.555745] usbcore: registered new interface driver usbhid
+[    1.555756] usbhid: USB HID core driver
+[    1.562474] NET: Registered PF_PACKET protocol family
+[    1.562593] Key type dns_resolver registered
+[    1.563619] registered taskstats version 1
+[    1.563807] Loading compiled-in X.509 certificates
+[    1.564563] Key type .fscrypt registered
+[    1.564578] Key type fscrypt-provisioning registered
+[    1.576839] uart-pl011 fe201000.serial: there is not valid maps for state default
+[    1.577212] uart-pl011 fe201000.serial: cts_event_workaround enabled
+[    1.577296] fe201000.serial: ttyAMA0 at MMIO 0xfe201000 (irq = 36, base_baud = 0) is a PL011 rev2
+[    1.580914] bcm2835-aux-uart fe215040.serial: there is not valid maps for state default
+[    1.581413] printk: console [ttyS0] disabled
+[    1.581510] fe215040.serial: ttyS0 at MMIO 0xfe215040 (irq = 37, base_baud = 62500000) is a 16550
+[    2.736154] printk: console [ttyS0] enabled
+[    2.742611] bcm2835-wdt bcm2835-wdt: Broadcom BCM2835 watchdog timer
+[    2.749495] bcm2835-power bcm2835-power: Broadcom BCM2835 power domains driver
+[    2.757657] mmc-bcm2835 fe300000.mmcnr: mmc_debug:0 mmc_debug2:0
+[    2.763793] mmc-bcm2835 fe300000.mmcnr: DMA channel allocated
+[    2.796011] sdhci-iproc fe340000.mmc: SDHCI controller on fe340000.mmc [fe340000.mmc] using ADMA
+[    2.809186] of_cfs_init
+[    2.811814] of_cfs_init: OK
+[    2.815069] Waiting for root device PARTUUID=00000000-02...
+[    2.832129] mmc1: new high speed SDIO card at address 0001
+[    2.895279] mmc0: new ultra high speed DDR50 SDHC card at address aaaa
+[    2.902955] mmcblk0: mmc0:aaaa SC32G 29.7 GiB
+[    2.910793]  mmcblk0: p1 p2
+[    2.913974] mmcblk0: mmc0:aaaa SC32G 29.7 GiB
+[    2.933150] EXT4-fs (mmcblk0p2): mounted filesystem with ordered data mode. Quota mode: none.
+[    2.941703] VFS: Mounted root (ext4 filesystem) readonly on device 179:2.
+[    2.954356] devtmpfs: mounted
+[    2.964144] Freeing unused kernel memory: 4160K
+[    2.968951] Run /sbin/init as init process
+[    2.994101] usb 1-1: new high-speed USB device number 2 using xhci_hcd
+[    3.144867] usb 1-1: New USB device found, idVendor=2109, idProduct=3431, bcdDevice= 4.21
+[    3.153246] usb 1-1: New USB device strings: Mfr=0, Product=1, SerialNumber=0
+[    3.160569] usb 1-1: Product: USB2.0 Hub
+[    3.166198] hub 1-1:1.0: USB hub found
+[    3.170291] hub 1-1:1.0: 4 ports detected
+)corpus";
+
+inline constexpr const char SYSTEMD_BOOT[] = R"corpus(
+Welcome to Debian GNU/Linux 12 (bookworm)!
+
+[  OK  ] Created slice system-getty.slice - Slice /system/getty.
+[  OK  ] Created slice system-modprobe.slice - Slice /system/modprobe.
+[  OK  ] Created slice system-serial\x2dgetty.slice - Slice /system/serial-getty.
+[  OK  ] Created slice system-systemd\x2dfsck.slice - Slice /system/systemd-fsck.
+[  OK  ] Created slice user.slice - User and Session Slice.
+[  OK  ] Started systemd-ask-password-console.path - Dispatch Password Requests to Console Directory Watch.
+[  OK  ] Started systemd-ask-password-wall.path - Forward Password Requests to Wall Directory Watch.
+[  OK  ] Set up automount proc-sys-fs-binfmt_misc.automount - Arbitrary Executable File Formats File System Automount Point.
+[  OK  ] Reached target cryptsetup.target - Local Encrypted Volumes.
+[  OK  ] Reached target integritysetup.target - Local Integrity Protected Volumes.
+[  OK  ] Reached target paths.target - Path Units.
+[  OK  ] Reached target slices.target - Slice Units.
+[  OK  ] Reached target swap.target - Swaps.
+[  OK  ] Reached target veritysetup.target - Local Verity Protected Volumes.
+[  OK  ] Listening on systemd-fsckd.socket - fsck to fsckd communication Socket.
+[  OK  ] Listening on systemd-initctl.socket - initctl Compatibility Named Pipe.
+[  OK  ] Listening on systemd-journald-audit.socket - Journal Audit Socket.
+[  OK  ] Listening on systemd-journald-dev-log.socket - Journal Socket (/dev/log).
+[  OK  ] Listening on systemd-journald.socket - Journal Socket.
+[  OK  ] Listening on systemd-networkd.socket - Network Service Netlink Socket.
+[  OK  ] Listening on systemd-udevd-control.socket - udev Control Socket.
+[  OK  ] Listening on systemd-udevd-kernel.socket - udev Kernel Socket.
+         Mounting dev-hugepages.mount - Huge Pages File System...
+         Mounting dev-mqueue.mount - POSIX Message Queue File System...
+         Mounting sys-kernel-debug.mount - Kernel Debug File System...
+         Mounting sys-kernel-tracing.mount - Kernel Trace File System...
+         Starting fake-hwclock.service - Restore / save the current clock...
+         Starting keyboard-setup.service - Set the console keyboard layout...
+         Starting kmod-static-nodes.service - Create List of Static Device Nodes...
+         Starting modprobe@configfs.service - Load Kernel Module configfs...
+         Starting modprobe@dm_mod.service - Load Kernel Module dm_mod...
+         Starting modprobe@drm.service - Load Kernel Module drm...
+         Starting modprobe@efi_pstore.service - Load Kernel Module efi_pstore...
+         Starting modprobe@fuse.service - Load Kernel Module fuse...
+         Starting modprobe@loop.service - Load Kernel Module loop...
+         Starting systemd-fsck-root.service - File System Check on Root Device...
+         Starting systemd-journald.service - Journal Service...
+         Starting systemd-modules-load.service - Load Kernel Modules...
+         Starting systemd-udev-trigger.service - Coldplug All udev Devices...
+[  OK  ] Mounted dev-hugepages.mount - Huge Pages File System.
+[  OK  ] Mounted dev-mqueue.mount - POSIX Message Queue File System.
+[  OK  ] Mounted sys-kernel-debug.mount - Kernel Debug File System.
+[  OK  ] Mounted sys-kernel-tracing.mount - Kernel Trace File System.
+[  OK  ] Finished fake-hwclock.service - Restore / save the current clock.
+[  OK  ] Finished kmod-static-nodes.service - Create List of Static Device Nodes.
+[  OK  ] Finished modprobe@configfs.service - Load Kernel Module configfs.
+[  OK  ] Finished modprobe@dm_mod.service - Load Kernel Module dm_mod.
+[  OK  ] Finished modprobe@drm.service - Load Kernel Module drm.
+[  OK  ] Finished modprobe@efi_pstore.service - Load Kernel Module efi_pstore.
+[  OK  ] Finished modprobe@fuse.service - Load Kernel Module fuse.
+[  OK  ] Finished modprobe@loop.service - Load Kernel Module loop.
+[  OK  ] Finished systemd-fsck-root.service - File System Check on Root Device.
+[  OK  ] Finished systemd-modules-load.service - Load Kernel Modules.
+         Mounting sys-fs-fuse-connections.mount - FUSE Control File System...
+         Mounting sys-kernel-config.mount - Kernel Configuration File System...
+         Starting systemd-remount-fs.service - Remount Root and Kernel File Systems...
+         Starting systemd-sysctl.service - Apply Kernel Variables...
+[  OK  ] Mounted sys-fs-fuse-connections.mount - FUSE Control File System.
+[  OK  ] Mounted sys-kernel-config.mount - Kernel Configuration File System.
+[  OK  ] Finished systemd-remount-fs.service - Remount Root and Kernel File Systems.
+[  OK  ] Finished systemd-sysctl.service - Apply Kernel Variables.
+         Starting systemd-random-seed.service - Load/Save Random Seed...
+         Starting systemd-sysusers.service - Create System Users...
+[  OK  ] Started systemd-journald.service - Journal Service.
+         Starting systemd-journal-flush.service - Flush Journal to Persistent Storage...
+[  OK  ] Finished keyboard-setup.service - Set the console keyboard layout.
+[  OK  ] Finished systemd-random-seed.service - Load/Save Random Seed.
+[  OK  ] Finished systemd-sysusers.service - Create System Users.
+         Starting systemd-tmpfiles-setup-dev.service - Create Static Device Nodes in /dev...
+[  OK  ] Finished systemd-journal-flush.service - Flush Journal to Persistent Storage.
+[  OK  ] Finished systemd-tmpfiles-setup-dev.service - Create Static Device Nodes in /dev.
+[  OK  ] Reached target local-fs-pre.target - Preparation for Local File Systems.
+         Starting systemd-udevd.service - Rule-based Manager for Device Events and Files...
+[  OK  ] Finished systemd-udev-trigger.service - Coldplug All udev Devices.
+         Starting ifupdown-pre.service - Helper to synchronize boot up for ifupdown...
+[  OK  ] Started systemd-udevd.service - Rule-based Manager for Device Events and Files.
+[  OK  ] Found device dev-ttyS0.device - /dev/ttyS0.
+[  OK  ] Found device dev-disk-by\x2dpartuuid-00000000\x2d01.device - /dev/disk/by-partuuid/00000000-01.
+         Starting systemd-fsck@dev-disk-by\x2dpartuuid-00000000\x2d01.service - File System Check on /dev/disk/by-partuuid/00000000-01...
+[  OK  ] Finished ifupdown-pre.service - Helper to synchronize boot up for ifupdown.
+[  OK  ] Finished systemd-fsck@dev-disk-by\x2dpartuuid-00000000\x2d01.service - File System Check on /dev/disk/by-partuuid/00000000-01.
+         Mounting boot-firmware.mount - /boot/firmware...
+[  OK  ] Mounted boot-firmware.mount - /boot/firmware.
+[  OK  ] Reached target local-fs.target - Local File Systems.
+         Starting apparmor.service - Load AppArmor profiles...
+         Starting console-setup.service - Set console font and keymap...
+         Starting systemd-binfmt.service - Set Up Additional Binary Formats...
+         Starting systemd-tmpfiles-setup.service - Create System Files and Directories...
+[  OK  ] Finished console-setup.service - Set console font and keymap.
+         Mounting proc-sys-fs-binfmt_misc.mount - Arbitrary Executable File Formats File System...
+[  OK  ] Mounted proc-sys-fs-binfmt_misc.mount - Arbitrary Executable File Formats File System.
+[  OK  ] Finished systemd-binfmt.service - Set Up Additional Binary Formats.
+[  OK  ] Finished apparmor.service - Load AppArmor profiles.
+[  OK  ] Finished systemd-tmpfiles-setup.service - Create System Files and Directories.
+         Starting systemd-timesyncd.service - Network Time Synchronization...
+         Starting systemd-update-utmp.service - Record System Boot/Shutdown in UTMP...
+[  OK  ] Finished systemd-update-utmp.service - Record System Boot/Shutdown in UTMP.
+[  OK  ] Started systemd-timesyncd.service - Network Time Synchronization.
+[  OK  ] Reached target sysinit.target - System Initialization.
+[  OK  ] Started apt-daily.timer - Daily apt download activities.
+[  OK  ] Started apt-daily-upgrade.timer - Daily apt upgrade and clean activities.
+[  OK  ] Started dpkg-db-backup.timer - Daily dpkg database backup timer.
+[  OK  ] Started e2scrub_all.timer - Periodic ext4 Online Metadata Check for All Filesystems.
+[  OK  ] Started fstrim.timer - Discard unused blocks once a week.
+[  OK  ] Started logrotate.timer - Daily rotation of log files.
+[  OK  ] Started man-db.timer - Daily man-db regeneration.
+[  OK  ] Started systemd-tmpfiles-clean.timer - Daily Cleanup of Temporary Directories.
+[  OK  ] Reached target time-set.target - System Time Set.
+[  OK  ] Reached target timers.target - Timer Units.
+[  OK  ] Listening on avahi-daemon.socket - Avahi mDNS/DNS-SD Stack Activation Socket.
+[  OK  ] Listening on dbus.socket - D-Bus System Message Bus Socket.
+[  OK  ] Listening on triggerhappy.socket - triggerhappy.socket.
+[  OK  ] Reached target sockets.target - Socket Units.
+[  OK  ] Reached target basic.target - Basic System.
+         Starting avahi-daemon.service - Avahi mDNS/DNS-SD Stack...
+         Starting bluetooth.service - Bluetooth service...
+[  OK  ] Started cron.service - Regular background program processing daemon.
+         Starting dbus.service - D-Bus System Message Bus...
+         Starting dphys-swapfile.service - dphys-swapfile - set up, mount/unmount, and delete a swap file...
+         Starting e2scrub_reap.service - Remove Stale Online ext4 Metadata Check Snapshots...
+         Starting rpi-eeprom-update.service - Check for Raspberry Pi EEPROM updates...
+         Starting systemd-logind.service - User Login Management...
+         Starting triggerhappy.service - triggerhappy global hotkey daemon...
+[  OK  ] Started triggerhappy.service - triggerhappy global hotkey daemon.
+[  OK  ] Started dbus.service - D-Bus System Message Bus.
+[  OK  ] Started avahi-daemon.service - Avahi mDNS/DNS-SD Stack.
+[  OK  ] Finished dphys-swapfile.service - dphys-swapfile - set up, mount/unmount, and delete a swap file.
+[  OK  ] Finished e2scrub_reap.service - Remove Stale Online ext4 Metadata Check Snapshots.
+[  OK  ] Started systemd-logind.service - User Login Management.
+[  OK  ] Started bluetooth.service - Bluetooth service.
+[  OK  ] Reached target bluetooth.target - Bluetooth Support.
+         Starting NetworkManager.service - Network Manager...
+[  OK  ] Finished rpi-eeprom-update.service - Check for Raspberry Pi EEPROM updates.
+[  OK  ] Started NetworkManager.service - Network Manager.
+[  OK  ] Reached target network.target - Network.
+         Starting NetworkManager-wait-online.service - Network Manager Wait Online...
+         Starting ssh.service - OpenBSD Secure Shell server...
+         Starting systemd-user-sessions.service - Permit User Sessions...
+[  OK  ] Finished systemd-user-sessions.service - Permit User Sessions.
+[  OK  ] Started getty@tty1.service - Getty on tty1.
+[  OK  ] Started serial-getty@ttyS0.service - Serial Getty on ttyS0.
+[  OK  ] Reached target getty.target - Login Prompts.
+[  OK  ] Started ssh.service - OpenBSD Secure Shell server.
+         Starting wpa_supplicant.service - WPA supplicant...
+[  OK  ] Started wpa_supplicant.service - WPA supplicant.
+[  OK  ] Finished NetworkManager-wait-online.service - Network Manager Wait Online.
+[  OK  ] Reached target network-online.target - Network is Online.
+[  OK  ] Reached target multi-user.target - Multi-User System.
+         Starting systemd-update-utmp-runlevel.service - Record Runlevel Change in UTMP...
+[  OK  ] Finished systemd-update-utmp-runlevel.service - Record Runlevel Change in UTMP.
+
+Debian GNU/Linux 12 node01 ttyS0
+
+node01 login:
+)corpus";
+
+inline constexpr const char SHELL_SESSION[] = R"corpus(
+pi@node01:~$ uptime
+ 14:02:11 up 12 days,  3:41,  1 user,  load average: 0.41, 0.37, 0.33
+pi@node01:~$ df -h
+Filesystem      Size  Used Avail Use% Mounted on
+udev            3.7G     0  3.7G   0% /dev
+tmpfs           782M  1.5M  781M   1% /run
+/dev/mmcblk0p2   29G  9.8G   18G  36% /
+tmpfs           3.9G     0  3.9G   0% /dev/shm
+tmpfs           5.0M   16K  5.0M   1% /run/lock
+/dev/mmcblk0p1  510M   63M  448M  13% /boot/firmware
+tmpfs           782M     0  782M   0% /run/user/1000
+pi@node01:~$ systemctl --failed
+  UNIT               LOAD   ACTIVE SUB    DESCRIPTION
+* k3s-agent.service  loaded failed failed Lightweight Kubernetes
+
+LOAD   = Reflects whether the unit definition was properly loaded.
+ACTIVE = The high-level unit activation state, i.e. generalization of SUB.
+SUB    = The low-level unit activation state, values depend on unit type.
+1 loaded units listed.
+pi@node01:~$ sudo journalctl -u k3s-agent -n 20 --no-pager
+Jun 11 13:58:02 node01 k3s[30211]: time="2024-06-11T13:58:02+01:00" level=info msg="Starting k3s agent v1.29.4+k3s1 (94e29e2e)"
+Jun 11 13:58:02 node01 k3s[30211]: time="2024-06-11T13:58:02+01:00" level=info msg="Adding server to load balancer k3s-agent-load-balancer: 10.0.0.10:6443"
+Jun 11 13:58:02 node01 k3s[30211]: time="2024-06-11T13:58:02+01:00" level=info msg="Running load balancer k3s-agent-load-balancer 127.0.0.1:6444 -> [10.0.0.10:6443] [default: 10.0.0.10:6443]"
+Jun 11 13:58:04 node01 k3s[30211]: time="2024-06-11T13:58:04+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": read tcp 127.0.0.1:51238->127.0.0.1:6444: read: connection reset by peer"
+Jun 11 13:58:06 node01 k3s[30211]: time="2024-06-11T13:58:06+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": read tcp 127.0.0.1:51252->127.0.0.1:6444: read: connection reset by peer"
+Jun 11 13:58:08 node01 k3s[30211]: time="2024-06-11T13:58:08+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": read tcp 127.0.0.1:51266->127.0.0.1:6444: read: connection reset by peer"
+Jun 11 13:58:10 node01 k3s[30211]: time="2024-06-11T13:58:10+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": dial tcp 127.0.0.1:6444: connect: connection refused"
+Jun 11 13:58:12 node01 k3s[30211]: time="2024-06-11T13:58:12+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": dial tcp 127.0.0.1:6444: connect: connection refused"
+Jun 11 13:58:14 node01 k3s[30211]: time="2024-06-11T13:58:14+01:00" level=info msg="Stopped tunnel to 10.0.0.10:6443"
+Jun 11 13:58:14 node01 systemd[1]: k3s-agent.service: Main process exited, code=exited, status=1/FAILURE
+Jun 11 13:58:14 node01 systemd[1]: k3s-agent.service: Failed with result 'exit-code'.
+Jun 11 13:58:14 node01 systemd[1]: Failed to start k3s-agent.service - Lightweight Kubernetes.
+Jun 11 13:58:19 node01 systemd[1]: k3s-agent.service: Scheduled restart job, restart counter is at 212.
+Jun 11 13:58:19 node01 systemd[1]: Stopped k3s-agent.service - Lightweight Kubernetes.
+Jun 11 13:58:19 node01 systemd[1]: Starting k3s-agent.service - Lightweight Kubernetes...
+Jun 11 13:58:19 node01 sh[30262]: + /usr/bin/systemctl is-enabled --quiet nm-cloud-setup.service
+Jun 11 13:58:19 node01 sh[30263]: Failed to get unit file state for nm-cloud-setup.service: No such file or directory
+Jun 11 13:58:20 node01 k3s[30266]: time="2024-06-11T13:58:20+01:00" level=info msg="Starting k3s agent v1.29.4+k3s1 (94e29e2e)"
+Jun 11 13:58:20 node01 k3s[30266]: time="2024-06-11T13:58:20+01:00" level=info msg="Adding server to load balancer k3s-agent-load-balancer: 10.0.0.10:6443"
+Jun 11 13:58:22 node01 k3s[30266]: time="2024-06-11T13:58:22+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": read tcp 127.0.0.1:51290->127.0.0.1:6444: read: connection reset by peer"
+pi@node01:~$ ping -c 4 10.0.0.10
+PING 10.0.0.10 (10.0.0.10) 56(84) bytes of data.
+From 10.0.0.21 icmp_seq=1 Destination Host Unreachable
+From 10.0.0.21 icmp_seq=2 Destination Host Unreachable
+From 10.0.0.21 icmp_seq=3 Destination Host Unreachable
+From 10.0.0.21 icmp_seq=4 Destination Host Unreachable
+
+--- 10.0.0.10 ping statistics ---
+4 packets transmitted, 0 received, +4 errors, 100% packet loss, time 3055ms
+pipe 4
+pi@node01:~$ ip -br addr
+lo               UNKNOWN        127.0.0.1/8 ::1/128
+eth0             UP             10.0.0.21/24 fe80::dea6:32ff:fe00:0/64
+wlan0            DOWN
+pi@node01:~$ ip route
+default via 10.0.0.1 dev eth0 proto dhcp src 10.0.0.21 metric 100
+10.0.0.0/24 dev eth0 proto kernel scope link src 10.0.0.21 metric 100
+pi@node01:~$ sudo journalctl -f
+Jun 11 14:03:01 node01 CRON[31020]: pam_unix(cron:session): session opened for user root(uid=0) by (uid=0)
+Jun 11 14:03:01 node01 CRON[31021]: (root) CMD (/usr/local/bin/node-exporter-textfile.sh > /dev/null 2>&1)
+Jun 11 14:03:01 node01 CRON[31020]: pam_unix(cron:session): session closed for user root
+Jun 11 14:03:07 node01 k3s[30988]: time="2024-06-11T14:03:07+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": dial tcp 127.0.0.1:6444: connect: connection refused"
+Jun 11 14:03:09 node01 k3s[30988]: time="2024-06-11T14:03:09+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": dial tcp 127.0.0.1:6444: connect: connection refused"
+Jun 11 14:03:11 node01 k3s[30988]: time="2024-06-11T14:03:11+01:00" level=info msg="Stopped tunnel to 10.0.0.10:6443"
+Jun 11 14:03:11 node01 systemd[1]: k3s-agent.service: Main process exited, code=exited, status=1/FAILURE
+Jun 11 14:03:11 node01 systemd[1]: k3s-agent.service: Failed with result 'exit-code'.
+Jun 11 14:03:11 node01 systemd[1]: Failed to start k3s-agent.service - Lightweight Kubernetes.
+Jun 11 14:03:16 node01 systemd[1]: k3s-agent.service: Scheduled restart job, restart counter is at 218.
+Jun 11 14:03:16 node01 systemd[1]: Stopped k3s-agent.service - Lightweight Kubernetes.
+Jun 11 14:03:16 node01 systemd[1]: Starting k3s-agent.service - Lightweight Kubernetes...
+Jun 11 14:03:17 node01 k3s[31044]: time="2024-06-11T14:03:17+01:00" level=info msg="Starting k3s agent v1.29.4+k3s1 (94e29e2e)"
+Jun 11 14:03:17 node01 k3s[31044]: time="2024-06-11T14:03:17+01:00" level=info msg="Adding server to load balancer k3s-agent-load-balancer: 10.0.0.10:6443"
+Jun 11 14:03:17 node01 k3s[31044]: time="2024-06-11T14:03:17+01:00" level=info msg="Running load balancer k3s-agent-load-balancer 127.0.0.1:6444 -> [10.0.0.10:6443] [default: 10.0.0.10:6443]"
+Jun 11 14:03:19 node01 k3s[31044]: time="2024-06-11T14:03:19+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": read tcp 127.0.0.1:52010->127.0.0.1:6444: read: connection reset by peer"
+Jun 11 14:03:21 node01 k3s[31044]: time="2024-06-11T14:03:21+01:00" level=error msg="failed to get CA certs: Get \"https://127.0.0.1:6444/cacerts\": read tcp 127.0.0.1:52024->127.0.0.1:6444: read: connection reset by peer"
+Jun 11 14:03:23 node01 kernel: bcmgenet fd580000.ethernet eth0: Link is Down
+Jun 11 14:03:25 node01 kernel: bcmgenet fd580000.ethernet eth0: Link is Up - 1Gbps/Full - flow control rx/tx
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4411] device (eth0): carrier: link connected
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4425] device (eth0): state change: unavailable -> disconnected (reason 'carrier-changed', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4463] policy: auto-activating connection 'Wired connection 1' (7ab1a1b8-0b8b-3c41-8d6e-1f1c6c7d4b21)
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4479] device (eth0): Activation: starting connection 'Wired connection 1' (7ab1a1b8-0b8b-3c41-8d6e-1f1c6c7d4b21)
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4483] device (eth0): state change: disconnected -> prepare (reason 'none', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4497] device (eth0): state change: prepare -> config (reason 'none', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4521] device (eth0): state change: config -> ip-config (reason 'none', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.4539] dhcp4 (eth0): activation: beginning transaction (timeout in 45 seconds)
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.5010] dhcp4 (eth0): state changed new lease, address=10.0.0.21
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.5047] device (eth0): state change: ip-config -> ip-check (reason 'none', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.5102] device (eth0): state change: ip-check -> secondaries (reason 'none', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.5108] device (eth0): state change: secondaries -> activated (reason 'none', sys-iface-state: 'managed')
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.5131] manager: NetworkManager state is now CONNECTED_SITE
+Jun 11 14:03:25 node01 NetworkManager[612]: <info>  [1718110985.5174] device (eth0): Activation: successful, device activated.
+Jun 11 14:03:26 node01 NetworkManager[612]: <info>  [1718110986.0812] manager: NetworkManager state is now CONNECTED_GLOBAL
+Jun 11 14:03:27 node01 k3s[31044]: time="2024-06-11T14:03:27+01:00" level=info msg="Connecting to proxy" url="wss://10.0.0.10:6443/v1-k3s/connect"
+Jun 11 14:03:27 node01 k3s[31044]: time="2024-06-11T14:03:27+01:00" level=info msg="Remotedialer connected to proxy" url="wss://10.0.0.10:6443/v1-k3s/connect"
+Jun 11 14:03:28 node01 k3s[31044]: time="2024-06-11T14:03:28+01:00" level=info msg="Server 10.0.0.10:6443@RECOVERING->ACTIVE from successful health check"
+Jun 11 14:03:28 node01 systemd[1]: Started k3s-agent.service - Lightweight Kubernetes.
+^C
+pi@node01:~$ exit
+logout
+)corpus";
+
+} // namespace jrb::wifi_serial::console_corpus
@@ -1,20 +1,163 @@
-// Placeholder test file
-// TODO: Implement once Arduino dependencies are abstracted
+#include "domain/messaging/mqtt_flush_policy.cpp"
+#include "domain/messaging/tty_frame.h"
+#include "infrastructure/mqttt/pub_sub_client_test.h"
 
 #include <gtest/gtest.h>
+#include <string>
 
 namespace jrb::wifi_serial {
 namespace {
 
+using Policy = internal::MqttFlushPolicy<PubSubClientTest>;
+
 class MqttFlushPolicyTest : public ::testing::Test {
 protected:
-  void SetUp() override {}
-  void TearDown() override {}
+  PubSubClientTest client;
+  types::string topic{"dev/ttyS1/tx"};
+  bool connected{true};
+  bool framed{false};
+  bool compressed{false};
+  bool json{false};
+  Policy policy{client, topic, connected, framed, compressed, json, 1};
+
+  void SetUp() override { client.setConnected(true); }
+
+  void flush(const std::string &data, uint32_t offset) {
+    policy.flush(types::span<const uint8_t>(
+                     reinterpret_cast<const uint8_t *>(data.data()),
+                     data.size()),
+                 offset, "tty1");
+  }
+
+  tty_frame::Header lastHeader() {
+    const auto &payload = client.getPublishedPayloads().back();
+    tty_frame::Header header;
+    EXPECT_TRUE(
+        tty_frame::decodeHeader(payload.data(), payload.size(), header));
+    return header;
+  }
 };
 
-TEST_F(MqttFlushPolicyTest, PlaceholderTest) {
-  // Add the tests here once dependencies are resolved
-  EXPECT_TRUE(true);
+TEST_F(MqttFlushPolicyTest, UnframedPublishesRawChunk) {
+  flush("hello\n", 42);
+  ASSERT_EQ(client.getPublishedPayloads().size(), 1u);
+  const auto &payload = client.getPublishedPayloads().back();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "hello\n");
+}
+
+TEST_F(MqttFlushPolicyTest, FramedPrefixesPortAndOffset) {
+  framed = true;
+  flush("hello\n", 42);
+
+  const auto &payload = client.getPublishedPayloads().back();
+  ASSERT_EQ(payload.size(), tty_frame::HEADER_SIZE + 6);
+  EXPECT_EQ(std::string(payload.begin() + tty_frame::HEADER_SIZE,
+                        payload.end()),
+            "hello\n");
+  const tty_frame::Header header = lastHeader();
+  EXPECT_EQ(header.port, 1);
+  EXPECT_EQ(header.offset, 42u);
+}
+
+TEST_F(MqttFlushPolicyTest, PublishPropertiesCarryExpiryAndMetadata) {
+  flush("hello\n", 42);
+  EXPECT_EQ(client.getLastMessageExpiry(),
+            static_cast<uint32_t>(MQTT_TTY_MESSAGE_EXPIRY_SEC));
+  const std::vector<std::pair<std::string, std::string>> metadata = {
+      {"port", "1"}, {"seq", "42"}};
+  EXPECT_EQ(client.getLastUserProperties(), metadata);
+
+  // Framed headers already carry port and offset
+  framed = true;
+  flush("more\n", 48);
+  EXPECT_EQ(client.getLastMessageExpiry(),
+            static_cast<uint32_t>(MQTT_TTY_MESSAGE_EXPIRY_SEC));
+  EXPECT_TRUE(client.getLastUserProperties().empty());
+}
+
+TEST_F(MqttFlushPolicyTest, StreamStartFlagUntilFirstDelivery) {
+  framed = true;
+  client.setConnected(false); // publish fails
+  flush("a", 0);
+  client.setConnected(true);
+
+  flush("b", 1);
+  EXPECT_EQ(lastHeader().flags, tty_frame::FLAG_STREAM_START);
+  flush("c", 2);
+  EXPECT_EQ(lastHeader().flags, 0);
+}
+
+TEST_F(MqttFlushPolicyTest, CompressedFramesRestartHistoryAfterLoss) {
+  framed = true;
+  compressed = true;
+  const std::string line = "kernel: eth0: Link is Up - 1Gbps/Full\n";
+  flush(line, 0);
+  // Nothing to reference yet, so this one goes out raw
+  EXPECT_EQ(lastHeader().flags,
+            tty_frame::FLAG_STREAM_START | tty_frame::FLAG_HISTORY_RESET);
+  flush(line, line.size());
+  EXPECT_EQ(lastHeader().flags, tty_frame::FLAG_COMPRESSED);
+  EXPECT_LT(client.getPublishedPayloads().back().size(),
+            tty_frame::HEADER_SIZE + line.size() / 4);
+
+  // Bytes dropped upstream: the receiver can't follow the old history
+  flush(line, 1000);
+  EXPECT_TRUE(lastHeader().flags & tty_frame::FLAG_HISTORY_RESET);
+
+  client.setConnected(false); // publish fails
+  flush(line, 1000 + line.size());
+  client.setConnected(true);
+  flush(line, 1000 + 2 * line.size());
+  EXPECT_TRUE(lastHeader().flags & tty_frame::FLAG_HISTORY_RESET);
+}
+
+TEST_F(MqttFlushPolicyTest, JsonPublishesStampedLineRecords) {
+  json = true;
+  framed = true; // JSON output replaces framing
+  policy.stampLine(40, 1000);
+  policy.stampLine(46, 1500);
+  flush("hello\nworld\r\npart", 40);
+
+  ASSERT_EQ(client.getPublishedPayloads().size(), 1u);
+  const auto &payload = client.getPublishedPayloads().back();
+  EXPECT_EQ(std::string(payload.begin(), payload.end()),
+            "[{\"ts\":1000,\"port\":1,\"seq\":40,\"line\":\"hello\"},"
+            "{\"ts\":1500,\"port\":1,\"seq\":46,\"line\":\"world\"},"
+            "{\"ts\":1500,\"port\":1,\"seq\":53,\"line\":\"part\","
+            "\"partial\":true}]");
+  // The rest of a partial line keeps the line's arrival time
+  flush("ial\n", 57);
+  const auto &rest = client.getPublishedPayloads().back();
+  EXPECT_EQ(std::string(rest.begin(), rest.end()),
+            "[{\"ts\":1500,\"port\":1,\"seq\":57,\"line\":\"ial\"}]");
+  EXPECT_TRUE(client.getLastUserProperties().empty());
+}
+
+TEST_F(MqttFlushPolicyTest, JsonSplitsLargeChunksIntoBatches) {
+  json = true;
+  // Every quote doubles when escaped
+  std::string data(MQTT_BUFFER_SIZE - 1, '"');
+  data += '\n';
+  const uint16_t packetId = policy.publishAcked(
+      types::span<const uint8_t>(
+          reinterpret_cast<const uint8_t *>(data.data()), data.size()),
+      0);
+
+  const auto &payloads = client.getPublishedPayloads();
+  ASSERT_EQ(payloads.size(), 3u);
+  EXPECT_EQ(packetId, client.getLastPacketId());
+  size_t quotes = 0;
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    const std::string text(payloads[i].begin(), payloads[i].end());
+    EXPECT_LE(text.size(), static_cast<size_t>(MQTT_JSON_BATCH_SIZE));
+    EXPECT_EQ(text.back(), ']');
+    EXPECT_EQ(text.find("\"partial\":true") != std::string::npos,
+              i + 1 < payloads.size());
+    for (size_t at = text.find("\\\""); at != std::string::npos;
+         at = text.find("\\\"", at + 2))
+      quotes++;
+  }
+  EXPECT_EQ(quotes, MQTT_BUFFER_SIZE - 1u);
 }
 
 } // namespace
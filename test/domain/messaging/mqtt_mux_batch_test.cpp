@@ -0,0 +1,147 @@
+#include "domain/messaging/mqtt_mux_batch.cpp"
+#include "domain/messaging/tty_frame.h"
+#include "domain/messaging/tty_mux.h"
+#include "infrastructure/mqttt/pub_sub_client_test.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using MuxPolicy = internal::MqttFlushPolicy<PubSubClientTest>;
+using MuxBatch = internal::MqttMuxBatch<PubSubClientTest>;
+
+struct MuxFrame {
+  uint8_t port;
+  tty_frame::Header header;
+  std::string payload;
+};
+
+class MqttMuxBatchTest : public ::testing::Test {
+protected:
+  PubSubClientTest client;
+  types::string muxTopic{"dev/mux/tx"};
+  types::string tty0Topic{"dev/ttyS0/tx"};
+  types::string tty1Topic{"dev/ttyS1/tx"};
+  bool connected{true};
+  bool framed{false};
+  bool compressed{false};
+  bool json{false};
+  bool multiplexed{true};
+  MuxBatch batch{client, muxTopic, multiplexed};
+  MuxPolicy tty0{client, tty0Topic, connected, framed, compressed, json, 0,
+                 &batch};
+  MuxPolicy tty1{client, tty1Topic, connected, framed, compressed, json, 1,
+                 &batch};
+
+  void SetUp() override { client.setConnected(true); }
+
+  void flush(MuxPolicy &policy, const std::string &data, uint32_t offset) {
+    policy.flush(types::span<const uint8_t>(
+                     reinterpret_cast<const uint8_t *>(data.data()),
+                     data.size()),
+                 offset, "tty");
+  }
+
+  std::vector<MuxFrame> framesOf(const std::vector<uint8_t> &payload) {
+    std::vector<MuxFrame> frames;
+    tty_mux::Reader reader(payload.data(), payload.size());
+    tty_mux::Section section;
+    while (reader.next(section)) {
+      MuxFrame frame;
+      frame.port = section.port;
+      EXPECT_TRUE(
+          tty_frame::decodeHeader(section.data, section.size, frame.header));
+      frame.payload.assign(section.data + tty_frame::HEADER_SIZE,
+                           section.data + section.size);
+      frames.push_back(frame);
+    }
+    EXPECT_FALSE(reader.malformed());
+    return frames;
+  }
+};
+
+TEST_F(MqttMuxBatchTest, BothPortsLeaveInOnePublish) {
+  flush(tty0, "boot\n", 0);
+  flush(tty1, "login: ", 40);
+  EXPECT_TRUE(client.getPublishedTopics().empty());
+  EXPECT_EQ(batch.sections(), 2u);
+
+  ASSERT_TRUE(batch.publish());
+  ASSERT_EQ(client.getPublishedTopics().size(), 1u);
+  EXPECT_EQ(client.getPublishedTopics().back(), "dev/mux/tx");
+  EXPECT_EQ(client.getLastMessageExpiry(),
+            static_cast<uint32_t>(MQTT_TTY_MESSAGE_EXPIRY_SEC));
+  const auto frames = framesOf(client.getPublishedPayloads().back());
+  ASSERT_EQ(frames.size(), 2u);
+  EXPECT_EQ(frames[0].port, 0);
+  EXPECT_EQ(frames[0].header.port, 0);
+  EXPECT_EQ(frames[0].header.flags, tty_frame::FLAG_STREAM_START);
+  EXPECT_EQ(frames[0].payload, "boot\n");
+  EXPECT_EQ(frames[1].port, 1);
+  EXPECT_EQ(frames[1].header.offset, 40u);
+  EXPECT_EQ(frames[1].payload, "login: ");
+  EXPECT_TRUE(batch.empty());
+  EXPECT_TRUE(batch.publish()); // nothing left to send
+  EXPECT_EQ(client.getPublishedTopics().size(), 1u);
+}
+
+TEST_F(MqttMuxBatchTest, FullBatchPublishesBeforeTakingMore) {
+  const std::string chunk(MQTT_BUFFER_SIZE, 'x');
+  flush(tty0, chunk, 0);
+  flush(tty1, chunk, 0);
+  // Two uncompressed chunks exceed MQTT_MUX_BATCH_SIZE
+  ASSERT_EQ(client.getPublishedTopics().size(), 1u);
+  EXPECT_EQ(framesOf(client.getPublishedPayloads().back()).size(), 1u);
+  EXPECT_EQ(batch.sections(), 1u);
+
+  // Disabled, the ports publish on their own topics again
+  multiplexed = false;
+  flush(tty0, "direct\n", MQTT_BUFFER_SIZE);
+  EXPECT_EQ(client.getPublishedTopics().back(), "dev/ttyS0/tx");
+}
+
+TEST_F(MqttMuxBatchTest, LostPublishRestartsCompressionOfItsPorts) {
+  compressed = true;
+  const std::string line = "kernel: eth0: Link is Up - 1Gbps/Full\n";
+  flush(tty0, line, 0);
+  flush(tty1, line, 0);
+  ASSERT_TRUE(batch.publish());
+  flush(tty0, line, line.size());
+  client.setConnected(false);
+  EXPECT_FALSE(batch.publish());
+  client.setConnected(true);
+
+  flush(tty0, line, 2 * line.size());
+  flush(tty1, line, line.size());
+  ASSERT_TRUE(batch.publish());
+  const auto frames = framesOf(client.getPublishedPayloads().back());
+  ASSERT_EQ(frames.size(), 2u);
+  // Port 0's receiver lacks the lost frame; port 1 had nothing in it
+  EXPECT_TRUE(frames[0].header.flags & tty_frame::FLAG_HISTORY_RESET);
+  EXPECT_EQ(frames[1].header.flags, tty_frame::FLAG_COMPRESSED);
+}
+
+TEST_F(MqttMuxBatchTest, AcknowledgedChunksPublishAloneAfterTheBatch) {
+  flush(tty0, "queued\n", 0);
+  const std::string data = "acked\n";
+  const uint16_t packetId = tty1.publishAcked(
+      types::span<const uint8_t>(reinterpret_cast<const uint8_t *>(data.data()),
+                                 data.size()),
+      7);
+  EXPECT_NE(packetId, 0);
+  EXPECT_EQ(packetId, client.getLastPacketId());
+  ASSERT_EQ(client.getPublishedPayloads().size(), 2u);
+  EXPECT_EQ(framesOf(client.getPublishedPayloads()[0])[0].payload,
+            "queued\n");
+  const auto frames = framesOf(client.getPublishedPayloads()[1]);
+  ASSERT_EQ(frames.size(), 1u);
+  EXPECT_EQ(frames[0].port, 1);
+  EXPECT_EQ(frames[0].header.offset, 7u);
+  EXPECT_TRUE(batch.empty());
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
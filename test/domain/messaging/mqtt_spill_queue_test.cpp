@@ -0,0 +1,202 @@
+#include "domain/messaging/mqtt_spill_queue.cpp"
+#include "infrastructure/storage/file_system_test.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+class MqttSpillQueueTest : public ::testing::Test {
+protected:
+  MqttSpillQueue queue;
+
+  void SetUp() override {
+    FileSystemTest::reset();
+    ASSERT_TRUE(queue.begin());
+  }
+
+  void spill(uint8_t port, uint32_t offset, const std::string &text) {
+    queue.append(port, offset,
+                 types::span<const uint8_t>(
+                     reinterpret_cast<const uint8_t *>(text.data()),
+                     text.size()));
+  }
+
+  // Pops everything committed, in order
+  std::vector<std::pair<MqttSpillQueue::Record, std::string>> drainAll() {
+    std::vector<std::pair<MqttSpillQueue::Record, std::string>> records;
+    uint8_t payload[MQTT_SPILL_RECORD_SIZE];
+    MqttSpillQueue::Record record;
+    while (queue.peek(record, payload)) {
+      records.emplace_back(
+          record, std::string(reinterpret_cast<char *>(payload),
+                              record.length));
+      queue.pop();
+    }
+    return records;
+  }
+};
+
+TEST_F(MqttSpillQueueTest, BytesStayInRamUntilCommitted) {
+  spill(0, 0, "boot\n");
+
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(queue.size(), 5u);
+  EXPECT_EQ(FileSystemTest::totalBytes(), 0u);
+  EXPECT_TRUE(drainAll().empty());
+
+  queue.commit();
+  EXPECT_EQ(FileSystemTest::totalBytes(), 8u + 5u);
+}
+
+TEST_F(MqttSpillQueueTest, RecordsReplayInOrderWithPortAndOffset) {
+  spill(0, 100, "abc");
+  spill(0, 103, "def"); // contiguous: same record
+  spill(1, 7, "tty1");  // other port: new record
+  spill(1, 20, "gap");  // offset jump: new record
+  queue.commit();
+
+  auto records = drainAll();
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0].first.port, 0);
+  EXPECT_EQ(records[0].first.offset, 100u);
+  EXPECT_EQ(records[0].second, "abcdef");
+  EXPECT_EQ(records[1].first.port, 1);
+  EXPECT_EQ(records[1].first.offset, 7u);
+  EXPECT_EQ(records[2].first.offset, 20u);
+  EXPECT_EQ(records[2].second, "gap");
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MqttSpillQueueTest, FullRecordIsCommittedAutomatically) {
+  spill(0, 0, std::string(MQTT_SPILL_RECORD_SIZE + 10, 'x'));
+
+  auto records = drainAll();
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].first.length, MQTT_SPILL_RECORD_SIZE);
+  EXPECT_EQ(queue.size(), 10u); // the rest is still collecting
+}
+
+TEST_F(MqttSpillQueueTest, LineStampsTravelWithTheirRecord) {
+  queue.stampLine(0, 50, 1000);
+  spill(0, 50, "boot\n");
+  queue.stampLine(0, 55, 2500);
+  spill(0, 55, "ready\n");
+  spill(1, 0, "plain"); // no stamps: the old record format
+  queue.commit();
+  EXPECT_EQ(FileSystemTest::totalBytes(),
+            (8u + 11u + 1u + 2u * 6u) + (8u + 5u));
+
+  auto records = drainAll();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].second, "boot\nready\n");
+  ASSERT_EQ(records[0].first.stampCount, 2);
+  EXPECT_EQ(records[0].first.stamps[0].offset, 50u);
+  EXPECT_EQ(records[0].first.stamps[0].millis, 1000u);
+  EXPECT_EQ(records[0].first.stamps[1].offset, 55u);
+  EXPECT_EQ(records[0].first.stamps[1].millis, 2500u);
+  EXPECT_EQ(records[1].second, "plain");
+  EXPECT_EQ(records[1].first.stampCount, 0);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MqttSpillQueueTest, FullStampsStartANewRecord) {
+  for (uint32_t i = 0; i <= MQTT_SPILL_RECORD_STAMPS; ++i) {
+    queue.stampLine(0, i * 2, 100 + i);
+    spill(0, i * 2, "x\n");
+  }
+  queue.commit();
+
+  auto records = drainAll();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].first.stampCount, MQTT_SPILL_RECORD_STAMPS);
+  EXPECT_EQ(records[0].first.length, MQTT_SPILL_RECORD_STAMPS * 2);
+  ASSERT_EQ(records[1].first.stampCount, 1);
+  EXPECT_EQ(records[1].first.offset, MQTT_SPILL_RECORD_STAMPS * 2u);
+  EXPECT_EQ(records[1].first.stamps[0].offset, MQTT_SPILL_RECORD_STAMPS * 2u);
+  EXPECT_EQ(records[1].first.stamps[0].millis,
+            100u + MQTT_SPILL_RECORD_STAMPS);
+}
+
+TEST_F(MqttSpillQueueTest, PeekWithoutPopRepeatsTheRecord) {
+  spill(0, 0, "once");
+  queue.commit();
+
+  uint8_t payload[MQTT_SPILL_RECORD_SIZE];
+  MqttSpillQueue::Record first, second;
+  ASSERT_TRUE(queue.peek(first, payload));
+  ASSERT_TRUE(queue.peek(second, payload));
+  EXPECT_EQ(first.offset, second.offset);
+  EXPECT_EQ(queue.size(), 4u);
+}
+
+TEST_F(MqttSpillQueueTest, OldestSegmentDroppedWhenQueueIsFull) {
+  // Far more than MQTT_SPILL_MAX_SEGMENTS segments' worth
+  const size_t total = MQTT_SPILL_SEGMENT_SIZE * (MQTT_SPILL_MAX_SEGMENTS + 4);
+  for (uint32_t offset = 0; offset < total; offset += MQTT_SPILL_RECORD_SIZE)
+    spill(0, offset, std::string(MQTT_SPILL_RECORD_SIZE, 'a'));
+
+  EXPECT_LE(FileSystemTest::fileCount(), size_t{MQTT_SPILL_MAX_SEGMENTS});
+  EXPECT_GT(queue.dropped(), 0u);
+  EXPECT_EQ(queue.size() + queue.dropped(), total);
+
+  // What survives is the newest output, still contiguous
+  auto records = drainAll();
+  ASSERT_FALSE(records.empty());
+  EXPECT_EQ(records.front().first.offset, queue.dropped());
+  EXPECT_EQ(records.back().first.offset + records.back().first.length, total);
+  EXPECT_EQ(FileSystemTest::fileCount(), 0u); // replayed segments removed
+}
+
+TEST_F(MqttSpillQueueTest, FullPartitionDropsOldestToMakeRoom) {
+  FileSystemTest::setCapacity(MQTT_SPILL_SEGMENT_SIZE + 1024);
+  const size_t total = MQTT_SPILL_SEGMENT_SIZE * 3;
+  for (uint32_t offset = 0; offset < total; offset += MQTT_SPILL_RECORD_SIZE)
+    spill(0, offset, std::string(MQTT_SPILL_RECORD_SIZE, 'b'));
+
+  EXPECT_LE(FileSystemTest::totalBytes(), MQTT_SPILL_SEGMENT_SIZE + 1024u);
+  EXPECT_EQ(queue.size() + queue.dropped(), total);
+  auto records = drainAll();
+  ASSERT_FALSE(records.empty());
+  EXPECT_EQ(records.back().first.offset + records.back().first.length, total);
+}
+
+TEST_F(MqttSpillQueueTest, CorruptSegmentIsSkipped) {
+  spill(0, 0, "good");
+  queue.commit();
+  FileSystemTest fs;
+  const uint8_t garbage[] = {0x00, 0x01, 0x02};
+  fs.append("/spill/00000000", garbage, sizeof(garbage));
+  spill(0, 4, "lost");
+  queue.commit();
+
+  // Records before the damage survive, the rest of the segment is dropped
+  auto records = drainAll();
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].second, "good");
+  EXPECT_EQ(queue.dropped(), 4u);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MqttSpillQueueTest, BeginDiscardsPreviousBoot) {
+  spill(0, 0, "old boot");
+  queue.commit();
+  ASSERT_GT(FileSystemTest::fileCount(), 0u);
+
+  MqttSpillQueue rebooted;
+  ASSERT_TRUE(rebooted.begin());
+  EXPECT_TRUE(rebooted.empty());
+  EXPECT_EQ(FileSystemTest::fileCount(), 0u);
+}
+
+TEST_F(MqttSpillQueueTest, UnmountedFileSystemDisablesQueue) {
+  FileSystemTest::setMounted(false);
+  MqttSpillQueue unmounted;
+  EXPECT_FALSE(unmounted.begin());
+  EXPECT_FALSE(unmounted.available());
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,132 @@
+// Routing cost of inbound MQTT topics with 2, 16 and 64 routes.
+//
+// Each table holds per-device exact filters plus, from 16 routes on, one
+// wildcard filter for every eight routes (fleet groups). Lookups hit the
+// last exact route, the last wildcard route, or nothing; the last two are
+// the worst cases since every wildcard filter gets tried.
+//
+// "linear" is the old mqttCallback approach generalised to N topics: string
+// compares one route after another, wildcards matched char by char.
+//
+// Timings are native host numbers; the ESP32-C3 at 160 MHz is roughly an
+// order of magnitude slower.
+#include "domain/messaging/mqtt_topic_router.hpp"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using RouterClock = std::chrono::steady_clock;
+constexpr auto ROUTER_MIN_TIMING = std::chrono::milliseconds(20);
+
+void ignorePayload(void *, const char *, const types::span<const uint8_t> &) {}
+
+// MQTT filter match, one char at a time
+bool naiveMatch(const std::string &filter, const char *topic) {
+  size_t f = 0;
+  const char *t = topic;
+  while (f < filter.size()) {
+    if (filter[f] == '#')
+      return true;
+    if (filter[f] == '+') {
+      while (*t && *t != '/')
+        ++t;
+      ++f;
+      continue;
+    }
+    if (*t != filter[f]) {
+      // "a/#" also matches "a"
+      return *t == '\0' && filter.compare(f, 2, "/#") == 0;
+    }
+    ++f;
+    ++t;
+  }
+  return *t == '\0';
+}
+
+int linearMatch(const std::vector<std::string> &filters, const char *topic) {
+  for (size_t i = 0; i < filters.size(); ++i) {
+    if (filters[i] == topic)
+      return static_cast<int>(i);
+  }
+  for (size_t i = 0; i < filters.size(); ++i) {
+    if (filters[i].find_first_of("+#") != std::string::npos &&
+        naiveMatch(filters[i], topic))
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+template <typename Fn> double nsPerLookup(Fn &&lookup) {
+  size_t rounds = 0;
+  volatile int sink = 0;
+  for (int i = 0; i < 1000; ++i) // warm up caches and branch predictors
+    sink = sink + lookup();
+  const auto start = RouterClock::now();
+  do {
+    for (int i = 0; i < 1000; ++i)
+      sink = sink + lookup();
+    rounds += 1000;
+  } while (RouterClock::now() - start < ROUTER_MIN_TIMING);
+  return std::chrono::duration<double, std::nano>(RouterClock::now() - start)
+             .count() /
+         rounds;
+}
+
+void benchmarkRoutes(size_t routeCount) {
+  MqttTopicRouter<64> router;
+  std::vector<std::string> filters;
+  for (size_t i = 0; i < routeCount; ++i) {
+    const bool wildcard = routeCount >= 16 && i % 8 == 7;
+    filters.push_back(
+        wildcard ? "wifi_serial/+/group" + std::to_string(i) + "/rx"
+                 : "wifi_serial/dev" + std::to_string(i) + "/ttyS" +
+                       std::to_string(i % 2) + "/rx");
+  }
+  for (const auto &filter : filters)
+    ASSERT_TRUE(router.add(filter.c_str(), ignorePayload));
+
+  std::string exactHit, wildcardHit;
+  for (size_t i = 0; i < routeCount; ++i) {
+    if (filters[i].find('+') == std::string::npos)
+      exactHit = filters[i];
+    else
+      wildcardHit = "wifi_serial/all/group" + std::to_string(i) + "/rx";
+  }
+  const std::string miss = "wifi_serial/other/ttyS1/rx";
+
+  struct Lookup {
+    const char *name;
+    const std::string *topic;
+  };
+  std::vector<Lookup> lookups = {{"exact", &exactHit}, {"miss", &miss}};
+  if (!wildcardHit.empty())
+    lookups.insert(lookups.begin() + 1, {"wildcard", &wildcardHit});
+
+  for (const auto &lookup : lookups) {
+    const char *topic = lookup.topic->c_str();
+    // Same answer as the reference before timing anything
+    ASSERT_EQ(router.match(topic), linearMatch(filters, topic))
+        << lookup.name << " " << routeCount;
+    const double routed = nsPerLookup([&] { return router.match(topic); });
+    const double linear =
+        nsPerLookup([&] { return linearMatch(filters, topic); });
+    std::printf("[ ROUTER   ] %2zu routes  %-8s  router %7.1f ns  "
+                "linear %7.1f ns\n",
+                routeCount, lookup.name, routed, linear);
+  }
+}
+
+TEST(MqttTopicRouterBenchmark, TwoRoutes) { benchmarkRoutes(2); }
+
+TEST(MqttTopicRouterBenchmark, SixteenRoutes) { benchmarkRoutes(16); }
+
+TEST(MqttTopicRouterBenchmark, SixtyFourRoutes) { benchmarkRoutes(64); }
+
+} // namespace
+} // namespace jrb::wifi_serial
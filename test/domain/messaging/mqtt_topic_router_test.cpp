@@ -0,0 +1,119 @@
+#include "domain/messaging/mqtt_topic_router.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+struct RoutedMessage {
+  std::string route;
+  std::string topic;
+  std::string payload;
+};
+
+std::vector<RoutedMessage> routedMessages;
+
+void recordRoute(void *context, const char *topic,
+                 const types::span<const uint8_t> &payload) {
+  routedMessages.push_back(
+      {static_cast<const char *>(context), topic,
+       std::string(reinterpret_cast<const char *>(payload.data()),
+                   payload.size())});
+}
+
+class MqttTopicRouterTest : public ::testing::Test {
+protected:
+  MqttTopicRouter<8> router;
+
+  void SetUp() override { routedMessages.clear(); }
+
+  bool add(const char *filter) {
+    return router.add(filter, recordRoute, const_cast<char *>(filter));
+  }
+
+  // Filter of the route that handles topic, "" if none
+  std::string routeOf(const char *topic) {
+    const int i = router.match(topic);
+    return i < 0 ? "" : router.filter(static_cast<size_t>(i));
+  }
+};
+
+TEST_F(MqttTopicRouterTest, ExactTopicDispatchesToItsHandler) {
+  ASSERT_TRUE(add("wifi_serial/dev/ttyS0/rx"));
+  ASSERT_TRUE(add("wifi_serial/dev/ttyS1/rx"));
+
+  const uint8_t payload[] = {'l', 's', '\n'};
+  EXPECT_TRUE(router.dispatch("wifi_serial/dev/ttyS1/rx",
+                              types::span<const uint8_t>(payload, 3)));
+
+  ASSERT_EQ(routedMessages.size(), 1u);
+  EXPECT_EQ(routedMessages[0].route, "wifi_serial/dev/ttyS1/rx");
+  EXPECT_EQ(routedMessages[0].payload, "ls\n");
+  EXPECT_FALSE(router.dispatch("wifi_serial/dev/ttyS2/rx", {}));
+}
+
+TEST_F(MqttTopicRouterTest, SingleLevelWildcardMatchesExactlyOneLevel) {
+  ASSERT_TRUE(add("wifi_serial/+/ttyS1/rx"));
+
+  EXPECT_EQ(routeOf("wifi_serial/all/ttyS1/rx"), "wifi_serial/+/ttyS1/rx");
+  EXPECT_EQ(routeOf("wifi_serial//ttyS1/rx"), "wifi_serial/+/ttyS1/rx");
+  EXPECT_EQ(routeOf("wifi_serial/a/b/ttyS1/rx"), "");
+  EXPECT_EQ(routeOf("wifi_serial/all/ttyS1"), "");
+  EXPECT_EQ(routeOf("wifi_serial/all/ttyS0/rx"), "");
+}
+
+TEST_F(MqttTopicRouterTest, MultiLevelWildcardMatchesParentAndChildren) {
+  ASSERT_TRUE(add("wifi_serial/dev/control/#"));
+
+  EXPECT_NE(routeOf("wifi_serial/dev/control"), "");
+  EXPECT_NE(routeOf("wifi_serial/dev/control/reboot"), "");
+  EXPECT_NE(routeOf("wifi_serial/dev/control/a/b/c/d/e/f/g/h/i"), "");
+  EXPECT_EQ(routeOf("wifi_serial/dev/controller"), "");
+}
+
+TEST_F(MqttTopicRouterTest, ExactRouteWinsOverEarlierWildcard) {
+  ASSERT_TRUE(add("wifi_serial/#"));
+  ASSERT_TRUE(add("wifi_serial/dev/ttyS1/rx"));
+  ASSERT_TRUE(add("wifi_serial/+/ttyS1/rx"));
+
+  EXPECT_EQ(routeOf("wifi_serial/dev/ttyS1/rx"), "wifi_serial/dev/ttyS1/rx");
+  // Otherwise registration order decides between wildcards
+  EXPECT_EQ(routeOf("wifi_serial/all/ttyS1/rx"), "wifi_serial/#");
+}
+
+TEST_F(MqttTopicRouterTest, FirstLevelWildcardsSkipSystemTopics) {
+  ASSERT_TRUE(add("#"));
+  ASSERT_TRUE(add("$SYS/#"));
+
+  EXPECT_EQ(routeOf("$SYS/broker/uptime"), "$SYS/#");
+  EXPECT_EQ(routeOf("anything/else"), "#");
+}
+
+TEST_F(MqttTopicRouterTest, MalformedFiltersRejected) {
+  EXPECT_FALSE(add(""));
+  EXPECT_FALSE(add("a/#/b"));
+  EXPECT_FALSE(add("a/b#"));
+  EXPECT_FALSE(add("a/+b/c"));
+  EXPECT_FALSE(add("1/2/3/4/5/6/7/8/9")); // more than MAX_LEVELS levels
+  EXPECT_EQ(router.size(), 0u);
+}
+
+TEST_F(MqttTopicRouterTest, DuplicateAndOverflowRejected) {
+  ASSERT_TRUE(add("a"));
+  EXPECT_FALSE(add("a"));
+
+  const char *filters[] = {"b", "c", "d", "e", "f", "g", "h"};
+  for (const char *filter : filters)
+    ASSERT_TRUE(add(filter));
+  EXPECT_FALSE(add("i"));
+  for (const char *filter : filters)
+    EXPECT_EQ(routeOf(filter), filter);
+
+  router.clear();
+  EXPECT_EQ(routeOf("a"), "");
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,113 @@
+#include "domain/messaging/mqtt_upload_receiver.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+std::vector<uint8_t> uploadChunk(uint16_t id, uint32_t offset,
+                                 const std::string &data, bool final = false) {
+  std::vector<uint8_t> chunk = {
+      static_cast<uint8_t>(id >> 8),      static_cast<uint8_t>(id),
+      static_cast<uint8_t>(offset >> 24), static_cast<uint8_t>(offset >> 16),
+      static_cast<uint8_t>(offset >> 8),  static_cast<uint8_t>(offset),
+      final ? MqttUploadReceiver::FLAG_FINAL : uint8_t{0}};
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  return chunk;
+}
+
+class MqttUploadReceiverTest : public ::testing::Test {
+protected:
+  MqttUploadReceiver receiver;
+  std::string written;
+  bool accepting = true;
+
+  MqttUploadReceiver::Ack send(uint16_t id, uint32_t offset,
+                               const std::string &data, bool final = false) {
+    const auto chunk = uploadChunk(id, offset, data, final);
+    return receiver.receive(
+        types::span<const uint8_t>(chunk.data(), chunk.size()),
+        [this](const types::span<const uint8_t> &bytes) {
+          if (!accepting)
+            return false;
+          written.append(reinterpret_cast<const char *>(bytes.data()),
+                         bytes.size());
+          return true;
+        });
+  }
+};
+
+TEST_F(MqttUploadReceiverTest, ChunksReassembledInOrder) {
+  EXPECT_EQ(send(7, 0, "echo ").status, MqttUploadReceiver::Status::Ok);
+  EXPECT_TRUE(receiver.inProgress());
+  const auto ack = send(7, 5, "hi\n", true);
+
+  EXPECT_EQ(ack.status, MqttUploadReceiver::Status::Done);
+  EXPECT_EQ(ack.transferId, 7);
+  EXPECT_EQ(ack.offset, 8u);
+  EXPECT_EQ(written, "echo hi\n");
+  EXPECT_FALSE(receiver.inProgress());
+}
+
+TEST_F(MqttUploadReceiverTest, RetransmittedBytesWrittenOnce) {
+  send(1, 0, "abcd");
+  // Resent with a different split: only "ef" is new
+  const auto ack = send(1, 2, "cdef");
+  EXPECT_EQ(ack.status, MqttUploadReceiver::Status::Ok);
+  EXPECT_EQ(ack.offset, 6u);
+  EXPECT_EQ(send(1, 0, "ab").offset, 6u);
+  EXPECT_EQ(written, "abcdef");
+
+  send(1, 6, "", true);
+  // A lost Done ack is answered again, nothing rewritten
+  EXPECT_EQ(send(1, 2, "cdef", true).status, MqttUploadReceiver::Status::Done);
+  EXPECT_EQ(written, "abcdef");
+}
+
+TEST_F(MqttUploadReceiverTest, GapAndBusyReportOffsetToResendFrom) {
+  send(2, 0, "1234");
+  auto ack = send(2, 8, "9");
+  EXPECT_EQ(ack.status, MqttUploadReceiver::Status::Gap);
+  EXPECT_EQ(ack.offset, 4u);
+
+  accepting = false;
+  ack = send(2, 4, "5678");
+  EXPECT_EQ(ack.status, MqttUploadReceiver::Status::Busy);
+  EXPECT_EQ(ack.offset, 4u);
+
+  accepting = true;
+  EXPECT_EQ(send(2, 4, "5678").offset, 8u);
+  EXPECT_EQ(written, "12345678");
+}
+
+TEST_F(MqttUploadReceiverTest, UnknownTransferAndMalformedChunksRejected) {
+  EXPECT_EQ(send(3, 10, "late").status, MqttUploadReceiver::Status::Unknown);
+
+  send(4, 0, "new");
+  const auto stale = send(3, 3, "old");
+  EXPECT_EQ(stale.status, MqttUploadReceiver::Status::Unknown);
+  EXPECT_EQ(stale.offset, 0u);
+
+  const uint8_t shortChunk[] = {0, 4, 0};
+  EXPECT_EQ(receiver
+                .receive(types::span<const uint8_t>(shortChunk, 3),
+                         [](const types::span<const uint8_t> &) { return true; })
+                .status,
+            MqttUploadReceiver::Status::Malformed);
+  EXPECT_EQ(send(4, 3, std::string(MQTT_UPLOAD_CHUNK_SIZE + 1, 'x')).status,
+            MqttUploadReceiver::Status::Malformed);
+  EXPECT_EQ(written, "new");
+}
+
+TEST_F(MqttUploadReceiverTest, AckFormattedAsJson) {
+  const MqttUploadReceiver::Ack ack{9, 960, MqttUploadReceiver::Status::Busy};
+  char out[96];
+  const size_t length = MqttUploadReceiver::formatAck(ack, 64, out, sizeof(out));
+  EXPECT_EQ(std::string(out, length),
+            "{\"id\":9,\"offset\":960,\"status\":\"busy\",\"window\":64}");
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,70 @@
+#include "domain/messaging/publish_budget.hpp"
+
+#include <gtest/gtest.h>
+
+namespace jrb::wifi_serial {
+namespace {
+
+// 20 per second, burst 40: Bulk keeps 20 in reserve, Info 4
+using TestBudget = PublishBudget<20, 40>;
+using Priority = TestBudget::Priority;
+
+int takeAll(TestBudget &budget, Priority priority, unsigned long nowMs) {
+  int taken = 0;
+  while (budget.take(priority, nowMs))
+    taken++;
+  return taken;
+}
+
+TEST(PublishBudgetTest, EachClassStopsAtItsReserve) {
+  TestBudget budget(1000);
+
+  EXPECT_EQ(takeAll(budget, Priority::Bulk, 1000), 20);
+  EXPECT_TRUE(budget.available(Priority::Info, 1000));
+  EXPECT_EQ(takeAll(budget, Priority::Info, 1000), 16);
+  EXPECT_TRUE(budget.available(Priority::Control, 1000));
+  EXPECT_EQ(takeAll(budget, Priority::Control, 1000), 4);
+  EXPECT_EQ(budget.tokens(1000), 0u);
+}
+
+TEST(PublishBudgetTest, RefillsAtRateUpToBurst) {
+  TestBudget budget(0);
+  takeAll(budget, Priority::Control, 0);
+
+  EXPECT_FALSE(budget.available(Priority::Control, 49));
+  EXPECT_TRUE(budget.take(Priority::Control, 50)); // 1 token per 50 ms
+  EXPECT_FALSE(budget.take(Priority::Control, 60));
+  // Fractions carry over between refills
+  EXPECT_FALSE(budget.take(Priority::Control, 99));
+  EXPECT_TRUE(budget.take(Priority::Control, 100));
+
+  EXPECT_EQ(budget.tokens(60000), 40u);
+}
+
+TEST(PublishBudgetTest, BulkFloodLeavesInfoAndControlTheirShare) {
+  TestBudget budget(0);
+  int bulk = 0;
+  for (unsigned long now = 0; now < 1000; now += 5)
+    bulk += takeAll(budget, Priority::Bulk, now);
+
+  // The burst above the reserve, then the refill rate
+  EXPECT_EQ(bulk, 20 + 19);
+  EXPECT_TRUE(budget.take(Priority::Info, 1000));
+  EXPECT_TRUE(budget.take(Priority::Control, 1000));
+}
+
+TEST(PublishBudgetTest, ResetRefillsAndKeepsCounters) {
+  TestBudget budget(0);
+  takeAll(budget, Priority::Control, 0);
+  budget.countDeferred();
+  budget.countDeferred();
+  budget.countDropped();
+
+  budget.reset(10);
+  EXPECT_EQ(budget.tokens(10), 40u);
+  EXPECT_EQ(budget.deferred(), 2u);
+  EXPECT_EQ(budget.dropped(), 1u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
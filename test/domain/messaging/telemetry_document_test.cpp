@@ -0,0 +1,79 @@
+#include "domain/messaging/telemetry_document.hpp"
+
+#include <gtest/gtest.h>
+
+namespace jrb::wifi_serial {
+namespace {
+
+class TelemetryDocumentTest : public ::testing::Test {
+protected:
+  TelemetryDocument<4> document;
+};
+
+TEST_F(TelemetryDocumentTest, FullDocumentHoldsEveryField) {
+  document.setString("deviceName", "esp32c3");
+  document.setNumber("rssi", -61);
+  document.setBool("debugEnabled", false);
+
+  EXPECT_EQ(document.full(),
+            "{\"deviceName\":\"esp32c3\",\"rssi\":-61,\"debugEnabled\":false}");
+  EXPECT_TRUE(document.changed());
+  document.markPublished();
+  EXPECT_FALSE(document.changed());
+}
+
+TEST_F(TelemetryDocumentTest, DeltaHoldsOnlyChangedFields) {
+  document.setString("ssid", "homelab");
+  document.setNumber("freeHeap", 120000);
+  document.full();
+  document.markPublished();
+
+  document.setString("ssid", "homelab"); // same value: not dirty
+  EXPECT_FALSE(document.changed());
+  document.setNumber("freeHeap", 118000);
+  ASSERT_TRUE(document.changed());
+  EXPECT_EQ(document.delta(), "{\"freeHeap\":118000}");
+  document.markPublished();
+
+  EXPECT_FALSE(document.changed());
+  EXPECT_EQ(document.delta(), "{}");
+  EXPECT_EQ(document.full(), "{\"ssid\":\"homelab\",\"freeHeap\":118000}");
+}
+
+TEST_F(TelemetryDocumentTest, FailedDeltaIsSentAgain) {
+  document.setNumber("rssi", -61);
+  document.markPublished();
+
+  document.setNumber("rssi", -70);
+  EXPECT_EQ(document.delta(), "{\"rssi\":-70}");
+  // Not published: the next delta still carries the field
+  document.setNumber("freeHeap", 118000);
+  EXPECT_TRUE(document.changed());
+  EXPECT_EQ(document.delta(), "{\"rssi\":-70,\"freeHeap\":118000}");
+  document.markPublished();
+  EXPECT_EQ(document.delta(), "{}");
+}
+
+TEST_F(TelemetryDocumentTest, FullDocumentCachedUntilAFieldChanges) {
+  document.setNumber("uptimeSec", 10);
+  const char *first = document.full().c_str();
+  document.setNumber("uptimeSec", 10);
+  EXPECT_EQ(document.full().c_str(), first);
+
+  document.setNumber("uptimeSec", 15);
+  EXPECT_EQ(document.full(), "{\"uptimeSec\":15}");
+}
+
+TEST_F(TelemetryDocumentTest, StringsEscapedAndFieldLimitEnforced) {
+  document.setString("ssid", "my \"lab\"\\net");
+  EXPECT_EQ(document.full(), "{\"ssid\":\"my \\\"lab\\\"\\\\net\"}");
+
+  EXPECT_TRUE(document.setNumber("a", 1));
+  EXPECT_TRUE(document.setNumber("b", 2));
+  EXPECT_TRUE(document.setNumber("c", 3));
+  EXPECT_FALSE(document.setNumber("d", 4));
+  EXPECT_EQ(document.size(), 4u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
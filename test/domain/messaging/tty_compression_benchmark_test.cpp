@@ -0,0 +1,160 @@
+// Compression ratio and CPU cost of framed tty payloads on console text.
+//
+// Each corpus goes through MqttFlushPolicy in MQTT_FRAME_MIN_BYTES chunks,
+// the size framed mode batches to, and the published frames are decoded
+// with TtyFrameDecoder. "wire" counts every published byte, headers
+// included, against the same frames sent uncompressed. "isolated" is what
+// compressing each frame on its own (no shared history) would give.
+//
+// Timings are native host numbers; the ESP32-C3 at 160 MHz is roughly an
+// order of magnitude slower per byte.
+//
+// MqttFlushPolicy template definitions come from mqtt_flush_policy_test.cpp.
+#include "console_corpus.hpp"
+#include "domain/messaging/mqtt_flush_policy.h"
+#include "domain/messaging/tty_compression.h"
+#include "domain/messaging/tty_frame_decoder.h"
+#include "infrastructure/mqttt/pub_sub_client_test.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t CHUNK = MQTT_FRAME_MIN_BYTES;
+constexpr auto MIN_TIMING = std::chrono::milliseconds(20);
+
+struct CompressionReport {
+  double wireRatio{0};
+  double isolatedRatio{0};
+  double compressUsPerKb{0};
+  double decompressUsPerKb{0};
+  bool roundTrip{false};
+};
+
+const uint8_t *corpusBytes(const char *text) {
+  return reinterpret_cast<const uint8_t *>(text);
+}
+
+CompressionReport measure(const char *corpus) {
+  const size_t length = std::strlen(corpus);
+  CompressionReport report;
+
+  // Firmware path: frames exactly as published
+  PubSubClientTest client;
+  client.setConnected(true);
+  types::string topic{"dev/ttyS1/tx"};
+  bool connected = true, framed = true, compressed = true, json = false;
+  internal::MqttFlushPolicy<PubSubClientTest> policy{
+      client, topic, connected, framed, compressed, json, 1};
+  for (size_t at = 0; at < length; at += CHUNK) {
+    const size_t n = std::min(CHUNK, length - at);
+    policy.flush(types::span<const uint8_t>(corpusBytes(corpus) + at, n),
+                 static_cast<uint32_t>(at), "tty1");
+  }
+
+  size_t wire = 0;
+  std::string decoded;
+  TtyFrameDecoder decoder;
+  decoder.onData([&decoded](uint8_t, const uint8_t *data, size_t n) {
+    decoded.append(reinterpret_cast<const char *>(data), n);
+  });
+  for (const auto &payload : client.getPublishedPayloads()) {
+    wire += payload.size();
+    decoder.feed(payload.data(), payload.size());
+  }
+  const size_t frames = client.getPublishedPayloads().size();
+  const size_t plainWire = length + frames * tty_frame::HEADER_SIZE;
+  report.wireRatio = static_cast<double>(wire) / plainWire;
+  report.roundTrip = decoded == corpus && decoder.stats().gaps == 0;
+
+  // Same frames without shared history
+  std::vector<uint8_t> packed(tty_compression::maxCompressedSize(CHUNK));
+  size_t isolated = 0;
+  for (size_t at = 0; at < length; at += CHUNK) {
+    const size_t n = std::min(CHUNK, length - at);
+    tty_compression::Compressor fresh;
+    isolated += tty_frame::HEADER_SIZE +
+                std::min(n, fresh.compress(corpusBytes(corpus) + at, n,
+                                           packed.data()));
+  }
+  report.isolatedRatio = static_cast<double>(isolated) / plainWire;
+
+  // CPU cost: whole corpus, repeated until the timing is meaningful
+  std::vector<std::vector<uint8_t>> chunks;
+  size_t rounds = 0;
+  tty_compression::Compressor compressor;
+  const auto compressStart = Clock::now();
+  do {
+    compressor.reset();
+    chunks.clear();
+    for (size_t at = 0; at < length; at += CHUNK) {
+      const size_t n = std::min(CHUNK, length - at);
+      chunks.emplace_back(packed.size());
+      chunks.back().resize(
+          compressor.compress(corpusBytes(corpus) + at, n, chunks.back().data()));
+    }
+    rounds++;
+  } while (Clock::now() - compressStart < MIN_TIMING);
+  const double kb = length * rounds / 1024.0;
+  report.compressUsPerKb =
+      std::chrono::duration<double, std::micro>(Clock::now() - compressStart)
+          .count() /
+      kb;
+
+  rounds = 0;
+  std::vector<uint8_t> out;
+  out.reserve(CHUNK * 4);
+  const auto decompressStart = Clock::now();
+  do {
+    tty_compression::Decompressor decompressor;
+    for (const auto &chunk : chunks) {
+      out.clear();
+      decompressor.decompress(chunk.data(), chunk.size(), out);
+    }
+    rounds++;
+  } while (Clock::now() - decompressStart < MIN_TIMING);
+  report.decompressUsPerKb =
+      std::chrono::duration<double, std::micro>(Clock::now() -
+                                                decompressStart)
+          .count() /
+      (length * rounds / 1024.0);
+  return report;
+}
+
+void print(const char *name, size_t length, const CompressionReport &r) {
+  std::printf("[ COMPRESS ] %-14s %6zu B  wire %5.1f%%  isolated %5.1f%%  "
+              "compress %6.2f us/KB  decompress %6.2f us/KB\n",
+              name, length, r.wireRatio * 100, r.isolatedRatio * 100,
+              r.compressUsPerKb, r.decompressUsPerKb);
+}
+
+void check(const char *name, const char *corpus) {
+  const CompressionReport report = measure(corpus);
+  print(name, std::strlen(corpus), report);
+  EXPECT_TRUE(report.roundTrip) << name;
+  EXPECT_LT(report.wireRatio, report.isolatedRatio) << name;
+  EXPECT_LT(report.wireRatio, 0.65) << name;
+}
+
+TEST(TtyCompressionBenchmark, KernelBoot) {
+  check("kernel boot", console_corpus::KERNEL_BOOT);
+}
+
+TEST(TtyCompressionBenchmark, SystemdBoot) {
+  check("systemd boot", console_corpus::SYSTEMD_BOOT);
+}
+
+TEST(TtyCompressionBenchmark, ShellSession) {
+  check("shell session", console_corpus::SHELL_SESSION);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,106 @@
+#include "domain/messaging/tty_compression.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using tty_compression::Compressor;
+using tty_compression::Decompressor;
+using tty_compression::maxCompressedSize;
+
+std::vector<uint8_t> compress(Compressor &compressor, const std::string &s) {
+  std::vector<uint8_t> out(maxCompressedSize(s.size()));
+  out.resize(compressor.compress(
+      reinterpret_cast<const uint8_t *>(s.data()), s.size(), out.data()));
+  return out;
+}
+
+std::string expand(Decompressor &decompressor,
+                   const std::vector<uint8_t> &packed) {
+  std::vector<uint8_t> out;
+  EXPECT_TRUE(decompressor.decompress(packed.data(), packed.size(), out));
+  return std::string(out.begin(), out.end());
+}
+
+TEST(TtyCompressionTest, RoundTripsText) {
+  Compressor compressor;
+  Decompressor decompressor;
+  const std::string line = "[  OK  ] Started ssh.service - OpenBSD Secure "
+                           "Shell server.\n[  OK  ] Started cron.service\n";
+  EXPECT_EQ(expand(decompressor, compress(compressor, line)), line);
+}
+
+TEST(TtyCompressionTest, OverlappingRunCollapses) {
+  Compressor compressor;
+  Decompressor decompressor;
+  const std::string run(200, '=');
+  const auto packed = compress(compressor, run);
+  EXPECT_LT(packed.size(), 20u);
+  EXPECT_EQ(expand(decompressor, packed), run);
+}
+
+TEST(TtyCompressionTest, LaterChunksReferenceEarlierOnes) {
+  Compressor compressor;
+  Decompressor decompressor;
+  const std::string line = "Jun 11 14:03:11 node01 systemd[1]: k3s-agent.service: "
+                           "Failed with result 'exit-code'.\n";
+  const auto first = compress(compressor, line);
+  const auto second = compress(compressor, line);
+  EXPECT_LT(second.size(), first.size() / 4);
+
+  EXPECT_EQ(expand(decompressor, first), line);
+  EXPECT_EQ(expand(decompressor, second), line);
+}
+
+TEST(TtyCompressionTest, AbsorbedRawChunkKeepsHistoriesInStep) {
+  Compressor compressor;
+  Decompressor decompressor;
+  const std::string raw = "random-ish 8f3a:c1\n";
+  compress(compressor, raw); // sender ends up publishing it raw
+  decompressor.absorb(reinterpret_cast<const uint8_t *>(raw.data()),
+                      raw.size());
+
+  EXPECT_EQ(expand(decompressor, compress(compressor, raw + raw)), raw + raw);
+}
+
+TEST(TtyCompressionTest, IncompressibleDataStaysWithinBound) {
+  Compressor compressor;
+  Decompressor decompressor;
+  std::string noise;
+  uint32_t state = 12345;
+  for (int i = 0; i < 512; ++i) {
+    state = state * 1103515245u + 12345u;
+    noise.push_back(static_cast<char>(state >> 24));
+  }
+  const auto packed = compress(compressor, noise);
+  EXPECT_LE(packed.size(), maxCompressedSize(noise.size()));
+  EXPECT_EQ(expand(decompressor, packed), noise);
+}
+
+TEST(TtyCompressionTest, ResetDropsReferencesToOlderBytes) {
+  Compressor compressor;
+  const std::string line = "eth0: Link is Up - 1Gbps/Full\n";
+  compress(compressor, line);
+  compressor.reset();
+
+  // A receiver that only sees what follows the reset can decode it
+  Decompressor lateJoiner;
+  EXPECT_EQ(expand(lateJoiner, compress(compressor, line)), line);
+}
+
+TEST(TtyCompressionTest, ReferenceBeforeHistoryIsRejected) {
+  Compressor compressor;
+  const std::string line = "abcabcabcabc\n";
+  compress(compressor, line);
+  const auto second = compress(compressor, line);
+
+  Decompressor missedFirst;
+  std::vector<uint8_t> out;
+  EXPECT_FALSE(missedFirst.decompress(second.data(), second.size(), out));
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,218 @@
+#include "domain/messaging/tty_compression.h"
+#include "domain/messaging/tty_frame.h"
+#include "domain/messaging/tty_frame_decoder.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+std::vector<uint8_t> frame(uint8_t port, uint32_t offset,
+                           const std::string &payload, uint8_t flags = 0) {
+  std::vector<uint8_t> out(tty_frame::HEADER_SIZE + payload.size());
+  tty_frame::Header header;
+  header.port = port;
+  header.flags = flags;
+  header.offset = offset;
+  tty_frame::encodeHeader(header, out.data());
+  std::copy(payload.begin(), payload.end(),
+            out.begin() + tty_frame::HEADER_SIZE);
+  return out;
+}
+
+// Compresses like MqttFlushPolicy does; sets FLAG_HISTORY_RESET when the
+// compressor has no history
+std::vector<uint8_t> compressedFrame(tty_compression::Compressor &compressor,
+                                     uint32_t offset, const std::string &text,
+                                     uint8_t flags = 0) {
+  if (compressor.historySize() == 0)
+    flags |= tty_frame::FLAG_HISTORY_RESET;
+  std::vector<uint8_t> packed(tty_compression::maxCompressedSize(text.size()));
+  packed.resize(compressor.compress(
+      reinterpret_cast<const uint8_t *>(text.data()), text.size(),
+      packed.data()));
+  std::vector<uint8_t> out =
+      frame(0, offset, "", flags | tty_frame::FLAG_COMPRESSED);
+  out.insert(out.end(), packed.begin(), packed.end());
+  return out;
+}
+
+class TtyFrameDecoderTest : public ::testing::Test {
+protected:
+  TtyFrameDecoder decoder;
+  std::string stream; // delivered data, holes rendered as <offset+length>
+  int restarts{0};
+
+  void SetUp() override {
+    decoder.onData([this](uint8_t, const uint8_t *data, size_t length) {
+      stream.append(reinterpret_cast<const char *>(data), length);
+    });
+    decoder.onGap([this](uint8_t, uint32_t offset, uint32_t length) {
+      stream += "<" + std::to_string(offset) + "+" + std::to_string(length) +
+                ">";
+    });
+    decoder.onRestart([this](uint8_t) { restarts++; });
+  }
+
+  void feed(const std::vector<uint8_t> &payload) {
+    ASSERT_TRUE(decoder.feed(payload.data(), payload.size()));
+  }
+};
+
+TEST(TtyFrameTest, HeaderRoundTrips) {
+  tty_frame::Header in;
+  in.port = 1;
+  in.flags = tty_frame::FLAG_STREAM_START;
+  in.offset = 0xA1B2C3D4;
+  uint8_t bytes[tty_frame::HEADER_SIZE];
+  tty_frame::encodeHeader(in, bytes);
+
+  EXPECT_EQ(bytes[0], 0x11); // version 1, port 1
+  EXPECT_EQ(bytes[2], 0xA1);
+  EXPECT_EQ(bytes[5], 0xD4);
+
+  tty_frame::Header out;
+  ASSERT_TRUE(tty_frame::decodeHeader(bytes, sizeof(bytes), out));
+  EXPECT_EQ(out.port, 1);
+  EXPECT_EQ(out.flags, tty_frame::FLAG_STREAM_START);
+  EXPECT_EQ(out.offset, 0xA1B2C3D4u);
+}
+
+TEST(TtyFrameTest, RejectsShortOrForeignPayloads) {
+  tty_frame::Header header;
+  const uint8_t shortFrame[] = {0x10, 0, 0, 0, 0};
+  EXPECT_FALSE(tty_frame::decodeHeader(shortFrame, sizeof(shortFrame), header));
+  const uint8_t rawText[] = {'h', 'e', 'l', 'l', 'o', '\n'};
+  EXPECT_FALSE(tty_frame::decodeHeader(rawText, sizeof(rawText), header));
+}
+
+TEST_F(TtyFrameDecoderTest, ContiguousFramesReassemble) {
+  feed(frame(0, 0, "boot\n", tty_frame::FLAG_STREAM_START));
+  feed(frame(0, 5, "ok\n"));
+  EXPECT_EQ(stream, "boot\nok\n");
+  EXPECT_EQ(decoder.stats().gaps, 0u);
+}
+
+TEST_F(TtyFrameDecoderTest, ReportsMissingRangeExactly) {
+  feed(frame(0, 0, "abc", tty_frame::FLAG_STREAM_START));
+  feed(frame(0, 10, "xyz"));
+  EXPECT_EQ(stream, "abc<3+7>xyz");
+  EXPECT_EQ(decoder.stats().lostBytes, 7u);
+}
+
+TEST_F(TtyFrameDecoderTest, LostFirstFrameCountsFromBoot) {
+  feed(frame(0, 4, "tail", tty_frame::FLAG_STREAM_START));
+  EXPECT_EQ(stream, "<0+4>tail");
+}
+
+TEST_F(TtyFrameDecoderTest, JoiningMidStreamIsNotAGap) {
+  feed(frame(1, 5000, "late"));
+  feed(frame(1, 5004, "r"));
+  EXPECT_EQ(stream, "later");
+  EXPECT_EQ(decoder.stats().gaps, 0u);
+}
+
+TEST_F(TtyFrameDecoderTest, OverlappingRedeliveryIsTrimmed) {
+  feed(frame(0, 0, "abcd", tty_frame::FLAG_STREAM_START));
+  feed(frame(0, 2, "cdef"));
+  feed(frame(0, 0, "ab"));
+  EXPECT_EQ(stream, "abcdef");
+  EXPECT_EQ(decoder.stats().duplicateBytes, 4u);
+}
+
+TEST_F(TtyFrameDecoderTest, StreamStartAfterSyncIsARestart) {
+  feed(frame(0, 0, "one", tty_frame::FLAG_STREAM_START));
+  feed(frame(0, 0, "two", tty_frame::FLAG_STREAM_START));
+  EXPECT_EQ(stream, "onetwo");
+  EXPECT_EQ(restarts, 1);
+}
+
+TEST_F(TtyFrameDecoderTest, OffsetsWrapAround) {
+  feed(frame(0, 0xFFFFFFFE, "ab"));
+  feed(frame(0, 0, "cd"));
+  feed(frame(0, 3, "f"));
+  EXPECT_EQ(stream, "abcd<2+1>f");
+}
+
+TEST_F(TtyFrameDecoderTest, PortsAreTrackedIndependently) {
+  feed(frame(0, 0, "a", tty_frame::FLAG_STREAM_START));
+  feed(frame(1, 0, "b", tty_frame::FLAG_STREAM_START));
+  feed(frame(0, 1, "c"));
+  EXPECT_EQ(stream, "abc");
+  EXPECT_EQ(decoder.stats().gaps, 0u);
+}
+
+TEST_F(TtyFrameDecoderTest, CompressedFramesReassemble) {
+  tty_compression::Compressor compressor;
+  const std::string line = "[  OK  ] Reached target network.target\n";
+  feed(compressedFrame(compressor, 0, line, tty_frame::FLAG_STREAM_START));
+  feed(compressedFrame(compressor, line.size(), line));
+  EXPECT_EQ(stream, line + line);
+  EXPECT_LT(decoder.stats().compressedBytes, 2 * line.size());
+}
+
+TEST_F(TtyFrameDecoderTest, LostCompressedFrameResumesAtHistoryReset) {
+  tty_compression::Compressor compressor;
+  const std::string a = "first line\n", b = "second line\n",
+                    c = "third line\n", d = "fourth line\n";
+  feed(compressedFrame(compressor, 0, a, tty_frame::FLAG_STREAM_START));
+  compressedFrame(compressor, 11, b); // lost by the broker
+  feed(compressedFrame(compressor, 23, c)); // refers to b: can't decode
+  EXPECT_EQ(decoder.stats().undecodable, 1u);
+
+  compressor.reset();
+  feed(compressedFrame(compressor, 34, d));
+  EXPECT_EQ(stream, a + "<11+23>" + d);
+}
+
+TEST_F(TtyFrameDecoderTest, RawFramesFeedTheHistory) {
+  tty_compression::Compressor compressor;
+  const std::string raw = "noise 7f1c\n";
+  // The sender compressed it, found no gain and published it raw
+  compressedFrame(compressor, 0, raw);
+  feed(frame(0, 0, raw,
+             tty_frame::FLAG_STREAM_START | tty_frame::FLAG_HISTORY_RESET));
+  feed(compressedFrame(compressor, raw.size(), raw));
+  EXPECT_EQ(stream, raw + raw);
+}
+
+TEST_F(TtyFrameDecoderTest, OverlappingCompressedResendRebuildsHistory) {
+  tty_compression::Compressor compressor;
+  const std::string a = "boot: eth0 up\n", b = "boot: eth1 up\n",
+                    c = "boot: wlan0 up\n", d = "boot: wlan1 up\n";
+  feed(compressedFrame(compressor, 0, a, tty_frame::FLAG_STREAM_START));
+  feed(compressedFrame(compressor, a.size(), b));
+  // Reconnect: b was delivered but not acknowledged, so it goes out again
+  // with c, compressed from a fresh history
+  compressor.reset();
+  feed(compressedFrame(compressor, a.size(), b + c));
+  feed(compressedFrame(compressor, a.size() + b.size() + c.size(), d));
+  EXPECT_EQ(stream, a + b + c + d);
+  EXPECT_EQ(decoder.stats().undecodable, 0u);
+  EXPECT_EQ(decoder.stats().lostBytes, 0u);
+  EXPECT_EQ(decoder.stats().duplicateBytes, b.size());
+}
+
+TEST_F(TtyFrameDecoderTest, OverlappingRawResetFeedsTheWholeFrame) {
+  tty_compression::Compressor compressor;
+  const std::string a = "alpha-bravo\n", b = "7391 x 0455\n";
+  feed(frame(0, 0, a, tty_frame::FLAG_STREAM_START));
+  // Resent raw from offset 0 with a reset; the next frame refers to a
+  compressedFrame(compressor, 0, a + b);
+  feed(frame(0, 0, a + b, tty_frame::FLAG_HISTORY_RESET));
+  feed(compressedFrame(compressor, a.size() + b.size(), a));
+  EXPECT_EQ(stream, a + b + a);
+  EXPECT_EQ(decoder.stats().undecodable, 0u);
+}
+
+TEST_F(TtyFrameDecoderTest, MalformedPayloadIgnored) {
+  const uint8_t raw[] = {'r', 'a', 'w'};
+  EXPECT_FALSE(decoder.feed(raw, sizeof(raw)));
+  EXPECT_EQ(decoder.stats().malformed, 1u);
+  EXPECT_TRUE(stream.empty());
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
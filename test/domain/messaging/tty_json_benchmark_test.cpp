@@ -0,0 +1,145 @@
+// Size and CPU cost of JSON line records on console text.
+//
+// Each corpus goes through MqttFlushPolicy in MQTT_FRAME_MIN_BYTES chunks,
+// the size JSON output batches to, with every line stamped like the
+// MqttClient does. "wire" is every published byte against the raw text.
+// "encode" times tty_json::BatchWriter alone over the corpus lines into one
+// MQTT_JSON_BATCH_SIZE buffer, restarted whenever it fills, i.e. the work
+// the MQTT task adds per flush without the publish itself.
+//
+// Timings are native host numbers; the ESP32-C3 at 160 MHz is roughly an
+// order of magnitude slower per byte.
+//
+// MqttFlushPolicy template definitions come from mqtt_flush_policy_test.cpp.
+#include "console_corpus.hpp"
+#include "domain/messaging/mqtt_flush_policy.h"
+#include "domain/messaging/tty_json.h"
+#include "infrastructure/mqttt/pub_sub_client_test.h"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using JsonClock = std::chrono::steady_clock;
+
+constexpr size_t JSON_CHUNK = MQTT_FRAME_MIN_BYTES;
+constexpr auto JSON_MIN_TIMING = std::chrono::milliseconds(20);
+
+struct JsonReport {
+  size_t lines{0};
+  size_t completeRecords{0};
+  size_t publishes{0};
+  double wireRatio{0};
+  double encodeUsPerKb{0};
+  bool wellFormed{true};
+};
+
+size_t countSubstrings(const std::string &text, const char *needle) {
+  size_t count = 0;
+  for (size_t at = text.find(needle); at != std::string::npos;
+       at = text.find(needle, at + 1))
+    count++;
+  return count;
+}
+
+JsonReport measureJson(const char *corpus) {
+  const size_t length = std::strlen(corpus);
+  const auto *bytes = reinterpret_cast<const uint8_t *>(corpus);
+  JsonReport report;
+
+  // Firmware path: batches exactly as published
+  PubSubClientTest client;
+  client.setConnected(true);
+  types::string topic{"dev/ttyS1/tx"};
+  bool connected = true, framed = false, compressed = false, json = true;
+  internal::MqttFlushPolicy<PubSubClientTest> policy{
+      client, topic, connected, framed, compressed, json, 1};
+  bool lineStart = true;
+  for (size_t at = 0; at < length; ++at) {
+    if (lineStart)
+      policy.stampLine(static_cast<uint32_t>(at), 1000 + at);
+    lineStart = bytes[at] == '\n';
+    if (bytes[at] == '\n')
+      report.lines++;
+  }
+  for (size_t at = 0; at < length; at += JSON_CHUNK) {
+    const size_t n = std::min(JSON_CHUNK, length - at);
+    policy.flush(types::span<const uint8_t>(bytes + at, n),
+                 static_cast<uint32_t>(at), "tty1");
+  }
+
+  size_t wire = 0;
+  for (const auto &payload : client.getPublishedPayloads()) {
+    const std::string text(payload.begin(), payload.end());
+    wire += text.size();
+    report.wellFormed &= text.size() <= MQTT_JSON_BATCH_SIZE &&
+                         text.front() == '[' && text.back() == ']';
+    report.completeRecords +=
+        countSubstrings(text, "\"ts\":") - countSubstrings(text, "\"partial\"");
+  }
+  report.publishes = client.getPublishedPayloads().size();
+  report.wireRatio = static_cast<double>(wire) / length;
+
+  // CPU cost of the encoder alone
+  std::array<uint8_t, MQTT_JSON_BATCH_SIZE> out;
+  size_t rounds = 0;
+  const auto start = JsonClock::now();
+  do {
+    tty_json::BatchWriter batch(out.data(), out.size());
+    size_t at = 0;
+    while (at < length) {
+      const auto *newline =
+          static_cast<const uint8_t *>(memchr(bytes + at, '\n', length - at));
+      const size_t end = newline ? newline - bytes : length;
+      if (!batch.beginRecord(1000, 1, static_cast<uint32_t>(at))) {
+        batch.finish();
+        batch = tty_json::BatchWriter(out.data(), out.size());
+        continue;
+      }
+      at += batch.appendText(bytes + at, end - at);
+      const bool complete = at == end;
+      batch.endRecord(!complete);
+      if (complete)
+        at = end + 1;
+    }
+    batch.finish();
+    rounds++;
+  } while (JsonClock::now() - start < JSON_MIN_TIMING);
+  report.encodeUsPerKb =
+      std::chrono::duration<double, std::micro>(JsonClock::now() - start)
+          .count() /
+      (length * rounds / 1024.0);
+  return report;
+}
+
+void checkJson(const char *name, const char *corpus) {
+  const JsonReport report = measureJson(corpus);
+  std::printf("[ JSON     ] %-14s %6zu B  %4zu lines  %3zu publishes  "
+              "wire %5.1f%%  encode %6.2f us/KB (%5.1f MB/s)\n",
+              name, std::strlen(corpus), report.lines, report.publishes,
+              report.wireRatio * 100, report.encodeUsPerKb,
+              1e6 / 1024.0 / report.encodeUsPerKb);
+  EXPECT_TRUE(report.wellFormed) << name;
+  EXPECT_EQ(report.completeRecords, report.lines) << name;
+}
+
+TEST(TtyJsonBenchmark, KernelBoot) {
+  checkJson("kernel boot", console_corpus::KERNEL_BOOT);
+}
+
+TEST(TtyJsonBenchmark, SystemdBoot) {
+  checkJson("systemd boot", console_corpus::SYSTEMD_BOOT);
+}
+
+TEST(TtyJsonBenchmark, ShellSession) {
+  checkJson("shell session", console_corpus::SHELL_SESSION);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,97 @@
+#include "domain/messaging/tty_json.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+class TtyJsonTest : public ::testing::Test {
+protected:
+  std::vector<uint8_t> buffer = std::vector<uint8_t>(256);
+
+  // One finished batch with a single complete record
+  std::string encodeLine(const std::string &text) {
+    tty_json::BatchWriter batch(buffer.data(), buffer.size());
+    EXPECT_TRUE(batch.beginRecord(7, 1, 9));
+    EXPECT_EQ(batch.appendText(bytes(text), text.size()), text.size());
+    batch.endRecord(false);
+    return finish(batch);
+  }
+
+  std::string finish(tty_json::BatchWriter &batch) {
+    const size_t length = batch.finish();
+    return std::string(buffer.begin(), buffer.begin() + length);
+  }
+
+  static const uint8_t *bytes(const std::string &text) {
+    return reinterpret_cast<const uint8_t *>(text.data());
+  }
+};
+
+TEST_F(TtyJsonTest, RecordsFormOneArray) {
+  tty_json::BatchWriter batch(buffer.data(), buffer.size());
+  ASSERT_TRUE(batch.beginRecord(81234, 1, 5120));
+  batch.appendText(bytes("login: "), 7);
+  batch.endRecord(false);
+  ASSERT_TRUE(batch.beginRecord(0, 1, 5128));
+  batch.appendText(bytes("Pass"), 4);
+  batch.endRecord(true);
+
+  EXPECT_EQ(finish(batch),
+            "[{\"ts\":81234,\"port\":1,\"seq\":5120,\"line\":\"login: \"},"
+            "{\"ts\":0,\"port\":1,\"seq\":5128,\"line\":\"Pass\","
+            "\"partial\":true}]");
+}
+
+TEST_F(TtyJsonTest, EscapesQuotesAndControlCharacters) {
+  EXPECT_EQ(encodeLine("say \"hi\"\\\t\r\x1b[0m\x7f"),
+            "[{\"ts\":7,\"port\":1,\"seq\":9,\"line\":"
+            "\"say \\\"hi\\\"\\\\\\t\\r\\u001b[0m\x7f\"}]");
+}
+
+TEST_F(TtyJsonTest, KeepsUtf8AndReplacesInvalidBytes) {
+  // "µs" and "✓" pass through; a stray continuation byte, an overlong
+  // encoding and a truncated sequence don't
+  EXPECT_EQ(encodeLine("\xc2\xb5s \xe2\x9c\x93 \x80 \xc0\xaf \xe2\x9c"),
+            "[{\"ts\":7,\"port\":1,\"seq\":9,\"line\":\"\xc2\xb5s \xe2\x9c\x93 "
+            "\\ufffd \\ufffd\\ufffd \\ufffd\\ufffd\"}]");
+}
+
+TEST_F(TtyJsonTest, StopsAtCapacityWithAValidDocument) {
+  buffer.resize(tty_json::BatchWriter::MAX_HEADER_SIZE +
+                tty_json::BatchWriter::CLOSE_SIZE + 4);
+  tty_json::BatchWriter batch(buffer.data(), buffer.size());
+  ASSERT_TRUE(batch.beginRecord(UINT32_MAX, 255, UINT32_MAX));
+  // A two-byte escape and the start of an escaped control character
+  const std::string text = "ab\"\x01";
+  const size_t used = batch.appendText(bytes(text), text.size());
+  EXPECT_EQ(used, 3u);
+  batch.endRecord(true);
+  EXPECT_FALSE(batch.beginRecord(0, 0, 3));
+
+  EXPECT_EQ(finish(batch),
+            "[{\"ts\":4294967295,\"port\":255,\"seq\":4294967295,\"line\":"
+            "\"ab\\\"\",\"partial\":true}]");
+}
+
+TEST_F(TtyJsonTest, CancelledRecordLeavesNoTrace) {
+  tty_json::BatchWriter batch(buffer.data(), buffer.size());
+  ASSERT_TRUE(batch.beginRecord(1, 0, 0));
+  batch.appendText(bytes("a"), 1);
+  batch.endRecord(false);
+  ASSERT_TRUE(batch.beginRecord(2, 0, 2));
+  batch.cancelRecord();
+
+  EXPECT_EQ(batch.recordCount(), 1u);
+  EXPECT_EQ(finish(batch), "[{\"ts\":1,\"port\":0,\"seq\":0,\"line\":\"a\"}]");
+}
+
+TEST_F(TtyJsonTest, EmptyBatchHasNoDocument) {
+  tty_json::BatchWriter batch(buffer.data(), buffer.size());
+  EXPECT_EQ(batch.finish(), 0u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
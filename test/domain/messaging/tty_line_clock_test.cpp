@@ -0,0 +1,43 @@
+#include "domain/messaging/tty_line_clock.hpp"
+
+#include <gtest/gtest.h>
+
+namespace jrb::wifi_serial {
+namespace {
+
+TEST(TtyLineClockTest, OffsetGetsTheTimeOfItsLine) {
+  TtyLineClock<4> clock;
+  EXPECT_EQ(clock.arrival(0, 99), 99u);
+
+  clock.stamp(10, 1000);
+  clock.stamp(20, 2000);
+  EXPECT_EQ(clock.arrival(10, 99), 1000u);
+  EXPECT_EQ(clock.arrival(19, 99), 1000u);
+  EXPECT_EQ(clock.arrival(25, 99), 2000u);
+  // Looked up again, e.g. when a chunk is resent
+  EXPECT_EQ(clock.arrival(12, 99), 1000u);
+}
+
+TEST(TtyLineClockTest, OverwrittenLinesGetTheOldestTimeKept) {
+  TtyLineClock<2> clock;
+  clock.stamp(10, 1000);
+  clock.stamp(20, 2000);
+  clock.stamp(30, 3000);
+
+  EXPECT_EQ(clock.size(), 2u);
+  EXPECT_EQ(clock.arrival(15, 99), 2000u);
+  EXPECT_EQ(clock.arrival(35, 99), 3000u);
+}
+
+TEST(TtyLineClockTest, OffsetsWrapAround) {
+  TtyLineClock<4> clock;
+  clock.stamp(0xFFFFFFF0u, 1000);
+  clock.stamp(0x10, 2000);
+
+  EXPECT_EQ(clock.arrival(0xFFFFFFFFu, 99), 1000u);
+  EXPECT_EQ(clock.arrival(0x05, 99), 1000u);
+  EXPECT_EQ(clock.arrival(0x10, 99), 2000u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
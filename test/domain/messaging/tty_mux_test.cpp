@@ -0,0 +1,133 @@
+#include "domain/messaging/tty_frame.h"
+#include "domain/messaging/tty_mux.h"
+#include "domain/messaging/tty_mux_decoder.h"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+std::vector<uint8_t> muxFrame(uint8_t port, uint32_t offset,
+                              const std::string &payload) {
+  std::vector<uint8_t> out(tty_frame::HEADER_SIZE);
+  tty_frame::Header header;
+  header.port = port;
+  header.offset = offset;
+  tty_frame::encodeHeader(header, out.data());
+  out.insert(out.end(), payload.begin(), payload.end());
+  return out;
+}
+
+class MuxPayload {
+public:
+  MuxPayload &add(uint8_t port, const std::vector<uint8_t> &data) {
+    EXPECT_TRUE(writer.append(port, data.data(), data.size()));
+    return *this;
+  }
+  std::vector<uint8_t> bytes() const {
+    return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+  }
+
+private:
+  std::array<uint8_t, 256> buffer{};
+  tty_mux::Writer writer{buffer.data(), buffer.size()};
+};
+
+TEST(TtyMuxTest, SectionsRoundTrip) {
+  std::array<uint8_t, 32> buffer{};
+  tty_mux::Writer writer(buffer.data(), buffer.size());
+  const std::string first = "ab", second = "xyz";
+  ASSERT_TRUE(writer.append(0, reinterpret_cast<const uint8_t *>(first.data()),
+                            first.size()));
+  ASSERT_TRUE(writer.append(
+      1, reinterpret_cast<const uint8_t *>(second.data()), second.size()));
+  EXPECT_EQ(writer.sections(), 2u);
+  ASSERT_EQ(writer.size(), 2 * tty_mux::SECTION_HEADER_SIZE + 5);
+  EXPECT_EQ(buffer[5], 1);    // second section's port
+  EXPECT_EQ(buffer[6], 0x00); // ...and big-endian length
+  EXPECT_EQ(buffer[7], 0x03);
+
+  tty_mux::Reader reader(writer.data(), writer.size());
+  tty_mux::Section section;
+  ASSERT_TRUE(reader.next(section));
+  EXPECT_EQ(section.port, 0);
+  EXPECT_EQ(std::string(section.data, section.data + section.size), "ab");
+  ASSERT_TRUE(reader.next(section));
+  EXPECT_EQ(section.port, 1);
+  EXPECT_EQ(std::string(section.data, section.data + section.size), "xyz");
+  EXPECT_FALSE(reader.next(section));
+  EXPECT_FALSE(reader.malformed());
+}
+
+TEST(TtyMuxTest, WriterRefusesWhatDoesNotFitAndReaderStopsAtTruncation) {
+  std::array<uint8_t, 8> buffer{};
+  tty_mux::Writer writer(buffer.data(), buffer.size());
+  const uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+  EXPECT_FALSE(writer.append(0, data, sizeof(data)));
+  EXPECT_TRUE(writer.empty());
+  EXPECT_TRUE(writer.append(0, data, 5));
+  EXPECT_FALSE(writer.fits(0));
+
+  // The length claims more than the payload holds
+  tty_mux::Reader reader(writer.data(), writer.size() - 1);
+  tty_mux::Section section;
+  EXPECT_FALSE(reader.next(section));
+  EXPECT_TRUE(reader.malformed());
+}
+
+TEST(TtyMuxDecoderTest, DemultiplexesPortsWithPerPortGaps) {
+  TtyMuxDecoder decoder;
+  std::array<std::string, 2> streams;
+  decoder.frames().onData(
+      [&streams](uint8_t port, const uint8_t *data, size_t length) {
+        streams[port].append(reinterpret_cast<const char *>(data), length);
+      });
+  decoder.frames().onGap(
+      [&streams](uint8_t port, uint32_t offset, uint32_t length) {
+        streams[port] += "<" + std::to_string(offset) + "+" +
+                         std::to_string(length) + ">";
+      });
+
+  auto payload = MuxPayload()
+                     .add(0, muxFrame(0, 0, "boot\n"))
+                     .add(1, muxFrame(1, 100, "login: "))
+                     .bytes();
+  ASSERT_TRUE(decoder.feed(payload.data(), payload.size()));
+  // Port 1 lost a range; port 0 didn't
+  payload = MuxPayload()
+                .add(1, muxFrame(1, 110, "root\n"))
+                .add(0, muxFrame(0, 5, "ok\n"))
+                .bytes();
+  ASSERT_TRUE(decoder.feed(payload.data(), payload.size()));
+
+  EXPECT_EQ(streams[0], "boot\nok\n");
+  EXPECT_EQ(streams[1], "login: <107+3>root\n");
+  EXPECT_EQ(decoder.stats().publishes, 2u);
+  EXPECT_EQ(decoder.stats().sections, 4u);
+  EXPECT_EQ(decoder.frames().stats().gaps, 1u);
+}
+
+TEST(TtyMuxDecoderTest, MislabeledAndTruncatedSectionsAreMalformed) {
+  TtyMuxDecoder decoder;
+  std::string delivered;
+  decoder.frames().onData(
+      [&delivered](uint8_t, const uint8_t *data, size_t length) {
+        delivered.append(reinterpret_cast<const char *>(data), length);
+      });
+
+  auto payload = MuxPayload()
+                     .add(0, muxFrame(1, 0, "wrong port\n"))
+                     .add(1, muxFrame(1, 0, "kept\n"))
+                     .bytes();
+  payload.push_back(0); // half a section header
+  EXPECT_FALSE(decoder.feed(payload.data(), payload.size()));
+
+  EXPECT_EQ(delivered, "kept\n");
+  EXPECT_EQ(decoder.stats().malformed, 2u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,50 @@
+#include "domain/messaging/tty_snapshot.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace jrb::wifi_serial {
+namespace {
+
+class TtySnapshotTest : public ::testing::Test {
+protected:
+  TtySnapshot<16> snapshot;
+
+  void write(const std::string &text) {
+    snapshot.append(types::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(text.data()), text.size()));
+  }
+
+  std::string rendered() {
+    const auto span = snapshot.render();
+    return std::string(reinterpret_cast<const char *>(span.data()),
+                       span.size());
+  }
+};
+
+TEST_F(TtySnapshotTest, DirtyUntilPublished) {
+  EXPECT_FALSE(snapshot.dirty());
+  write("login: ");
+  EXPECT_TRUE(snapshot.dirty());
+
+  snapshot.markPublished();
+  EXPECT_FALSE(snapshot.dirty());
+  EXPECT_EQ(rendered(), "login: "); // contents stay
+}
+
+TEST_F(TtySnapshotTest, WrappedSnapshotStartsAtALineBoundary) {
+  write("first line\nsecond\nthird\n"); // 24 bytes into 16
+
+  EXPECT_EQ(rendered(), "second\nthird\n"); // "ne\n" was a torn line
+  write("x");
+  EXPECT_EQ(rendered(), "second\nthird\nx"); // render() leaves the ring usable
+}
+
+TEST_F(TtySnapshotTest, WrappedSnapshotWithoutNewlineKeptWhole) {
+  write("0123456789abcdefXYZ");
+
+  EXPECT_EQ(rendered(), "3456789abcdefXYZ");
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,74 @@
+// SSH public key logins: looking the key up in the pre-parsed table against
+// reading and parsing authorized_keys on every login.
+//
+// The file holds SSH_AUTHORIZED_KEYS_MAX keys and the key that logs in is
+// the last one, the worst case for both. "parse per login" is what a
+// server that reads the file per attempt pays: load() each time. "table" is
+// SSHServer: contains() on the base64 key libssh exports. Native numbers;
+// on the ESP32-C3 the file read is a LittleFS read from flash, so the gap
+// there is wider.
+//
+// SshAuthorizedKeys template definitions come from
+// ssh_authorized_keys_test.cpp.
+#include "domain/network/ssh_authorized_keys.h"
+#include "infrastructure/storage/file_system_test.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using AuthClock = std::chrono::steady_clock;
+constexpr int AUTH_ROUNDS = 2000;
+
+TEST(SshAuthorizedKeysBenchmark, TableVersusParsePerLogin) {
+  FileSystemTest::reset();
+  // Distinct Ed25519-shaped keys: the type prefix, then 32 varying bytes
+  std::string file, lastKey;
+  for (int i = 0; i < SSH_AUTHORIZED_KEYS_MAX; ++i) {
+    char key[80];
+    snprintf(key, sizeof(key),
+             "AAAAC3NzaC1lZDI1NTE5AAAAICy31zro4PMpFgnPnG5dLu2XkTBhsCT5R%011d",
+             i);
+    lastKey = key;
+    file += "ssh-ed25519 " + lastKey + " user" + std::to_string(i) + "\n";
+  }
+  FileSystemTest().append("/authorized_keys",
+                          reinterpret_cast<const uint8_t *>(file.data()),
+                          file.size());
+
+  internal::SshAuthorizedKeys<FileSystemTest> keys("/authorized_keys");
+  ASSERT_TRUE(keys.begin());
+  ASSERT_EQ(keys.load(), size_t{SSH_AUTHORIZED_KEYS_MAX});
+
+  bool found = true;
+  auto start = AuthClock::now();
+  for (int i = 0; i < AUTH_ROUNDS; ++i) {
+    keys.load();
+    found = found && keys.contains(lastKey.c_str());
+  }
+  const double parseUs =
+      std::chrono::duration<double, std::micro>(AuthClock::now() - start)
+          .count() /
+      AUTH_ROUNDS;
+
+  start = AuthClock::now();
+  for (int i = 0; i < AUTH_ROUNDS; ++i)
+    found = found && keys.contains(lastKey.c_str());
+  const double tableUs =
+      std::chrono::duration<double, std::micro>(AuthClock::now() - start)
+          .count() /
+      AUTH_ROUNDS;
+
+  std::printf("[ SSH AUTH ] %d keys  parse per login %7.2f us  table %5.2f "
+              "us  (%zu bytes of file)\n",
+              SSH_AUTHORIZED_KEYS_MAX, parseUs, tableUs, file.size());
+  EXPECT_TRUE(found);
+  EXPECT_LT(tableUs, parseUs);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,110 @@
+#include "domain/network/ssh_authorized_keys.cpp"
+#include "infrastructure/storage/file_system_test.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using AuthorizedKeys = internal::SshAuthorizedKeys<FileSystemTest>;
+constexpr const char *TEST_AUTHORIZED_KEYS_PATH = "/authorized_keys";
+
+// Generated with ssh-keygen; the base64 is what libssh exports for them
+const std::string ED25519_KEY =
+    "AAAAC3NzaC1lZDI1NTE5AAAAICy31zro4PMpFgnPnG5dLu2XkTBhsCT5RyyIq1C2600w";
+const std::string ECDSA_KEY =
+    "AAAAE2VjZHNhLXNoYTItbmlzdHAyNTYAAAAIbmlzdHAyNTYAAABBBDEmOlmCKyPhUNUY"
+    "Vx/uPUOGX4+5a8hjr1hCVr+hCHRPDJjGh+FN1tGKV3/DpuQuA7dNBfQY9xmuw3sIybDD"
+    "hoI=";
+const std::string RSA_KEY =
+    "AAAAB3NzaC1yc2EAAAADAQABAAABAQC1b9UHu7ABXSGB3gPq5OOtIDDynMDEgMvVf77t"
+    "bVQSbGnGQIuwWMxjKg8vEKLk0yRfuPY4aCG6OfocX41fxoRhBSx0o9xRQc4Jkn2DVMif"
+    "sNMGiLpVycj+4O2XH46jSSIjlKuJHGr6XMz0n9HLup6Sf1xgV2oDSjDIy7Lv5pBFcrHA"
+    "3b9casAuODU5yFoDy1pN+pNZ+GHlPDpVVKmYU+rV104Zb1nX2uLQDR4bp9kRditIrr6M"
+    "2AHQiSM11mXjLfMz9DeKVLl+fERqcQd8tTbSXiz3aozUbOJkWeWwww4h1vwlQKrS+fcz"
+    "TG1vzwkTzZxPP0uQeQ84B7bVm+jVq9Wj";
+
+class SshAuthorizedKeysTest : public ::testing::Test {
+protected:
+  void SetUp() override { FileSystemTest::reset(); }
+
+  void writeAuthorizedKeys(const std::string &text) {
+    FileSystemTest fs;
+    fs.remove(TEST_AUTHORIZED_KEYS_PATH);
+    fs.append(TEST_AUTHORIZED_KEYS_PATH,
+              reinterpret_cast<const uint8_t *>(text.data()), text.size());
+  }
+};
+
+TEST_F(SshAuthorizedKeysTest, LoadsEveryKeyTypeOnce) {
+  writeAuthorizedKeys("# operators\n"
+                      "ssh-ed25519 " + ED25519_KEY + " ci@build\n"
+                      "\n"
+                      "ecdsa-sha2-nistp256 " + ECDSA_KEY + " laptop\r\n"
+                      "  ssh-rsa " + RSA_KEY); // no comment, no newline
+  AuthorizedKeys keys(TEST_AUTHORIZED_KEYS_PATH);
+  ASSERT_TRUE(keys.begin());
+  EXPECT_EQ(keys.load(), 3u);
+  EXPECT_TRUE(keys.contains(ED25519_KEY.c_str()));
+  EXPECT_TRUE(keys.contains(ECDSA_KEY.c_str()));
+  EXPECT_TRUE(keys.contains(RSA_KEY.c_str()));
+
+  // Parsed once: the table no longer needs the file
+  FileSystemTest().remove(TEST_AUTHORIZED_KEYS_PATH);
+  EXPECT_TRUE(keys.contains(ED25519_KEY.c_str()));
+  EXPECT_EQ(keys.load(), 0u);
+  EXPECT_FALSE(keys.contains(ED25519_KEY.c_str()));
+}
+
+TEST_F(SshAuthorizedKeysTest, RejectsKeysThatAreNotListed) {
+  writeAuthorizedKeys("ssh-ed25519 " + ED25519_KEY + "\n");
+  AuthorizedKeys keys(TEST_AUTHORIZED_KEYS_PATH);
+  ASSERT_TRUE(keys.begin());
+  ASSERT_EQ(keys.load(), 1u);
+  EXPECT_FALSE(keys.contains(RSA_KEY.c_str()));
+  EXPECT_FALSE(keys.contains("not base64!"));
+  EXPECT_FALSE(keys.contains(static_cast<const char *>(nullptr)));
+
+  // One bit off in the key material
+  std::string changed = ED25519_KEY;
+  changed[40] = changed[40] == 'A' ? 'B' : 'A';
+  EXPECT_FALSE(keys.contains(changed.c_str()));
+}
+
+TEST_F(SshAuthorizedKeysTest, SkipsLinesItCannotHonour) {
+  writeAuthorizedKeys(
+      // Restrictions we don't enforce: the key must not get in unrestricted
+      "from=\"10.0.0.0/8\" ssh-ed25519 " + ED25519_KEY + "\n"
+      "ssh-dss AAAAB3NzaC1kc3MAAACBAP\n"
+      "ssh-rsa " + ED25519_KEY + " type doesn't match the key\n"
+      "ssh-ed25519 AAAA*broken*\n"
+      "ecdsa-sha2-nistp256 " + ECDSA_KEY + "\n"
+      "ecdsa-sha2-nistp256 " + ECDSA_KEY + " duplicate\n");
+  AuthorizedKeys keys(TEST_AUTHORIZED_KEYS_PATH);
+  ASSERT_TRUE(keys.begin());
+  EXPECT_EQ(keys.load(), 1u);
+  EXPECT_FALSE(keys.contains(ED25519_KEY.c_str()));
+  EXPECT_TRUE(keys.contains(ECDSA_KEY.c_str()));
+}
+
+TEST_F(SshAuthorizedKeysTest, NoFileMeansNoKeys) {
+  AuthorizedKeys keys(TEST_AUTHORIZED_KEYS_PATH);
+  ASSERT_TRUE(keys.begin());
+  EXPECT_EQ(keys.load(), 0u);
+  EXPECT_EQ(keys.size(), 0u);
+  EXPECT_FALSE(keys.contains(ED25519_KEY.c_str()));
+}
+
+TEST_F(SshAuthorizedKeysTest, DecodesBase64) {
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(internal::decodeBase64("aGVsbG8=", 8, out));
+  EXPECT_EQ(std::string(out.begin(), out.end()), "hello");
+  ASSERT_TRUE(internal::decodeBase64("aGk", 3, out));
+  EXPECT_EQ(std::string(out.begin(), out.end()), "hi");
+  EXPECT_FALSE(internal::decodeBase64("aGVsb", 5, out));
+  EXPECT_FALSE(internal::decodeBase64("aG-s", 4, out));
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
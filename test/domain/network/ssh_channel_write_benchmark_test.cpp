@@ -0,0 +1,212 @@
+// SSH channel writes: one packet per small write against coalesced writes.
+//
+// Every ssh_channel_write() becomes at least one SSH_MSG_CHANNEL_DATA
+// packet: length, padding length, the 9-byte message header, the data,
+// 4 to 19 bytes of padding, then the MAC, all encrypted. libssh isn't
+// available natively, so this builds those packets the way libssh does for
+// aes128-ctr with hmac-sha2-256 (OpenSSL for the crypto) and writes them to
+// a local socket that a client thread drains.
+//
+// Throughput streams serial output in writes of a UART read (64 bytes),
+// the old ring read chunk (1024) and one SSH_WRITE_BATCH_SIZE batch, and
+// reports packets/s, payload MB/s and wire overhead. Echo is the interactive
+// case: a keystroke echo followed by a short line of serial output, written
+// separately (two packets) or together (one).
+//
+// The rates are only reported; the checks are on packet counts and
+// overhead, which don't depend on how fast the host is.
+#include "config.h"
+
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using ChannelClock = std::chrono::steady_clock;
+constexpr size_t CHANNEL_PAYLOAD = 1024 * 1024;
+constexpr size_t CHANNEL_MAX_PACKET = 32768; // OpenSSH's channel max packet
+constexpr size_t CHANNEL_BLOCK = 16;         // AES
+constexpr size_t CHANNEL_MAC_SIZE = 32;      // hmac-sha2-256
+constexpr int CHANNEL_ECHO_ROUNDS = 5000;
+
+/**
+ * @brief Server side of one channel: frames, MACs and encrypts each write
+ */
+class ChannelWriter {
+public:
+  explicit ChannelWriter(int socket) : socket{socket} {
+    const uint8_t key[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    const uint8_t iv[16] = {};
+    cipher = EVP_CIPHER_CTX_new();
+    EVP_EncryptInit_ex(cipher, EVP_aes_128_ctr(), nullptr, key, iv);
+  }
+  ~ChannelWriter() { EVP_CIPHER_CTX_free(cipher); }
+
+  // ssh_channel_write(): split by the peer's max packet size
+  void write(const uint8_t *data, size_t length) {
+    while (length > 0) {
+      const size_t chunk = std::min(length, CHANNEL_MAX_PACKET);
+      sendPacket(data, chunk);
+      data += chunk;
+      length -= chunk;
+    }
+  }
+
+  size_t packets{0};
+  size_t wireBytes{0};
+
+private:
+  int socket;
+  EVP_CIPHER_CTX *cipher;
+  uint32_t sequence{0};
+  std::vector<uint8_t> plain;
+  std::vector<uint8_t> wire;
+
+  static void putUint32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+  }
+
+  void sendPacket(const uint8_t *data, size_t length) {
+    const size_t payload = 9 + length; // type, channel, data length
+    size_t padding = CHANNEL_BLOCK - (5 + payload) % CHANNEL_BLOCK;
+    if (padding < 4)
+      padding += CHANNEL_BLOCK;
+    const size_t packetLength = 1 + payload + padding;
+
+    plain.resize(4 + 4 + packetLength); // sequence number for the MAC first
+    uint8_t *p = plain.data();
+    putUint32(p, sequence++);
+    putUint32(p + 4, packetLength);
+    p[8] = static_cast<uint8_t>(padding);
+    p[9] = 94; // SSH_MSG_CHANNEL_DATA
+    putUint32(p + 10, 0);
+    putUint32(p + 14, length);
+    memcpy(p + 18, data, length);
+    memset(p + 18 + length, 0, padding);
+
+    wire.resize(4 + packetLength + CHANNEL_MAC_SIZE);
+    unsigned int macLength = 0;
+    HMAC(EVP_sha256(), "mac key", 7, p, plain.size(),
+         wire.data() + 4 + packetLength, &macLength);
+    int outLength = 0;
+    EVP_EncryptUpdate(cipher, wire.data(), &outLength, p + 4,
+                      4 + packetLength);
+
+    for (size_t sent = 0; sent < wire.size();) {
+      const ssize_t rc =
+          ::write(socket, wire.data() + sent, wire.size() - sent);
+      if (rc <= 0)
+        return;
+      sent += static_cast<size_t>(rc);
+    }
+    packets++;
+    wireBytes += wire.size();
+  }
+};
+
+struct ChannelResult {
+  double packetsPerSec{0};
+  double payloadMBps{0};
+  double overheadPercent{0};
+  size_t packets{0};
+};
+
+/**
+ * @param writes Calls writer.write() for the whole scenario
+ */
+template <typename Writes> ChannelResult runChannel(Writes writes) {
+  int fds[2];
+  EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  std::thread client([fd = fds[1]] {
+    uint8_t buffer[65536];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+  });
+
+  ChannelWriter writer(fds[0]);
+  const auto start = ChannelClock::now();
+  const size_t payload = writes(writer);
+  const double seconds =
+      std::chrono::duration<double>(ChannelClock::now() - start).count();
+  shutdown(fds[0], SHUT_WR);
+  client.join();
+  close(fds[0]);
+  close(fds[1]);
+
+  ChannelResult result;
+  result.packets = writer.packets;
+  result.packetsPerSec = writer.packets / seconds;
+  result.payloadMBps = payload / seconds / (1024 * 1024);
+  result.overheadPercent =
+      100.0 * (writer.wireBytes - payload) / double(payload);
+  return result;
+}
+
+void printChannel(const char *name, const ChannelResult &result) {
+  std::printf("[ SSH WRITE] %-14s %9.0f packets/s  %7.1f MB/s  overhead "
+              "%5.1f%%\n",
+              name, result.packetsPerSec, result.payloadMBps,
+              result.overheadPercent);
+}
+
+TEST(SshChannelWriteBenchmark, CoalescedThroughput) {
+  std::vector<uint8_t> output(CHANNEL_PAYLOAD);
+  for (size_t i = 0; i < output.size(); ++i)
+    output[i] = static_cast<uint8_t>('a' + i % 26);
+
+  std::vector<ChannelResult> results;
+  for (size_t writeSize : {size_t{64}, size_t{1024},
+                           size_t{SSH_WRITE_BATCH_SIZE}}) {
+    results.push_back(runChannel([&output, writeSize](ChannelWriter &writer) {
+      for (size_t i = 0; i < output.size(); i += writeSize)
+        writer.write(output.data() + i,
+                     std::min(writeSize, output.size() - i));
+      return output.size();
+    }));
+    char name[32];
+    snprintf(name, sizeof(name), "write %zu B", writeSize);
+    printChannel(name, results.back());
+  }
+  EXPECT_LT(results[2].overheadPercent, results[0].overheadPercent);
+  EXPECT_EQ(results[2].packets, CHANNEL_PAYLOAD / size_t{SSH_WRITE_BATCH_SIZE});
+}
+
+TEST(SshChannelWriteBenchmark, EchoMergedWithOutput) {
+  const uint8_t line[] = "ok\r\n$ ";
+  const size_t perRound = 1 + sizeof(line) - 1;
+  const ChannelResult separate = runChannel([&line](ChannelWriter &writer) {
+    const uint8_t key = 'k';
+    for (int i = 0; i < CHANNEL_ECHO_ROUNDS; ++i) {
+      writer.write(&key, 1);
+      writer.write(line, sizeof(line) - 1);
+    }
+    return CHANNEL_ECHO_ROUNDS * perRound;
+  });
+  const ChannelResult merged = runChannel([&line](ChannelWriter &writer) {
+    uint8_t batch[16] = {'k'};
+    memcpy(batch + 1, line, sizeof(line) - 1);
+    for (int i = 0; i < CHANNEL_ECHO_ROUNDS; ++i)
+      writer.write(batch, perRound);
+    return CHANNEL_ECHO_ROUNDS * perRound;
+  });
+  printChannel("echo separate", separate);
+  printChannel("echo merged", merged);
+  EXPECT_EQ(separate.packets, 2u * CHANNEL_ECHO_ROUNDS);
+  EXPECT_EQ(merged.packets, size_t{CHANNEL_ECHO_ROUNDS});
+  EXPECT_LT(merged.overheadPercent, separate.overheadPercent);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,173 @@
+// SSH host keys: what each boot and each handshake costs per key type.
+//
+// GenerateVersusLoad is server startup: generating the RSA-2048 host key
+// against loading the stored one.
+// "generate" is what every boot used to do. "load" is a later boot with
+// SshHostKeyStore: read and check the stored key, then parse it. Native
+// numbers with OpenSSL; on the ESP32-C3 generation runs on a 160 MHz core
+// and takes tens of seconds, while loading is still a flash read and a
+// parse, so the saving there is far larger. It spends about 1 s on RSA
+// keygen and compares wall-clock times, so it is disabled; run it with
+// --gtest_also_run_disabled_tests --gtest_filter='*SshHostKeyBenchmark*'.
+//
+// HandshakeSignature is the host key's part of every key exchange: the
+// server signs the 32-byte exchange hash once per connection. Measured for
+// each type SSH_HOST_KEY_ORDER can list, with the signature algorithm the
+// server offers for it. It takes about 1 s and compares timings, so it is
+// disabled too; ssh_host_key_order_test.cpp covers the order itself.
+//
+// SshHostKeyStore template definitions come from ssh_host_key_store_test.cpp.
+#include "domain/network/ssh_host_key_order.h"
+#include "domain/network/ssh_host_key_store.h"
+#include "infrastructure/storage/file_system_test.h"
+
+#include <gtest/gtest.h>
+#include <openssl/bio.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using HostKeyClock = std::chrono::steady_clock;
+constexpr int HOST_KEY_GENERATE_ROUNDS = 5;
+constexpr int HOST_KEY_LOAD_ROUNDS = 50;
+constexpr int HOST_KEY_SIGN_ROUNDS = 50;
+
+double hostKeyMedian(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+types::string exportPrivateKey(EVP_PKEY *key) {
+  BIO *bio = BIO_new(BIO_s_mem());
+  PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+  char *data = nullptr;
+  const long length = BIO_get_mem_data(bio, &data);
+  types::string pem(data, static_cast<size_t>(length));
+  BIO_free(bio);
+  return pem;
+}
+
+TEST(SshHostKeyBenchmark, DISABLED_GenerateVersusLoad) {
+  FileSystemTest::reset();
+  internal::SshHostKeyStore<FileSystemTest> store("/ssh_host_key");
+  ASSERT_TRUE(store.begin());
+
+  std::vector<double> generate;
+  for (int i = 0; i < HOST_KEY_GENERATE_ROUNDS; ++i) {
+    const auto start = HostKeyClock::now();
+    EVP_PKEY *key = EVP_RSA_gen(2048);
+    ASSERT_NE(key, nullptr);
+    const types::string pem = exportPrivateKey(key);
+    ASSERT_TRUE(store.save(pem));
+    generate.push_back(std::chrono::duration<double, std::milli>(
+                           HostKeyClock::now() - start)
+                           .count());
+    EVP_PKEY_free(key);
+  }
+
+  std::vector<double> load;
+  for (int i = 0; i < HOST_KEY_LOAD_ROUNDS; ++i) {
+    const auto start = HostKeyClock::now();
+    types::string pem;
+    ASSERT_TRUE(store.load(pem));
+    BIO *bio = BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()));
+    EVP_PKEY *key = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    ASSERT_NE(key, nullptr);
+    load.push_back(std::chrono::duration<double, std::milli>(
+                       HostKeyClock::now() - start)
+                       .count());
+    EVP_PKEY_free(key);
+  }
+
+  const double generateMs = hostKeyMedian(generate);
+  const double loadMs = hostKeyMedian(load);
+  std::printf("[ SSH KEY  ] rsa-2048  generate %8.2f ms  load %6.3f ms  "
+              "saved %8.2f ms per boot (x%.0f)\n",
+              generateMs, loadMs, generateMs - loadMs, generateMs / loadMs);
+  EXPECT_LT(loadMs * 10, generateMs);
+}
+
+EVP_PKEY *generateHostKey(SshHostKeyType type) {
+  switch (type) {
+  case SshHostKeyType::Ed25519:
+    return EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519");
+  case SshHostKeyType::EcdsaP256:
+    return EVP_EC_gen("P-256");
+  case SshHostKeyType::Rsa:
+    break;
+  }
+  return EVP_RSA_gen(2048);
+}
+
+// The digest each type signs with: Ed25519 hashes internally, ECDSA P-256
+// uses SHA-256 and rsa-sha2-512 SHA-512
+const EVP_MD *signatureDigest(SshHostKeyType type) {
+  switch (type) {
+  case SshHostKeyType::Ed25519:
+    return nullptr;
+  case SshHostKeyType::EcdsaP256:
+    return EVP_sha256();
+  case SshHostKeyType::Rsa:
+    break;
+  }
+  return EVP_sha512();
+}
+
+TEST(SshHostKeyBenchmark, DISABLED_HandshakeSignature) {
+  const uint8_t exchangeHash[32] = {0x5a};
+  double rsaSignMs = 0, ed25519SignMs = 0;
+  for (const SshHostKeyInfo &info : SSH_HOST_KEYS) {
+    std::vector<double> generate;
+    EVP_PKEY *key = nullptr;
+    for (int i = 0; i < HOST_KEY_GENERATE_ROUNDS; ++i) {
+      EVP_PKEY_free(key);
+      const auto start = HostKeyClock::now();
+      key = generateHostKey(info.type);
+      generate.push_back(std::chrono::duration<double, std::milli>(
+                             HostKeyClock::now() - start)
+                             .count());
+      ASSERT_NE(key, nullptr) << info.name;
+    }
+
+    std::vector<double> sign;
+    uint8_t signature[512];
+    for (int i = 0; i < HOST_KEY_SIGN_ROUNDS; ++i) {
+      const auto start = HostKeyClock::now();
+      EVP_MD_CTX *context = EVP_MD_CTX_new();
+      size_t length = sizeof(signature);
+      ASSERT_EQ(EVP_DigestSignInit(context, nullptr,
+                                   signatureDigest(info.type), nullptr, key),
+                1);
+      ASSERT_EQ(EVP_DigestSign(context, signature, &length, exchangeHash,
+                               sizeof(exchangeHash)),
+                1);
+      EVP_MD_CTX_free(context);
+      sign.push_back(std::chrono::duration<double, std::milli>(
+                         HostKeyClock::now() - start)
+                         .count());
+    }
+    EVP_PKEY_free(key);
+
+    const double signMs = hostKeyMedian(sign);
+    std::printf("[ SSH KEX  ] %-8s generate %8.3f ms  sign %6.3f ms per "
+                "handshake (%s)\n",
+                info.name, hostKeyMedian(generate), signMs, info.algorithms);
+    if (info.type == SshHostKeyType::Rsa)
+      rsaSignMs = signMs;
+    if (info.type == SshHostKeyType::Ed25519)
+      ed25519SignMs = signMs;
+  }
+  EXPECT_LT(ed25519SignMs * 5, rsaSignMs);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
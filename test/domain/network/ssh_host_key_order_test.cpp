@@ -0,0 +1,41 @@
+#include "domain/network/ssh_host_key_order.h"
+
+#include <gtest/gtest.h>
+
+namespace jrb::wifi_serial {
+namespace {
+
+TEST(SshHostKeyOrderTest, DefaultOrderPrefersEd25519) {
+  SshHostKeyOrder order(SSH_HOST_KEY_ORDER);
+  ASSERT_EQ(order.size(), 3u);
+  EXPECT_EQ(order[0].type, SshHostKeyType::Ed25519);
+  EXPECT_EQ(order[1].type, SshHostKeyType::EcdsaP256);
+  EXPECT_EQ(order[2].type, SshHostKeyType::Rsa);
+  EXPECT_STREQ(order[0].algorithms, "ssh-ed25519");
+  EXPECT_STREQ(order[2].path, SSH_HOST_KEY_PATH); // upgraded devices keep it
+  EXPECT_EQ(order.skipped(), 0u);
+}
+
+TEST(SshHostKeyOrderTest, FollowsTheConfiguredOrder) {
+  SshHostKeyOrder order("rsa, ecdsa");
+  ASSERT_EQ(order.size(), 2u);
+  EXPECT_EQ(order[0].type, SshHostKeyType::Rsa);
+  EXPECT_EQ(order[1].type, SshHostKeyType::EcdsaP256);
+  EXPECT_STREQ(order[1].name, "ecdsa");
+}
+
+TEST(SshHostKeyOrderTest, SkipsUnknownAndRepeatedNames) {
+  SshHostKeyOrder order("dsa,ecdsa,,ecdsa,ed25519x,ed25519");
+  ASSERT_EQ(order.size(), 2u);
+  EXPECT_EQ(order[0].type, SshHostKeyType::EcdsaP256);
+  EXPECT_EQ(order[1].type, SshHostKeyType::Ed25519);
+  EXPECT_EQ(order.skipped(), 3u);
+
+  SshHostKeyOrder nothing("dsa");
+  ASSERT_EQ(nothing.size(), 1u);
+  EXPECT_EQ(nothing[0].type, SshHostKeyType::Ed25519);
+  EXPECT_EQ(SshHostKeyOrder(nullptr).size(), 1u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,206 @@
+// Serial output fanned out to 1, 2 and 4 SSH sessions.
+//
+// Mirrors SSHServer: the producer appends serial output to one
+// BroadcastRing<SSH_SESSION_BACKLOG> under a mutex (sendToSSHClients), and
+// every session thread reads it through its own cursor and writes it to its
+// client, a local socket read by a client thread. libssh isn't available
+// natively, so the channel is the bare socket; encryption cost per byte is
+// the same whatever the number of sessions.
+//
+// "flood" writes as fast as it can and reports the aggregate bytes the
+// clients received. It runs real threads for about 1 s, so it is disabled;
+// run it with --gtest_also_run_disabled_tests
+// --gtest_filter='*SshSessionFanOutBenchmark*'.
+//
+// "slow client" drives the sessions in a fixed order on one thread instead,
+// so its result doesn't depend on scheduling: after every write each session
+// forwards what its client's window takes, and one client drains its window
+// only every FANOUT_SLOW_READ_EVERY writes. That session loses output, the
+// others must lose nothing.
+#include "config.h"
+#include "infrastructure/memory/broadcast_ring.hpp"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using FanOutClock = std::chrono::steady_clock;
+using FanOutRing = BroadcastRing<SSH_SESSION_BACKLOG>;
+constexpr auto FANOUT_RUN_TIME = std::chrono::milliseconds(300);
+constexpr size_t FANOUT_WRITE_SIZE = 128;
+constexpr size_t FANOUT_READ_CHUNK_SIZE = SSH_WRITE_BATCH_SIZE;
+constexpr size_t FANOUT_SLOW_WINDOW = 4096;
+constexpr size_t FANOUT_SLOW_READ_SIZE = 512;
+constexpr int FANOUT_SLOW_READ_EVERY = 20;
+constexpr int FANOUT_SLOW_WRITES = 400;
+
+struct FanOutSession {
+  int fds[2]{-1, -1}; // session side, client side
+  size_t cursor{0};
+  size_t lost{0};
+  size_t received{0};
+};
+
+struct FanOutResult {
+  double aggregateMBps{0};
+  size_t written{0};
+  std::vector<FanOutSession> sessions;
+};
+
+// Floods count sessions, each on its own thread, for FANOUT_RUN_TIME
+FanOutResult runFanOut(int count) {
+  FanOutRing ring;
+  std::mutex outputMutex;
+  std::atomic<bool> delivering{true};
+  FanOutResult result;
+  result.sessions.resize(count);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < count; ++i) {
+    FanOutSession &session = result.sessions[i];
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, session.fds), 0);
+    session.cursor = ring.writePosition();
+    threads.emplace_back([&ring, &session, &delivering] {
+      uint8_t chunk[FANOUT_READ_CHUNK_SIZE];
+      while (delivering.load() || ring.pending(session.cursor) > 0) {
+        size_t lost = 0;
+        const size_t n =
+            ring.read(session.cursor, chunk, sizeof(chunk), lost);
+        session.lost += lost;
+        if (n == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(200));
+          continue;
+        }
+        for (size_t sent = 0; sent < n;) {
+          const ssize_t rc = write(session.fds[0], chunk + sent, n - sent);
+          if (rc <= 0)
+            return;
+          sent += static_cast<size_t>(rc);
+        }
+      }
+      shutdown(session.fds[0], SHUT_WR);
+    });
+    threads.emplace_back([&session] {
+      uint8_t buffer[4096];
+      ssize_t rc;
+      while ((rc = read(session.fds[1], buffer, sizeof(buffer))) > 0)
+        session.received += static_cast<size_t>(rc);
+    });
+  }
+
+  uint8_t line[FANOUT_WRITE_SIZE];
+  for (size_t i = 0; i < sizeof(line); ++i)
+    line[i] = static_cast<uint8_t>('a' + i % 26);
+  const auto start = FanOutClock::now();
+  while (FanOutClock::now() - start < FANOUT_RUN_TIME) {
+    {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      ring.write(line, sizeof(line));
+    }
+    result.written += sizeof(line);
+  }
+  delivering = false;
+  for (auto &thread : threads)
+    thread.join();
+  const double seconds =
+      std::chrono::duration<double>(FanOutClock::now() - start).count();
+
+  size_t received = 0;
+  for (FanOutSession &session : result.sessions) {
+    received += session.received;
+    close(session.fds[0]);
+    close(session.fds[1]);
+  }
+  result.aggregateMBps = received / seconds / (1024 * 1024);
+  return result;
+}
+
+TEST(SshSessionFanOutBenchmark, DISABLED_AggregateThroughput) {
+  for (int count : {1, 2, 4}) {
+    const FanOutResult flood = runFanOut(count);
+    size_t lost = 0;
+    for (const FanOutSession &session : flood.sessions) {
+      lost += session.lost;
+      EXPECT_EQ(session.received + session.lost, flood.written);
+    }
+    std::printf("[ SSH FAN  ] flood        %d session%s  aggregate %7.1f MB/s"
+                "  lost %5.1f%% per session\n",
+                count, count == 1 ? " " : "s", flood.aggregateMBps,
+                100.0 * lost / (count * double(flood.written)));
+  }
+}
+
+TEST(SshSessionFanOutBenchmark, SlowClientOnlyStallsItself) {
+  FanOutRing ring;
+  std::vector<FanOutSession> sessions(4);
+  std::vector<size_t> inWindow(sessions.size(), 0); // sent, not yet read
+  for (FanOutSession &session : sessions)
+    session.cursor = ring.writePosition();
+
+  // Session 0's client drains its window at a fifth of the output rate
+  const auto forward = [&](size_t i) {
+    FanOutSession &session = sessions[i];
+    uint8_t chunk[FANOUT_READ_CHUNK_SIZE];
+    size_t room = i == 0 ? FANOUT_SLOW_WINDOW - inWindow[i] : sizeof(chunk);
+    while (room > 0) {
+      size_t lost = 0;
+      const size_t n = ring.read(session.cursor, chunk,
+                                 std::min(room, sizeof(chunk)), lost);
+      session.lost += lost;
+      if (n == 0)
+        break;
+      if (i == 0) {
+        inWindow[i] += n;
+        room -= n;
+      } else {
+        session.received += n;
+      }
+    }
+  };
+  const auto drainWindow = [&](size_t bytes) {
+    const size_t n = std::min(bytes, inWindow[0]);
+    inWindow[0] -= n;
+    sessions[0].received += n;
+  };
+
+  uint8_t line[FANOUT_WRITE_SIZE];
+  for (size_t i = 0; i < sizeof(line); ++i)
+    line[i] = static_cast<uint8_t>('a' + i % 26);
+  size_t written = 0;
+  for (int w = 0; w < FANOUT_SLOW_WRITES; ++w) {
+    ring.write(line, sizeof(line));
+    written += sizeof(line);
+    for (size_t i = 0; i < sessions.size(); ++i)
+      forward(i);
+    if (w % FANOUT_SLOW_READ_EVERY == 0)
+      drainWindow(FANOUT_SLOW_READ_SIZE);
+  }
+  // The slow client catches up once the output stops
+  while (ring.pending(sessions[0].cursor) > 0 || inWindow[0] > 0) {
+    drainWindow(FANOUT_SLOW_WINDOW);
+    forward(0);
+  }
+
+  std::printf("[ SSH FAN  ] slow client  4 sessions  lost %zu / %zu / %zu / "
+              "%zu of %zu bytes\n",
+              sessions[0].lost, sessions[1].lost, sessions[2].lost,
+              sessions[3].lost, written);
+  EXPECT_GT(sessions[0].lost, 0u);
+  for (size_t i = 0; i < sessions.size(); ++i)
+    EXPECT_EQ(sessions[i].received + sessions[i].lost, written) << i;
+  for (size_t i = 1; i < sessions.size(); ++i)
+    EXPECT_EQ(sessions[i].lost, 0u) << i;
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
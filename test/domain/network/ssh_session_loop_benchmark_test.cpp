@@ -0,0 +1,209 @@
+// SSH session loop: the old 10 ms polling against waiting for events.
+//
+// "polling" is the loop SSHServer used to run: a non-blocking read of the
+// client socket, then a wait of up to 10 ms for serial output (the FreeRTOS
+// queue timeout), so a keystroke sits unread for up to 10 ms and the task
+// wakes 100 times per second with nothing to do. "event" is the current
+// loop: sleep in poll() on the socket and the session's eventfd, which
+// sendToSSHClients() signals. libssh isn't available natively, so the
+// client socket is a local socketpair and ssh_event_dopoll() is plain
+// poll(); the wake-up logic is the same.
+//
+// Echo latency is measured from the client writing a keystroke to reading
+// its echo; output latency from the producer appending serial output to
+// the client reading it. Idle cost is loop passes and thread CPU time while
+// nothing happens.
+//
+// It takes about 2 s, so it is disabled; run it with
+// --gtest_also_run_disabled_tests --gtest_filter='*SshSessionLoopBenchmark*'.
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using LoopClock = std::chrono::steady_clock;
+constexpr auto POLLING_PERIOD = std::chrono::milliseconds(10);
+constexpr auto LOOP_IDLE_TIME = std::chrono::milliseconds(500);
+constexpr int LOOP_SAMPLES = 40;
+
+struct LoopResult {
+  double echoMedianMs{0};
+  double outputMedianMs{0};
+  double idleWakeupsPerSec{0};
+  double idleCpuPercent{0};
+};
+
+double threadCpuMs() {
+  timespec now{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+double loopMedian(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+/**
+ * @brief Session stand-in: echoes client bytes and forwards output bytes
+ */
+class LoopSession {
+public:
+  LoopSession(int socket, bool eventDriven)
+      : socket{socket}, eventDriven{eventDriven} {
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    pipe(outputPipe); // serial output, like the ring
+  }
+  ~LoopSession() {
+    close(wakeFd);
+    close(outputPipe[0]);
+    close(outputPipe[1]);
+  }
+
+  // Producer side (sendToSSHClients)
+  void sendOutput(uint8_t byte) {
+    write(outputPipe[1], &byte, 1);
+    if (waiting.exchange(false)) {
+      const uint64_t one = 1;
+      write(wakeFd, &one, sizeof(one));
+    }
+  }
+
+  void run() {
+    setNonBlocking(socket);
+    setNonBlocking(outputPipe[0]);
+    while (!stopping.load()) {
+      passes++;
+      cpuMs = threadCpuMs();
+      uint8_t byte;
+      bool idle = true;
+      if (read(socket, &byte, 1) == 1) {
+        write(socket, &byte, 1); // echo
+        idle = false;
+      }
+      if (read(outputPipe[0], &byte, 1) == 1) {
+        write(socket, &byte, 1);
+        idle = false;
+      }
+      if (!idle)
+        continue;
+      if (eventDriven) {
+        waiting = true;
+        pollfd fds[2] = {{socket, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+        if (!outputPending())
+          poll(fds, 2, 1000);
+        waiting = false;
+        uint64_t count;
+        read(wakeFd, &count, sizeof(count));
+      } else {
+        // xQueueReceive(..., 10 ms): returns early only for output
+        pollfd output{outputPipe[0], POLLIN, 0};
+        poll(&output, 1, POLLING_PERIOD.count());
+      }
+    }
+  }
+
+  void stop() {
+    stopping = true;
+    sendOutput('\0');
+  }
+
+  std::atomic<size_t> passes{0};
+  std::atomic<double> cpuMs{0}; // thread CPU time at the last loop pass
+
+private:
+  int socket;
+  bool eventDriven;
+  int wakeFd{-1};
+  int outputPipe[2]{-1, -1};
+  std::atomic<bool> waiting{false};
+  std::atomic<bool> stopping{false};
+
+  bool outputPending() const {
+    pollfd output{outputPipe[0], POLLIN, 0};
+    return poll(&output, 1, 0) > 0;
+  }
+
+  static void setNonBlocking(int fd) {
+    const int one = 1;
+    ioctl(fd, FIONBIO, &one);
+  }
+};
+
+LoopResult runLoop(bool eventDriven) {
+  int fds[2];
+  EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  LoopSession session(fds[0], eventDriven);
+  std::thread task([&session] { session.run(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  LoopResult result;
+  const size_t passesBefore = session.passes.load();
+  const double cpuBefore = session.cpuMs.load();
+  std::this_thread::sleep_for(LOOP_IDLE_TIME);
+  const double idleMs =
+      std::chrono::duration<double, std::milli>(LOOP_IDLE_TIME).count();
+  result.idleWakeupsPerSec =
+      (session.passes.load() - passesBefore) * 1000.0 / idleMs;
+  result.idleCpuPercent = 100.0 * (session.cpuMs.load() - cpuBefore) / idleMs;
+
+  std::vector<double> echo, output;
+  for (int i = 0; i < LOOP_SAMPLES; ++i) {
+    // Keystrokes land at arbitrary points of the polling period
+    std::this_thread::sleep_for(std::chrono::microseconds(1700 + i * 250));
+    uint8_t byte = 'k';
+    auto start = LoopClock::now();
+    write(fds[1], &byte, 1);
+    read(fds[1], &byte, 1);
+    echo.push_back(
+        std::chrono::duration<double, std::milli>(LoopClock::now() - start)
+            .count());
+
+    std::this_thread::sleep_for(std::chrono::microseconds(1300 + i * 250));
+    start = LoopClock::now();
+    session.sendOutput('o');
+    read(fds[1], &byte, 1);
+    output.push_back(
+        std::chrono::duration<double, std::milli>(LoopClock::now() - start)
+            .count());
+  }
+
+  session.stop();
+  task.join();
+  close(fds[0]);
+  close(fds[1]);
+  result.echoMedianMs = loopMedian(echo);
+  result.outputMedianMs = loopMedian(output);
+  return result;
+}
+
+TEST(SshSessionLoopBenchmark, DISABLED_PollingVersusEvents) {
+  const LoopResult polling = runLoop(false);
+  const LoopResult events = runLoop(true);
+  for (const auto &[name, result] :
+       {std::pair<const char *, const LoopResult &>{"polling", polling},
+        {"event", events}}) {
+    std::printf("[ SSH LOOP ] %-8s echo %6.3f ms  output %6.3f ms  idle "
+                "%5.1f wakeups/s %6.3f%% CPU\n",
+                name, result.echoMedianMs, result.outputMedianMs,
+                result.idleWakeupsPerSec, result.idleCpuPercent);
+  }
+  EXPECT_LT(events.echoMedianMs, polling.echoMedianMs);
+  EXPECT_LT(events.idleWakeupsPerSec, 5.0);
+  EXPECT_GT(polling.idleWakeupsPerSec, 50.0);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
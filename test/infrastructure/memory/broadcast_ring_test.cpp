@@ -0,0 +1,136 @@
+#include "infrastructure/memory/broadcast_ring.hpp"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+std::string readAll(const BroadcastRing<16> &ring, size_t &cursor,
+                    size_t &lost) {
+  uint8_t out[32];
+  size_t lostBefore = 0;
+  const size_t n = ring.read(cursor, out, sizeof(out), lostBefore);
+  lost += lostBefore;
+  return std::string(reinterpret_cast<char *>(out), n);
+}
+
+void writeText(BroadcastRing<16> &ring, const std::string &text) {
+  ring.write(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+TEST(BroadcastRingTest, EveryReaderSeesEveryByte) {
+  BroadcastRing<16> ring;
+  size_t first = ring.writePosition();
+  writeText(ring, "abc");
+  size_t second = ring.writePosition(); // attached after "abc"
+  writeText(ring, "def");
+
+  size_t lost = 0;
+  EXPECT_EQ(readAll(ring, first, lost), "abcdef");
+  EXPECT_EQ(readAll(ring, second, lost), "def");
+  EXPECT_EQ(readAll(ring, first, lost), "");
+  EXPECT_EQ(lost, 0u);
+  EXPECT_EQ(ring.pending(first), 0u);
+}
+
+TEST(BroadcastRingTest, SlowReaderLosesOnlyItsOwnBacklog) {
+  BroadcastRing<16> ring;
+  size_t fast = ring.writePosition();
+  size_t slow = ring.writePosition();
+  size_t fastLost = 0, slowLost = 0;
+
+  std::string fastText, written;
+  for (int i = 0; i < 4; ++i) {
+    writeText(ring, "0123456789");
+    written += "0123456789";
+    fastText += readAll(ring, fast, fastLost);
+  }
+  EXPECT_EQ(fastText, written);
+  EXPECT_EQ(fastLost, 0u);
+
+  EXPECT_EQ(ring.pending(slow), 40u);
+  EXPECT_EQ(readAll(ring, slow, slowLost), "4567890123456789");
+  EXPECT_EQ(slowLost, 24u);
+}
+
+TEST(BroadcastRingTest, ReplayPositionReachesBackIntoHistory) {
+  BroadcastRing<16> ring;
+  EXPECT_EQ(ring.replayPosition(8), 0u);
+  writeText(ring, "abc");
+  size_t cursor = ring.replayPosition(8); // only 3 bytes written so far
+  size_t lost = 0;
+  EXPECT_EQ(readAll(ring, cursor, lost), "abc");
+
+  writeText(ring, "defghijklmnopqrstuvwxyz");
+  cursor = ring.replayPosition(4);
+  EXPECT_EQ(readAll(ring, cursor, lost), "wxyz");
+  cursor = ring.replayPosition(1024); // no further back than the ring holds
+  EXPECT_EQ(readAll(ring, cursor, lost), "klmnopqrstuvwxyz");
+  EXPECT_EQ(lost, 0u);
+}
+
+TEST(BroadcastRingTest, OversizedWriteKeepsTheNewestBytes) {
+  BroadcastRing<16> ring;
+  size_t cursor = ring.writePosition();
+  writeText(ring, "abcdefghijklmnopqrstuvwxyz");
+  size_t lost = 0;
+  EXPECT_EQ(readAll(ring, cursor, lost), "klmnopqrstuvwxyz");
+  EXPECT_EQ(lost, 10u);
+}
+
+TEST(BroadcastRingTest, ConcurrentReadersNeverSeeTornBytes) {
+  // Byte at position p is p & 0xFF, so every reader can check each byte
+  // against its cursor
+  BroadcastRing<256> ring;
+  constexpr size_t TOTAL = 1 << 20;
+  std::atomic<bool> done{false};
+
+  auto reader = [&ring, &done](size_t &received, size_t &lost, bool &valid) {
+    size_t cursor = 0;
+    uint8_t out[96];
+    while (!done.load() || ring.pending(cursor) > 0) {
+      size_t lostBefore = 0;
+      const size_t start = cursor;
+      const size_t n = ring.read(cursor, out, sizeof(out), lostBefore);
+      const size_t first = cursor - n;
+      lost += lostBefore;
+      received += n;
+      if (start + lostBefore != first)
+        valid = false;
+      for (size_t i = 0; i < n; ++i) {
+        if (out[i] != static_cast<uint8_t>(first + i))
+          valid = false;
+      }
+    }
+  };
+
+  size_t received[3] = {}, lost[3] = {};
+  bool valid[3] = {true, true, true};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i)
+    readers.emplace_back(reader, std::ref(received[i]), std::ref(lost[i]),
+                         std::ref(valid[i]));
+
+  uint8_t chunk[37];
+  for (size_t position = 0; position < TOTAL; position += sizeof(chunk)) {
+    for (size_t i = 0; i < sizeof(chunk); ++i)
+      chunk[i] = static_cast<uint8_t>(position + i);
+    ring.write(chunk, sizeof(chunk));
+  }
+  done = true;
+  for (auto &thread : readers)
+    thread.join();
+
+  const size_t written = ring.writePosition();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(valid[i]) << i;
+    EXPECT_EQ(received[i] + lost[i], written) << i;
+  }
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,136 @@
+#include "infrastructure/memory/loss_tracking_ring.hpp"
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+namespace jrb::wifi_serial {
+namespace {
+
+types::span<const uint8_t> text(const std::string &s) {
+  return types::span<const uint8_t>(
+      reinterpret_cast<const uint8_t *>(s.data()), s.size());
+}
+
+// Reads everything, rendering each hole as "<n>"
+template <typename Ring> std::string drain(Ring &ring) {
+  std::string out;
+  uint8_t chunk[16];
+  size_t lost = 0;
+  size_t n = 0;
+  while ((n = ring.read(chunk, sizeof(chunk), lost)) > 0) {
+    if (lost > 0)
+      out += "<" + std::to_string(lost) + ">";
+    out.append(reinterpret_cast<char *>(chunk), n);
+  }
+  return out;
+}
+
+TEST(LossTrackingRingTest, NoLossReadsLikeAPlainRing) {
+  LossTrackingRing<16> ring;
+  ring.append(text("abc"));
+  ring.append('d');
+  EXPECT_EQ(drain(ring), "abcd");
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(LossTrackingRingTest, HoleReportedBeforeTheNextSurvivingByte) {
+  LossTrackingRing<8> ring;
+  ring.append(text("0123456789")); // 89 dropped
+
+  uint8_t out[4];
+  size_t lost = 0;
+  ASSERT_EQ(ring.read(out, sizeof(out), lost), 4u);
+  EXPECT_EQ(lost, 0u);
+  ring.append(text("xy"));
+
+  EXPECT_EQ(drain(ring), "4567<2>xy");
+}
+
+TEST(LossTrackingRingTest, ReadStopsAtTheHole) {
+  LossTrackingRing<8> ring;
+  ring.append(text("abcdefgh"));
+  ring.append(text("ZZ")); // dropped
+  uint8_t out[8];
+  size_t lost = 0;
+  ASSERT_EQ(ring.read(out, 3, lost), 3u);
+  ring.append(text("ij"));
+
+  // "defgh" must come back on its own so the caller can place the hole
+  ASSERT_EQ(ring.read(out, sizeof(out), lost), 5u);
+  EXPECT_EQ(lost, 0u);
+  ASSERT_EQ(ring.read(out, sizeof(out), lost), 2u);
+  EXPECT_EQ(lost, 2u);
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), 2), "ij");
+}
+
+TEST(LossTrackingRingTest, ConsecutiveDropsMergeIntoOneHole) {
+  LossTrackingRing<4> ring;
+  ring.append(text("abcd"));
+  ring.append(text("ef"));
+  ring.append('g');
+  uint8_t out[4];
+  size_t lost = 0;
+  ring.read(out, sizeof(out), lost);
+  ring.append('h');
+
+  EXPECT_EQ(drain(ring), "<3>h");
+}
+
+TEST(LossTrackingRingTest, FullGapLogKeepsCountingUntilRecorded) {
+  // The side ring holds a single record (2-byte frame + 8 bytes)
+  LossTrackingRing<4, 16> ring;
+  uint8_t out[1];
+  size_t lost = 0;
+  ring.append(text("abcd"));
+  ring.append('x');        // hole 1
+  ring.read(out, 1, lost); // a
+  ring.append('e');        // records hole 1
+  ring.append('y');        // hole 2
+  ring.read(out, 1, lost); // b, consumer now holds hole 1
+  ring.append('f');        // records hole 2
+  ring.append('z');        // hole 3
+  ring.read(out, 1, lost); // c
+  ring.append(text("gh")); // side ring full: g and h join hole 3
+
+  EXPECT_EQ(drain(ring), "d<1>e<1>f");
+  ring.append('i'); // records hole 3
+  EXPECT_EQ(drain(ring), "<3>i");
+}
+
+TEST(LossTrackingRingTest, ThreadedProducerLossesAccountForEveryByte) {
+  LossTrackingRing<64> ring;
+  constexpr size_t total = 20000;
+
+  std::thread producer([&ring] {
+    for (size_t i = 0; i < total; ++i) {
+      ring.append(static_cast<uint8_t>(i & 0xFF));
+      if (i % 32 == 0)
+        std::this_thread::yield();
+    }
+    // A trailing hole is only recorded with the next byte that fits
+    while (!ring.empty())
+      std::this_thread::yield();
+    ring.append(0);
+  });
+
+  size_t position = 0;
+  bool inOrder = true;
+  uint8_t chunk[16];
+  while (position < total) {
+    size_t lost = 0;
+    const size_t n = ring.read(chunk, sizeof(chunk), lost);
+    position += lost;
+    if (n == 0 && lost == 0)
+      std::this_thread::yield();
+    for (size_t i = 0; i < n && position < total; ++i, ++position)
+      inOrder &= chunk[i] == static_cast<uint8_t>(position & 0xFF);
+  }
+  producer.join();
+
+  EXPECT_TRUE(inOrder);
+  EXPECT_EQ(position, total);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,130 @@
+#include "infrastructure/memory/spsc_ring.hpp"
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+types::span<const uint8_t> bytes(const std::string &s) {
+  return types::span<const uint8_t>(
+      reinterpret_cast<const uint8_t *>(s.data()), s.size());
+}
+
+TEST(SpscRingTest, StartsEmpty) {
+  SpscRing<16> ring;
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(ring.size(), 0u);
+  EXPECT_EQ(ring.capacity(), 16u);
+}
+
+TEST(SpscRingTest, ReadReturnsBytesInOrder) {
+  SpscRing<16> ring;
+  ring.append(bytes("abc"));
+  ring.append('d');
+
+  uint8_t out[8];
+  ASSERT_EQ(ring.read(out, sizeof(out)), 4u);
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), 4), "abcd");
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, FullRingDropsNewBytesInsteadOfOverwriting) {
+  SpscRing<8> ring;
+  EXPECT_EQ(ring.write(bytes("0123456789").data(), 10), 8u);
+  EXPECT_EQ(ring.dropped(), 2u);
+
+  uint8_t out[8];
+  ASSERT_EQ(ring.read(out, sizeof(out)), 8u);
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), 8), "01234567");
+}
+
+TEST(SpscRingTest, WrapsAroundTheEnd) {
+  SpscRing<8> ring;
+  uint8_t out[8];
+  ring.append(bytes("abcdef"));
+  ASSERT_EQ(ring.read(out, 5), 5u);
+  ring.append(bytes("ghijkl"));
+
+  ASSERT_EQ(ring.read(out, sizeof(out)), 7u);
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), 7), "fghijkl");
+}
+
+TEST(SpscRingTest, MessagesKeepTheirBoundaries) {
+  SpscRing<32> ring;
+  ASSERT_TRUE(ring.pushMessage(bytes("one")));
+  ASSERT_TRUE(ring.pushMessage(bytes("")));
+  ASSERT_TRUE(ring.pushMessage(bytes("three")));
+
+  uint8_t out[16];
+  size_t length = 0;
+  ASSERT_TRUE(ring.popMessage(out, sizeof(out), length));
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), length), "one");
+  ASSERT_TRUE(ring.popMessage(out, sizeof(out), length));
+  EXPECT_EQ(length, 0u);
+  ASSERT_TRUE(ring.popMessage(out, sizeof(out), length));
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), length), "three");
+  EXPECT_FALSE(ring.popMessage(out, sizeof(out), length));
+}
+
+TEST(SpscRingTest, MessageThatDoesNotFitIsRejectedWhole) {
+  SpscRing<8> ring;
+  EXPECT_TRUE(ring.pushMessage(bytes("abcd"))); // 2 + 4 bytes
+  EXPECT_FALSE(ring.pushMessage(bytes("ef")));  // would need 4 more
+  EXPECT_EQ(ring.size(), 6u);
+}
+
+TEST(SpscRingTest, OversizedMessageSkippedOnPop) {
+  SpscRing<32> ring;
+  ring.pushMessage(bytes("too long for reader"));
+  ring.pushMessage(bytes("ok"));
+
+  uint8_t out[4];
+  size_t length = 0;
+  EXPECT_FALSE(ring.popMessage(out, sizeof(out), length));
+  ASSERT_TRUE(ring.popMessage(out, sizeof(out), length));
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(out), length), "ok");
+}
+
+TEST(SpscRingTest, ProducerAndConsumerThreadsSeeEveryByteInOrder) {
+  SpscRing<64> ring;
+  constexpr size_t total = 50000;
+
+  std::thread producer([&ring] {
+    size_t sent = 0;
+    while (sent < total) {
+      uint8_t chunk[7];
+      size_t n = std::min(sizeof(chunk), total - sent);
+      for (size_t i = 0; i < n; ++i)
+        chunk[i] = static_cast<uint8_t>((sent + i) & 0xFF);
+      size_t accepted = 0;
+      while (accepted < n) {
+        accepted += ring.write(chunk + accepted, n - accepted);
+        if (accepted < n)
+          std::this_thread::yield();
+      }
+      sent += n;
+    }
+  });
+
+  size_t received = 0;
+  bool inOrder = true;
+  while (received < total) {
+    uint8_t chunk[13];
+    size_t n = ring.read(chunk, sizeof(chunk));
+    if (n == 0)
+      std::this_thread::yield();
+    for (size_t i = 0; i < n; ++i)
+      inOrder &= chunk[i] == static_cast<uint8_t>((received + i) & 0xFF);
+    received += n;
+  }
+  producer.join();
+
+  EXPECT_TRUE(inOrder);
+  EXPECT_TRUE(ring.empty());
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,50 @@
+#include "infrastructure/memory/write_batch.hpp"
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace jrb::wifi_serial {
+namespace {
+
+std::string batchText(const WriteBatch<16> &batch) {
+  return std::string(reinterpret_cast<const char *>(batch.data()),
+                     batch.size());
+}
+
+TEST(WriteBatchTest, GathersAppendsAndDirectWrites) {
+  WriteBatch<16> batch;
+  EXPECT_TRUE(batch.empty());
+  EXPECT_TRUE(batch.append("ab", 2));
+  memcpy(batch.tail(), "cdef", 4);
+  batch.commit(4);
+  EXPECT_TRUE(batch.append("g", 1));
+  EXPECT_EQ(batchText(batch), "abcdefg");
+  EXPECT_EQ(batch.room(), 9u);
+
+  batch.clear();
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(batch.room(), 16u);
+}
+
+TEST(WriteBatchTest, InsertMovesLaterBytes) {
+  WriteBatch<16> batch;
+  batch.append("echo", 4);
+  batch.append("data", 4);
+  EXPECT_TRUE(batch.insert(4, "[note]", 6));
+  EXPECT_EQ(batchText(batch), "echo[note]data");
+  EXPECT_FALSE(batch.insert(20, "x", 1));
+}
+
+TEST(WriteBatchTest, OversizedAppendChangesNothing) {
+  WriteBatch<16> batch;
+  batch.append("0123456789", 10);
+  EXPECT_FALSE(batch.append("abcdefg", 7));
+  EXPECT_FALSE(batch.insert(0, "abcdefg", 7));
+  EXPECT_EQ(batchText(batch), "0123456789");
+  batch.commit(100); // clamped to the capacity
+  EXPECT_EQ(batch.size(), 16u);
+  EXPECT_EQ(batch.room(), 0u);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
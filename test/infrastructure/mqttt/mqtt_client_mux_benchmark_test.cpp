@@ -0,0 +1,137 @@
+// Publishes per second with both ports busy: framed output on the per-port
+// tx topics against the same output multiplexed onto one topic.
+//
+// Both UART sinks get a BENCH_MUX_LINE_SIZE line every BENCH_MUX_LINE_PERIOD
+// while the test thread runs MqttClient::loop() every BENCH_MUX_TASK_PERIOD
+// like the MQTT task, for BENCH_MUX_RUN_TIME against the in-memory client.
+// Both modes batch the same way (MQTT_FRAME_MIN_BYTES or
+// MQTT_FRAME_MAX_DELAY_MS) and share the publish budget; everything
+// published is decoded again to check no byte went missing.
+//
+// It takes about 2 s, so it is disabled; run it with
+// --gtest_also_run_disabled_tests --gtest_filter='*MqttClientMuxBenchmark*'.
+//
+// MqttClient template definitions come from mqtt_client_test.cpp.
+#include "domain/config/preferences_storage.h"
+#include "domain/messaging/tty_frame_decoder.h"
+#include "domain/messaging/tty_mux_decoder.h"
+#include "infrastructure/mqttt/mqtt_client.h"
+#include "infrastructure/mqttt/pub_sub_client_test.h"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using MuxBenchClock = std::chrono::steady_clock;
+constexpr size_t BENCH_MUX_LINE_SIZE = 48;
+constexpr auto BENCH_MUX_LINE_PERIOD = std::chrono::milliseconds(10);
+constexpr auto BENCH_MUX_TASK_PERIOD = std::chrono::milliseconds(5);
+constexpr auto BENCH_MUX_RUN_TIME = std::chrono::milliseconds(1000);
+
+struct MuxBenchResult {
+  double publishesPerSec{0};
+  double bytesPerPublish{0};
+  std::array<size_t, 2> delivered{}; // tty bytes per port after decoding
+  std::array<size_t, 2> written{};
+};
+
+std::string muxBenchLine(uint8_t port, int index) {
+  char prefix[16];
+  snprintf(prefix, sizeof(prefix), "tty%u %05d ", static_cast<unsigned>(port),
+           index);
+  std::string line(prefix);
+  line.resize(BENCH_MUX_LINE_SIZE - 1, '.');
+  return line + '\n';
+}
+
+MuxBenchResult runMuxBench(bool multiplexed) {
+  PubSubClientTest mqtt;
+  mqtt.reset();
+  PreferencesStorage preferencesStorage;
+  preferencesStorage.mqttFramed = true;
+  preferencesStorage.mqttMultiplex = multiplexed;
+  internal::MqttClient<PubSubClientTest> client(mqtt, preferencesStorage);
+  client.connect("bench.broker", 1883);
+
+  MuxBenchResult result;
+  MqttTxSink *sinks[] = {&client.getTty0Sink(), &client.getTty1Sink()};
+  const auto start = MuxBenchClock::now();
+  auto nextLine = start;
+  int index = 0;
+  while (MuxBenchClock::now() - start < BENCH_MUX_RUN_TIME) {
+    while (MuxBenchClock::now() >= nextLine) {
+      for (uint8_t port = 0; port < 2; ++port) {
+        const std::string line = muxBenchLine(port, index);
+        sinks[port]->append(types::span<const uint8_t>(
+            reinterpret_cast<const uint8_t *>(line.data()), line.size()));
+        result.written[port] += line.size();
+      }
+      index++;
+      nextLine += BENCH_MUX_LINE_PERIOD;
+    }
+    client.loop();
+    std::this_thread::sleep_for(BENCH_MUX_TASK_PERIOD);
+  }
+  // Let the last batch go out
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(MQTT_FRAME_MAX_DELAY_MS + 5));
+  client.loop();
+  const double seconds =
+      std::chrono::duration<double>(MuxBenchClock::now() - start).count();
+
+  TtyMuxDecoder muxDecoder;
+  TtyFrameDecoder frameDecoder;
+  const auto count = [&result](uint8_t port, const uint8_t *, size_t length) {
+    result.delivered[port] += length;
+  };
+  muxDecoder.frames().onData(count);
+  frameDecoder.onData(count);
+  size_t publishes = 0, bytes = 0;
+  const auto &topics = mqtt.getPublishedTopics();
+  const auto &payloads = mqtt.getPublishedPayloads();
+  for (size_t i = 0; i < topics.size(); ++i) {
+    const auto &payload = payloads[i];
+    if (topics[i] == client.getMuxTxTopic()) {
+      EXPECT_TRUE(muxDecoder.feed(payload.data(), payload.size()));
+    } else if (topics[i] == preferencesStorage.topicTty0Tx ||
+               topics[i] == preferencesStorage.topicTty1Tx) {
+      EXPECT_TRUE(frameDecoder.feed(payload.data(), payload.size()));
+    } else {
+      continue;
+    }
+    publishes++;
+    bytes += payload.size();
+  }
+  result.publishesPerSec = publishes / seconds;
+  result.bytesPerPublish = publishes ? double(bytes) / publishes : 0;
+  return result;
+}
+
+TEST(MqttClientMuxBenchmark, DISABLED_BothPortsBusy) {
+  const MuxBenchResult perPort = runMuxBench(false);
+  const MuxBenchResult muxed = runMuxBench(true);
+  const double kbPerSec = 2 * BENCH_MUX_LINE_SIZE * 1000.0 /
+                          BENCH_MUX_LINE_PERIOD.count() / 1024.0;
+  std::printf("[ MUX      ] 2 ports x %.1f KB/s  per-port topics %5.1f pub/s "
+              "(%4.0f B/pub)  multiplexed %5.1f pub/s (%4.0f B/pub)  "
+              "saved %4.1f%%\n",
+              kbPerSec / 2, perPort.publishesPerSec, perPort.bytesPerPublish,
+              muxed.publishesPerSec, muxed.bytesPerPublish,
+              100.0 * (1.0 - muxed.publishesPerSec / perPort.publishesPerSec));
+
+  for (size_t port = 0; port < 2; ++port) {
+    EXPECT_EQ(perPort.delivered[port], perPort.written[port]) << port;
+    EXPECT_EQ(muxed.delivered[port], muxed.written[port]) << port;
+  }
+  // Every mux publish carries what would have been two
+  EXPECT_LT(muxed.publishesPerSec, perPort.publishesPerSec * 0.6);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -1,12 +1,19 @@
-#include "domain/messaging/mqtt_flush_policy.cpp"
+// MqttFlushPolicy and MqttSpillQueue template definitions come from their
+// own test files
 #include "infrastructure/mqttt/mqtt_client.cpp"
 #include "domain/config/preferences_storage.h"
+#include "domain/messaging/tty_frame_decoder.h"
+#include "domain/messaging/tty_mux_decoder.h"
 #include "infrastructure/mqttt/pub_sub_client_test.h"
+#include "infrastructure/storage/file_system_test.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <regex>
+#include <thread>
 #include <vector>
 
 namespace jrb::wifi_serial {
@@ -106,6 +113,19 @@ protected:
     ASSERT_TRUE(mockPubSubClient.connected());
   }
 
+  // Helper: Deliver a broker message and run the main loop dispatch
+  void receive(const char *topic, const uint8_t *payload,
+               unsigned int length) {
+    mockPubSubClient.simulateMessage(topic, payload, length);
+    mqttClient->dispatchInbound();
+  }
+
+  // Helper: Topics subscribed for the two ports (rx and chunked upload)
+  std::vector<std::string> portSubscriptions() const {
+    return {preferencesStorage.topicTty0Rx, preferencesStorage.topicTty1Rx,
+            mqttClient->getUploadTopic(0), mqttClient->getUploadTopic(1)};
+  }
+
   // Helper: Verify subscription list
   void expectSubscribed(const std::vector<std::string> &expectedTopics) {
     const auto &actual = mockPubSubClient.getSubscribedTopics();
@@ -123,6 +143,45 @@ protected:
               published.end())
         << "Expected publish to topic '" << topic << "' not found";
   }
+
+  // Helper: Feed tty1 output through the UART sink and run the MQTT task
+  void sendTty1(const std::string &text) {
+    mqttClient->getTty1Sink().append(types::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(text.data()), text.size()));
+    mqttClient->loop();
+  }
+
+  // Helper: Run the MQTT task, acknowledging every replay publish, until
+  // the offline spill is empty
+  bool replayAcknowledged(int timeoutMs = 2000) {
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(timeoutMs);
+    uint16_t acked = 0;
+    while (!mqttClient->getSpillQueue().empty()) {
+      if (std::chrono::steady_clock::now() > deadline)
+        return false;
+      mqttClient->loop();
+      if (mockPubSubClient.getLastPacketId() != acked) {
+        acked = mockPubSubClient.getLastPacketId();
+        mockPubSubClient.simulatePubAck(acked);
+      } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    mqttClient->loop(); // trims the last record
+    return true;
+  }
+
+  std::string publishedTo(const std::string &topic) const {
+    std::string all;
+    const auto &topics = mockPubSubClient.getPublishedTopics();
+    const auto &payloads = mockPubSubClient.getPublishedPayloads();
+    for (size_t i = 0; i < topics.size(); ++i) {
+      if (topics[i] == topic)
+        all.append(payloads[i].begin(), payloads[i].end());
+    }
+    return all;
+  }
 };
 
 // Static member definitions
@@ -164,16 +223,10 @@ TEST_F(MqttClientTest, ConstructorLoadsTopicsFromPreferences) {
   connectAndVerify();
 
   // Should subscribe to topics from PreferencesStorage
-  expectSubscribed(
-      {preferencesStorage.topicTty0Rx, preferencesStorage.topicTty1Rx});
+  expectSubscribed(portSubscriptions());
 }
 
-TEST_F(MqttClientTest, DISABLED_CallbacksInitiallyNull) {
-  // DISABLED: This test reveals a bug in production code at mqtt_client.cpp:274-279
-  // The mqttCallback() function doesn't check for nullptr before invoking callbacks
-  // This causes a segmentation fault when callbacks are not set
-  // TODO: Fix production code to add nullptr checks before invoking callbacks
-
+TEST_F(MqttClientTest, CallbacksInitiallyNull) {
   // Create client without setting callbacks
   auto clientWithoutCallbacks =
       std::make_unique<internal::MqttClient<PubSubClientTest>>(
@@ -185,9 +238,9 @@ TEST_F(MqttClientTest, DISABLED_CallbacksInitiallyNull) {
   // Simulate message (callback is nullptr, should handle gracefully)
   const uint8_t payload[] = {0x01, 0x02, 0x03};
 
-  // Note: This crashes due to missing nullptr check in mqttCallback()
-  EXPECT_NO_THROW(mockPubSubClient.simulateMessage(
-      preferencesStorage.topicTty0Rx.c_str(), payload, sizeof(payload)));
+  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
+                                   payload, sizeof(payload));
+  EXPECT_NO_THROW(clientWithoutCallbacks->dispatchInbound());
 }
 
 // ============================================================================
@@ -243,8 +296,7 @@ TEST_P(ConnectionParametricTest, ConnectWithVariousCredentials) {
 
   if (param.expectSuccess) {
     // Should subscribe to configured topics
-    expectSubscribed(
-        {preferencesStorage.topicTty0Rx, preferencesStorage.topicTty1Rx});
+    expectSubscribed(portSubscriptions());
   }
 }
 
@@ -312,8 +364,7 @@ TEST_F(MqttClientTest, MessageToTty0RxRoutedToTty0Callback) {
 
   const uint8_t payload[] = {0x48, 0x65, 0x6C, 0x6C, 0x6F}; // "Hello"
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload, sizeof(payload));
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload, sizeof(payload));
 
   EXPECT_TRUE(tty0CallbackInvoked);
   EXPECT_FALSE(tty1CallbackInvoked);
@@ -326,8 +377,7 @@ TEST_F(MqttClientTest, MessageToTty1RxRoutedToTty1Callback) {
 
   const uint8_t payload[] = {0x57, 0x6F, 0x72, 0x6C, 0x64}; // "World"
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty1Rx.c_str(),
-                                    payload, sizeof(payload));
+  receive(preferencesStorage.topicTty1Rx.c_str(), payload, sizeof(payload));
 
   EXPECT_FALSE(tty0CallbackInvoked);
   EXPECT_TRUE(tty1CallbackInvoked);
@@ -340,20 +390,115 @@ TEST_F(MqttClientTest, UnknownTopicIgnored) {
 
   const uint8_t payload[] = {0x01, 0x02, 0x03};
 
-  mockPubSubClient.simulateMessage("unknown/topic", payload, sizeof(payload));
+  receive("unknown/topic", payload, sizeof(payload));
 
   EXPECT_FALSE(tty0CallbackInvoked);
   EXPECT_FALSE(tty1CallbackInvoked);
 }
 
+TEST_F(MqttClientTest, AddedRouteSubscribedAndDispatched) {
+  struct Received {
+    std::string topic;
+    std::string payload;
+  } received;
+  auto handler = [](void *context, const char *topic,
+                    const types::span<const uint8_t> &payload) {
+    auto *out = static_cast<Received *>(context);
+    out->topic = topic;
+    out->payload.assign(reinterpret_cast<const char *>(payload.data()),
+                        payload.size());
+  };
+  ASSERT_TRUE(mqttClient->addRoute("wifi_serial/+/fleet/#", handler,
+                                   &received));
+  EXPECT_FALSE(mqttClient->addRoute("wifi_serial/#/fleet", handler, nullptr));
+
+  connectAndVerify();
+  auto expected = portSubscriptions();
+  expected.push_back("wifi_serial/+/fleet/#");
+  expectSubscribed(expected);
+
+  const uint8_t payload[] = {'o', 'k'};
+  mockPubSubClient.simulateMessage("wifi_serial/all/fleet/reboot", payload,
+                                   sizeof(payload));
+  EXPECT_EQ(received.topic, "wifi_serial/all/fleet/reboot");
+  EXPECT_EQ(received.payload, "ok");
+  mqttClient->dispatchInbound();
+  EXPECT_FALSE(tty0CallbackInvoked);
+  EXPECT_FALSE(tty1CallbackInvoked);
+}
+
+TEST_F(MqttClientTest, ChunkedUploadReassembledIntoTty1) {
+  connectAndVerify();
+  std::string script;
+  for (int line = 0; script.size() < 3000; ++line)
+    script += "echo line " + std::to_string(line) + "\n";
+
+  const std::string &uploadTopic = mqttClient->getUploadTopic(1);
+  const std::string &statusTopic = mqttClient->getUploadStatusTopic(1);
+  EXPECT_EQ(uploadTopic, "wifi_serial/esp32c3/ttyS1/upload");
+  EXPECT_EQ(statusTopic, uploadTopic + "/status");
+
+  auto sendChunk = [&](uint32_t offset) {
+    const size_t n = std::min<size_t>(MQTT_UPLOAD_CHUNK_SIZE,
+                                      script.size() - offset);
+    std::vector<uint8_t> chunk = {
+        0, 42, static_cast<uint8_t>(offset >> 24),
+        static_cast<uint8_t>(offset >> 16), static_cast<uint8_t>(offset >> 8),
+        static_cast<uint8_t>(offset),
+        offset + n == script.size() ? MqttUploadReceiver::FLAG_FINAL
+                                    : uint8_t{0}};
+    chunk.insert(chunk.end(), script.begin() + offset,
+                 script.begin() + offset + n);
+    mockPubSubClient.simulateMessage(uploadTopic.c_str(), chunk.data(),
+                                     chunk.size());
+    return offset + static_cast<uint32_t>(n);
+  };
+  auto lastAck = [&]() {
+    const auto &topics = mockPubSubClient.getPublishedTopics();
+    for (size_t i = topics.size(); i-- > 0;) {
+      if (topics[i] == statusTopic) {
+        const auto &payload = mockPubSubClient.getPublishedPayloads()[i];
+        return std::string(payload.begin(), payload.end());
+      }
+    }
+    return std::string();
+  };
+
+  // Sender pushes chunks until the device reports busy, then resumes from
+  // the acked offset once the main loop has written to the UART
+  uint32_t offset = 0;
+  bool sawBusy = false;
+  for (int round = 0; round < 50 && lastAck().find("done") ==
+                                        std::string::npos;
+       ++round) {
+    uint32_t next = offset;
+    for (int i = 0; i < 4 && next < script.size(); ++i)
+      next = sendChunk(next);
+    mqttClient->loop();
+    const std::string ack = lastAck();
+    sawBusy |= ack.find("\"busy\"") != std::string::npos;
+    unsigned long acked = 0;
+    ASSERT_EQ(sscanf(ack.c_str(), "{\"id\":42,\"offset\":%lu", &acked), 1)
+        << ack;
+    offset = static_cast<uint32_t>(acked);
+    mqttClient->dispatchInbound();
+  }
+
+  EXPECT_TRUE(sawBusy); // 4 chunks overrun the rx ring
+  EXPECT_NE(lastAck().find("\"status\":\"done\""), std::string::npos);
+  EXPECT_EQ(std::string(tty1ReceivedData.begin(), tty1ReceivedData.end()),
+            script);
+  EXPECT_TRUE(tty0ReceivedData.empty());
+}
+
 TEST_F(MqttClientTest, OversizedPayloadDropped) {
   connectAndVerify();
 
   // Create payload > 512 bytes (MQTT_CALLBACK_BUFFER_SIZE)
   std::vector<uint8_t> largePayload(513, 0xFF);
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    largePayload.data(), largePayload.size());
+  receive(preferencesStorage.topicTty0Rx.c_str(),
+           largePayload.data(), largePayload.size());
 
   // Should be dropped silently
   EXPECT_FALSE(tty0CallbackInvoked);
@@ -365,8 +510,8 @@ TEST_F(MqttClientTest, MaxSizePayloadAccepted) {
   // Exactly 511 bytes (just under the 512 limit)
   std::vector<uint8_t> maxPayload(511, 0xAA);
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    maxPayload.data(), maxPayload.size());
+  receive(preferencesStorage.topicTty0Rx.c_str(),
+           maxPayload.data(), maxPayload.size());
 
   EXPECT_TRUE(tty0CallbackInvoked);
   EXPECT_EQ(tty0ReceivedData, maxPayload);
@@ -377,8 +522,7 @@ TEST_F(MqttClientTest, EmptyPayloadAccepted) {
 
   const uint8_t payload[] = {};
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload, 0);
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload, 0);
 
   EXPECT_TRUE(tty0CallbackInvoked);
   EXPECT_TRUE(tty0ReceivedData.empty());
@@ -390,11 +534,9 @@ TEST_F(MqttClientTest, MultipleMessagesToSameTopic) {
   const uint8_t payload1[] = {0x01};
   const uint8_t payload2[] = {0x02};
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload1, sizeof(payload1));
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload1, sizeof(payload1));
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload2, sizeof(payload2));
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload2, sizeof(payload2));
 
   // Both should be received (concatenated in our tracking vector)
   EXPECT_TRUE(tty0CallbackInvoked);
@@ -409,11 +551,9 @@ TEST_F(MqttClientTest, MessagesToDifferentTopics) {
   const uint8_t payload0[] = {0xAA};
   const uint8_t payload1[] = {0xBB};
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload0, sizeof(payload0));
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload0, sizeof(payload0));
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty1Rx.c_str(),
-                                    payload1, sizeof(payload1));
+  receive(preferencesStorage.topicTty1Rx.c_str(), payload1, sizeof(payload1));
 
   EXPECT_TRUE(tty0CallbackInvoked);
   EXPECT_TRUE(tty1CallbackInvoked);
@@ -446,8 +586,7 @@ TEST_F(MqttClientTest, ConnectSubscribesToTty1RxTopic) {
 TEST_F(MqttClientTest, ConnectSubscribesToBothTopics) {
   connectAndVerify();
 
-  expectSubscribed(
-      {preferencesStorage.topicTty0Rx, preferencesStorage.topicTty1Rx});
+  expectSubscribed(portSubscriptions());
 }
 
 TEST_F(MqttClientTest, InfoTopicGeneratedFromTty0Rx) {
@@ -514,6 +653,18 @@ TEST_F(MqttClientTest, PublishInfoWhenConnected) {
   EXPECT_GT(published.size(), 0);
 }
 
+TEST_F(MqttClientTest, PublishInfoDeltaGoesToDeltaSubtopic) {
+  connectAndVerify();
+
+  EXPECT_TRUE(mqttClient->publishInfoDelta("{\"rssi\":-61}"));
+  ASSERT_TRUE(mqttClient->publishInfo("{}"));
+
+  const auto &published = mockPubSubClient.getPublishedTopics();
+  ASSERT_EQ(published.size(), 2u);
+  EXPECT_EQ(published[0], published[1] + "/delta");
+  EXPECT_EQ(publishedTo(published[0]), "{\"rssi\":-61}");
+}
+
 TEST_F(MqttClientTest, PublishInfoWhenDisconnectedFails) {
   // Don't connect
   types::string infoData = "System info";
@@ -596,7 +747,7 @@ TEST_F(MqttClientTest, LoopWhenDisconnectedReturnsEarly) {
   // Don't connect
   EXPECT_FALSE(mqttClient->isConnected());
 
-  // Should return early, not crash
+  // Should drive the client and return early, not crash
   EXPECT_NO_THROW(mqttClient->loop());
 }
 
@@ -623,6 +774,514 @@ TEST_F(MqttClientTest, GetTty1StreamReturnsValidReference) {
   EXPECT_NO_THROW(stream.append(0x43));
 }
 
+TEST_F(MqttClientTest, StreamsInactiveUntilConnected) {
+  EXPECT_FALSE(mqttClient->getTty0Stream().active());
+  EXPECT_FALSE(mqttClient->getTty1Stream().active());
+
+  connectAndVerify();
+
+  EXPECT_TRUE(mqttClient->getTty0Stream().active());
+  EXPECT_TRUE(mqttClient->getTty1Stream().active());
+}
+
+TEST_F(MqttClientTest, LoopPublishesLinesFromUartSink) {
+  connectAndVerify();
+
+  const uint8_t line[] = {'o', 'k', '\n'};
+  mqttClient->getTty1Sink().append(
+      types::span<const uint8_t>(line, sizeof(line)));
+  EXPECT_TRUE(mockPubSubClient.getPublishedTopics().empty());
+
+  mqttClient->loop();
+
+  expectPublishedTo(preferencesStorage.topicTty1Tx);
+  EXPECT_TRUE(mqttClient->getTty1Sink().empty());
+}
+
+TEST_F(MqttClientTest, UartSinkRetainedWhileOffline) {
+  const uint8_t line[] = {'u', 'p', '\n'};
+  mqttClient->getTty0Sink().append(
+      types::span<const uint8_t>(line, sizeof(line)));
+
+  mqttClient->loop(); // offline: moved into the stream's backlog
+  EXPECT_TRUE(mqttClient->getTty0Sink().empty());
+  EXPECT_TRUE(mockPubSubClient.getPublishedTopics().empty());
+
+  connectAndVerify();
+
+  expectPublishedTo(preferencesStorage.topicTty0Tx);
+}
+
+TEST_F(MqttClientTest, InboundPayloadWaitsForDispatch) {
+  connectAndVerify();
+
+  const uint8_t payload[] = {'l', 's'};
+  mockPubSubClient.simulateMessage(preferencesStorage.topicTty1Rx.c_str(),
+                                   payload, sizeof(payload));
+  EXPECT_FALSE(tty1CallbackInvoked); // still in the MQTT task's ring
+
+  mqttClient->dispatchInbound();
+
+  EXPECT_TRUE(tty1CallbackInvoked);
+  EXPECT_EQ(tty1ReceivedData, std::vector<uint8_t>({'l', 's'}));
+}
+
+TEST_F(MqttClientTest, FramedPublishesExposeDroppedUartBytes) {
+  preferencesStorage.mqttFramed = true;
+  connectAndVerify();
+
+  // Overrun the UART sink by 100 bytes before the MQTT task gets to run
+  std::vector<uint8_t> burst(MQTT_TX_RING_SIZE + 100, 'x');
+  mqttClient->getTty1Sink().append(
+      types::span<const uint8_t>(burst.data(), burst.size()));
+  mqttClient->loop();
+  const uint8_t tail[] = {'e', 'n', 'd', '\n'};
+  mqttClient->getTty1Sink().append(
+      types::span<const uint8_t>(tail, sizeof(tail)));
+  mqttClient->loop();
+  mqttClient->getTty1Stream().flush();
+
+  TtyFrameDecoder decoder;
+  std::string received;
+  std::vector<std::pair<uint32_t, uint32_t>> gaps;
+  decoder.onData([&received](uint8_t port, const uint8_t *data, size_t len) {
+    EXPECT_EQ(port, 1);
+    received.append(reinterpret_cast<const char *>(data), len);
+  });
+  decoder.onGap([&gaps](uint8_t, uint32_t offset, uint32_t length) {
+    gaps.emplace_back(offset, length);
+  });
+  const auto &topics = mockPubSubClient.getPublishedTopics();
+  const auto &payloads = mockPubSubClient.getPublishedPayloads();
+  for (size_t i = 0; i < topics.size(); ++i) {
+    if (topics[i] == preferencesStorage.topicTty1Tx) {
+      EXPECT_TRUE(decoder.feed(payloads[i].data(), payloads[i].size()));
+    }
+  }
+
+  ASSERT_EQ(gaps.size(), 1u);
+  EXPECT_EQ(gaps[0].first, static_cast<uint32_t>(MQTT_TX_RING_SIZE));
+  EXPECT_EQ(gaps[0].second, 100u);
+  EXPECT_EQ(received, std::string(MQTT_TX_RING_SIZE, 'x') + "end\n");
+}
+
+TEST_F(MqttClientTest, FramedModeBatchesLines) {
+  preferencesStorage.mqttFramed = true;
+  connectAndVerify();
+  mockPubSubClient.reset();
+  mockPubSubClient.setConnected(true);
+
+  const uint8_t lines[] = {'a', '\n', 'b', '\n'};
+  mqttClient->getTty0Sink().append(
+      types::span<const uint8_t>(lines, sizeof(lines)));
+  mqttClient->loop();
+  EXPECT_TRUE(mockPubSubClient.getPublishedTopics().empty());
+
+  std::vector<uint8_t> bulk(MQTT_FRAME_MIN_BYTES, 'z');
+  mqttClient->getTty0Sink().append(
+      types::span<const uint8_t>(bulk.data(), bulk.size()));
+  mqttClient->loop();
+
+  ASSERT_EQ(mockPubSubClient.getPublishedPayloads().size(), 1u);
+  EXPECT_EQ(mockPubSubClient.getPublishedPayloads()[0].size(),
+            tty_frame::HEADER_SIZE + sizeof(lines) + bulk.size());
+}
+
+TEST_F(MqttClientTest, RetainedOutputReplayedOnConnect) {
+  const uint8_t data[] = {'b', 'o', 'o', 't', '\n'};
+  mqttClient->getTty1Stream().retain(
+      types::span<const uint8_t>(data, sizeof(data)));
+  EXPECT_TRUE(mockPubSubClient.getPublishedTopics().empty());
+
+  connectAndVerify();
+
+  expectPublishedTo(preferencesStorage.topicTty1Tx);
+}
+
+TEST_F(MqttClientTest, OfflineOutputSpilledAndReplayedInOrder) {
+  FileSystemTest::reset();
+  ASSERT_TRUE(mqttClient->setupSpill());
+  connectAndVerify();
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+
+  std::string offline;
+  for (int i = 0; i < 40; ++i) {
+    const std::string line = "offline " + std::to_string(i) + "\n";
+    offline += line;
+    sendTty1(line);
+  }
+  EXPECT_TRUE(publishedTo(preferencesStorage.topicTty1Tx).empty());
+  EXPECT_EQ(mqttClient->getSpillQueue().size(), offline.size());
+
+  // Output produced while the replay runs queues behind it
+  mockPubSubClient.setConnected(true);
+  sendTty1("live\n");
+  ASSERT_TRUE(replayAcknowledged());
+  sendTty1("after\n");
+
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty1Tx),
+            offline + "live\nafter\n");
+  EXPECT_EQ(FileSystemTest::fileCount(), 0u);
+}
+
+TEST_F(MqttClientTest, SpillRecordKeptUntilBrokerAcknowledges) {
+  FileSystemTest::reset();
+  ASSERT_TRUE(mqttClient->setupSpill());
+  connectAndVerify();
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+  sendTty1("precious\n");
+
+  mockPubSubClient.setConnected(true);
+  for (int i = 0; i < 5; ++i)
+    mqttClient->loop();
+  ASSERT_EQ(publishedTo(preferencesStorage.topicTty1Tx), "precious\n");
+  EXPECT_FALSE(mqttClient->getSpillQueue().empty());
+
+  // Dropped before the PUBACK: the record goes out again
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+  mockPubSubClient.setConnected(true);
+  ASSERT_TRUE(replayAcknowledged());
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty1Tx),
+            "precious\nprecious\n");
+}
+
+TEST_F(MqttClientTest, AcknowledgedTtyOutputHeldUntilPubAck) {
+  preferencesStorage.mqttInflight = 2;
+  connectAndVerify();
+  const std::string &topic = preferencesStorage.topicTty1Tx;
+
+  sendTty1("one\ntwo\nthree\n");
+  EXPECT_EQ(publishedTo(topic), "one\ntwo\n"); // window full
+  EXPECT_EQ(mqttClient->getTty1Stream().buffered(), 14u);
+
+  mockPubSubClient.simulatePubAck(mockPubSubClient.getLastPacketId() - 1);
+  mqttClient->loop();
+  EXPECT_EQ(publishedTo(topic), "one\ntwo\nthree\n");
+  EXPECT_EQ(mqttClient->getTty1Stream().buffered(), 10u);
+}
+
+TEST_F(MqttClientTest, UnacknowledgedTtyOutputRepublishedAfterReconnect) {
+  preferencesStorage.mqttInflight = 4;
+  connectAndVerify();
+  sendTty1("one\n");
+  mockPubSubClient.simulatePubAck(mockPubSubClient.getLastPacketId());
+  sendTty1("two\n");
+
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+  mockPubSubClient.setConnected(true);
+  mqttClient->loop();
+
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty1Tx), "one\ntwo\ntwo\n");
+}
+
+TEST_F(MqttClientTest, CompressedResendAfterReconnectDecodesExactly) {
+  preferencesStorage.mqttFramed = true;
+  preferencesStorage.mqttCompressed = true;
+  preferencesStorage.mqttInflight = 4;
+  connectAndVerify();
+  std::string expected;
+  auto send = [this, &expected](const std::string &text) {
+    expected += text;
+    sendTty1(text);
+    mqttClient->getTty1Stream().flush();
+  };
+  send("[  OK  ] Started Journal Service.\n");
+  mockPubSubClient.simulatePubAck(mockPubSubClient.getLastPacketId());
+  send("[  OK  ] Started Network Service.\n");
+  send("[  OK  ] Started Login Service.\n");
+
+  // Two chunks unacknowledged when the connection drops; more output
+  // arrives while offline and goes out with the resend
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+  send("[  OK  ] Started Time Service.\n");
+  mockPubSubClient.setConnected(true);
+  mqttClient->loop();
+  mqttClient->getTty1Stream().flush();
+  for (int i = 0; i < 4; ++i) {
+    mockPubSubClient.simulatePubAck(mockPubSubClient.getLastPacketId());
+    mqttClient->loop();
+  }
+  send("[  OK  ] Started Cron Service.\n");
+
+  TtyFrameDecoder decoder;
+  std::string received;
+  decoder.onData([&received](uint8_t, const uint8_t *data, size_t len) {
+    received.append(reinterpret_cast<const char *>(data), len);
+  });
+  const auto &topics = mockPubSubClient.getPublishedTopics();
+  const auto &payloads = mockPubSubClient.getPublishedPayloads();
+  for (size_t i = 0; i < topics.size(); ++i) {
+    if (topics[i] == preferencesStorage.topicTty1Tx) {
+      EXPECT_TRUE(decoder.feed(payloads[i].data(), payloads[i].size()));
+    }
+  }
+  EXPECT_GT(decoder.stats().duplicateBytes, 0u); // something was resent
+  EXPECT_GT(decoder.stats().compressedBytes, 0u);
+  EXPECT_EQ(decoder.stats().gaps, 0u);
+  EXPECT_EQ(decoder.stats().undecodable, 0u);
+  EXPECT_EQ(received, expected);
+}
+
+TEST_F(MqttClientTest, AcknowledgedOutputBacksUpInSinkWhenStreamIsFull) {
+  preferencesStorage.mqttInflight = 1;
+  connectAndVerify();
+  std::string expected;
+  for (int i = 0; i < 20; ++i)
+    expected += std::string(60, 'a' + i) + "...\n"; // 1280 bytes
+  sendTty1(expected);
+  EXPECT_EQ(mqttClient->getTty1Stream().buffered(), MQTT_BUFFER_SIZE);
+  EXPECT_EQ(mqttClient->getTty1Sink().size(), 1280u - MQTT_BUFFER_SIZE);
+
+  for (int i = 0; i < 10; ++i) {
+    mockPubSubClient.simulatePubAck(mockPubSubClient.getLastPacketId());
+    mqttClient->loop();
+  }
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty1Tx), expected);
+}
+
+TEST_F(MqttClientTest, CrashLoopOutputCoalescedWhenOverBudget) {
+  connectAndVerify();
+  const size_t before = mockPubSubClient.getPublishedTopics().size();
+  std::string expected;
+  for (int i = 0; i < 90; ++i)
+    expected += "panic " + std::to_string(i) + "\n";
+  sendTty1(expected);
+
+  // The info document still gets through the flood
+  EXPECT_TRUE(mqttClient->publishInfo("{\"uptimeSec\":1}"));
+
+  // Info's token came out of the bulk reserve: two refills until bulk can
+  // spend again
+  std::this_thread::sleep_for(std::chrono::milliseconds(110));
+  mqttClient->loop();
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty1Tx), expected);
+  // Bulk spends its share of the burst, then the rest leaves in one publish
+  const size_t publishes =
+      mockPubSubClient.getPublishedTopics().size() - before;
+  EXPECT_EQ(publishes, MQTT_PUBLISH_BURST / 2 + 1u + 1u);
+  EXPECT_EQ(mqttClient->getPublishBudget().deferred(),
+            90u - MQTT_PUBLISH_BURST / 2);
+  EXPECT_EQ(mqttClient->getPublishBudget().dropped(), 0u);
+}
+
+TEST_F(MqttClientTest, InfoDroppedOnceBudgetIsExhausted) {
+  connectAndVerify();
+  int published = 0;
+  for (int i = 0; i < MQTT_PUBLISH_BURST; ++i)
+    published += mqttClient->publishInfo("{}") ? 1 : 0;
+
+  // Info leaves a tenth of the burst for control messages
+  EXPECT_EQ(published, MQTT_PUBLISH_BURST - MQTT_PUBLISH_BURST / 10);
+  EXPECT_EQ(mqttClient->getPublishBudget().dropped(),
+            static_cast<uint32_t>(MQTT_PUBLISH_BURST / 10));
+}
+
+TEST_F(MqttClientTest, JsonRecordsCarryUartArrivalTimes) {
+  preferencesStorage.mqttJson = true;
+  connectAndVerify();
+  const unsigned long start = millis();
+  const std::string first = "boot\n", second = "ready\n";
+  mqttClient->getTty1Sink().append(types::span<const uint8_t>(
+      reinterpret_cast<const uint8_t *>(first.data()), first.size()));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  mqttClient->getTty1Sink().append(types::span<const uint8_t>(
+      reinterpret_cast<const uint8_t *>(second.data()), second.size()));
+  // Both lines reach the stream in one loop; the batch leaves once the
+  // first has waited MQTT_FRAME_MAX_DELAY_MS
+  mqttClient->loop();
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(MQTT_FRAME_MAX_DELAY_MS + 5));
+  mqttClient->loop();
+
+  const std::string payload = publishedTo(preferencesStorage.topicTty1Tx);
+  const std::regex record("\\{\"ts\":(\\d+),\"port\":1,\"seq\":(\\d+),"
+                          "\"line\":\"(\\w+)\"\\}");
+  std::vector<std::smatch> records(
+      std::sregex_iterator(payload.begin(), payload.end(), record),
+      std::sregex_iterator());
+  ASSERT_EQ(records.size(), 2u) << payload;
+  EXPECT_EQ(payload.front(), '[');
+  EXPECT_EQ(records[0][3], "boot");
+  EXPECT_EQ(records[0][2], "0");
+  EXPECT_EQ(records[1][3], "ready");
+  EXPECT_EQ(records[1][2], "5");
+  const unsigned long bootTs = std::stoul(records[0][1]);
+  const unsigned long readyTs = std::stoul(records[1][1]);
+  EXPECT_LE(bootTs - start, 5u);
+  EXPECT_GE(readyTs - bootTs, 30u);
+}
+
+TEST_F(MqttClientTest, JsonSpillReplayKeepsArrivalTimes) {
+  preferencesStorage.mqttJson = true;
+  FileSystemTest::reset();
+  ASSERT_TRUE(mqttClient->setupSpill());
+  connectAndVerify();
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+
+  const unsigned long start = millis();
+  sendTty1("boot\n");
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  sendTty1("ready\n");
+  // Replayed well after the lines arrived
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  mockPubSubClient.setConnected(true);
+  ASSERT_TRUE(replayAcknowledged());
+
+  const std::string payload = publishedTo(preferencesStorage.topicTty1Tx);
+  const std::regex record("\\{\"ts\":(\\d+),\"port\":1,\"seq\":(\\d+),"
+                          "\"line\":\"(\\w+)\"\\}");
+  std::vector<std::smatch> records(
+      std::sregex_iterator(payload.begin(), payload.end(), record),
+      std::sregex_iterator());
+  ASSERT_EQ(records.size(), 2u) << payload;
+  EXPECT_EQ(records[0][3], "boot");
+  EXPECT_EQ(records[1][3], "ready");
+  const unsigned long bootTs = std::stoul(records[0][1]);
+  const unsigned long readyTs = std::stoul(records[1][1]);
+  EXPECT_LE(bootTs - start, 5u);
+  EXPECT_GE(readyTs - bootTs, 30u);
+  EXPECT_LT(readyTs - start, 55u);
+}
+
+TEST_F(MqttClientTest, MultiplexedOutputCarriesBothPortsInOnePublish) {
+  // Routing is fixed when the client is created
+  preferencesStorage.mqttMultiplex = true;
+  mqttClient = std::make_unique<internal::MqttClient<PubSubClientTest>>(
+      mockPubSubClient, preferencesStorage);
+  connectAndVerify();
+  const std::string &muxTx = mqttClient->getMuxTxTopic();
+  ASSERT_GT(muxTx.size(), 7u);
+  EXPECT_EQ(muxTx.substr(muxTx.size() - 7), "/mux/tx");
+  EXPECT_EQ(mqttClient->getMuxRxTopic(),
+            muxTx.substr(0, muxTx.size() - 3) + "/rx");
+  expectSubscribed({mqttClient->getMuxRxTopic(), mqttClient->getUploadTopic(0),
+                    mqttClient->getUploadTopic(1)});
+
+  const std::string boot = "boot\n", login = "login: ";
+  mqttClient->getTty0Sink().append(types::span<const uint8_t>(
+      reinterpret_cast<const uint8_t *>(boot.data()), boot.size()));
+  sendTty1(login);
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(MQTT_FRAME_MAX_DELAY_MS + 5));
+  mqttClient->loop();
+
+  const auto &topics = mockPubSubClient.getPublishedTopics();
+  ASSERT_EQ(std::count(topics.begin(), topics.end(), muxTx), 1);
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty0Tx), "");
+  EXPECT_EQ(publishedTo(preferencesStorage.topicTty1Tx), "");
+  TtyMuxDecoder decoder;
+  std::array<std::string, 2> streams;
+  decoder.frames().onData(
+      [&streams](uint8_t port, const uint8_t *data, size_t length) {
+        streams[port].append(reinterpret_cast<const char *>(data), length);
+      });
+  const auto &payload = mockPubSubClient.getPublishedPayloads().back();
+  ASSERT_TRUE(decoder.feed(payload.data(), payload.size()));
+  EXPECT_EQ(streams[0], boot);
+  EXPECT_EQ(streams[1], login);
+}
+
+TEST_F(MqttClientTest, MuxRxDemultiplexesIntoPorts) {
+  preferencesStorage.mqttMultiplex = true;
+  mqttClient = std::make_unique<internal::MqttClient<PubSubClientTest>>(
+      mockPubSubClient, preferencesStorage);
+  mqttClient->setCallbacks(tty0Callback, tty1Callback);
+  connectAndVerify();
+
+  std::array<uint8_t, 64> buffer{};
+  tty_mux::Writer writer(buffer.data(), buffer.size());
+  const std::string ls = "ls\n", reboot = "reboot\n";
+  writer.append(1, reinterpret_cast<const uint8_t *>(reboot.data()),
+                reboot.size());
+  writer.append(0, reinterpret_cast<const uint8_t *>(ls.data()), ls.size());
+  writer.append(7, buffer.data(), 1); // no such port
+  receive(mqttClient->getMuxRxTopic().c_str(), writer.data(),
+          static_cast<unsigned int>(writer.size()));
+
+  EXPECT_EQ(std::string(tty0ReceivedData.begin(), tty0ReceivedData.end()), ls);
+  EXPECT_EQ(std::string(tty1ReceivedData.begin(), tty1ReceivedData.end()),
+            reboot);
+}
+
+TEST_F(MqttClientTest, FramedSpillReplayDecodesWithoutGaps) {
+  preferencesStorage.mqttFramed = true;
+  preferencesStorage.mqttCompressed = true;
+  FileSystemTest::reset();
+  ASSERT_TRUE(mqttClient->setupSpill());
+  connectAndVerify();
+  sendTty1("online\n");
+  mqttClient->getTty1Stream().flush();
+  mockPubSubClient.setConnected(false);
+  mqttClient->loop();
+
+  std::string expected = "online\n";
+  for (int i = 0; i < 200; ++i) {
+    const std::string line = "[  " + std::to_string(i) + "] offline\n";
+    expected += line;
+    sendTty1(line);
+  }
+  mockPubSubClient.setConnected(true);
+  ASSERT_TRUE(replayAcknowledged());
+
+  TtyFrameDecoder decoder;
+  std::string received;
+  decoder.onData([&received](uint8_t, const uint8_t *data, size_t len) {
+    received.append(reinterpret_cast<const char *>(data), len);
+  });
+  const auto &topics = mockPubSubClient.getPublishedTopics();
+  const auto &payloads = mockPubSubClient.getPublishedPayloads();
+  for (size_t i = 0; i < topics.size(); ++i) {
+    if (topics[i] == preferencesStorage.topicTty1Tx) {
+      EXPECT_TRUE(decoder.feed(payloads[i].data(), payloads[i].size()));
+    }
+  }
+  EXPECT_EQ(decoder.stats().gaps, 0u);
+  EXPECT_EQ(decoder.stats().undecodable, 0u);
+  EXPECT_EQ(received, expected);
+}
+
+TEST_F(MqttClientTest, SnapshotTopicSitsNextToTxTopic) {
+  const std::string tx = preferencesStorage.topicTty1Tx;
+  ASSERT_EQ(tx.substr(tx.size() - 3), "/tx");
+  EXPECT_EQ(mqttClient->getSnapshotTopic(1),
+            tx.substr(0, tx.size() - 3) + "/snapshot");
+}
+
+TEST_F(MqttClientTest, SnapshotRetainedWhenDirtyAtMostEveryInterval) {
+  preferencesStorage.mqttSnapshotInterval = 1;
+  mqttClient = std::make_unique<internal::MqttClient<PubSubClientTest>>(
+      mockPubSubClient, preferencesStorage);
+  connectAndVerify();
+  const std::string topic = mqttClient->getSnapshotTopic(1);
+
+  sendTty1("boot\n");
+  EXPECT_TRUE(publishedTo(topic).empty()); // first one waits an interval too
+  advanceMillis(1010);
+  sendTty1("login: ");
+  ASSERT_EQ(publishedTo(topic), "boot\nlogin: ");
+  const auto &topics = mockPubSubClient.getPublishedTopics();
+  const size_t index = std::find(topics.begin(), topics.end(), topic) -
+                       topics.begin();
+  EXPECT_TRUE(mockPubSubClient.getPublishedRetained()[index]);
+
+  // Dirty again, but the interval hasn't passed
+  sendTty1("root\n");
+  EXPECT_EQ(publishedTo(topic), "boot\nlogin: ");
+
+  // Interval passed but nothing new: nothing to refresh
+  advanceMillis(1010);
+  mqttClient->loop();
+  EXPECT_EQ(publishedTo(topic), "boot\nlogin: boot\nlogin: root\n");
+  mqttClient->loop();
+  EXPECT_EQ(publishedTo(topic), "boot\nlogin: boot\nlogin: root\n");
+}
+
 // ============================================================================
 // GROUP 7: Connection State Management Tests (Part 1)
 // ============================================================================
@@ -641,12 +1300,7 @@ TEST_F(MqttClientTest, SetConnectedUpdatesState) {
   EXPECT_FALSE(mqttClient->isConnected());
 }
 
-TEST_F(MqttClientTest, DISABLED_LoopDetectsConnectionLoss) {
-  // DISABLED: Design limitation - loop() returns early at line 190-191 when
-  // mqttClient.connected() is false, preventing state sync
-  // The early return prevents detecting connection loss after it occurs
-  // Connection state must be synced via reconnect() or next successful loop()
-
+TEST_F(MqttClientTest, LoopDetectsConnectionLoss) {
   connectAndVerify();
 
   // Simulate connection loss at underlying client level
@@ -658,10 +1312,7 @@ TEST_F(MqttClientTest, DISABLED_LoopDetectsConnectionLoss) {
   EXPECT_FALSE(mqttClient->isConnected());
 }
 
-TEST_F(MqttClientTest, DISABLED_LoopDetectsReconnection) {
-  // DISABLED: Same design limitation as LoopDetectsConnectionLoss
-  // Once disconnected, loop() returns early and can't detect reconnection
-
+TEST_F(MqttClientTest, LoopDetectsReconnection) {
   // Start connected
   connectAndVerify();
 
@@ -681,13 +1332,10 @@ TEST_F(MqttClientTest, DISABLED_LoopDetectsReconnection) {
   EXPECT_TRUE(mqttClient->isConnected());
 
   // Should resubscribe to topics
-  expectSubscribed(
-      {preferencesStorage.topicTty0Rx, preferencesStorage.topicTty1Rx});
+  expectSubscribed(portSubscriptions());
 }
 
-TEST_F(MqttClientTest, DISABLED_ReconnectionResubscribesToTopics) {
-  // DISABLED: Same design limitation as LoopDetectsConnectionLoss
-
+TEST_F(MqttClientTest, ReconnectionResubscribesToTopics) {
   connectAndVerify();
 
   // Clear subscriptions
@@ -700,8 +1348,7 @@ TEST_F(MqttClientTest, DISABLED_ReconnectionResubscribesToTopics) {
   mqttClient->loop();
 
   // Verify resubscription
-  expectSubscribed(
-      {preferencesStorage.topicTty0Rx, preferencesStorage.topicTty1Rx});
+  expectSubscribed(portSubscriptions());
 }
 
 // ============================================================================
@@ -714,8 +1361,7 @@ TEST_F(MqttClientTest, SetCallbacksRegistersCallbacks) {
 
   const uint8_t payload[] = {0x99};
 
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload, sizeof(payload));
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload, sizeof(payload));
 
   EXPECT_TRUE(tty0CallbackInvoked);
 }
@@ -733,18 +1379,13 @@ TEST_F(MqttClientTest, SetCallbacksCanBeCalledMultipleTimes) {
   connectAndVerify();
 
   const uint8_t payload[] = {0xFF};
-  mockPubSubClient.simulateMessage(preferencesStorage.topicTty0Rx.c_str(),
-                                    payload, sizeof(payload));
+  receive(preferencesStorage.topicTty0Rx.c_str(), payload, sizeof(payload));
 
   EXPECT_TRUE(secondCallback0Invoked);
   EXPECT_FALSE(tty0CallbackInvoked); // Old callback not invoked
 }
 
-TEST_F(MqttClientTest, DISABLED_NullCallbacksHandledGracefully) {
-  // DISABLED: This test reveals the same bug as CallbacksInitiallyNull
-  // The mqttCallback() function doesn't check for nullptr before invoking callbacks
-  // TODO: Fix production code to add nullptr checks
-
+TEST_F(MqttClientTest, NullCallbacksHandledGracefully) {
   mqttClient->setCallbacks(nullptr, nullptr);
 
   connectAndVerify();
@@ -752,8 +1393,8 @@ TEST_F(MqttClientTest, DISABLED_NullCallbacksHandledGracefully) {
   const uint8_t payload[] = {0x01};
 
   // Should not crash
-  EXPECT_NO_THROW(mockPubSubClient.simulateMessage(
-      preferencesStorage.topicTty0Rx.c_str(), payload, sizeof(payload)));
+  EXPECT_NO_THROW(receive(preferencesStorage.topicTty0Rx.c_str(), payload,
+                          sizeof(payload)));
 }
 
 // ============================================================================
@@ -786,6 +1427,7 @@ TEST_F(MqttClientTest, LoopAfterDisconnect) {
 
   // Loop should return early without crashing
   EXPECT_NO_THROW(mqttClient->loop());
+  EXPECT_FALSE(mqttClient->isConnected());
 }
 
 TEST_F(MqttClientTest, PublishInfoAfterConnectionLoss) {
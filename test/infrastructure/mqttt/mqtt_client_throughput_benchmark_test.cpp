@@ -0,0 +1,239 @@
+// MqttClient tty publish throughput and end-to-end latency under scripted
+// broker conditions.
+//
+// The client runs on the real MqttEngine over loopback against the broker
+// stand-in, which adds one-way latency, PUBACK delays, a bandwidth cap or
+// periodic disconnects. Tty lines enter through the UART sink like
+// production output, and the test thread runs MqttClient::loop() every
+// BENCH_TASK_PERIOD like the MQTT task. Each profile runs QoS 0 and QoS 1
+// with an in-flight window of 1 and of MQTT_MAX_INFLIGHT:
+// - throughput: BENCH_LINES lines written as fast as the sink takes them,
+//   until the broker has the last one it will get
+// - latency: BENCH_LATENCY_LINES lines written one at a time once the
+//   publish budget has refilled, median time from the sink to the broker
+// - delivered: lines the broker got at least once
+//
+// Output is only written while connected, so "delivered" shows what was
+// in flight when a connection dropped rather than what the offline backlog
+// had to discard.
+//
+// The profiles take several seconds together, so they are disabled; run them
+// with --gtest_also_run_disabled_tests
+// --gtest_filter='*MqttClientThroughputBenchmark*'.
+#include "infrastructure/mqttt/mqtt_engine.h"
+#include "infrastructure/mqttt/socket_transport.h"
+#include "mqtt_test_broker.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using BenchEngine = internal::MqttEngine<SocketTransport>;
+using BenchClient = internal::MqttClient<BenchEngine>;
+using BenchClock = std::chrono::steady_clock;
+constexpr auto BENCH_TASK_PERIOD = std::chrono::milliseconds(5);
+constexpr size_t BENCH_LINE_SIZE = 64;
+constexpr int BENCH_LINES = 128; // 8 KB
+constexpr int BENCH_LATENCY_LINES = 10;
+
+struct BenchProfile {
+  const char *name;
+  int latencyMs;
+  int pubAckDelayMs;
+  size_t bandwidth; // bytes per second, 0 = unlimited
+  int dropIntervalMs;
+};
+
+struct BenchResult {
+  double kbPerSec{0};
+  double latencyMs{0};
+  double delivered{0}; // percent
+};
+
+std::string benchLine(int index) {
+  char prefix[8];
+  snprintf(prefix, sizeof(prefix), "%05d ", index);
+  std::string line(prefix);
+  line.resize(BENCH_LINE_SIZE - 1, '.');
+  return line + '\n';
+}
+
+class BenchRun {
+public:
+  BenchRun(const BenchProfile &profile, int32_t inflight) {
+    broker.setLatency(profile.latencyMs);
+    broker.setPubAckDelay(profile.pubAckDelayMs);
+    broker.setBandwidth(profile.bandwidth);
+    preferencesStorage.mqttInflight = inflight;
+    client = std::make_unique<BenchClient>(engine, preferencesStorage);
+    client->setCallbacks([](const types::span<const uint8_t> &) {},
+                         [](const types::span<const uint8_t> &) {});
+    connect();
+    EXPECT_TRUE(MqttTestBroker::waitFor(
+        [this] { return client->isConnected(); }, [this] { client->loop(); }));
+    // Disconnects start once the client is up
+    broker.setDropInterval(profile.dropIntervalMs);
+  }
+
+  BenchResult run() {
+    BenchResult result;
+    measureThroughput(result);
+    measureLatency(result);
+    return result;
+  }
+
+private:
+  MqttTestBroker broker;
+  BenchEngine engine;
+  PreferencesStorage preferencesStorage;
+  std::unique_ptr<BenchClient> client;
+  BenchClock::time_point lastConnect;
+  std::set<int> seen;
+  size_t scanned{0};
+  BenchClock::time_point lastArrival;
+
+  void connect() {
+    client->connect("127.0.0.1", broker.port());
+    lastConnect = BenchClock::now();
+  }
+
+  // One MQTT task iteration; reconnects like Application does, only faster
+  void tick() {
+    if (!client->isConnected() &&
+        BenchClock::now() - lastConnect > std::chrono::milliseconds(20))
+      connect();
+    client->loop();
+    std::this_thread::sleep_for(BENCH_TASK_PERIOD);
+  }
+
+  bool write(const std::string &line) {
+    MqttTxSink &sink = client->getTty1Sink();
+    if (!client->isConnected() ||
+        sink.size() + line.size() > MQTT_TX_RING_SIZE)
+      return false;
+    sink.append(types::span<const uint8_t>(
+        reinterpret_cast<const uint8_t *>(line.data()), line.size()));
+    return true;
+  }
+
+  // Collect the line numbers of tty publishes that arrived since last time
+  void scan() {
+    const auto messages = broker.published();
+    for (; scanned < messages.size(); ++scanned) {
+      const auto &message = messages[scanned];
+      if (message.topic != preferencesStorage.topicTty1Tx)
+        continue;
+      for (size_t pos = 0; pos + BENCH_LINE_SIZE <= message.payload.size();
+           pos += BENCH_LINE_SIZE) {
+        if (seen.insert(std::stoi(message.payload.substr(pos, 5))).second)
+          lastArrival = message.receivedAt;
+      }
+    }
+  }
+
+  void measureThroughput(BenchResult &result) {
+    const auto start = BenchClock::now();
+    lastArrival = start;
+    int next = 0;
+    auto idleSince = BenchClock::now();
+    while (static_cast<int>(seen.size()) < BENCH_LINES) {
+      while (next < BENCH_LINES && write(benchLine(next)))
+        next++;
+      tick();
+      const size_t before = seen.size();
+      scan();
+      if (seen.size() != before || next < BENCH_LINES)
+        idleSince = BenchClock::now();
+      // QoS 0 never gets back what a drop lost
+      if (BenchClock::now() - idleSince > std::chrono::milliseconds(500))
+        break;
+    }
+    const double seconds =
+        std::chrono::duration<double>(lastArrival - start).count();
+    result.kbPerSec = seen.size() * BENCH_LINE_SIZE / 1024.0 / seconds;
+    result.delivered = 100.0 * seen.size() / BENCH_LINES;
+  }
+
+  void measureLatency(BenchResult &result) {
+    std::vector<double> samples;
+    // The flood above used up the publish budget's tty share; refill it so
+    // the lines below measure the transport rather than the budget
+    while (client->getPublishBudget().tokens(millis()) <
+           MQTT_PUBLISH_BURST / 2 + BENCH_LATENCY_LINES)
+      tick();
+    for (int i = 0; i < BENCH_LATENCY_LINES; ++i) {
+      const int index = BENCH_LINES + i;
+      while (!write(benchLine(index)))
+        tick();
+      const auto written = BenchClock::now();
+      const auto deadline = written + std::chrono::milliseconds(500);
+      while (!seen.count(index) && BenchClock::now() < deadline) {
+        tick();
+        scan();
+      }
+      if (seen.count(index)) {
+        samples.push_back(
+            std::chrono::duration<double, std::milli>(lastArrival - written)
+                .count());
+      }
+    }
+    if (samples.empty())
+      return;
+    std::sort(samples.begin(), samples.end());
+    result.latencyMs = samples[samples.size() / 2];
+  }
+};
+
+// Results for QoS 0, QoS 1 x1 and QoS 1 x MQTT_MAX_INFLIGHT
+std::array<BenchResult, 3> reportProfile(const BenchProfile &profile) {
+  const int32_t windows[] = {0, 1, MQTT_MAX_INFLIGHT};
+  std::array<BenchResult, 3> results;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const int32_t window = windows[i];
+    const BenchResult result = BenchRun(profile, window).run();
+    results[i] = result;
+    char mode[16];
+    if (window == 0)
+      snprintf(mode, sizeof(mode), "QoS 0");
+    else
+      snprintf(mode, sizeof(mode), "QoS 1 x%d", static_cast<int>(window));
+    std::printf("[ MQTT     ] %-10s %-9s %7.1f KB/s  latency %5.1f ms  "
+                "delivered %5.1f%%\n",
+                profile.name, mode, result.kbPerSec, result.latencyMs,
+                result.delivered);
+    if (window > 0) {
+      EXPECT_EQ(result.delivered, 100.0) << profile.name << " " << mode;
+    }
+  }
+  return results;
+}
+
+TEST(MqttClientThroughputBenchmark, DISABLED_Loopback) {
+  reportProfile({"loopback", 0, 0, 0, 0});
+}
+
+TEST(MqttClientThroughputBenchmark, DISABLED_Wifi) {
+  reportProfile({"wifi", 5, 0, 256 * 1024, 0});
+}
+
+TEST(MqttClientThroughputBenchmark, DISABLED_SlowBroker) {
+  const auto results = reportProfile({"slow", 15, 10, 64 * 1024, 0});
+  // With one message in flight a line waits for the previous PUBACK
+  EXPECT_LT(results[2].latencyMs, results[1].latencyMs);
+}
+
+TEST(MqttClientThroughputBenchmark, DISABLED_FlakyLink) {
+  reportProfile({"flaky", 5, 0, 0, 150});
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
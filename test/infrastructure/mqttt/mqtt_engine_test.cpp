@@ -0,0 +1,417 @@
+// MqttClient template definitions come from mqtt_client_test.cpp, which
+// all_tests.cpp includes first
+#include "domain/config/preferences_storage.h"
+#include "infrastructure/mqttt/mqtt_client.h"
+#include "infrastructure/mqttt/mqtt_engine.cpp"
+#include "infrastructure/mqttt/socket_transport.h"
+#include "mqtt_test_broker.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using Engine = internal::MqttEngine<SocketTransport>;
+
+class MqttEngineTest : public ::testing::Test {
+protected:
+  MqttTestBroker broker;
+  Engine engine;
+  std::vector<std::pair<std::string, std::string>> received;
+
+  void SetUp() override {
+    engine.setServer("127.0.0.1", broker.port());
+    engine.setBufferSize(MQTT_BUFFER_SIZE);
+    engine.setCallback([this](char *topic, uint8_t *payload,
+                              unsigned int length) {
+      received.emplace_back(
+          topic, std::string(reinterpret_cast<char *>(payload), length));
+    });
+  }
+
+  bool pumpUntil(const std::function<bool()> &predicate, int timeoutMs = 2000) {
+    return MqttTestBroker::waitFor(predicate, [this] { engine.loop(); },
+                                   timeoutMs);
+  }
+
+  void connectAndWait(const char *user = nullptr,
+                      const char *password = nullptr) {
+    ASSERT_TRUE(engine.connect("engine-test", user, password));
+    ASSERT_TRUE(pumpUntil([this] { return engine.connected(); }));
+  }
+};
+
+TEST_F(MqttEngineTest, ConnectReturnsBeforeConnack) {
+  EXPECT_TRUE(engine.connect("engine-test"));
+  EXPECT_FALSE(engine.connected());
+
+  EXPECT_TRUE(pumpUntil([this] { return engine.connected(); }));
+  EXPECT_EQ(engine.state(), Engine::STATE_CONNECTED);
+  EXPECT_EQ(broker.clientId(), "engine-test");
+}
+
+TEST_F(MqttEngineTest, ConnectSendsCredentials) {
+  connectAndWait("bridge", "secret");
+
+  EXPECT_EQ(broker.user(), "bridge");
+  EXPECT_EQ(broker.password(), "secret");
+}
+
+TEST_F(MqttEngineTest, RefusedConnackReportsReturnCode) {
+  broker.setConnAckCode(5); // not authorized
+  ASSERT_TRUE(engine.connect("engine-test"));
+
+  EXPECT_TRUE(pumpUntil([this] { return engine.state() == 5; }));
+  EXPECT_FALSE(engine.connected());
+}
+
+TEST_F(MqttEngineTest, ConnectToClosedPortFails) {
+  engine.setServer("127.0.0.1", 1); // nothing listens on port 1
+
+  const bool started = engine.connect("engine-test");
+  if (started) {
+    EXPECT_TRUE(pumpUntil(
+        [this] { return engine.state() == Engine::STATE_CONNECT_FAILED; }));
+  }
+  EXPECT_FALSE(engine.connected());
+}
+
+TEST_F(MqttEngineTest, PublishFailsWhenNotConnected) {
+  const uint8_t payload[] = {'x'};
+  EXPECT_FALSE(engine.publish("t", payload, sizeof(payload)));
+}
+
+TEST_F(MqttEngineTest, PipelinedPublishesArriveInOrder) {
+  connectAndWait();
+
+  constexpr int count = 200;
+  for (int i = 0; i < count; ++i) {
+    std::string payload = "line " + std::to_string(i) + "\n";
+    ASSERT_TRUE(engine.publish("wifi_serial/dev/ttyS1/tx",
+                               reinterpret_cast<const uint8_t *>(payload.data()),
+                               payload.size()));
+  }
+
+  ASSERT_TRUE(pumpUntil([this] { return broker.published().size() == count; }));
+  const auto messages = broker.published();
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(messages[i].topic, "wifi_serial/dev/ttyS1/tx");
+    EXPECT_EQ(messages[i].payload, "line " + std::to_string(i) + "\n");
+  }
+}
+
+TEST_F(MqttEngineTest, RetainedFlagIsSent) {
+  connectAndWait();
+  const uint8_t payload[] = {'r'};
+  ASSERT_TRUE(engine.publish("info", payload, sizeof(payload), true));
+
+  ASSERT_TRUE(pumpUntil([this] { return broker.published().size() == 1; }));
+  EXPECT_TRUE(broker.published()[0].retained);
+}
+
+TEST_F(MqttEngineTest, QosOnePublishReportsPubAck) {
+  connectAndWait();
+  std::vector<uint16_t> acked;
+  engine.setPubAckCallback([&acked](uint16_t id) { acked.push_back(id); });
+  const uint8_t payload[] = {'s', 'p', 'i', 'l', 'l'};
+  const uint16_t id = engine.publishAcked("t", payload, sizeof(payload));
+  ASSERT_NE(id, 0);
+
+  ASSERT_TRUE(pumpUntil([&acked] { return acked.size() == 1; }));
+  EXPECT_EQ(acked[0], id);
+  ASSERT_EQ(broker.published().size(), 1u);
+  EXPECT_EQ(broker.published()[0].qos, 1);
+  EXPECT_EQ(broker.published()[0].payload, "spill");
+}
+
+TEST_F(MqttEngineTest, SubscribeReachesBroker) {
+  connectAndWait();
+  ASSERT_TRUE(engine.subscribe("wifi_serial/dev/ttyS1/rx", 1));
+
+  ASSERT_TRUE(pumpUntil([this] { return broker.subscriptions().size() == 1; }));
+  EXPECT_EQ(broker.subscriptions()[0], "wifi_serial/dev/ttyS1/rx");
+}
+
+TEST_F(MqttEngineTest, InboundPublishDeliveredToCallback) {
+  connectAndWait();
+  broker.publish("wifi_serial/dev/ttyS1/rx", "ls -l\n");
+
+  ASSERT_TRUE(pumpUntil([this] { return received.size() == 1; }));
+  EXPECT_EQ(received[0].first, "wifi_serial/dev/ttyS1/rx");
+  EXPECT_EQ(received[0].second, "ls -l\n");
+}
+
+TEST_F(MqttEngineTest, PacketsSplitAcrossReadsAreReassembled) {
+  connectAndWait();
+  broker.setDribble(true);
+  broker.publish("a/b", "first");
+  broker.publish("a/b", "second");
+
+  ASSERT_TRUE(pumpUntil([this] { return received.size() == 2; }, 4000));
+  EXPECT_EQ(received[0].second, "first");
+  EXPECT_EQ(received[1].second, "second");
+}
+
+TEST_F(MqttEngineTest, QosOneInboundIsAcknowledged) {
+  connectAndWait();
+  broker.publish("a/b", "ack me", 1);
+
+  ASSERT_TRUE(pumpUntil([this] { return broker.pubAcksReceived() == 1; }));
+  ASSERT_EQ(received.size(), 1u);
+  EXPECT_EQ(received[0].second, "ack me");
+}
+
+TEST_F(MqttEngineTest, OversizedPacketSkippedWithoutLosingSync) {
+  engine.setBufferSize(64);
+  connectAndWait();
+  broker.publish("a/b", std::string(500, 'x'));
+  broker.publish("a/b", "after");
+
+  ASSERT_TRUE(pumpUntil([this] { return received.size() == 1; }));
+  EXPECT_EQ(received[0].second, "after");
+  EXPECT_TRUE(engine.connected());
+}
+
+TEST_F(MqttEngineTest, PublishNeverBlocksWhenBrokerStopsReading) {
+  broker.setReceiveBufferSize(4096);
+  connectAndWait();
+  broker.setReading(false);
+
+  std::vector<uint8_t> payload(1024, 'p');
+  auto start = std::chrono::steady_clock::now();
+  int accepted = 0;
+  while (accepted < 100000 &&
+         engine.publish("bulk", payload.data(), payload.size())) {
+    accepted++;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_LT(accepted, 100000) << "back-pressure never reported";
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                .count(),
+            1000);
+  EXPECT_TRUE(engine.connected());
+  EXPECT_LE(engine.pendingTxBytes(), static_cast<size_t>(MQTT_TX_QUEUE_SIZE));
+}
+
+TEST_F(MqttEngineTest, DisconnectSendsDisconnectPacket) {
+  connectAndWait();
+  engine.disconnect();
+
+  EXPECT_FALSE(engine.connected());
+  EXPECT_EQ(engine.state(), Engine::STATE_DISCONNECTED);
+  EXPECT_TRUE(MqttTestBroker::waitFor(
+      [this] { return broker.disconnectsReceived() == 1; }, nullptr));
+}
+
+TEST_F(MqttEngineTest, BrokerDropIsReportedAsConnectionLost) {
+  connectAndWait();
+  broker.dropClient();
+
+  EXPECT_TRUE(pumpUntil([this] { return !engine.connected(); }));
+  EXPECT_EQ(engine.state(), Engine::STATE_CONNECTION_LOST);
+}
+
+TEST_F(MqttEngineTest, ReconnectAfterDrop) {
+  connectAndWait();
+  broker.dropClient();
+  ASSERT_TRUE(pumpUntil([this] { return !engine.connected(); }));
+
+  connectAndWait();
+  EXPECT_TRUE(engine.connected());
+}
+
+TEST_F(MqttEngineTest, Version5SendsRepeatedTopicAsAlias) {
+  engine.setProtocolVersion(5);
+  connectAndWait();
+  EXPECT_EQ(broker.protocolLevel(), 5);
+  EXPECT_EQ(engine.topicAliasMaximum(), 10);
+
+  const std::string topic = "wifi_serial/dev/ttyS1/tx";
+  const uint8_t payload[] = {'o', 'k'};
+  size_t wireBytes[2];
+  for (size_t i = 0; i < 2; ++i) {
+    const size_t before = broker.bytesReceived();
+    ASSERT_TRUE(engine.publish(topic.c_str(), payload, sizeof(payload)));
+    ASSERT_TRUE(pumpUntil([&] { return broker.published().size() == i + 1; }));
+    wireBytes[i] = broker.bytesReceived() - before;
+  }
+
+  const auto messages = broker.published();
+  EXPECT_EQ(messages[0].topicAlias, 1);
+  EXPECT_EQ(messages[1].topicAlias, 1);
+  EXPECT_EQ(messages[1].topic, topic); // resolved by the broker
+  EXPECT_EQ(wireBytes[0] - wireBytes[1], topic.size());
+
+  // A new connection starts a new alias table
+  broker.dropClient();
+  ASSERT_TRUE(pumpUntil([this] { return !engine.connected(); }));
+  connectAndWait();
+  ASSERT_TRUE(engine.publish(topic.c_str(), payload, sizeof(payload)));
+  ASSERT_TRUE(pumpUntil([this] { return broker.published().size() == 3; }));
+  EXPECT_EQ(broker.published()[2].topic, topic);
+}
+
+TEST_F(MqttEngineTest, Version5PublishCarriesProperties) {
+  engine.setProtocolVersion(5);
+  broker.setTopicAliasMaximum(0); // aliases not allowed
+  connectAndWait();
+
+  MqttPublishProperties properties;
+  properties.messageExpirySec = 600;
+  properties.addUserProperty("port", "1");
+  properties.addUserProperty("seq", "4096");
+  const uint8_t payload[] = {'$', ' '};
+  ASSERT_NE(engine.publishAcked("wifi_serial/dev/ttyS1/tx", payload,
+                                sizeof(payload), properties),
+            0);
+  ASSERT_TRUE(pumpUntil([this] { return broker.published().size() == 1; }));
+  const auto message = broker.published()[0];
+  EXPECT_EQ(message.topic, "wifi_serial/dev/ttyS1/tx");
+  EXPECT_EQ(message.topicAlias, 0);
+  EXPECT_EQ(message.expiry, 600u);
+  EXPECT_EQ(message.payload, "$ ");
+  ASSERT_EQ(message.userProperties.size(), 2u);
+  EXPECT_EQ(message.userProperties[0],
+            std::make_pair(std::string("port"), std::string("1")));
+  EXPECT_EQ(message.userProperties[1],
+            std::make_pair(std::string("seq"), std::string("4096")));
+
+  // Subscriptions and inbound publishes carry (empty) properties too
+  ASSERT_TRUE(engine.subscribe("wifi_serial/dev/ttyS1/rx", 0));
+  ASSERT_TRUE(pumpUntil([this] { return broker.subscriptions().size() == 1; }));
+  EXPECT_EQ(broker.subscriptions()[0], "wifi_serial/dev/ttyS1/rx");
+  broker.publish("wifi_serial/dev/ttyS1/rx", "ls\n");
+  ASSERT_TRUE(pumpUntil([this] { return received.size() == 1; }));
+  EXPECT_EQ(received[0].second, "ls\n");
+}
+
+TEST_F(MqttEngineTest, Version5RefusedFallsBackTo311) {
+  engine.setProtocolVersion(5);
+  broker.setVersion5(false);
+  ASSERT_TRUE(engine.connect("engine-test"));
+  ASSERT_TRUE(pumpUntil([this] { return engine.state() == 1; }));
+  EXPECT_EQ(engine.protocolVersion(), 4);
+
+  connectAndWait();
+  EXPECT_EQ(broker.protocolLevel(), 4);
+  const uint8_t payload[] = {'x'};
+  ASSERT_TRUE(engine.publish("t", payload, sizeof(payload)));
+  ASSERT_TRUE(pumpUntil([this] { return broker.published().size() == 1; }));
+  EXPECT_EQ(broker.published()[0].topic, "t");
+}
+
+// ============================================================================
+// MqttClient on top of the engine (end to end over loopback)
+// ============================================================================
+
+class MqttClientOverEngineTest : public ::testing::Test {
+protected:
+  MqttTestBroker broker;
+  Engine engine;
+  PreferencesStorage preferencesStorage;
+  std::unique_ptr<internal::MqttClient<Engine>> mqttClient;
+
+  void SetUp() override {
+    mqttClient = std::make_unique<internal::MqttClient<Engine>>(
+        engine, preferencesStorage);
+    mqttClient->setCallbacks([](const types::span<const uint8_t> &) {},
+                             [](const types::span<const uint8_t> &) {});
+  }
+
+  bool loopUntil(const std::function<bool()> &predicate) {
+    return MqttTestBroker::waitFor(predicate, [this] { mqttClient->loop(); });
+  }
+};
+
+TEST_F(MqttClientOverEngineTest, SubscribesOnceConnackArrives) {
+  ASSERT_TRUE(mqttClient->connect("127.0.0.1", broker.port()));
+  EXPECT_FALSE(mqttClient->isConnected());
+
+  ASSERT_TRUE(loopUntil([this] { return mqttClient->isConnected(); }));
+  ASSERT_TRUE(loopUntil([this] { return broker.subscriptions().size() == 4; }));
+  const auto subscriptions = broker.subscriptions();
+  EXPECT_EQ(subscriptions[0], preferencesStorage.topicTty0Rx);
+  EXPECT_EQ(subscriptions[1], preferencesStorage.topicTty1Rx);
+  EXPECT_EQ(subscriptions[2], mqttClient->getUploadTopic(0));
+  EXPECT_EQ(subscriptions[3], mqttClient->getUploadTopic(1));
+}
+
+TEST_F(MqttClientOverEngineTest, TtyLinePublishedToTxTopic) {
+  ASSERT_TRUE(mqttClient->connect("127.0.0.1", broker.port()));
+  ASSERT_TRUE(loopUntil([this] { return mqttClient->isConnected(); }));
+
+  const std::string line = "login: ";
+  mqttClient->getTty1Stream().append(types::span<const uint8_t>(
+      reinterpret_cast<const uint8_t *>(line.data()), line.size()));
+  mqttClient->getTty1Stream().append('\n');
+
+  ASSERT_TRUE(loopUntil([this] { return broker.published().size() == 1; }));
+  EXPECT_EQ(broker.published()[0].topic, preferencesStorage.topicTty1Tx);
+  EXPECT_EQ(broker.published()[0].payload, "login: \n");
+}
+
+TEST_F(MqttClientOverEngineTest, QosOneTtyOutputSurvivesLostPublishes) {
+  preferencesStorage.mqttInflight = 4;
+  broker.setQos1LossEvery(7);
+  ASSERT_TRUE(mqttClient->connect("127.0.0.1", broker.port()));
+  ASSERT_TRUE(loopUntil([this] { return mqttClient->isConnected(); }));
+
+  constexpr int LINES = 200;
+  std::string expected;
+  for (int i = 0; i < LINES; ++i)
+    expected += "line " + std::to_string(i) + "\n";
+
+  // First copy of every line, in arrival order; retransmits may duplicate
+  auto delivered = [this] {
+    std::string all, unique;
+    for (const auto &message : broker.published()) {
+      if (message.topic == preferencesStorage.topicTty1Tx)
+        all += message.payload;
+    }
+    std::vector<std::string> seen;
+    size_t start = 0;
+    for (size_t end; (end = all.find('\n', start)) != std::string::npos;
+         start = end + 1) {
+      const std::string line = all.substr(start, end + 1 - start);
+      if (std::find(seen.begin(), seen.end(), line) == seen.end()) {
+        seen.push_back(line);
+        unique += line;
+      }
+    }
+    return unique;
+  };
+
+  int next = 0;
+  auto lastAttempt = std::chrono::steady_clock::now();
+  auto pump = [&] {
+    if (!mqttClient->isConnected()) {
+      if (std::chrono::steady_clock::now() - lastAttempt >
+          std::chrono::milliseconds(20)) {
+        mqttClient->connect("127.0.0.1", broker.port());
+        lastAttempt = std::chrono::steady_clock::now();
+      }
+    } else if (next < LINES) {
+      const std::string line = "line " + std::to_string(next++) + "\n";
+      mqttClient->getTty1Sink().append(types::span<const uint8_t>(
+          reinterpret_cast<const uint8_t *>(line.data()), line.size()));
+    }
+    mqttClient->loop();
+  };
+  ASSERT_TRUE(MqttTestBroker::waitFor(
+      [&] { return delivered() == expected; }, pump, 10000))
+      << delivered();
+  EXPECT_GT(broker.qos1PublishesLost(), 0u);
+  for (const auto &message : broker.published()) {
+    if (message.topic == preferencesStorage.topicTty1Tx) {
+      EXPECT_EQ(message.qos, 1);
+    }
+  }
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
@@ -0,0 +1,88 @@
+// Bytes on the wire per byte of tty payload, MQTT 3.1.1 against MQTT 5.
+//
+// One connection per run publishes the same tty chunks to a tty topic; the
+// broker stand-in counts every byte it receives after the handshake. MQTT 5
+// runs add what MqttFlushPolicy sends: a message expiry, and in unframed
+// mode "port" and "seq" user properties. The topic travels once per
+// connection; later publishes carry its 2-byte alias instead.
+//
+// Payload sizes follow tty traffic: a prompt, an interactive line, and a
+// full MQTT_BUFFER_SIZE flush of a log burst.
+#include "infrastructure/mqttt/mqtt_engine.h"
+#include "infrastructure/mqttt/socket_transport.h"
+#include "mqtt_test_broker.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using WireEngine = internal::MqttEngine<SocketTransport>;
+constexpr const char *WIRE_TOPIC = "wifi_serial/esp32c3-dev/ttyS1/tx";
+constexpr size_t WIRE_MESSAGES = 200;
+
+enum class WireMode { V311, V5, V5Metadata };
+
+// Wire bytes per payload byte over WIRE_MESSAGES publishes
+double wireBytesPerPayloadByte(WireMode mode, size_t payloadSize) {
+  MqttTestBroker broker;
+  WireEngine engine;
+  engine.setServer("127.0.0.1", broker.port());
+  engine.setBufferSize(MQTT_BUFFER_SIZE);
+  engine.setProtocolVersion(mode == WireMode::V311 ? 4 : 5);
+  const auto pump = [&engine] { engine.loop(); };
+  EXPECT_TRUE(engine.connect("wire-benchmark"));
+  EXPECT_TRUE(MqttTestBroker::waitFor([&] { return engine.connected(); }, pump));
+
+  const std::string payload(payloadSize, 'x');
+  char seq[11];
+  uint32_t offset = 0;
+  const size_t before = broker.bytesReceived();
+  for (size_t i = 0; i < WIRE_MESSAGES; ++i) {
+    const auto *data = reinterpret_cast<const uint8_t *>(payload.data());
+    if (mode == WireMode::V311) {
+      EXPECT_TRUE(engine.publish(WIRE_TOPIC, data, payload.size()));
+    } else {
+      MqttPublishProperties properties;
+      properties.messageExpirySec = MQTT_TTY_MESSAGE_EXPIRY_SEC;
+      if (mode == WireMode::V5Metadata) {
+        snprintf(seq, sizeof(seq), "%lu", static_cast<unsigned long>(offset));
+        properties.addUserProperty("port", "1");
+        properties.addUserProperty("seq", seq);
+      }
+      EXPECT_TRUE(engine.publish(WIRE_TOPIC, data, payload.size(), false,
+                                 properties));
+    }
+    offset += static_cast<uint32_t>(payload.size());
+    // Keep the send queue from filling
+    EXPECT_TRUE(MqttTestBroker::waitFor(
+        [&] { return broker.published().size() == i + 1; }, pump));
+  }
+  return static_cast<double>(broker.bytesReceived() - before) /
+         static_cast<double>(WIRE_MESSAGES * payloadSize);
+}
+
+void reportWireBytes(size_t payloadSize) {
+  const double v311 = wireBytesPerPayloadByte(WireMode::V311, payloadSize);
+  const double v5 = wireBytesPerPayloadByte(WireMode::V5, payloadSize);
+  const double v5Metadata =
+      wireBytesPerPayloadByte(WireMode::V5Metadata, payloadSize);
+  std::printf("[ MQTT5    ] %3zu B payload  3.1.1 %.3f  5 %.3f  "
+              "5+port/seq %.3f  wire bytes per payload byte\n",
+              payloadSize, v311, v5, v5Metadata);
+  // The alias saves more than the expiry property costs
+  EXPECT_LT(v5, v311);
+}
+
+TEST(MqttEngineWireBenchmark, PromptPayload) { reportWireBytes(2); }
+
+TEST(MqttEngineWireBenchmark, LinePayload) { reportWireBytes(40); }
+
+TEST(MqttEngineWireBenchmark, FullBufferPayload) {
+  reportWireBytes(MQTT_BUFFER_SIZE);
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
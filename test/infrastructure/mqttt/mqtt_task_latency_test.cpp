@@ -0,0 +1,251 @@
+// Native simulation of the UART service latency with a stalled broker.
+//
+// "Inline" reproduces the old single-loop Application: UART bytes go through
+// the broadcaster straight into the MQTT stream (publish on '\n') and
+// mqttClient.loop() runs on the same thread. "Task" is the current layout:
+// the UART side only writes into the SPSC sink and dispatches rx payloads,
+// while a second thread plays the MQTT FreeRTOS task.
+//
+// The stall model is a broker whose socket stops draining: every publish()
+// and loop() blocks for STALL_MS, as a blocking client would. The reported
+// backlog is how many bytes pile up in the UART driver at 115200 baud during
+// the worst gap between two services (the Arduino RX buffer holds 256).
+// These measure real threads, take about 0.8 s each and depend on the host
+// keeping them scheduled, so they are disabled; run them with
+// --gtest_also_run_disabled_tests --gtest_filter='*MqttTaskLatency*'.
+//
+// StalledTaskLeavesUartSideRunning checks the same property without timing:
+// the broker holds the MQTT task on a latch while the UART side services.
+//
+// MqttClient template definitions come from mqtt_client_test.cpp.
+#include "app/broadcaster.hpp"
+#include "domain/config/preferences_storage.h"
+#include "infrastructure/mqttt/mqtt_client.h"
+#include "infrastructure/mqttt/pub_sub_client_test.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int STALL_MS = 50;
+constexpr auto RUN_TIME = std::chrono::milliseconds(250);
+constexpr double UART_BYTES_PER_MS = 115200.0 / 10 / 1000; // 8N1
+constexpr size_t UART_RX_BUFFER = 256;
+constexpr auto TASK_PERIOD = std::chrono::milliseconds(5);
+constexpr auto MAIN_LOOP_WORK = std::chrono::microseconds(100);
+
+// PubSubClientTest whose network calls block while the broker is stalled
+class StallingPubSubClient : public PubSubClientTest {
+public:
+  std::atomic<bool> stalled{false};
+
+  // Latched: network calls block until release() instead of for STALL_MS
+  void latch() { latched = true; }
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(latchMutex);
+      latched = false;
+    }
+    latchChanged.notify_all();
+  }
+  void waitUntilBlocked() {
+    std::unique_lock<std::mutex> lock(latchMutex);
+    latchChanged.wait(lock, [this] { return blocked; });
+  }
+  bool isBlocked() {
+    std::lock_guard<std::mutex> lock(latchMutex);
+    return blocked;
+  }
+
+  void loop() { stall(); }
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length) {
+    return publish(topic, payload, length, false);
+  }
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length,
+               bool retained) {
+    stall();
+    return PubSubClientTest::publish(topic, payload, length, retained);
+  }
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length,
+               bool retained, const MqttPublishProperties &properties) {
+    stall();
+    return PubSubClientTest::publish(topic, payload, length, retained,
+                                     properties);
+  }
+
+private:
+  bool latched{false};
+  bool blocked{false};
+  std::mutex latchMutex;
+  std::condition_variable latchChanged;
+
+  void stall() {
+    if (stalled)
+      std::this_thread::sleep_for(std::chrono::milliseconds(STALL_MS));
+    std::unique_lock<std::mutex> lock(latchMutex);
+    if (!latched)
+      return;
+    blocked = true;
+    latchChanged.notify_all();
+    latchChanged.wait(lock, [this] { return !latched; });
+    blocked = false;
+  }
+};
+
+using Client = internal::MqttClient<StallingPubSubClient>;
+
+struct LatencyReport {
+  double worstGapMs{0};
+  double meanGapMs{0};
+  size_t peakBacklog{0};
+};
+
+// Feeds the bytes that arrived on the wire since the last service, like
+// handleSerialPort1() draining serial1, and tracks the gaps between calls
+class UartModel {
+public:
+  template <typename Broadcast> void service(Broadcast &&broadcast) {
+    arrived += recordGap() * UART_BYTES_PER_MS;
+    const size_t pending = static_cast<size_t>(arrived);
+    arrived -= pending;
+    for (size_t i = 0; i < pending; ++i) {
+      broadcast(static_cast<uint8_t>(++column % 64 == 0 ? '\n' : 'x'));
+    }
+  }
+
+  LatencyReport finish() {
+    recordGap(); // a service stuck at the end of the run still counts
+    report.meanGapMs = services ? totalGapMs / services : 0;
+    return report;
+  }
+
+private:
+  double recordGap() {
+    const auto now = Clock::now();
+    const double gapMs =
+        std::chrono::duration<double, std::milli>(now - last).count();
+    last = now;
+    report.worstGapMs = std::max(report.worstGapMs, gapMs);
+    report.peakBacklog = std::max(
+        report.peakBacklog, static_cast<size_t>(gapMs * UART_BYTES_PER_MS));
+    totalGapMs += gapMs;
+    services++;
+    return gapMs;
+  }
+
+  Clock::time_point last{Clock::now()};
+  LatencyReport report;
+  double totalGapMs{0};
+  double arrived{0};
+  size_t services{0};
+  size_t column{0};
+};
+
+class MqttTaskLatencyTest : public ::testing::Test {
+protected:
+  StallingPubSubClient broker;
+  PreferencesStorage preferencesStorage;
+  Client client{broker, preferencesStorage};
+
+  void SetUp() override {
+    client.setCallbacks([](const types::span<const uint8_t> &) {},
+                        [](const types::span<const uint8_t> &) {});
+    ASSERT_TRUE(client.connect("broker", 1883));
+  }
+
+  LatencyReport runInline() {
+    Broadcaster<Client::TtyStream> tty1(client.getTty1Stream());
+    UartModel uart;
+    const auto end = Clock::now() + RUN_TIME;
+    while (Clock::now() < end) {
+      client.loop();
+      uart.service([&tty1](uint8_t byte) { tty1.append(byte); });
+      std::this_thread::sleep_for(MAIN_LOOP_WORK);
+    }
+    return uart.finish();
+  }
+
+  LatencyReport runTask() {
+    Broadcaster<MqttTxSink> tty1(client.getTty1Sink());
+    std::atomic<bool> running{true};
+    std::thread mqttTask([this, &running] {
+      while (running) {
+        client.loop();
+        std::this_thread::sleep_for(TASK_PERIOD);
+      }
+    });
+
+    UartModel uart;
+    const auto end = Clock::now() + RUN_TIME;
+    while (Clock::now() < end) {
+      client.dispatchInbound();
+      uart.service([&tty1](uint8_t byte) { tty1.append(byte); });
+      std::this_thread::sleep_for(MAIN_LOOP_WORK);
+    }
+    const LatencyReport report = uart.finish();
+    running = false;
+    mqttTask.join();
+    return report;
+  }
+
+  static void print(const char *layout, const char *brokerState,
+                    const LatencyReport &r) {
+    std::printf("[ LATENCY  ] %-6s broker %-7s worst %7.2f ms  mean %6.3f ms  "
+                "peak backlog %5zu B%s\n",
+                layout, brokerState, r.worstGapMs, r.meanGapMs, r.peakBacklog,
+                r.peakBacklog > UART_RX_BUFFER ? "  (RX overrun)" : "");
+  }
+};
+
+TEST_F(MqttTaskLatencyTest, DISABLED_InlineLoopStallsUartWithBroker) {
+  print("inline", "ok", runInline());
+
+  broker.stalled = true;
+  const LatencyReport stalled = runInline();
+  print("inline", "stalled", stalled);
+
+  EXPECT_GE(stalled.worstGapMs, STALL_MS);
+  EXPECT_GT(stalled.peakBacklog, UART_RX_BUFFER);
+}
+
+TEST_F(MqttTaskLatencyTest, DISABLED_MqttTaskKeepsUartServiced) {
+  print("task", "ok", runTask());
+
+  broker.stalled = true;
+  const LatencyReport stalled = runTask();
+  print("task", "stalled", stalled);
+
+  EXPECT_LT(stalled.worstGapMs, STALL_MS / 2.0);
+  EXPECT_LE(stalled.peakBacklog, UART_RX_BUFFER);
+}
+
+TEST_F(MqttTaskLatencyTest, StalledTaskLeavesUartSideRunning) {
+  broker.latch();
+  std::thread mqttTask([this] { client.loop(); });
+  broker.waitUntilBlocked();
+
+  // Every service completes while the MQTT task is stuck in the broker
+  Broadcaster<MqttTxSink> tty1(client.getTty1Sink());
+  constexpr size_t SERVICES = 1000;
+  for (size_t i = 0; i < SERVICES; ++i) {
+    client.dispatchInbound();
+    tty1.append(static_cast<uint8_t>(i % 64 == 63 ? '\n' : 'x'));
+  }
+  EXPECT_TRUE(broker.isBlocked());
+  EXPECT_EQ(client.getTty1Sink().size(), SERVICES);
+
+  broker.release();
+  mqttTask.join();
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
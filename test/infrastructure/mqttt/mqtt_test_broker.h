@@ -0,0 +1,684 @@
+/**
+ * @file mqtt_test_broker.h
+ * @brief Minimal MQTT 3.1.1 / 5 broker stand-in on loopback TCP for native
+ * tests.
+ *
+ * Accepts one client at a time on 127.0.0.1 (ephemeral port) and runs in its
+ * own thread. Constructed with TlsMode::On it speaks MQTT over TLS (OpenSSL)
+ * with a self-signed certificate for 127.0.0.1 / localhost, see
+ * tlsCaCertPem(); sessions are resumable by ticket and session ID. It answers CONNECT/SUBSCRIBE/PINGREQ/QoS 1 PUBLISH, records
+ * everything it receives and can push PUBLISH packets to the client.
+ *
+ * Test knobs:
+ * - setConnAckCode(): refuse connections with a CONNACK return code
+ * - setDribble(): send outbound packets one byte per write
+ * - setReading(): stop reading from the client to create back-pressure
+ * - dropClient(): close the client socket
+ * - setTopicAliasMaximum(): MQTT 5 Topic Alias Maximum sent in CONNACK
+ * - setVersion5(): answer protocol level 5 like a 3.1.1-only broker
+ * - setQos1LossEvery(): lose every nth QoS 1 PUBLISH together with the
+ *   connection, like a WiFi blip before the broker got it
+ * - setLatency(): one-way delay, applied to what the client sends before
+ *   the broker sees it and to everything the broker sends
+ * - setPubAckDelay(): extra delay on PUBACKs, like a broker persisting QoS 1
+ *   messages before acknowledging them
+ * - setBandwidth(): cap on the bytes per second read from the client; the
+ *   rest backs up in the socket buffers
+ * - setDropInterval(): close every connection once it is this old
+ *
+ * Delayed packets leave in the order they were queued, so a delayed PUBACK
+ * holds back what is queued behind it, as on a TCP stream.
+ *
+ * MQTT 5 PUBLISH topic aliases are resolved, so published() always carries
+ * the full topic.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace jrb::wifi_serial {
+
+class MqttTestBroker {
+public:
+  struct Message {
+    std::string topic;
+    std::string payload;
+    uint8_t qos;
+    bool retained;
+    // MQTT 5 properties
+    uint32_t expiry{0};
+    uint16_t topicAlias{0};
+    std::vector<std::pair<std::string, std::string>> userProperties;
+    // When the broker processed it, latency included
+    std::chrono::steady_clock::time_point receivedAt{};
+  };
+
+  enum class TlsMode { Off, On };
+
+  struct TlsIdentity {
+    std::string certPem;
+    std::string keyPem;
+  };
+
+  explicit MqttTestBroker(TlsMode tlsMode = TlsMode::Off) {
+    if (tlsMode == TlsMode::On)
+      setUpTls();
+    listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    ::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    ::listen(listenFd, 4);
+    socklen_t len = sizeof(addr);
+    ::getsockname(listenFd, reinterpret_cast<sockaddr *>(&addr), &len);
+    listenPort = ntohs(addr.sin_port);
+    worker = std::thread([this] { run(); });
+  }
+
+  ~MqttTestBroker() {
+    running = false;
+    worker.join();
+    closeClient();
+    ::close(listenFd);
+    SSL_CTX_free(tlsContext);
+  }
+
+  MqttTestBroker(const MqttTestBroker &) = delete;
+  MqttTestBroker &operator=(const MqttTestBroker &) = delete;
+
+  uint16_t port() const { return listenPort; }
+
+  void setConnAckCode(uint8_t code) { connAckCode = code; }
+  void setDribble(bool enabled) { dribble = enabled; }
+  void setReading(bool enabled) { reading = enabled; }
+  void setTopicAliasMaximum(uint16_t count) { topicAliasMaximum = count; }
+  void setVersion5(bool supported) { version5 = supported; }
+  void setQos1LossEvery(size_t count) { qos1LossEvery = count; }
+  void setLatency(int ms) { latencyMs = ms; }
+  void setPubAckDelay(int ms) { pubAckDelayMs = ms; }
+  void setBandwidth(size_t bytesPerSec) { bandwidth = bytesPerSec; }
+  void setDropInterval(int ms) { dropIntervalMs = ms; }
+
+  /**
+   * @brief Limit the kernel receive buffer of the next accepted client.
+   */
+  void setReceiveBufferSize(int bytes) { receiveBufferSize = bytes; }
+
+  void publish(const std::string &topic, const std::string &payload,
+               uint8_t qos = 0) {
+    std::string body;
+    appendString(body, topic);
+    if (qos > 0) {
+      body.push_back(0x00);
+      body.push_back(0x2A); // fixed packet id 42
+    }
+    if (level == 5)
+      body.push_back(0x00); // no properties
+    body += payload;
+    std::lock_guard<std::mutex> lock(mutex);
+    enqueue(packet(static_cast<uint8_t>(0x30 | (qos << 1)), body));
+  }
+
+  void dropClient() { dropRequested = true; }
+
+  bool hasClient() const { return clientConnected; }
+
+  std::vector<Message> published() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return messages;
+  }
+
+  std::vector<std::string> subscriptions() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscribed;
+  }
+
+  std::string clientId() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastClientId;
+  }
+
+  std::string user() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastUser;
+  }
+
+  std::string password() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastPassword;
+  }
+
+  size_t pubAcksReceived() const { return pubAcks; }
+  size_t pingsReceived() const { return pings; }
+  size_t disconnectsReceived() const { return disconnects; }
+  size_t bytesReceived() const { return rxBytes; }
+  size_t tlsHandshakes() const { return handshakes; }
+  size_t tlsResumptions() const { return resumptions; }
+  size_t qos1PublishesLost() const { return qos1Lost; }
+  size_t clientsDropped() const { return drops; }
+
+  /**
+   * @brief CA certificate a client needs to verify a TLS broker
+   */
+  static const std::string &tlsCaCertPem() { return brokerIdentity().certPem; }
+
+  /**
+   * @brief Self-signed P-256 certificate for 127.0.0.1 and localhost
+   */
+  static TlsIdentity makeTlsIdentity() {
+    TlsIdentity identity;
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509V3_CTX context;
+    X509V3_set_ctx_nodb(&context);
+    X509V3_set_ctx(&context, cert, cert, nullptr, nullptr, 0);
+    const std::pair<int, const char *> extensions[] = {
+        {NID_subject_alt_name, "IP:127.0.0.1,DNS:localhost"},
+        {NID_basic_constraints, "critical,CA:TRUE"}};
+    for (const auto &extension : extensions) {
+      X509_EXTENSION *ext = X509V3_EXT_conf_nid(
+          nullptr, &context, extension.first, extension.second);
+      X509_add_ext(cert, ext, -1);
+      X509_EXTENSION_free(ext);
+    }
+    X509_sign(cert, key, EVP_sha256());
+
+    BIO *bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, cert);
+    identity.certPem = drain(bio);
+    PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+    identity.keyPem = drain(bio);
+    BIO_free(bio);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return identity;
+  }
+  uint8_t protocolLevel() const { return level; }
+
+  /**
+   * @brief Poll a predicate, calling pump() in between, until it holds.
+   */
+  static bool waitFor(const std::function<bool()> &predicate,
+                      const std::function<void()> &pump, int timeoutMs = 2000) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeoutMs);
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (pump)
+        pump();
+      if (predicate())
+        return true;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return predicate();
+  }
+
+private:
+  int listenFd{-1};
+  int clientFd{-1};
+  uint16_t listenPort{0};
+  std::thread worker;
+  std::mutex mutex;
+  std::atomic<bool> running{true};
+  std::atomic<bool> clientConnected{false};
+  std::atomic<bool> dribble{false};
+  std::atomic<bool> reading{true};
+  std::atomic<bool> dropRequested{false};
+  std::atomic<uint8_t> connAckCode{0};
+  std::atomic<uint16_t> topicAliasMaximum{10};
+  std::atomic<bool> version5{true};
+  std::atomic<uint8_t> level{0}; // of the last CONNECT
+  std::atomic<int> receiveBufferSize{0};
+  std::atomic<size_t> pubAcks{0};
+  std::atomic<size_t> pings{0};
+  std::atomic<size_t> disconnects{0};
+  std::atomic<size_t> rxBytes{0};
+  std::atomic<size_t> handshakes{0};
+  std::atomic<size_t> resumptions{0};
+  std::atomic<size_t> qos1LossEvery{0};
+  std::atomic<size_t> qos1Lost{0};
+  size_t qos1Received{0};
+  std::atomic<int> latencyMs{0};
+  std::atomic<int> pubAckDelayMs{0};
+  std::atomic<size_t> bandwidth{0};
+  std::atomic<int> dropIntervalMs{0};
+  std::atomic<size_t> drops{0};
+  std::chrono::steady_clock::time_point clientSince;
+  double readTokens{0};
+  std::chrono::steady_clock::time_point tokensRefilled;
+  SSL_CTX *tlsContext{nullptr};
+  SSL *clientTls{nullptr};
+
+  struct Delayed {
+    std::chrono::steady_clock::time_point due;
+    std::string data;
+  };
+
+  std::string inbox;
+  std::deque<Delayed> inbound;  // bytes the broker hasn't "received" yet
+  std::deque<Delayed> outbound; // guarded by mutex
+  std::vector<Message> messages;
+  std::vector<std::string> subscribed;
+  std::string lastClientId, lastUser, lastPassword;
+  std::map<uint16_t, std::string> aliases; // client's topic aliases
+
+  static void appendString(std::string &out, const std::string &s) {
+    out.push_back(static_cast<char>(s.size() >> 8));
+    out.push_back(static_cast<char>(s.size() & 0xFF));
+    out += s;
+  }
+
+  static std::string packet(uint8_t type, const std::string &body) {
+    std::string out(1, static_cast<char>(type));
+    size_t length = body.size();
+    do {
+      uint8_t digit = length % 128;
+      length /= 128;
+      if (length > 0)
+        digit |= 0x80;
+      out.push_back(static_cast<char>(digit));
+    } while (length > 0);
+    return out + body;
+  }
+
+  static std::string readString(const std::string &body, size_t &pos) {
+    size_t len = (static_cast<uint8_t>(body[pos]) << 8) |
+                 static_cast<uint8_t>(body[pos + 1]);
+    std::string s = body.substr(pos + 2, len);
+    pos += 2 + len;
+    return s;
+  }
+
+  static size_t readLength(const std::string &body, size_t &pos) {
+    size_t length = 0, multiplier = 1;
+    while (pos < body.size()) {
+      const uint8_t digit = static_cast<uint8_t>(body[pos++]);
+      length += (digit & 0x7F) * multiplier;
+      multiplier *= 128;
+      if ((digit & 0x80) == 0)
+        break;
+    }
+    return length;
+  }
+
+  static uint32_t readNumber(const std::string &body, size_t pos,
+                             size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+      value = (value << 8) | static_cast<uint8_t>(body[pos + i]);
+    return value;
+  }
+
+  // PUBLISH properties this stand-in cares about; others end the parse
+  static void readPublishProperties(const std::string &body, size_t &pos,
+                                    Message &message) {
+    const size_t length = readLength(body, pos);
+    const size_t end = pos + length;
+    while (pos < end) {
+      const uint8_t id = static_cast<uint8_t>(body[pos++]);
+      if (id == 0x02) {
+        message.expiry = readNumber(body, pos, 4);
+        pos += 4;
+      } else if (id == 0x23) {
+        message.topicAlias = static_cast<uint16_t>(readNumber(body, pos, 2));
+        pos += 2;
+      } else if (id == 0x26) {
+        std::string key = readString(body, pos);
+        message.userProperties.emplace_back(key, readString(body, pos));
+      } else {
+        break;
+      }
+    }
+    pos = end;
+  }
+
+  static std::string drain(BIO *bio) {
+    char *data = nullptr;
+    const long length = BIO_get_mem_data(bio, &data);
+    std::string text(data, static_cast<size_t>(length));
+    (void)BIO_reset(bio);
+    return text;
+  }
+
+  // One identity per test run; key generation isn't what's measured
+  static const TlsIdentity &brokerIdentity() {
+    static const TlsIdentity identity = makeTlsIdentity();
+    return identity;
+  }
+
+  void setUpTls() {
+    tlsContext = SSL_CTX_new(TLS_server_method());
+    BIO *cert = BIO_new_mem_buf(brokerIdentity().certPem.data(), -1);
+    BIO *key = BIO_new_mem_buf(brokerIdentity().keyPem.data(), -1);
+    X509 *x509 = PEM_read_bio_X509(cert, nullptr, nullptr, nullptr);
+    EVP_PKEY *pkey = PEM_read_bio_PrivateKey(key, nullptr, nullptr, nullptr);
+    SSL_CTX_use_certificate(tlsContext, x509);
+    SSL_CTX_use_PrivateKey(tlsContext, pkey);
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    BIO_free(cert);
+    BIO_free(key);
+    static const unsigned char SESSION_CONTEXT[] = "mqtt";
+    SSL_CTX_set_session_id_context(tlsContext, SESSION_CONTEXT,
+                                   sizeof(SESSION_CONTEXT) - 1);
+  }
+
+  // Blocking server handshake; the client side is pumped by the test
+  bool acceptTls(int fd) {
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    clientTls = SSL_new(tlsContext);
+    SSL_set_fd(clientTls, fd);
+    if (SSL_accept(clientTls) != 1) {
+      ERR_clear_error();
+      SSL_free(clientTls);
+      clientTls = nullptr;
+      return false;
+    }
+    handshakes++;
+    if (SSL_session_reused(clientTls))
+      resumptions++;
+    return true;
+  }
+
+  ssize_t sendBytes(const char *data, size_t length) {
+    if (clientTls)
+      return SSL_write(clientTls, data, static_cast<int>(length));
+    return ::send(clientFd, data, length, MSG_NOSIGNAL);
+  }
+
+  void closeClient() {
+    if (clientTls) {
+      SSL_shutdown(clientTls); // keeps the session resumable
+      SSL_free(clientTls);
+      clientTls = nullptr;
+      ERR_clear_error();
+    }
+    if (clientFd >= 0) {
+      ::close(clientFd);
+      clientFd = -1;
+    }
+    clientConnected = false;
+    inbox.clear();
+    inbound.clear();
+    aliases.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    outbound.clear(); // never reaches the next connection
+  }
+
+  // Caller holds mutex
+  void enqueue(std::string data, int extraDelayMs = 0) {
+    const auto due = std::chrono::steady_clock::now() +
+                     std::chrono::milliseconds(latencyMs + extraDelayMs);
+    outbound.push_back({due, std::move(data)});
+  }
+
+  // Bytes the read may take under the bandwidth cap; 10 ms of burst
+  size_t readAllowance(size_t wanted) {
+    if (bandwidth == 0)
+      return wanted;
+    const auto now = std::chrono::steady_clock::now();
+    const double rate = static_cast<double>(bandwidth);
+    readTokens = std::min(
+        readTokens +
+            rate * std::chrono::duration<double>(now - tokensRefilled).count(),
+        std::max(rate / 100, 64.0));
+    tokensRefilled = now;
+    return std::min(wanted, static_cast<size_t>(readTokens));
+  }
+
+  void sendRaw(const std::string &data) {
+    if (clientFd < 0)
+      return;
+    if (dribble) {
+      for (char c : data) {
+        sendBytes(&c, 1);
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+      }
+      return;
+    }
+    size_t sent = 0;
+    while (sent < data.size()) {
+      ssize_t n = sendBytes(data.data() + sent, data.size() - sent);
+      if (n <= 0)
+        return;
+      sent += static_cast<size_t>(n);
+    }
+  }
+
+  void run() {
+    while (running) {
+      const auto now = std::chrono::steady_clock::now();
+      if (dropRequested.exchange(false))
+        closeClient();
+      if (clientFd >= 0 && dropIntervalMs > 0 &&
+          now - clientSince >= std::chrono::milliseconds(dropIntervalMs)) {
+        drops++;
+        closeClient();
+      }
+
+      std::string pending;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!outbound.empty() && outbound.front().due <= now) {
+          pending += outbound.front().data;
+          outbound.pop_front();
+        }
+      }
+      sendRaw(pending);
+
+      while (!inbound.empty() && inbound.front().due <= now) {
+        inbox += inbound.front().data;
+        inbound.pop_front();
+      }
+      processInbox();
+
+      char buf[4096];
+      const size_t allowance = readAllowance(sizeof(buf));
+      pollfd fds[2] = {{listenFd, POLLIN, 0}, {clientFd, POLLIN, 0}};
+      const nfds_t count =
+          (clientFd >= 0 && reading && allowance > 0) ? 2 : 1;
+      // Decrypted bytes may already wait inside OpenSSL
+      const bool buffered = count == 2 && clientTls && SSL_pending(clientTls);
+      ::poll(fds, count, buffered ? 0 : 1);
+      if (buffered)
+        fds[1].revents |= POLLIN;
+
+      if (fds[0].revents & POLLIN) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd >= 0) {
+          closeClient();
+          int one = 1;
+          ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          if (receiveBufferSize > 0) {
+            int size = receiveBufferSize;
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+          }
+          if (tlsContext && !acceptTls(fd)) {
+            ::close(fd);
+            continue;
+          }
+          clientFd = fd;
+          clientConnected = true;
+          clientSince = std::chrono::steady_clock::now();
+        }
+      }
+
+      if (count == 2 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+        ssize_t n = clientTls
+                        ? SSL_read(clientTls, buf, static_cast<int>(allowance))
+                        : ::recv(clientFd, buf, allowance, 0);
+        if (n <= 0) {
+          closeClient();
+          continue;
+        }
+        rxBytes += static_cast<size_t>(n);
+        readTokens -= static_cast<double>(n);
+        if (latencyMs > 0) {
+          inbound.push_back({std::chrono::steady_clock::now() +
+                                 std::chrono::milliseconds(latencyMs),
+                             std::string(buf, static_cast<size_t>(n))});
+        } else {
+          inbox.append(buf, static_cast<size_t>(n));
+          processInbox();
+        }
+      }
+    }
+  }
+
+  void processInbox() {
+    while (inbox.size() >= 2) {
+      size_t length = 0, multiplier = 1, pos = 1;
+      bool complete = false;
+      while (pos < inbox.size() && pos <= 4) {
+        uint8_t digit = static_cast<uint8_t>(inbox[pos++]);
+        length += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+        if ((digit & 0x80) == 0) {
+          complete = true;
+          break;
+        }
+      }
+      if (!complete || inbox.size() < pos + length)
+        return;
+      const uint8_t type = static_cast<uint8_t>(inbox[0]);
+      std::string body = inbox.substr(pos, length);
+      inbox.erase(0, pos + length);
+      handle(type, body);
+    }
+  }
+
+  void handle(uint8_t type, const std::string &body) {
+    switch (type & 0xF0) {
+    case 0x10: { // CONNECT
+      size_t pos = 0;
+      readString(body, pos); // protocol name
+      level = static_cast<uint8_t>(body[pos++]);
+      const uint8_t flags = static_cast<uint8_t>(body[pos]);
+      pos += 3; // flags + keep alive
+      if (level == 5)
+        pos += readLength(body, pos); // properties
+      std::lock_guard<std::mutex> lock(mutex);
+      lastClientId = readString(body, pos);
+      lastUser = (flags & 0x80) ? readString(body, pos) : "";
+      lastPassword = (flags & 0x40) ? readString(body, pos) : "";
+      if (level == 5 && !version5) {
+        // A 3.1.1 broker: "unacceptable protocol version"
+        enqueue(packet(0x20, std::string{'\0', '\x01'}));
+        break;
+      }
+      std::string connAck{'\0', static_cast<char>(connAckCode.load())};
+      if (level == 5) {
+        const uint16_t aliasMax = topicAliasMaximum;
+        connAck += std::string{'\x03', '\x22',
+                               static_cast<char>(aliasMax >> 8),
+                               static_cast<char>(aliasMax & 0xFF)};
+      }
+      enqueue(packet(0x20, connAck));
+      break;
+    }
+    case 0x30: { // PUBLISH
+      const uint8_t qos = (type >> 1) & 0x03;
+      if (qos == 1 && qos1LossEvery > 0 &&
+          ++qos1Received % qos1LossEvery == 0) {
+        // Neither recorded nor acknowledged; what follows is lost as well
+        qos1Lost++;
+        closeClient();
+        break;
+      }
+      size_t pos = 0;
+      Message message;
+      message.topic = readString(body, pos);
+      std::string packetId;
+      if (qos > 0) {
+        packetId = body.substr(pos, 2);
+        pos += 2;
+      }
+      if (level == 5) {
+        readPublishProperties(body, pos, message);
+        if (message.topicAlias != 0) {
+          if (message.topic.empty())
+            message.topic = aliases[message.topicAlias];
+          else
+            aliases[message.topicAlias] = message.topic;
+        }
+      }
+      message.payload = body.substr(pos);
+      message.qos = qos;
+      message.retained = (type & 0x01) != 0;
+      message.receivedAt = std::chrono::steady_clock::now();
+      std::lock_guard<std::mutex> lock(mutex);
+      messages.push_back(message);
+      if (qos == 1)
+        enqueue(packet(0x40, packetId), pubAckDelayMs);
+      break;
+    }
+    case 0x40: // PUBACK
+      pubAcks++;
+      break;
+    case 0x80: { // SUBSCRIBE
+      size_t pos = 2;
+      if (level == 5)
+        pos += readLength(body, pos); // properties
+      std::lock_guard<std::mutex> lock(mutex);
+      while (pos + 2 < body.size()) {
+        subscribed.push_back(readString(body, pos));
+        pos += 1; // requested QoS
+      }
+      enqueue(packet(0x90, body.substr(0, 2) +
+                               (level == 5 ? std::string(1, '\0') : "") +
+                               std::string(1, '\x01')));
+      break;
+    }
+    case 0xC0: // PINGREQ
+      pings++;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        enqueue(packet(0xD0, ""));
+      }
+      break;
+    case 0xE0: // DISCONNECT
+      disconnects++;
+      break;
+    default:
+      break;
+    }
+  }
+};
+
+} // namespace jrb::wifi_serial
@@ -0,0 +1,89 @@
+// MQTT connect time over TLS: full against resumed handshakes.
+//
+// Each round connects the engine to the TLS broker stand-in and times
+// connect() up to the CONNACK (TCP connect, TLS handshake, MQTT CONNECT):
+// - "fresh context": a new transport per connect, as a client that builds
+//   its TLS context every time (CA parsed, buffers allocated, no session)
+// - "full": the transport's context reused, cached session dropped
+// - "resumed": the transport's context and cached session reused
+//
+// Native numbers with OpenSSL on loopback. On the ESP32-C3 a full ECDHE
+// handshake costs seconds of CPU, while a resumed one skips the certificate
+// check and key agreement entirely, which is where the saving shows.
+// The timings are only reported; the test checks which handshakes resumed.
+#include "infrastructure/mqttt/mqtt_engine.h"
+#include "infrastructure/mqttt/mqtt_transport.h"
+#include "mqtt_test_broker.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using HandshakeEngine = internal::MqttEngine<MqttTransport>;
+using HandshakeClock = std::chrono::steady_clock;
+constexpr int HANDSHAKE_ROUNDS = 15;
+
+// Time to CONNACK in microseconds, then disconnect
+double timeConnect(HandshakeEngine &engine, MqttTestBroker &broker) {
+  const auto start = HandshakeClock::now();
+  EXPECT_TRUE(engine.connect("handshake-benchmark"));
+  while (!engine.connected() &&
+         HandshakeClock::now() - start < std::chrono::seconds(2)) {
+    engine.loop();
+    std::this_thread::yield(); // the broker thread shares the CPU
+  }
+  const double micros = std::chrono::duration<double, std::micro>(
+                            HandshakeClock::now() - start)
+                            .count();
+  EXPECT_TRUE(engine.connected());
+  engine.disconnect();
+  MqttTestBroker::waitFor([&] { return !broker.hasClient(); }, nullptr);
+  return micros;
+}
+
+double median(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+TEST(TlsHandshakeBenchmark, FullVersusResumed) {
+  MqttTestBroker broker{MqttTestBroker::TlsMode::On};
+  const std::string caCert = MqttTestBroker::tlsCaCertPem();
+  const auto configure = [&](HandshakeEngine &engine) {
+    engine.setServer("127.0.0.1", broker.port());
+    engine.getTransport().setTls(true, caCert.c_str());
+  };
+
+  std::vector<double> fresh, full, resumed;
+  for (int i = 0; i < HANDSHAKE_ROUNDS; ++i) {
+    auto engine = std::make_unique<HandshakeEngine>();
+    configure(*engine);
+    fresh.push_back(timeConnect(*engine, broker));
+  }
+
+  HandshakeEngine engine;
+  configure(engine);
+  timeConnect(engine, broker); // context built, session cached
+  for (int i = 0; i < HANDSHAKE_ROUNDS; ++i) {
+    engine.getTransport().forgetSession();
+    full.push_back(timeConnect(engine, broker));
+    EXPECT_FALSE(engine.getTransport().lastHandshakeResumed());
+    resumed.push_back(timeConnect(engine, broker));
+    EXPECT_TRUE(engine.getTransport().lastHandshakeResumed());
+  }
+
+  std::printf("[ TLS      ] connect to CONNACK (median of %d): fresh context "
+              "%.0f us  full %.0f us  resumed %.0f us\n",
+              HANDSHAKE_ROUNDS, median(fresh), median(full), median(resumed));
+  EXPECT_EQ(broker.tlsResumptions(), static_cast<size_t>(HANDSHAKE_ROUNDS));
+}
+
+} // namespace
+} // namespace jrb::wifi_serial
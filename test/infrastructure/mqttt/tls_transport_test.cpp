@@ -0,0 +1,109 @@
+// MqttEngine over TlsTransport against the broker stand-in in TLS mode
+#include "infrastructure/mqttt/mqtt_engine.h"
+#include "infrastructure/mqttt/mqtt_transport.h"
+#include "mqtt_test_broker.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace jrb::wifi_serial {
+namespace {
+
+using TlsEngine = internal::MqttEngine<MqttTransport>;
+
+class TlsTransportTest : public ::testing::Test {
+protected:
+  MqttTestBroker broker{MqttTestBroker::TlsMode::On};
+  TlsEngine engine;
+  std::string caCert = MqttTestBroker::tlsCaCertPem();
+  std::vector<std::string> received;
+
+  void SetUp() override {
+    engine.setServer("127.0.0.1", broker.port());
+    engine.setBufferSize(MQTT_BUFFER_SIZE);
+    engine.setCallback([this](char *, uint8_t *payload, unsigned int length) {
+      received.emplace_back(reinterpret_cast<char *>(payload), length);
+    });
+    engine.getTransport().setTls(true, caCert.c_str());
+  }
+
+  bool pumpUntil(const std::function<bool()> &predicate) {
+    return MqttTestBroker::waitFor(predicate, [this] { engine.loop(); });
+  }
+
+  void connectAndWait() {
+    ASSERT_TRUE(engine.connect("tls-test"));
+    ASSERT_TRUE(pumpUntil([this] { return engine.connected(); }));
+  }
+
+  void dropAndWait() {
+    broker.dropClient();
+    ASSERT_TRUE(pumpUntil([this] { return !engine.connected(); }));
+  }
+};
+
+TEST_F(TlsTransportTest, VerifiedConnectionCarriesMqtt) {
+  connectAndWait();
+  EXPECT_EQ(broker.clientId(), "tls-test");
+  EXPECT_FALSE(engine.getTransport().lastHandshakeResumed());
+
+  // Bigger than one staged TLS write
+  const std::string line(MQTT_TLS_WRITE_SIZE + 100, 'x');
+  ASSERT_TRUE(engine.publish("dev/ttyS1/tx",
+                             reinterpret_cast<const uint8_t *>(line.data()),
+                             line.size()));
+  ASSERT_TRUE(pumpUntil([this] { return broker.published().size() == 1; }));
+  EXPECT_EQ(broker.published()[0].payload, line);
+
+  ASSERT_TRUE(engine.subscribe("dev/ttyS1/rx", 0));
+  ASSERT_TRUE(pumpUntil([this] { return broker.subscriptions().size() == 1; }));
+  broker.publish("dev/ttyS1/rx", "uptime\n");
+  ASSERT_TRUE(pumpUntil([this] { return received.size() == 1; }));
+  EXPECT_EQ(received[0], "uptime\n");
+}
+
+TEST_F(TlsTransportTest, ReconnectResumesSession) {
+  connectAndWait();
+  dropAndWait();
+  connectAndWait();
+
+  EXPECT_TRUE(engine.getTransport().lastHandshakeResumed());
+  EXPECT_EQ(broker.tlsHandshakes(), 2u);
+  EXPECT_EQ(broker.tlsResumptions(), 1u);
+
+  // A forgotten session costs a full handshake again
+  dropAndWait();
+  engine.getTransport().forgetSession();
+  connectAndWait();
+  EXPECT_FALSE(engine.getTransport().lastHandshakeResumed());
+  EXPECT_EQ(broker.tlsResumptions(), 1u);
+}
+
+TEST_F(TlsTransportTest, UnknownCaFailsHandshake) {
+  const std::string otherCa = MqttTestBroker::makeTlsIdentity().certPem;
+  engine.getTransport().setTls(true, otherCa.c_str());
+  ASSERT_TRUE(engine.connect("tls-test"));
+
+  EXPECT_TRUE(pumpUntil(
+      [this] { return engine.state() == TlsEngine::STATE_CONNECT_FAILED; }));
+  EXPECT_FALSE(engine.connected());
+  EXPECT_EQ(broker.tlsHandshakes(), 0u);
+}
+
+TEST(TlsTransportPlainTest, TlsOffIsPlainTcp) {
+  MqttTestBroker broker;
+  TlsEngine engine;
+  engine.setServer("127.0.0.1", broker.port());
+  ASSERT_TRUE(engine.connect("plain-test"));
+  ASSERT_TRUE(MqttTestBroker::waitFor([&] { return engine.connected(); },
+                                      [&] { engine.loop(); }));
+  const uint8_t payload[] = {'o', 'k'};
+  ASSERT_TRUE(engine.publish("t", payload, sizeof(payload)));
+  ASSERT_TRUE(MqttTestBroker::waitFor(
+      [&] { return broker.published().size() == 1; }, [&] { engine.loop(); }));
+  EXPECT_EQ(broker.published()[0].payload, "ok");
+}
+
+} // namespace
+} // namespace jrb::wifi_serial